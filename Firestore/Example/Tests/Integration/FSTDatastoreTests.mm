@@ -67,7 +67,7 @@ using firebase::firestore::local::Persistence;
 using firebase::firestore::local::QueryEngine;
 using firebase::firestore::model::BatchId;
 using firebase::firestore::model::DatabaseId;
-using firebase::firestore::model::DocumentKeySet;
+using firebase::firestore::model::DocumentKeyHashSet;
 using firebase::firestore::model::MutationBatch;
 using firebase::firestore::model::MutationBatchResult;
 using firebase::firestore::model::OnlineState;
@@ -153,8 +153,8 @@ NS_ASSUME_NONNULL_BEGIN
   HARD_FAIL("Not implemented");
 }
 
-- (DocumentKeySet)remoteKeysForTarget:(__unused TargetId)targetId {
-  return DocumentKeySet{};
+- (DocumentKeyHashSet)remoteKeysForTarget:(__unused TargetId)targetId {
+  return DocumentKeyHashSet{};
 }
 
 - (void)applyRemoteEvent:(const RemoteEvent &)remoteEvent {
@@ -204,7 +204,7 @@ class RemoteStoreEventCapture : public RemoteStoreCallback {
     HARD_FAIL("Not implemented");
   }
 
-  model::DocumentKeySet GetRemoteKeys(TargetId target_id) const override {
+  model::DocumentKeyHashSet GetRemoteKeys(TargetId target_id) const override {
     return [underlying_capture_ remoteKeysForTarget:target_id];
   }
 
@@ -251,7 +251,7 @@ void Firestore::EnsureClientConfigured() {
 
 DatabaseInfo Firestore::MakeDatabaseInfo() const {
   return DatabaseInfo(database_id_, persistence_key_, settings_.host(),
-                      settings_.ssl_enabled());
+                      settings_.ssl_enabled(), settings_.compression_enabled());
 }
 
 void Firestore::SetIndexConfiguration(const std::string& config,
@@ -302,14 +302,35 @@ void Firestore::SetIndexConfiguration(const std::string& config,
       }
     }
 
+    // Covered fields are an SDK extension of the index format: their values
+    // are stored in the index so that queries can be served without loading
+    // the documents.
+    std::vector<FieldPath> covered_fields;
+    const auto& json_covered_fields =
+        reader.OptionalArray("coveredFields", json_index, default_vector);
+    for (const auto& json_covered_field : json_covered_fields) {
+      if (!json_covered_field.is_string()) {
+        callback(Status(Error::kErrorInvalidArgument,
+                        "'coveredFields' must only contain field paths."));
+        return;
+      }
+      auto field_path =
+          FieldPath::FromServerFormat(json_covered_field.get<std::string>());
+      if (!field_path.ok()) {
+        callback(field_path.status());
+        return;
+      }
+      covered_fields.push_back(std::move(field_path).ValueOrDie());
+    }
+
     if (reader.status() != util::Status::OK()) {
       callback(reader.status());
       return;
     }
 
-    parsed_indexes.emplace_back(
-        FieldIndex(FieldIndex::UnknownId(), collection_group,
-                   std::move(segments), FieldIndex::InitialState()));
+    parsed_indexes.emplace_back(FieldIndex(
+        FieldIndex::UnknownId(), collection_group, std::move(segments),
+        FieldIndex::InitialState(), std::move(covered_fields)));
   }
 
   client_->ConfigureFieldIndexes(std::move(parsed_indexes));
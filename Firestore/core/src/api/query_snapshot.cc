@@ -16,7 +16,9 @@
 
 #include "Firestore/core/src/api/query_snapshot.h"
 
+#include <algorithm>
 #include <utility>
+#include <vector>
 
 #include "Firestore/core/src/api/document_change.h"
 #include "Firestore/core/src/api/document_snapshot.h"
@@ -133,10 +135,22 @@ void QuerySnapshot::ForEachChange(
     }
 
   } else {
-    // A DocumentSet that is updated incrementally as changes are applied to use
-    // to lookup the index of a document.
-    DocumentSet index_tracker = snapshot_.old_documents();
-    for (const DocumentViewChange& change : snapshot_.document_changes()) {
+    // Snapshots raised by a View carry the index of every change. Otherwise,
+    // use a DocumentSet that is updated incrementally as changes are applied
+    // to look up the index of a document.
+    const std::vector<DocumentViewChange>& changes =
+        snapshot_.document_changes();
+    bool has_indices =
+        std::all_of(changes.begin(), changes.end(),
+                    [](const DocumentViewChange& change) {
+                      return change.has_indices();
+                    });
+    absl::optional<DocumentSet> index_tracker;
+    if (!has_indices) {
+      index_tracker = snapshot_.old_documents();
+    }
+
+    for (const DocumentViewChange& change : changes) {
       if (!include_metadata_changes &&
           change.type() == DocumentViewChange::Type::Metadata) {
         continue;
@@ -148,17 +162,21 @@ void QuerySnapshot::ForEachChange(
           /*from_cache=*/snapshot_.from_cache());
       auto document = DocumentSnapshot::FromDocument(firestore_, doc, metadata);
 
-      size_t old_index = DocumentChange::npos;
-      size_t new_index = DocumentChange::npos;
-      if (change.type() != DocumentViewChange::Type::Added) {
-        old_index = index_tracker.IndexOf(change.document()->key());
-        HARD_ASSERT(old_index != DocumentSet::npos,
-                    "Index for document not found");
-        index_tracker = index_tracker.erase(change.document()->key());
-      }
-      if (change.type() != DocumentViewChange::Type::Removed) {
-        index_tracker = index_tracker.insert(change.document());
-        new_index = index_tracker.IndexOf(change.document()->key());
+      size_t old_index = change.old_index();
+      size_t new_index = change.new_index();
+      if (!has_indices) {
+        old_index = DocumentChange::npos;
+        new_index = DocumentChange::npos;
+        if (change.type() != DocumentViewChange::Type::Added) {
+          old_index = index_tracker->IndexOf(change.document()->key());
+          HARD_ASSERT(old_index != DocumentSet::npos,
+                      "Index for document not found");
+          index_tracker = index_tracker->erase(change.document()->key());
+        }
+        if (change.type() != DocumentViewChange::Type::Removed) {
+          index_tracker = index_tracker->insert(change.document());
+          new_index = index_tracker->IndexOf(change.document()->key());
+        }
       }
 
       DocumentChange::Type type = DocumentChangeTypeForChange(change);
@@ -29,6 +29,9 @@ namespace api {
 constexpr const char* Settings::DefaultHost;
 constexpr bool Settings::DefaultSslEnabled;
 constexpr bool Settings::DefaultPersistenceEnabled;
+constexpr bool Settings::DefaultCompressionEnabled;
+constexpr bool Settings::DefaultFieldNameDictionaryEnabled;
+constexpr bool Settings::DefaultGroupCommitEnabled;
 constexpr int64_t Settings::DefaultCacheSizeBytes;
 constexpr int64_t Settings::MinimumCacheSizeBytes;
 
@@ -36,7 +39,12 @@ Settings::Settings(const Settings& other)
     : host_(other.host_),
       ssl_enabled_(other.ssl_enabled_),
       persistence_enabled_(other.persistence_enabled_),
-      cache_size_bytes_(other.cache_size_bytes_) {
+      cache_size_bytes_(other.cache_size_bytes_),
+      compression_enabled_(other.compression_enabled_),
+      field_name_dictionary_enabled_(other.field_name_dictionary_enabled_),
+      resume_token_checkpoint_policy_(other.resume_token_checkpoint_policy_),
+      group_commit_enabled_(other.group_commit_enabled_),
+      group_commit_durability_(other.group_commit_durability_) {
   if (other.cache_settings_ != nullptr) {
     cache_settings_ = CopyCacheSettings(*other.cache_settings_);
   }
@@ -51,6 +59,11 @@ Settings& Settings::operator=(const Settings& other) {
   ssl_enabled_ = other.ssl_enabled_;
   persistence_enabled_ = other.persistence_enabled_;
   cache_size_bytes_ = other.cache_size_bytes_;
+  compression_enabled_ = other.compression_enabled_;
+  field_name_dictionary_enabled_ = other.field_name_dictionary_enabled_;
+  resume_token_checkpoint_policy_ = other.resume_token_checkpoint_policy_;
+  group_commit_enabled_ = other.group_commit_enabled_;
+  group_commit_durability_ = other.group_commit_durability_;
   if (other.cache_settings_ != nullptr) {
     cache_settings_ = CopyCacheSettings(*other.cache_settings_);
   }
@@ -115,13 +128,27 @@ MemoryCacheSettings MemoryCacheSettings::WithMemoryGarbageCollectorSettings(
 
 size_t Settings::Hash() const {
   return util::Hash(host_, ssl_enabled_, persistence_enabled_,
-                    cache_size_bytes_, cache_settings_);
+                    cache_size_bytes_, compression_enabled_,
+                    field_name_dictionary_enabled_,
+                    resume_token_checkpoint_policy_.max_age_seconds,
+                    resume_token_checkpoint_policy_.documents,
+                    resume_token_checkpoint_policy_.bytes,
+                    group_commit_enabled_,
+                    static_cast<int>(group_commit_durability_),
+                    cache_settings_);
 }
 
 bool operator==(const Settings& lhs, const Settings& rhs) {
   bool eq = lhs.host_ == rhs.host_ && lhs.ssl_enabled_ == rhs.ssl_enabled_ &&
             lhs.persistence_enabled_ == rhs.persistence_enabled_ &&
-            lhs.cache_size_bytes_ == rhs.cache_size_bytes_;
+            lhs.cache_size_bytes_ == rhs.cache_size_bytes_ &&
+            lhs.compression_enabled_ == rhs.compression_enabled_ &&
+            lhs.field_name_dictionary_enabled_ ==
+                rhs.field_name_dictionary_enabled_ &&
+            lhs.resume_token_checkpoint_policy_ ==
+                rhs.resume_token_checkpoint_policy_ &&
+            lhs.group_commit_enabled_ == rhs.group_commit_enabled_ &&
+            lhs.group_commit_durability_ == rhs.group_commit_durability_;
   if (!eq) {
     return eq;
   }
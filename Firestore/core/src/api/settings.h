@@ -22,6 +22,8 @@
 #include <string>
 #include <utility>
 
+#include "Firestore/core/src/local/resume_token_checkpoint_policy.h"
+#include "Firestore/core/src/local/write_durability.h"
 #include "absl/memory/memory.h"
 
 namespace firebase {
@@ -43,6 +45,9 @@ class Settings {
   static constexpr const char* DefaultHost = "firestore.googleapis.com";
   static constexpr bool DefaultSslEnabled = true;
   static constexpr bool DefaultPersistenceEnabled = true;
+  static constexpr bool DefaultCompressionEnabled = false;
+  static constexpr bool DefaultFieldNameDictionaryEnabled = false;
+  static constexpr bool DefaultGroupCommitEnabled = false;
   static constexpr int64_t DefaultCacheSizeBytes = 100 * 1024 * 1024;
   static constexpr int64_t MinimumCacheSizeBytes = 1 * 1024 * 1024;
   static constexpr int64_t CacheSizeUnlimited = -1;
@@ -68,6 +73,66 @@ class Settings {
     return ssl_enabled_;
   }
 
+  /**
+   * Whether the listen and write streams ask gRPC to gzip the messages they
+   * send. Compression trades CPU for bandwidth, so it is off by default.
+   */
+  void set_compression_enabled(bool value) {
+    compression_enabled_ = value;
+  }
+  bool compression_enabled() const {
+    return compression_enabled_;
+  }
+
+  /**
+   * Whether the persistent cache stores the field names of documents as ids
+   * from a per-collection-group dictionary, which makes cached documents
+   * smaller. SDK versions that predate the dictionary can't read documents
+   * stored this way; starting once with the dictionary disabled converts the
+   * cache back. Off by default.
+   */
+  void set_field_name_dictionary_enabled(bool value) {
+    field_name_dictionary_enabled_ = value;
+  }
+  bool field_name_dictionary_enabled() const {
+    return field_name_dictionary_enabled_;
+  }
+
+  /**
+   * How often the resume tokens of active listens are persisted. Persisting
+   * them more often means fewer documents are sent again when a listen is
+   * resumed after a restart, at the cost of more writes to the local cache.
+   */
+  void set_resume_token_checkpoint_policy(
+      const local::ResumeTokenCheckpointPolicy& value) {
+    resume_token_checkpoint_policy_ = value;
+  }
+  const local::ResumeTokenCheckpointPolicy& resume_token_checkpoint_policy()
+      const {
+    return resume_token_checkpoint_policy_;
+  }
+
+  /**
+   * Whether the persistent cache commits transactions by handing their
+   * changes to a writer thread, which writes the changes of all transactions
+   * committed in the meantime at once. Off by default, since the most recent
+   * commits are lost if the process crashes before they are written.
+   */
+  void set_group_commit_enabled(bool value) {
+    group_commit_enabled_ = value;
+  }
+  bool group_commit_enabled() const {
+    return group_commit_enabled_;
+  }
+
+  /** How durable the writes are once group commit writes them. */
+  void set_group_commit_durability(local::WriteDurability value) {
+    group_commit_durability_ = value;
+  }
+  local::WriteDurability group_commit_durability() const {
+    return group_commit_durability_;
+  }
+
   void set_persistence_enabled(bool value);
   bool persistence_enabled() const;
 
@@ -90,6 +155,12 @@ class Settings {
   bool ssl_enabled_ = DefaultSslEnabled;
   bool persistence_enabled_ = DefaultPersistenceEnabled;
   int64_t cache_size_bytes_ = DefaultCacheSizeBytes;
+  bool compression_enabled_ = DefaultCompressionEnabled;
+  bool field_name_dictionary_enabled_ = DefaultFieldNameDictionaryEnabled;
+  local::ResumeTokenCheckpointPolicy resume_token_checkpoint_policy_;
+  bool group_commit_enabled_ = DefaultGroupCommitEnabled;
+  local::WriteDurability group_commit_durability_ =
+      local::WriteDurability::kAsync;
   std::unique_ptr<LocalCacheSettings> cache_settings_ = nullptr;
 };
 
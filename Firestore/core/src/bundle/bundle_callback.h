@@ -44,6 +44,14 @@ class BundleCallback {
       const model::MutableDocumentMap& documents,
       const std::string& bundle_id) = 0;
 
+  /**
+   * Releases the documents retained from previous loads of the bundle with
+   * the given ID. Called before the first chunk of documents of a bundle is
+   * applied; documents of later chunks are retained in addition to the
+   * earlier ones.
+   */
+  virtual void ResetBundledDocuments(const std::string& bundle_id) = 0;
+
   /** Saves the given NamedQuery to local persistence. */
   virtual void SaveNamedQuery(const NamedQuery& query,
                               const model::DocumentKeySet& keys) = 0;
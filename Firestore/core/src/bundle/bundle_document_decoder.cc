@@ -0,0 +1,774 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/bundle/bundle_document_decoder.h"
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/model/document_key.h"
+#include "Firestore/core/src/model/mutable_document.h"
+#include "Firestore/core/src/model/object_value.h"
+#include "Firestore/core/src/model/resource_path.h"
+#include "Firestore/core/src/model/snapshot_version.h"
+#include "Firestore/core/src/nanopb/message.h"
+#include "Firestore/core/src/nanopb/nanopb_util.h"
+#include "Firestore/core/src/timestamp_internal.h"
+#include "Firestore/core/src/util/hard_assert.h"
+#include "Firestore/core/src/util/statusor.h"
+#include "Firestore/third_party/nlohmann_json/json.hpp"
+#include "absl/strings/escaping.h"
+#include "absl/strings/numbers.h"
+#include "absl/time/time.h"
+
+namespace firebase {
+namespace firestore {
+namespace bundle {
+namespace {
+
+using model::DocumentKey;
+using model::MutableDocument;
+using model::ObjectValue;
+using model::ResourcePath;
+using model::SnapshotVersion;
+using nanopb::Message;
+using nlohmann::json;
+using util::JsonReader;
+using util::StatusOr;
+
+/** The meaning of a JSON value, given its position within the element. */
+enum class Slot {
+  /** A value that is not needed to decode the document. */
+  kSkip,
+
+  /** The top-level object of the bundle element. */
+  kElement,
+
+  /** The `document` object of the bundle element. */
+  kDocument,
+  kName,
+  kUpdateTime,
+
+  /** The `fields` object of a document or of a `mapValue`. */
+  kFields,
+
+  /** A `google_firestore_v1_Value` object. */
+  kValue,
+  kNullValue,
+  kBooleanValue,
+  kIntegerValue,
+  kDoubleValue,
+  kTimestampValue,
+  kStringValue,
+  kBytesValue,
+  kReferenceValue,
+  kGeoPointValue,
+  kArrayValue,
+  kMapValue,
+
+  /** The `values` array of an `arrayValue`. */
+  kArrayValues,
+
+  /** The members of timestamps and geo points encoded as objects. */
+  kSeconds,
+  kNanos,
+  kLatitude,
+  kLongitude,
+};
+
+/** An object or array that is being decoded. */
+struct Frame {
+  explicit Frame(Slot slot) : slot(slot) {
+  }
+
+  Slot slot;
+
+  /** The slot of the next value within this object or array. */
+  Slot child = Slot::kSkip;
+
+  /** `kFields`: the key of the entry that is being decoded. */
+  std::string key;
+
+  /** `kFields`: the entries decoded so far. */
+  std::vector<Message<google_firestore_v1_MapValue_FieldsEntry>> entries;
+
+  /** `kArrayValues`: the values decoded so far. */
+  std::vector<Message<google_firestore_v1_Value>> values;
+
+  /** `kValue`: the value decoded so far, if `has_type`. */
+  Message<google_firestore_v1_Value> value;
+  bool has_type = false;
+
+  /** `kUpdateTime` and `kTimestampValue`: the members decoded so far. */
+  int64_t seconds = 0;
+  int32_t nanos = 0;
+
+  /** `kGeoPointValue`: the members decoded so far. */
+  double latitude = 0;
+  double longitude = 0;
+};
+
+Slot DocumentMemberSlot(const std::string& key) {
+  if (key == "name") return Slot::kName;
+  if (key == "fields") return Slot::kFields;
+  if (key == "updateTime") return Slot::kUpdateTime;
+  return Slot::kSkip;
+}
+
+Slot ValueMemberSlot(const std::string& key) {
+  if (key == "nullValue") return Slot::kNullValue;
+  if (key == "booleanValue") return Slot::kBooleanValue;
+  if (key == "integerValue") return Slot::kIntegerValue;
+  if (key == "doubleValue") return Slot::kDoubleValue;
+  if (key == "timestampValue") return Slot::kTimestampValue;
+  if (key == "stringValue") return Slot::kStringValue;
+  if (key == "bytesValue") return Slot::kBytesValue;
+  if (key == "referenceValue") return Slot::kReferenceValue;
+  if (key == "geoPointValue") return Slot::kGeoPointValue;
+  if (key == "arrayValue") return Slot::kArrayValue;
+  if (key == "mapValue") return Slot::kMapValue;
+  return Slot::kSkip;
+}
+
+/**
+ * Receives the SAX events of the JSON parser for a bundle element and builds
+ * the document it holds. Implements the SAX interface of `nlohmann::json`.
+ *
+ * Every event either starts a value (scalars, `start_object`, `start_array`),
+ * names the next value (`key`) or ends an object or array. The meaning of a
+ * value is determined by the innermost open object or array, tracked on
+ * `stack_`. Values that are not needed are skipped by counting their nesting
+ * depth in `skip_depth_`.
+ *
+ * Each handler returns false to stop parsing, either because an error has
+ * been reported to `reader_` or because the element is not a document.
+ */
+class DocumentSaxHandler {
+ public:
+  DocumentSaxHandler(const remote::Serializer& rpc_serializer,
+                     JsonReader& reader)
+      : rpc_serializer_(rpc_serializer), reader_(reader) {
+  }
+
+  bool null() {
+    switch (CurrentSlot()) {
+      case Slot::kSkip:
+        return true;
+      case Slot::kNullValue:
+        return SetNull();
+      default:
+        return UnexpectedValue();
+    }
+  }
+
+  bool boolean(bool value) {
+    switch (CurrentSlot()) {
+      case Slot::kSkip:
+        return true;
+      case Slot::kNullValue:
+        return SetNull();
+      case Slot::kBooleanValue: {
+        Message<google_firestore_v1_Value>& result = StartValue();
+        result->which_value_type = google_firestore_v1_Value_boolean_value_tag;
+        result->boolean_value = value;
+        return true;
+      }
+      default:
+        return UnexpectedValue();
+    }
+  }
+
+  bool number_integer(json::number_integer_t value) {
+    return Number(static_cast<int64_t>(value), static_cast<double>(value));
+  }
+
+  bool number_unsigned(json::number_unsigned_t value) {
+    if (value > static_cast<json::number_unsigned_t>(
+                    std::numeric_limits<int64_t>::max())) {
+      return Fail("Integer value is out of range");
+    }
+    return Number(static_cast<int64_t>(value), static_cast<double>(value));
+  }
+
+  bool number_float(json::number_float_t value, const json::string_t&) {
+    switch (CurrentSlot()) {
+      case Slot::kSkip:
+        return true;
+      case Slot::kNullValue:
+        return SetNull();
+      case Slot::kDoubleValue:
+        return SetDouble(value);
+      case Slot::kLatitude:
+        Top().latitude = value;
+        return true;
+      case Slot::kLongitude:
+        Top().longitude = value;
+        return true;
+      case Slot::kIntegerValue:
+      case Slot::kSeconds:
+      case Slot::kNanos:
+        return Fail("Only integer and string can be parsed into int type");
+      default:
+        return UnexpectedValue();
+    }
+  }
+
+  bool string(json::string_t& value) {
+    switch (CurrentSlot()) {
+      case Slot::kSkip:
+        return true;
+      case Slot::kNullValue:
+        return SetNull();
+      case Slot::kName:
+        name_ = std::move(value);
+        return true;
+      case Slot::kUpdateTime:
+        return ParseTimestamp(value, &update_time_);
+      case Slot::kIntegerValue:
+        return SetInteger(value);
+      case Slot::kDoubleValue:
+        return SetDouble(value);
+      case Slot::kTimestampValue: {
+        Timestamp timestamp;
+        if (!ParseTimestamp(value, &timestamp)) return false;
+        return SetTimestamp(timestamp);
+      }
+      case Slot::kStringValue: {
+        Message<google_firestore_v1_Value>& result = StartValue();
+        result->which_value_type = google_firestore_v1_Value_string_value_tag;
+        result->string_value = nanopb::MakeBytesArray(value);
+        return true;
+      }
+      case Slot::kBytesValue: {
+        std::string decoded;
+        if (!absl::Base64Unescape(value, &decoded)) {
+          return Fail("Failed to decode bytesValue string into binary form");
+        }
+        Message<google_firestore_v1_Value>& result = StartValue();
+        result->which_value_type = google_firestore_v1_Value_bytes_value_tag;
+        result->bytes_value = nanopb::MakeBytesArray(decoded);
+        return true;
+      }
+      case Slot::kReferenceValue: {
+        if (!rpc_serializer_.IsLocalDocumentKey(value)) {
+          return Fail("Tried to deserialize an invalid key: " + value);
+        }
+        Message<google_firestore_v1_Value>& result = StartValue();
+        result->which_value_type =
+            google_firestore_v1_Value_reference_value_tag;
+        result->reference_value = nanopb::MakeBytesArray(value);
+        return true;
+      }
+      case Slot::kSeconds: {
+        int64_t seconds = 0;
+        if (!absl::SimpleAtoi(value, &seconds)) {
+          return Fail("Failed to parse into integer: " + value);
+        }
+        Top().seconds = seconds;
+        return true;
+      }
+      case Slot::kNanos: {
+        int32_t nanos = 0;
+        if (!absl::SimpleAtoi(value, &nanos)) {
+          return Fail("Failed to parse into integer: " + value);
+        }
+        Top().nanos = nanos;
+        return true;
+      }
+      case Slot::kLatitude:
+        return ParseDouble(value, &Top().latitude);
+      case Slot::kLongitude:
+        return ParseDouble(value, &Top().longitude);
+      default:
+        return UnexpectedValue();
+    }
+  }
+
+  bool binary(json::binary_t&) {
+    // Binary values only occur in binary formats such as CBOR.
+    return UnexpectedValue();
+  }
+
+  bool start_object(std::size_t) {
+    if (stack_.empty()) {
+      stack_.emplace_back(Slot::kElement);
+      return true;
+    }
+
+    Slot slot = CurrentSlot();
+    switch (slot) {
+      case Slot::kSkip:
+        ++skip_depth_;
+        return true;
+      case Slot::kNullValue:
+        ++skip_depth_;
+        return SetNull();
+      case Slot::kDocument:
+      case Slot::kUpdateTime:
+      case Slot::kFields:
+      case Slot::kValue:
+      case Slot::kTimestampValue:
+      case Slot::kGeoPointValue:
+      case Slot::kArrayValue:
+      case Slot::kMapValue:
+        stack_.emplace_back(slot);
+        return true;
+      case Slot::kArrayValues:
+        return Fail("'values' is not an array");
+      default:
+        return UnexpectedValue();
+    }
+  }
+
+  bool key(json::string_t& key) {
+    if (skip_depth_ > 0) return true;
+
+    Frame& frame = Top();
+    switch (frame.slot) {
+      case Slot::kElement:
+        if (key != "document") {
+          // Not a document element; leave it to `BundleSerializer`.
+          not_document_ = true;
+          return false;
+        }
+        frame.child = Slot::kDocument;
+        return true;
+      case Slot::kDocument:
+        frame.child = DocumentMemberSlot(key);
+        return true;
+      case Slot::kFields:
+        frame.key = std::move(key);
+        frame.child = Slot::kValue;
+        return true;
+      case Slot::kValue:
+        frame.child = ValueMemberSlot(key);
+        if (frame.child != Slot::kSkip && frame.has_type) {
+          return MultipleTypes();
+        }
+        return true;
+      case Slot::kUpdateTime:
+      case Slot::kTimestampValue:
+        frame.child = key == "seconds"  ? Slot::kSeconds
+                      : key == "nanos" ? Slot::kNanos
+                                       : Slot::kSkip;
+        return true;
+      case Slot::kGeoPointValue:
+        frame.child = key == "latitude"    ? Slot::kLatitude
+                      : key == "longitude" ? Slot::kLongitude
+                                           : Slot::kSkip;
+        return true;
+      case Slot::kArrayValue:
+        frame.child = key == "values" ? Slot::kArrayValues : Slot::kSkip;
+        if (frame.child != Slot::kSkip && ValueFrame().has_type) {
+          return MultipleTypes();
+        }
+        return true;
+      case Slot::kMapValue:
+        frame.child = key == "fields" ? Slot::kFields : Slot::kSkip;
+        if (frame.child != Slot::kSkip && ValueFrame().has_type) {
+          return MultipleTypes();
+        }
+        return true;
+      default:
+        return UnexpectedValue();
+    }
+  }
+
+  bool end_object() {
+    if (skip_depth_ > 0) {
+      --skip_depth_;
+      return true;
+    }
+
+    Frame frame = std::move(stack_.back());
+    stack_.pop_back();
+    switch (frame.slot) {
+      case Slot::kElement:
+        return true;
+
+      case Slot::kDocument:
+        has_document_ = true;
+        return true;
+
+      case Slot::kUpdateTime: {
+        StatusOr<Timestamp> decoded =
+            TimestampInternal::FromUntrustedSecondsAndNanos(frame.seconds,
+                                                            frame.nanos);
+        if (!decoded.ok()) return InvalidTimestamp(decoded);
+        update_time_ = decoded.ConsumeValueOrDie();
+        return true;
+      }
+
+      case Slot::kTimestampValue: {
+        StatusOr<Timestamp> decoded =
+            TimestampInternal::FromUntrustedSecondsAndNanos(frame.seconds,
+                                                            frame.nanos);
+        if (!decoded.ok()) return InvalidTimestamp(decoded);
+        return SetTimestamp(decoded.ValueOrDie());
+      }
+
+      case Slot::kGeoPointValue: {
+        Message<google_firestore_v1_Value>& result = StartValue();
+        result->which_value_type =
+            google_firestore_v1_Value_geo_point_value_tag;
+        result->geo_point_value.latitude = frame.latitude;
+        result->geo_point_value.longitude = frame.longitude;
+        return true;
+      }
+
+      case Slot::kFields:
+        return EndFields(&frame);
+
+      case Slot::kMapValue:
+        // A `mapValue` without `fields` is an empty map.
+        if (!Top().has_type) {
+          SetMap(Message<google_firestore_v1_MapValue>{});
+        }
+        return true;
+
+      case Slot::kArrayValue:
+        // An `arrayValue` without `values` is an empty array.
+        if (!Top().has_type) {
+          Message<google_firestore_v1_Value>& result = StartValue();
+          result->which_value_type = google_firestore_v1_Value_array_value_tag;
+        }
+        return true;
+
+      case Slot::kValue:
+        return EndValue(&frame);
+
+      default:
+        return UnexpectedValue();
+    }
+  }
+
+  bool start_array(std::size_t) {
+    if (stack_.empty()) {
+      return Fail("Bundle element is not a JSON object");
+    }
+
+    switch (CurrentSlot()) {
+      case Slot::kSkip:
+        ++skip_depth_;
+        return true;
+      case Slot::kNullValue:
+        ++skip_depth_;
+        return SetNull();
+      case Slot::kArrayValues:
+        stack_.emplace_back(Slot::kArrayValues);
+        Top().child = Slot::kValue;
+        return true;
+      default:
+        return UnexpectedValue();
+    }
+  }
+
+  bool end_array() {
+    if (skip_depth_ > 0) {
+      --skip_depth_;
+      return true;
+    }
+
+    Frame frame = std::move(stack_.back());
+    stack_.pop_back();
+
+    // The array is the `values` of the `arrayValue` frame on top.
+    Message<google_firestore_v1_Value>& result = StartValue();
+    result->which_value_type = google_firestore_v1_Value_array_value_tag;
+    google_firestore_v1_ArrayValue& array = result->array_value;
+    array.values_count = nanopb::CheckedSize(frame.values.size());
+    array.values =
+        nanopb::MakeArray<google_firestore_v1_Value>(array.values_count);
+    for (size_t i = 0; i < frame.values.size(); ++i) {
+      array.values[i] = *frame.values[i].release();
+    }
+    return true;
+  }
+
+  bool parse_error(std::size_t,
+                   const std::string&,
+                   const nlohmann::detail::exception&) {
+    return Fail("Failed to parse string into json");
+  }
+
+  /** Whether parsing stopped because the element is not a document. */
+  bool not_document() const {
+    return not_document_;
+  }
+
+  /** Builds the decoded document once parsing has completed. */
+  absl::optional<BundleDocument> TakeDocument() {
+    if (!has_document_) {
+      reader_.Fail("Missing child 'document'");
+      return absl::nullopt;
+    }
+    if (!name_.has_value()) {
+      reader_.Fail("Document name is not a string.");
+      return absl::nullopt;
+    }
+    if (!update_time_.has_value()) {
+      reader_.Fail("Missing child 'updateTime'");
+      return absl::nullopt;
+    }
+
+    auto path = ResourcePath::FromString(*name_);
+    if (!rpc_serializer_.IsLocalResourceName(path)) {
+      reader_.Fail("Resource name is not valid for current instance: " +
+                   path.CanonicalString());
+      return absl::nullopt;
+    }
+    path = path.PopFirst(5);
+    if (!DocumentKey::IsDocumentKey(path)) {
+      reader_.Fail("Invalid document name: " + path.CanonicalString());
+      return absl::nullopt;
+    }
+
+    return BundleDocument(MutableDocument::FoundDocument(
+        DocumentKey(std::move(path)), SnapshotVersion(*update_time_),
+        ObjectValue::FromMapValue(std::move(fields_))));
+  }
+
+ private:
+  Frame& Top() {
+    return stack_.back();
+  }
+
+  /** The slot of the value that starts with the current event. */
+  Slot CurrentSlot() const {
+    if (skip_depth_ > 0 || stack_.empty()) return Slot::kSkip;
+    return stack_.back().child;
+  }
+
+  /**
+   * Returns the value of the innermost `Value` frame, which the current event
+   * determines the type of.
+   */
+  Message<google_firestore_v1_Value>& StartValue() {
+    Frame& frame = ValueFrame();
+    frame.has_type = true;
+    return frame.value;
+  }
+
+  /** Returns the innermost `Value` frame. */
+  Frame& ValueFrame() {
+    // Geo points, timestamps, maps and arrays are decoded in a frame of their
+    // own, directly above the frame of the `Value` that holds them.
+    return Top().slot == Slot::kValue ? Top() : stack_[stack_.size() - 2];
+  }
+
+  bool Number(int64_t integer, double floating) {
+    switch (CurrentSlot()) {
+      case Slot::kSkip:
+        return true;
+      case Slot::kNullValue:
+        return SetNull();
+      case Slot::kIntegerValue: {
+        Message<google_firestore_v1_Value>& result = StartValue();
+        result->which_value_type = google_firestore_v1_Value_integer_value_tag;
+        result->integer_value = integer;
+        return true;
+      }
+      case Slot::kDoubleValue:
+        return SetDouble(floating);
+      case Slot::kSeconds:
+        Top().seconds = integer;
+        return true;
+      case Slot::kNanos:
+        if (integer < std::numeric_limits<int32_t>::min() ||
+            integer > std::numeric_limits<int32_t>::max()) {
+          return Fail("Integer value is out of range");
+        }
+        Top().nanos = static_cast<int32_t>(integer);
+        return true;
+      case Slot::kLatitude:
+        Top().latitude = floating;
+        return true;
+      case Slot::kLongitude:
+        Top().longitude = floating;
+        return true;
+      default:
+        return UnexpectedValue();
+    }
+  }
+
+  bool SetNull() {
+    Message<google_firestore_v1_Value>& result = StartValue();
+    result->which_value_type = google_firestore_v1_Value_null_value_tag;
+    result->null_value = {};
+    return true;
+  }
+
+  bool SetInteger(const std::string& value) {
+    int64_t integer = 0;
+    if (!absl::SimpleAtoi(value, &integer)) {
+      return Fail("Failed to parse into integer: " + value);
+    }
+    Message<google_firestore_v1_Value>& result = StartValue();
+    result->which_value_type = google_firestore_v1_Value_integer_value_tag;
+    result->integer_value = integer;
+    return true;
+  }
+
+  bool SetDouble(const std::string& value) {
+    double floating = 0;
+    if (!ParseDouble(value, &floating)) return false;
+    return SetDouble(floating);
+  }
+
+  bool SetDouble(double value) {
+    Message<google_firestore_v1_Value>& result = StartValue();
+    result->which_value_type = google_firestore_v1_Value_double_value_tag;
+    result->double_value = value;
+    return true;
+  }
+
+  bool SetTimestamp(const Timestamp& timestamp) {
+    Message<google_firestore_v1_Value>& result = StartValue();
+    result->which_value_type = google_firestore_v1_Value_timestamp_value_tag;
+    result->timestamp_value.seconds = timestamp.seconds();
+    result->timestamp_value.nanos = timestamp.nanoseconds();
+    return true;
+  }
+
+  void SetMap(Message<google_firestore_v1_MapValue> map) {
+    Message<google_firestore_v1_Value>& result = StartValue();
+    result->which_value_type = google_firestore_v1_Value_map_value_tag;
+    result->map_value = *map.release();
+  }
+
+  bool EndFields(Frame* frame) {
+    Message<google_firestore_v1_MapValue> map;
+    map->fields_count = nanopb::CheckedSize(frame->entries.size());
+    map->fields = nanopb::MakeArray<google_firestore_v1_MapValue_FieldsEntry>(
+        map->fields_count);
+    for (size_t i = 0; i < frame->entries.size(); ++i) {
+      map->fields[i] = *frame->entries[i].release();
+    }
+
+    if (Top().slot == Slot::kDocument) {
+      fields_ = std::move(map);
+    } else {
+      // The fields of a `mapValue`.
+      SetMap(std::move(map));
+    }
+    return true;
+  }
+
+  bool EndValue(Frame* frame) {
+    if (!frame->has_type) {
+      return Fail("Failed to decode value, no type is recognized");
+    }
+
+    Frame& parent = Top();
+    if (parent.slot == Slot::kArrayValues) {
+      parent.values.push_back(std::move(frame->value));
+    } else {
+      Message<google_firestore_v1_MapValue_FieldsEntry> entry;
+      entry->key = nanopb::MakeBytesArray(parent.key);
+      entry->value = *frame->value.release();
+      parent.entries.push_back(std::move(entry));
+    }
+    return true;
+  }
+
+  bool ParseTimestamp(const std::string& value,
+                      absl::optional<Timestamp>* timestamp) {
+    Timestamp result;
+    if (!ParseTimestamp(value, &result)) return false;
+    *timestamp = result;
+    return true;
+  }
+
+  bool ParseTimestamp(const std::string& value, Timestamp* timestamp) {
+    absl::Time time;
+    std::string err;
+    if (!absl::ParseTime(absl::RFC3339_full, value, &time, &err)) {
+      return Fail("Parsing timestamp failed with error: " + err);
+    }
+
+    StatusOr<Timestamp> decoded = TimestampInternal::FromUntrustedTime(time);
+    if (!decoded.ok()) return InvalidTimestamp(decoded);
+    *timestamp = decoded.ConsumeValueOrDie();
+    return true;
+  }
+
+  bool ParseDouble(const std::string& value, double* result) {
+    if (!absl::SimpleAtod(value, result)) {
+      return Fail("Failed to parse into double: " + value);
+    }
+    return true;
+  }
+
+  bool InvalidTimestamp(const StatusOr<Timestamp>& decoded) {
+    return Fail(
+        "Failed to decode json into valid protobuf Timestamp with error '" +
+        decoded.status().error_message() + "'");
+  }
+
+  bool MultipleTypes() {
+    return Fail("Failed to decode value, more than one type is set");
+  }
+
+  bool UnexpectedValue() {
+    switch (CurrentSlot()) {
+      case Slot::kBooleanValue:
+        return Fail("'booleanValue' is not encoded as a valid boolean");
+      case Slot::kName:
+        return Fail("Document name is not a string.");
+      default:
+        return Fail("Unexpected JSON value in bundled document");
+    }
+  }
+
+  bool Fail(const std::string& message) {
+    reader_.Fail(message);
+    return false;
+  }
+
+  const remote::Serializer& rpc_serializer_;
+  JsonReader& reader_;
+
+  std::vector<Frame> stack_;
+  int skip_depth_ = 0;
+  bool not_document_ = false;
+
+  bool has_document_ = false;
+  absl::optional<std::string> name_;
+  absl::optional<Timestamp> update_time_;
+  Message<google_firestore_v1_MapValue> fields_;
+};
+
+}  // namespace
+
+absl::optional<BundleDocument> BundleDocumentDecoder::Decode(
+    JsonReader& reader, absl::string_view element_json) const {
+  DocumentSaxHandler handler(rpc_serializer_, reader);
+  bool completed =
+      json::sax_parse(element_json.begin(), element_json.end(), &handler);
+  if (handler.not_document() || !reader.ok()) {
+    return absl::nullopt;
+  }
+
+  HARD_ASSERT(completed, "JSON parsing stopped without an error");
+  return handler.TakeDocument();
+}
+
+}  // namespace bundle
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,64 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_BUNDLE_BUNDLE_DOCUMENT_DECODER_H_
+#define FIRESTORE_CORE_SRC_BUNDLE_BUNDLE_DOCUMENT_DECODER_H_
+
+#include "Firestore/core/src/bundle/bundle_document.h"
+#include "Firestore/core/src/remote/serializer.h"
+#include "Firestore/core/src/util/json_reader.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+
+namespace firebase {
+namespace firestore {
+namespace bundle {
+
+/**
+ * Decodes `document` bundle elements straight from their JSON string into
+ * Nanopb protos.
+ *
+ * Unlike `BundleSerializer::DecodeDocument`, the decoder consumes the SAX
+ * events of the JSON parser and does not build an intermediate
+ * `nlohmann::json` DOM first, so the fields of a document are materialized
+ * only once. Documents make up the bulk of a bundle; all other elements are
+ * small and still decoded by `BundleSerializer`.
+ */
+class BundleDocumentDecoder {
+ public:
+  explicit BundleDocumentDecoder(const remote::Serializer& rpc_serializer)
+      : rpc_serializer_(rpc_serializer) {
+  }
+
+  /**
+   * Decodes the given bundle element if it is a document.
+   *
+   * Returns `nullopt` without failing `reader` if `element_json` is valid
+   * JSON but holds any other kind of element. If it holds a malformed
+   * document or is not valid JSON, fails `reader` and returns `nullopt`.
+   */
+  absl::optional<BundleDocument> Decode(util::JsonReader& reader,
+                                        absl::string_view element_json) const;
+
+ private:
+  const remote::Serializer& rpc_serializer_;
+};
+
+}  // namespace bundle
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_BUNDLE_BUNDLE_DOCUMENT_DECODER_H_
@@ -38,6 +38,7 @@ using firestore::api::LoadBundleTaskState;
 using model::DocumentKeySet;
 using model::DocumentMap;
 using model::MutableDocument;
+using model::MutableDocumentMap;
 using util::Status;
 using util::StatusOr;
 
@@ -62,6 +63,7 @@ Status BundleLoader::AddElementInternal(const BundleElement& element) {
             document_metadata.key(),
             MutableDocument::NoDocument(document_metadata.key(),
                                         document_metadata.read_time()));
+        loaded_documents_.insert(document_metadata.key());
         current_document_ = absl::nullopt;
       }
       break;
@@ -77,6 +79,7 @@ Status BundleLoader::AddElementInternal(const BundleElement& element) {
       }
 
       documents_ = documents_.insert(document.key(), document.document());
+      loaded_documents_.insert(document.key());
       current_document_ = absl::nullopt;
       break;
     }
@@ -95,7 +98,7 @@ StatusOr<absl::optional<LoadBundleTaskProgress>> BundleLoader::AddElement(
   HARD_ASSERT(element_ptr->element_type() != BundleElement::Type::Metadata,
               "Unexpected bundle metadata element.");
 
-  auto before_count = documents_.size();
+  auto before_count = loaded_documents_.size();
 
   auto result = AddElementInternal(*element_ptr);
   if (!result.ok()) {
@@ -105,16 +108,31 @@ StatusOr<absl::optional<LoadBundleTaskProgress>> BundleLoader::AddElement(
   bytes_loaded_ += byte_size;
 
   // Document has only been partially loaded, no progress to report.
-  if (before_count == documents_.size()) {
+  if (before_count == loaded_documents_.size()) {
     return {absl::nullopt};
   }
 
+  auto documents_loaded = static_cast<uint32_t>(loaded_documents_.size());
   LoadBundleTaskProgress progress{
-      documents_.size(), metadata_.total_documents(), bytes_loaded_,
+      documents_loaded, metadata_.total_documents(), bytes_loaded_,
       metadata_.total_bytes(), LoadBundleTaskState::kInProgress};
   return {absl::make_optional(std::move(progress))};
 }
 
+DocumentMap BundleLoader::ApplyDocumentChunk() {
+  if (!documents_applied_) {
+    // Documents retained for a previous load of the bundle are released
+    // before the first chunk, so that all chunks of this load accumulate.
+    callback_->ResetBundledDocuments(metadata_.bundle_id());
+    documents_applied_ = true;
+  }
+
+  auto changes =
+      callback_->ApplyBundledDocuments(documents_, metadata_.bundle_id());
+  documents_ = MutableDocumentMap{};
+  return changes;
+}
+
 StatusOr<DocumentMap> BundleLoader::ApplyChanges() {
   if (current_document_ != absl::nullopt) {
     return StatusOr<DocumentMap>(
@@ -122,14 +140,13 @@ StatusOr<DocumentMap> BundleLoader::ApplyChanges() {
                "Bundled documents end with a document metadata "
                "element instead of a document."));
   }
-  if (metadata_.total_documents() != documents_.size()) {
+  if (metadata_.total_documents() != loaded_documents_.size()) {
     return StatusOr<DocumentMap>(
         Status(Error::kErrorInvalidArgument,
                "Loaded documents count is not the same as in metadata."));
   }
 
-  auto changes =
-      callback_->ApplyBundledDocuments(documents_, metadata_.bundle_id());
+  auto changes = ApplyDocumentChunk();
   auto query_document_map = GetQueryDocumentMapping();
   for (const auto& named_query : queries_) {
     const auto& matching_keys = query_document_map[named_query.query_name()];
@@ -20,6 +20,7 @@
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -55,8 +56,19 @@ class BundleLoader {
   using AddElementResult =
       util::StatusOr<absl::optional<api::LoadBundleTaskProgress>>;
 
-  BundleLoader(BundleCallback* callback, BundleMetadata metadata)
-      : callback_(callback), metadata_(std::move(metadata)) {
+  /**
+   * The default number of documents applied to local store at a time. Large
+   * bundles are applied in chunks, such that only the documents of one chunk
+   * need to be held in memory.
+   */
+  static constexpr size_t kDefaultDocumentsPerChunk = 1000;
+
+  BundleLoader(BundleCallback* callback,
+               BundleMetadata metadata,
+               size_t documents_per_chunk = kDefaultDocumentsPerChunk)
+      : callback_(callback),
+        metadata_(std::move(metadata)),
+        documents_per_chunk_(documents_per_chunk) {
   }
 
   /**
@@ -69,9 +81,25 @@ class BundleLoader {
   AddElementResult AddElement(std::unique_ptr<BundleElement> element,
                               uint64_t byte_size);
 
+  /** Returns whether a full chunk of documents is ready to be applied. */
+  bool HasFullChunk() const {
+    return documents_.size() >= documents_per_chunk_;
+  }
+
   /**
-   * Applies the loaded documents and queries to local store. Returns the
-   * document view changes. If an error occurred, returns a not `ok()` status.
+   * Applies the documents that have been loaded since the last chunk was
+   * applied to local store, and returns the document view changes.
+   *
+   * Documents applied this way are visible to queries before the bundle has
+   * been loaded completely. If the bundle turns out to be invalid later on,
+   * the documents applied so far remain in local store.
+   */
+  model::DocumentMap ApplyDocumentChunk();
+
+  /**
+   * Applies the remaining documents and all queries to local store. Returns
+   * the document view changes of the remaining documents. If an error
+   * occurred, returns a not `ok()` status.
    */
   util::StatusOr<model::DocumentMap> ApplyChanges();
 
@@ -91,12 +119,19 @@ class BundleLoader {
 
   BundleCallback* callback_ = nullptr;
   BundleMetadata metadata_;
+  size_t documents_per_chunk_ = kDefaultDocumentsPerChunk;
   std::vector<NamedQuery> queries_;
   std::unordered_map<model::DocumentKey,
                      BundledDocumentMetadata,
                      model::DocumentKeyHash>
       documents_metadata_;
+
+  // The documents that have not been applied to local store yet.
   model::MutableDocumentMap documents_;
+  // The keys of all documents loaded so far, including applied ones.
+  std::unordered_set<model::DocumentKey, model::DocumentKeyHash>
+      loaded_documents_;
+  bool documents_applied_ = false;
 
   uint64_t bytes_loaded_ = 0;
   absl::optional<model::DocumentKey> current_document_;
@@ -17,7 +17,9 @@
 #include "Firestore/core/src/bundle/bundle_reader.h"
 
 #include <algorithm>
+#include <thread>  // NOLINT(build/c++11)
 
+#include "Firestore/core/src/util/background_queue.h"
 #include "absl/memory/memory.h"
 #include "absl/strings/numbers.h"
 #include "absl/strings/string_view.h"
@@ -27,7 +29,10 @@ namespace firestore {
 namespace bundle {
 
 using nlohmann::json;
+using util::BackgroundQueue;
 using util::ByteStream;
+using util::Executor;
+using util::JsonReader;
 using util::StreamReadResult;
 
 namespace {
@@ -44,6 +49,9 @@ BundleReader::BundleReader(BundleSerializer serializer,
     : serializer_(std::move(serializer)), input_(std::move(input)) {
 }
 
+// Out of line because of unique_ptrs to incomplete types.
+BundleReader::~BundleReader() = default;
+
 BundleMetadata BundleReader::GetBundleMetadata() {
   if (metadata_loaded_) {
     return metadata_;
@@ -67,33 +75,94 @@ std::unique_ptr<BundleElement> BundleReader::GetNextElement() {
   return ReadNextElement();
 }
 
+std::vector<BundleReader::SizedElement> BundleReader::GetNextElements(
+    size_t max_bytes) {
+  GetBundleMetadata();
+
+  std::vector<std::string> json_strings;
+  std::vector<SizedElement> elements;
+  size_t bytes = 0;
+  while (bytes < max_bytes) {
+    absl::optional<int64_t> byte_size = ReadNextElementToBuffer();
+    if (!byte_size.has_value()) {
+      break;
+    }
+
+    bytes += buffer_.size();
+    json_strings.push_back(std::move(buffer_));
+    buffer_.clear();
+    elements.push_back(SizedElement{nullptr, byte_size.value()});
+  }
+  if (!reader_status_.ok()) {
+    return {};
+  }
+
+  if (!executor_) {
+    auto hw_concurrency = std::thread::hardware_concurrency();
+    if (hw_concurrency == 0) {
+      // If the standard library doesn't know, guess something reasonable.
+      hw_concurrency = 4;
+    }
+    executor_ = Executor::CreateConcurrent(
+        "com.google.firebase.firestore.bundle",
+        static_cast<int>(hw_concurrency));
+  }
+
+  std::vector<JsonReader> readers(elements.size());
+  BackgroundQueue tasks(executor_.get());
+  for (size_t i = 0; i < elements.size(); ++i) {
+    tasks.Execute([this, &json_strings, &elements, &readers, i] {
+      elements[i].element = DecodeBundleElement(json_strings[i], readers[i]);
+    });
+  }
+  tasks.AwaitAll();
+
+  for (const JsonReader& reader : readers) {
+    reader_status_.Update(reader.status());
+  }
+  if (!reader_status_.ok()) {
+    return {};
+  }
+  return elements;
+}
+
 std::unique_ptr<BundleElement> BundleReader::ReadNextElement() {
+  if (!ReadNextElementToBuffer().has_value()) {
+    return nullptr;
+  }
+
+  auto result = DecodeBundleElement(buffer_, json_reader_);
+  reader_status_.Update(json_reader_.status());
+
+  return result;
+}
+
+absl::optional<int64_t> BundleReader::ReadNextElementToBuffer() {
   auto length_prefix = ReadLengthPrefix();
   if (!length_prefix.has_value()) {
-    return nullptr;
+    return absl::nullopt;
   }
 
   size_t prefix_value = 0;
   auto ok = absl::SimpleAtoi<size_t>(length_prefix.value(), &prefix_value);
   if (!ok) {
     Fail("Prefix string is not a valid number");
-    return nullptr;
+    return absl::nullopt;
   }
 
   buffer_.clear();
   ReadJsonToBuffer(prefix_value);
   if (!reader_status_.ok()) {
-    return nullptr;
+    return absl::nullopt;
   }
 
+  auto byte_size =
+      static_cast<int64_t>(length_prefix.value().size() + buffer_.size());
   // metadata's size does not count in `bytes_read_`.
   if (metadata_loaded_) {
-    bytes_read_ += length_prefix.value().size() + buffer_.size();
+    bytes_read_ += byte_size;
   }
-  auto result = DecodeBundleElementFromBuffer();
-  reader_status_.Update(json_reader_.status());
-
-  return result;
+  return byte_size;
 }
 
 absl::optional<std::string> BundleReader::ReadLengthPrefix() {
@@ -139,29 +208,40 @@ void BundleReader::ReadJsonToBuffer(size_t required_size) {
   }
 }
 
-std::unique_ptr<BundleElement> BundleReader::DecodeBundleElementFromBuffer() {
-  auto json_object = Parse(buffer_);
+std::unique_ptr<BundleElement> BundleReader::DecodeBundleElement(
+    const std::string& json_string, JsonReader& reader) const {
+  // Documents are decoded without building a DOM first, since they make up
+  // the bulk of a bundle.
+  absl::optional<BundleDocument> document =
+      serializer_.DecodeDocumentElement(reader, json_string);
+  if (document.has_value()) {
+    return absl::make_unique<BundleDocument>(std::move(document).value());
+  }
+  if (!reader.ok()) {
+    return nullptr;
+  }
+
+  auto json_object = Parse(json_string);
   if (json_object.is_discarded()) {
-    Fail("Failed to parse string into json");
+    reader.Fail("Failed to parse string into json");
     return nullptr;
   }
 
   if (json_object.contains("metadata")) {
-    return absl::make_unique<BundleMetadata>(serializer_.DecodeBundleMetadata(
-        json_reader_, json_object.at("metadata")));
+    return absl::make_unique<BundleMetadata>(
+        serializer_.DecodeBundleMetadata(reader, json_object.at("metadata")));
   } else if (json_object.contains("namedQuery")) {
-    auto q = serializer_.DecodeNamedQuery(json_reader_,
-                                          json_object.at("namedQuery"));
+    auto q = serializer_.DecodeNamedQuery(reader, json_object.at("namedQuery"));
     return absl::make_unique<NamedQuery>(std::move(q));
   } else if (json_object.contains("documentMetadata")) {
     return absl::make_unique<BundledDocumentMetadata>(
-        serializer_.DecodeDocumentMetadata(json_reader_,
+        serializer_.DecodeDocumentMetadata(reader,
                                            json_object.at("documentMetadata")));
   } else if (json_object.contains("document")) {
     return absl::make_unique<BundleDocument>(
-        serializer_.DecodeDocument(json_reader_, json_object.at("document")));
+        serializer_.DecodeDocument(reader, json_object.at("document")));
   } else {
-    Fail("Unrecognized BundleElement");
+    reader.Fail("Unrecognized BundleElement");
     return nullptr;
   }
 }
@@ -20,10 +20,12 @@
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "Firestore/core/src/bundle/bundle_metadata.h"
 #include "Firestore/core/src/bundle/bundle_serializer.h"
 #include "Firestore/core/src/util/byte_stream.h"
+#include "Firestore/core/src/util/executor.h"
 #include "Firestore/core/src/util/json_reader.h"
 #include "absl/types/optional.h"
 
@@ -39,9 +41,17 @@ namespace bundle {
  */
 class BundleReader {
  public:
+  /** A bundle element together with the number of bytes it occupied. */
+  struct SizedElement {
+    std::unique_ptr<BundleElement> element;
+    int64_t byte_size = 0;
+  };
+
   BundleReader(BundleSerializer serializer,
                std::unique_ptr<util::ByteStream> input);
 
+  ~BundleReader();
+
   /**
    * Returns the metadata element from the bundle.
    *
@@ -60,6 +70,21 @@ class BundleReader {
    */
   std::unique_ptr<BundleElement> GetNextElement();
 
+  /**
+   * Returns the next elements from the bundle, in bundle order. Elements are
+   * read until at least `max_bytes` of element data have been read or the
+   * bundle ends, and are then decoded concurrently.
+   *
+   * Reading stays sequential, but JSON parsing and decoding of the elements
+   * dominate the cost of loading large bundles and are independent of each
+   * other. `max_bytes` bounds the amount of undecoded data held in memory.
+   *
+   * When there are no more elements to return, an empty vector is returned.
+   * Check `reader_status()` to see if it is due to the completion of bundle,
+   * or an error. On error, no elements are returned.
+   */
+  std::vector<SizedElement> GetNextElements(size_t max_bytes);
+
   /** Returns whether this instance is in good state. */
   const util::Status& reader_status() const {
     return reader_status_;
@@ -88,6 +113,14 @@ class BundleReader {
    */
   std::unique_ptr<BundleElement> ReadNextElement();
 
+  /**
+   * Reads the JSON string of the next element into `buffer_` without decoding
+   * it. Returns the number of bytes the element occupied (including its length
+   * prefix), or `nullopt` if we have reached the end of the stream or an error
+   * occurred.
+   */
+  absl::optional<int64_t> ReadNextElementToBuffer();
+
   /**
    * Reads the length prefix string from bundle stream. Returns `nullopt` when
    * at the end of stream.
@@ -104,12 +137,15 @@ class BundleReader {
   void ReadJsonToBuffer(size_t required_size);
 
   /**
-   * Decodes internal `buffer_` into a `BundleElement`, returned as a unique_ptr
-   * pointing to the element. Returns nullptr if fails.
+   * Decodes the given JSON string into a `BundleElement`, returned as a
+   * unique_ptr pointing to the element. Returns nullptr and fails `reader` if
+   * decoding fails.
    *
-   * Note this method will leave `buffer_` unchanged.
+   * This method does not modify the state of the `BundleReader` and may be
+   * called concurrently with distinct `reader`s.
    */
-  std::unique_ptr<BundleElement> DecodeBundleElementFromBuffer();
+  std::unique_ptr<BundleElement> DecodeBundleElement(
+      const std::string& json_string, util::JsonReader& reader) const;
 
   BundleSerializer serializer_;
   util::JsonReader json_reader_;
@@ -117,6 +153,9 @@ class BundleReader {
   // Input stream holding bundle data.
   std::unique_ptr<util::ByteStream> input_;
 
+  // Decodes elements concurrently in `GetNextElements`; created on first use.
+  std::unique_ptr<util::Executor> executor_;
+
   // Cached bundle metadata.
   BundleMetadata metadata_;
   bool metadata_loaded_ = false;
@@ -19,6 +19,7 @@
 #include <memory>
 #include <vector>
 
+#include "Firestore/core/src/bundle/bundle_document_decoder.h"
 #include "Firestore/core/src/core/bound.h"
 #include "Firestore/core/src/core/direction.h"
 #include "Firestore/core/src/core/field_filter.h"
@@ -690,6 +691,11 @@ BundleDocument BundleSerializer::DecodeDocument(JsonReader& reader,
       ObjectValue::FromMapValue(std::move(map_value))));
 }
 
+absl::optional<BundleDocument> BundleSerializer::DecodeDocumentElement(
+    JsonReader& reader, absl::string_view element_json) const {
+  return BundleDocumentDecoder(rpc_serializer_).Decode(reader, element_json);
+}
+
 }  // namespace bundle
 }  // namespace firestore
 }  // namespace firebase
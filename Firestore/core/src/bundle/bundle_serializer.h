@@ -34,6 +34,8 @@
 #include "Firestore/core/src/util/json_reader.h"
 #include "Firestore/core/src/util/read_context.h"
 #include "Firestore/third_party/nlohmann_json/json.hpp"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
 
 namespace firebase {
 namespace firestore {
@@ -58,6 +60,16 @@ class BundleSerializer {
   BundleDocument DecodeDocument(util::JsonReader& reader,
                                 const nlohmann::json& document) const;
 
+  /**
+   * Decodes a complete bundle element from its JSON string if it is a
+   * document, without building a JSON DOM first. See `BundleDocumentDecoder`.
+   *
+   * Returns `nullopt` without failing `reader` if the element is not a
+   * document.
+   */
+  absl::optional<BundleDocument> DecodeDocumentElement(
+      util::JsonReader& reader, absl::string_view element_json) const;
+
  private:
   BundledQuery DecodeBundledQuery(util::JsonReader& reader,
                                   const nlohmann::json& query) const;
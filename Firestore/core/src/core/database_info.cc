@@ -25,11 +25,13 @@ namespace core {
 DatabaseInfo::DatabaseInfo(model::DatabaseId database_id,
                            std::string persistence_key,
                            std::string host,
-                           bool ssl_enabled)
+                           bool ssl_enabled,
+                           bool compression_enabled)
     : database_id_{std::move(database_id)},
       persistence_key_{std::move(persistence_key)},
       host_{std::move(host)},
-      ssl_enabled_{ssl_enabled} {
+      ssl_enabled_{ssl_enabled},
+      compression_enabled_{compression_enabled} {
 }
 
 }  // namespace core
@@ -36,11 +36,14 @@ class DatabaseInfo {
    *        storage. Usually derived from -[FIRApp appName].
    * @param host The hostname of the Firestore backend.
    * @param ssl_enabled Whether to use SSL when connecting.
+   * @param compression_enabled Whether streams compress the messages they
+   *        send.
    */
   DatabaseInfo(model::DatabaseId database_id,
                std::string persistence_key,
                std::string host,
-               bool ssl_enabled);
+               bool ssl_enabled,
+               bool compression_enabled = false);
 
   DatabaseInfo() = default;
 
@@ -60,11 +63,16 @@ class DatabaseInfo {
     return ssl_enabled_;
   }
 
+  bool compression_enabled() const {
+    return compression_enabled_;
+  }
+
  private:
   model::DatabaseId database_id_;
   std::string persistence_key_;
   std::string host_;
   bool ssl_enabled_ = false;
+  bool compression_enabled_ = false;
 };
 
 }  // namespace core
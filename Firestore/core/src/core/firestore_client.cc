@@ -41,6 +41,7 @@
 #include "Firestore/core/src/local/local_store.h"
 #include "Firestore/core/src/local/memory_lru_reference_delegate.h"
 #include "Firestore/core/src/local/memory_persistence.h"
+#include "Firestore/core/src/local/persistence_tracer.h"
 #include "Firestore/core/src/local/proto_sizer.h"
 #include "Firestore/core/src/local/query_engine.h"
 #include "Firestore/core/src/local/query_result.h"
@@ -83,6 +84,7 @@ using local::LevelDbOpener;
 using local::LocalStore;
 using local::LruParams;
 using local::MemoryPersistence;
+using local::PersistenceTracer;
 using local::QueryEngine;
 using local::QueryResult;
 using model::AggregateField;
@@ -112,6 +114,16 @@ namespace {
 
 static const size_t kMaxConcurrentLimboResolutions = 100;
 
+/** The number of threads that serve reads from the local cache. */
+static const int kLocalCacheReaderThreads = 4;
+
+/**
+ * Transaction reads made within this long of each other share a single
+ * `BatchGetDocuments` call of at most `kMaxLookupBatchSize` documents.
+ */
+static const auto kLookupBatchDelay = std::chrono::milliseconds(2);
+static const size_t kMaxLookupBatchSize = 100;
+
 static const auto kInitialGCDelay = std::chrono::minutes(1);
 static const auto kRegularGCDelay = std::chrono::minutes(5);
 
@@ -193,7 +205,8 @@ FirestoreClient::FirestoreClient(
       auth_credentials_provider_(std::move(auth_credentials_provider)),
       worker_queue_(std::move(worker_queue)),
       user_executor_(std::move(user_executor)),
-      firebase_metadata_provider_(std::move(firebase_metadata_provider)) {
+      firebase_metadata_provider_(std::move(firebase_metadata_provider)),
+      persistence_tracer_(absl::make_unique<PersistenceTracer>()) {
 }
 
 void FirestoreClient::Initialize(const User& user, const Settings& settings) {
@@ -217,6 +230,11 @@ void FirestoreClient::Initialize(const User& user, const Settings& settings) {
                 created.status().ToString());
 
     auto ldb = std::move(created).ValueOrDie();
+    ldb->SetFieldNameDictionaryEnabled(
+        settings.field_name_dictionary_enabled());
+    if (settings.group_commit_enabled()) {
+      ldb->EnableGroupCommit(settings.group_commit_durability());
+    }
     lru_delegate_ = ldb->reference_delegate();
 
     persistence_ = std::move(ldb);
@@ -241,14 +259,29 @@ void FirestoreClient::Initialize(const User& user, const Settings& settings) {
     persistence_ = MemoryPersistence::WithEagerGarbageCollector();
   }
 
+  persistence_->set_tracer(persistence_tracer_.get());
+  if (persistence_->SupportsConcurrentReads()) {
+    reader_executor_ = Executor::CreateConcurrent(
+        "com.google.firebase.firestore.reader", kLocalCacheReaderThreads);
+  }
+
   query_engine_ = absl::make_unique<QueryEngine>();
   local_store_ = absl::make_unique<LocalStore>(persistence_.get(),
                                                query_engine_.get(), user);
+  local_store_->SetResumeTokenCheckpointPolicy(
+      settings.resume_token_checkpoint_policy());
   connectivity_monitor_ = ConnectivityMonitor::Create(worker_queue_);
   auto datastore = std::make_shared<Datastore>(
       database_info_, worker_queue_, auth_credentials_provider_,
       app_check_credentials_provider_, connectivity_monitor_.get(),
       firebase_metadata_provider_.get());
+  datastore->EnableLookupBatching(kMaxLookupBatchSize, kLookupBatchDelay);
+  datastore->EnableBackgroundWatchDecoding();
+  if (settings.persistence_enabled()) {
+    // Only LevelDB stores the serialized documents; in memory they would
+    // just double the size of every cached document.
+    datastore->RetainEncodedWatchDocuments();
+  }
 
   remote_store_ = absl::make_unique<RemoteStore>(
       local_store_.get(), std::move(datastore), worker_queue_,
@@ -264,6 +297,7 @@ void FirestoreClient::Initialize(const User& user, const Settings& settings) {
 
   // Setup wiring for remote store.
   remote_store_->set_sync_engine(sync_engine_.get());
+  remote_store_->EnableExistenceFilterReconciliation(kMaxLookupBatchSize);
 
   // NOTE: RemoteStore depends on LocalStore (for persisting stream tokens,
   // refilling mutation queue, etc.) so must be started after LocalStore.
@@ -334,6 +368,12 @@ void FirestoreClient::TerminateInternal() {
   backfiller_callback_.Cancel();
 
   remote_store_->Shutdown();
+
+  // Wait for in-flight cache reads, which use the local store and persistence.
+  if (reader_executor_) {
+    reader_executor_->Dispose();
+    reader_executor_.reset();
+  }
   persistence_->Shutdown();
 
   local_store_.reset();
@@ -452,31 +492,35 @@ void FirestoreClient::GetDocumentFromLocalCache(
   // TODO(c++14): move `callback` into lambda.
   auto shared_callback = absl::ShareUniquePtr(std::move(callback));
   worker_queue_->Enqueue([this, doc, shared_callback] {
-    Document document = local_store_->ReadDocument(doc.key());
-    StatusOr<DocumentSnapshot> maybe_snapshot;
-
-    if (document->is_found_document()) {
-      maybe_snapshot = DocumentSnapshot::FromDocument(
-          doc.firestore(), document,
-          SnapshotMetadata{document->has_local_mutations(),
-                           /*from_cache=*/true});
-    } else if (document->is_no_document()) {
-      maybe_snapshot = DocumentSnapshot::FromNoDocument(
-          doc.firestore(), doc.key(),
-          SnapshotMetadata{/*pending_writes=*/false,
-                           /*from_cache=*/true});
-    } else {
-      maybe_snapshot =
-          Status{Error::kErrorUnavailable,
-                 "Failed to get document from cache. (However, this document "
-                 "may exist on the server. Run again without setting source to "
-                 "FirestoreSourceCache to attempt to retrieve the document "};
-    }
+    RunLocalCacheRead([this, doc, shared_callback] {
+      Document document =
+          reader_executor_ ? local_store_->ReadDocumentFromSnapshot(doc.key())
+                           : local_store_->ReadDocument(doc.key());
+      StatusOr<DocumentSnapshot> maybe_snapshot;
+
+      if (document->is_found_document()) {
+        maybe_snapshot = DocumentSnapshot::FromDocument(
+            doc.firestore(), document,
+            SnapshotMetadata{document->has_local_mutations(),
+                             /*from_cache=*/true});
+      } else if (document->is_no_document()) {
+        maybe_snapshot = DocumentSnapshot::FromNoDocument(
+            doc.firestore(), doc.key(),
+            SnapshotMetadata{/*pending_writes=*/false,
+                             /*from_cache=*/true});
+      } else {
+        maybe_snapshot = Status{
+            Error::kErrorUnavailable,
+            "Failed to get document from cache. (However, this document "
+            "may exist on the server. Run again without setting source to "
+            "FirestoreSourceCache to attempt to retrieve the document "};
+      }
 
-    if (shared_callback) {
-      user_executor_->Execute(
-          [=] { shared_callback->OnEvent(std::move(maybe_snapshot)); });
-    }
+      if (shared_callback) {
+        user_executor_->Execute(
+            [=] { shared_callback->OnEvent(std::move(maybe_snapshot)); });
+      }
+    });
   });
 }
 
@@ -487,33 +531,48 @@ void FirestoreClient::GetDocumentsFromLocalCache(
   // TODO(c++14): move `callback` into lambda.
   auto shared_callback = absl::ShareUniquePtr(std::move(callback));
   worker_queue_->Enqueue([this, query, shared_callback] {
-    QueryResult query_result = local_store_->ExecuteQuery(
-        query.query(), /* use_previous_results= */ true);
-
-    View view(query.query(), query_result.remote_keys());
-    ViewDocumentChanges view_doc_changes =
-        view.ComputeDocumentChanges(query_result.documents());
-    ViewChange view_change = view.ApplyChanges(view_doc_changes);
-    HARD_ASSERT(
-        view_change.limbo_changes().empty(),
-        "View returned limbo documents during local-only query execution.");
-
-    HARD_ASSERT(view_change.snapshot().has_value(), "Expected a snapshot");
-
-    ViewSnapshot snapshot = std::move(view_change.snapshot()).value();
-    SnapshotMetadata metadata(snapshot.has_pending_writes(),
-                              snapshot.from_cache());
-
-    QuerySnapshot result(query.firestore(), query.query(), std::move(snapshot),
-                         std::move(metadata));
-
-    if (shared_callback) {
-      user_executor_->Execute(
-          [=] { shared_callback->OnEvent(std::move(result)); });
-    }
+    RunLocalCacheRead([this, query, shared_callback] {
+      QueryResult query_result =
+          reader_executor_
+              ? local_store_->ExecuteQueryFromSnapshot(query.query())
+              : local_store_->ExecuteQuery(query.query(),
+                                           /* use_previous_results= */ true);
+
+      View view(query.query(), query_result.remote_keys());
+      ViewDocumentChanges view_doc_changes =
+          view.ComputeDocumentChanges(query_result.documents());
+      ViewChange view_change = view.ApplyChanges(view_doc_changes);
+      HARD_ASSERT(
+          view_change.limbo_changes().empty(),
+          "View returned limbo documents during local-only query execution.");
+
+      HARD_ASSERT(view_change.snapshot().has_value(), "Expected a snapshot");
+
+      ViewSnapshot snapshot = std::move(view_change.snapshot()).value();
+      SnapshotMetadata metadata(snapshot.has_pending_writes(),
+                                snapshot.from_cache());
+
+      QuerySnapshot result(query.firestore(), query.query(),
+                           std::move(snapshot), std::move(metadata));
+
+      if (shared_callback) {
+        user_executor_->Execute(
+            [=] { shared_callback->OnEvent(std::move(result)); });
+      }
+    });
   });
 }
 
+void FirestoreClient::RunLocalCacheRead(std::function<void()> read) {
+  if (reader_executor_) {
+    // Writes enqueued before this read have already committed, so the
+    // snapshot taken by the reader thread observes them.
+    reader_executor_->Execute(std::move(read));
+  } else {
+    read();
+  }
+}
+
 void FirestoreClient::WriteMutations(std::vector<Mutation>&& mutations,
                                      StatusCallback callback) {
   VerifyNotTerminated();
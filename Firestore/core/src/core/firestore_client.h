@@ -17,6 +17,7 @@
 #ifndef FIRESTORE_CORE_SRC_CORE_FIRESTORE_CLIENT_H_
 #define FIRESTORE_CORE_SRC_CORE_FIRESTORE_CLIENT_H_
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
@@ -43,6 +44,7 @@ namespace local {
 class LocalStore;
 class LruDelegate;
 class Persistence;
+class PersistenceTracer;
 class QueryEngine;
 }  // namespace local
 
@@ -196,6 +198,15 @@ class FirestoreClient : public std::enable_shared_from_this<FirestoreClient> {
 
   void GetNamedQuery(const std::string& name, api::QueryCallback callback);
 
+  /**
+   * Records the latency and work of every persistence transaction once
+   * enabled; disabled initially. Thread-safe, and lives as long as this
+   * client.
+   */
+  local::PersistenceTracer& persistence_tracer() const {
+    return *persistence_tracer_;
+  }
+
   /** For usage in this class and testing only. */
   const std::shared_ptr<util::AsyncQueue>& worker_queue() const {
     return worker_queue_;
@@ -231,6 +242,13 @@ class FirestoreClient : public std::enable_shared_from_this<FirestoreClient> {
    */
   void ScheduleIndexBackfiller();
 
+  /**
+   * Runs a read from the local cache, either on `reader_executor_` or, if
+   * there is none, inline on the worker queue. Must be called on the worker
+   * queue.
+   */
+  void RunLocalCacheRead(std::function<void()> read);
+
   DatabaseInfo database_info_;
   std::shared_ptr<credentials::AppCheckCredentialsProvider>
       app_check_credentials_provider_;
@@ -248,6 +266,14 @@ class FirestoreClient : public std::enable_shared_from_this<FirestoreClient> {
 
   std::unique_ptr<remote::FirebaseMetadataProvider> firebase_metadata_provider_;
 
+  /**
+   * Serves reads from the local cache off the worker queue when the
+   * persistence layer supports concurrent reads; null otherwise.
+   */
+  std::unique_ptr<util::Executor> reader_executor_;
+
+  // Declared before `persistence_`, which refers to it.
+  std::unique_ptr<local::PersistenceTracer> persistence_tracer_;
   std::unique_ptr<local::Persistence> persistence_;
   std::unique_ptr<local::LocalStore> local_store_;
   std::unique_ptr<local::QueryEngine> query_engine_;
@@ -232,6 +232,12 @@ class Query {
   /** Returns true if the document matches the constraints of this query. */
   bool Matches(const model::Document& doc) const;
 
+  /**
+   * Returns true if the document is in the collection (or collection group)
+   * this query targets, ignoring filters, order-bys and bounds.
+   */
+  bool MatchesPathAndCollectionGroup(const model::Document& doc) const;
+
   /**
    * Returns a comparator that will sort documents according to the order by
    * clauses in this query.
@@ -262,7 +268,6 @@ class Query {
   size_t Hash() const;
 
  private:
-  bool MatchesPathAndCollectionGroup(const model::Document& doc) const;
   bool MatchesFilters(const model::Document& doc) const;
   bool MatchesOrderBy(const model::Document& doc) const;
   bool MatchesBounds(const model::Document& doc) const;
@@ -60,6 +60,7 @@ using local::TargetData;
 using model::AggregateField;
 using model::BatchId;
 using model::DocumentKey;
+using model::DocumentKeyHashSet;
 using model::DocumentKeySet;
 using model::DocumentMap;
 using model::DocumentUpdateMap;
@@ -78,6 +79,10 @@ using util::StatusCallback;
 // them don't need real sequence numbers.
 const ListenSequenceNumber kIrrelevantSequenceNumber = -1;
 
+// The amount of bundle data read before the elements read so far are decoded
+// concurrently. Bounds the undecoded bundle data held in memory.
+const size_t kMaxBundleBytesPerBatch = 4 * 1024 * 1024;
+
 bool ErrorIsInteresting(const Status& error) {
   bool missing_index =
       (error.code() == Error::kErrorFailedPrecondition &&
@@ -444,13 +449,13 @@ void SyncEngine::HandleOnlineStateChange(model::OnlineState online_state) {
   sync_engine_callback_->HandleOnlineStateChange(online_state);
 }
 
-DocumentKeySet SyncEngine::GetRemoteKeys(TargetId target_id) const {
+DocumentKeyHashSet SyncEngine::GetRemoteKeys(TargetId target_id) const {
   auto it = active_limbo_resolutions_by_target_.find(target_id);
   if (it != active_limbo_resolutions_by_target_.end() &&
       it->second.document_received) {
-    return DocumentKeySet{it->second.key};
+    return DocumentKeyHashSet{it->second.key};
   } else {
-    DocumentKeySet keys;
+    DocumentKeyHashSet keys;
     if (queries_by_target_.count(target_id) == 0) {
       return keys;
     }
@@ -628,36 +633,40 @@ absl::optional<BundleLoader> SyncEngine::ReadIntoLoader(
     bundle::BundleReader& reader,
     api::LoadBundleTask& result_task) {
   BundleLoader loader(local_store_, metadata);
-  int64_t current_bytes_read = 0;
   // Breaks when either error happened, or when there is no more element to
   // read.
   while (true) {
-    auto element = reader.GetNextElement();
+    auto elements = reader.GetNextElements(kMaxBundleBytesPerBatch);
     if (!reader.reader_status().ok()) {
-      LOG_WARN("Failed to GetNextElement() from bundle with error %s",
+      LOG_WARN("Failed to GetNextElements() from bundle with error %s",
                reader.reader_status().error_message());
       result_task.SetError(reader.reader_status());
       return absl::nullopt;
     }
 
     // No more elements from reader.
-    if (element == nullptr) {
+    if (elements.empty()) {
       break;
     }
 
-    int64_t old_bytes_read = current_bytes_read;
-    current_bytes_read = reader.bytes_read();
-    auto maybe_progress = loader.AddElement(
-        std::move(element), current_bytes_read - old_bytes_read);
-    if (!maybe_progress.ok()) {
-      LOG_WARN("Failed to AddElement() to bundle loader with error %s",
-               maybe_progress.status().error_message());
-      result_task.SetError(maybe_progress.status());
-      return absl::nullopt;
-    }
+    for (auto& sized_element : elements) {
+      auto maybe_progress = loader.AddElement(
+          std::move(sized_element.element), sized_element.byte_size);
+      if (!maybe_progress.ok()) {
+        LOG_WARN("Failed to AddElement() to bundle loader with error %s",
+                 maybe_progress.status().error_message());
+        result_task.SetError(maybe_progress.status());
+        return absl::nullopt;
+      }
 
-    if (maybe_progress.ValueOrDie().has_value()) {
-      result_task.UpdateProgress(maybe_progress.ConsumeValueOrDie().value());
+      if (loader.HasFullChunk()) {
+        EmitNewSnapshotsAndNotifyLocalStore(loader.ApplyDocumentChunk(),
+                                            absl::nullopt);
+      }
+
+      if (maybe_progress.ValueOrDie().has_value()) {
+        result_task.UpdateProgress(maybe_progress.ConsumeValueOrDie().value());
+      }
     }
   }
 
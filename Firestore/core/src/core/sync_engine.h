@@ -180,7 +180,8 @@ class SyncEngine : public remote::RemoteStoreCallback, public QueryEventSource {
   void HandleRejectedWrite(model::BatchId batch_id,
                            util::Status error) override;
   void HandleOnlineStateChange(model::OnlineState online_state) override;
-  model::DocumentKeySet GetRemoteKeys(model::TargetId target_id) const override;
+  model::DocumentKeyHashSet GetRemoteKeys(
+      model::TargetId target_id) const override;
 
   void LoadBundle(std::shared_ptr<bundle::BundleReader> reader,
                   std::shared_ptr<api::LoadBundleTask> result_task);
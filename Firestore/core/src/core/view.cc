@@ -16,17 +16,22 @@
 
 #include "Firestore/core/src/core/view.h"
 
+#include <algorithm>
 #include <utility>
+#include <vector>
 
 #include "Firestore/core/src/core/target.h"
 #include "Firestore/core/src/model/document_set.h"
+#include "Firestore/core/src/util/hard_assert.h"
 
 namespace firebase {
 namespace firestore {
 namespace core {
 
 using model::Document;
+using model::DocumentComparator;
 using model::DocumentKey;
+using model::DocumentKeyHashSet;
 using model::DocumentKeySet;
 using model::DocumentMap;
 using model::DocumentSet;
@@ -80,12 +85,153 @@ int GetDocumentViewChangeTypePosition(DocumentViewChange::Type change_type) {
   HARD_FAIL("Unknown DocumentViewChange::Type %s", change_type);
 }
 
+/**
+ * Counts the elements present at the positions of a fixed sequence, as
+ * elements are added and removed. Both operations and counting the elements
+ * before a position take O(log n) (this is a Fenwick tree).
+ */
+class PositionCounter {
+ public:
+  explicit PositionCounter(size_t size) : counts_(size + 1) {
+  }
+
+  void Add(size_t position, int delta) {
+    for (size_t i = position + 1; i < counts_.size(); i += LowestBit(i)) {
+      counts_[i] += delta;
+    }
+  }
+
+  /** Returns the number of elements present before `position`. */
+  size_t CountBefore(size_t position) const {
+    int result = 0;
+    for (size_t i = position; i > 0; i -= LowestBit(i)) {
+      result += counts_[i];
+    }
+    return static_cast<size_t>(result);
+  }
+
+ private:
+  static size_t LowestBit(size_t i) {
+    return i & (~i + 1);
+  }
+
+  std::vector<int> counts_;
+};
+
+/**
+ * Returns the given changes with the old and new index of every change,
+ * assuming that the changes are applied one by one, in order, to
+ * `old_documents` to end up with `new_documents`.
+ *
+ * Unchanged documents keep their relative order, so the index of a document at
+ * any point is the number of unchanged documents before it, which follows from
+ * its position in `old_documents` or `new_documents`, plus the number of
+ * changed documents before it at that point. Only the latter has to be tracked
+ * while the changes are applied, and only over the changed documents.
+ */
+std::vector<DocumentViewChange> WithChangeIndices(
+    const std::vector<DocumentViewChange>& changes,
+    const DocumentSet& old_documents,
+    const DocumentSet& new_documents) {
+  // The versions of all changed documents: the one in `old_documents` for
+  // removed and modified documents, and the one in `new_documents` for added
+  // and modified documents.
+  struct Version {
+    Document document;
+    bool is_old;
+    size_t change;
+  };
+  std::vector<Version> versions;
+  versions.reserve(changes.size() * 2);
+  for (size_t i = 0; i < changes.size(); ++i) {
+    const DocumentViewChange& change = changes[i];
+    if (change.type() != DocumentViewChange::Type::Added) {
+      absl::optional<Document> old_document =
+          old_documents.GetDocument(change.document()->key());
+      HARD_ASSERT(old_document, "Index for document not found");
+      versions.push_back({std::move(*old_document), true, i});
+    }
+    if (change.type() != DocumentViewChange::Type::Removed) {
+      versions.push_back({change.document(), false, i});
+    }
+  }
+
+  const DocumentComparator& comparator = new_documents.comparator();
+  std::sort(versions.begin(), versions.end(),
+            [&](const Version& lhs, const Version& rhs) {
+              return util::Ascending(
+                  comparator.Compare(lhs.document, rhs.document));
+            });
+
+  // For every version, the number of unchanged documents before it and the
+  // first position of the versions that compare equal to it. Only the two
+  // versions of a modified document can compare equal.
+  std::vector<size_t> unchanged_before(versions.size());
+  std::vector<size_t> first_equal(versions.size());
+  std::vector<size_t> old_position(changes.size(), DocumentSet::npos);
+  std::vector<size_t> new_position(changes.size(), DocumentSet::npos);
+  size_t old_versions = 0;
+  size_t new_versions = 0;
+  size_t old_versions_before = 0;
+  size_t new_versions_before = 0;
+  for (size_t i = 0; i < versions.size(); ++i) {
+    const Version& version = versions[i];
+    if (i == 0 || !util::Same(comparator.Compare(versions[i - 1].document,
+                                                 version.document))) {
+      first_equal[i] = i;
+      old_versions_before = old_versions;
+      new_versions_before = new_versions;
+    } else {
+      first_equal[i] = first_equal[i - 1];
+    }
+
+    const DocumentKey& key = version.document->key();
+    if (version.is_old) {
+      unchanged_before[i] = old_documents.IndexOf(key) - old_versions_before;
+      old_position[version.change] = i;
+      ++old_versions;
+    } else {
+      unchanged_before[i] = new_documents.IndexOf(key) - new_versions_before;
+      new_position[version.change] = i;
+      ++new_versions;
+    }
+  }
+
+  // Initially, all old versions are present.
+  PositionCounter present(versions.size());
+  for (size_t i = 0; i < versions.size(); ++i) {
+    if (versions[i].is_old) present.Add(i, 1);
+  }
+  auto index_at = [&](size_t position) {
+    return unchanged_before[position] +
+           present.CountBefore(first_equal[position]);
+  };
+
+  std::vector<DocumentViewChange> result;
+  result.reserve(changes.size());
+  for (size_t i = 0; i < changes.size(); ++i) {
+    size_t old_index = DocumentSet::npos;
+    size_t new_index = DocumentSet::npos;
+    if (old_position[i] != DocumentSet::npos) {
+      old_index = index_at(old_position[i]);
+      present.Add(old_position[i], -1);
+    }
+    if (new_position[i] != DocumentSet::npos) {
+      present.Add(new_position[i], 1);
+      new_index = index_at(new_position[i]);
+    }
+    result.emplace_back(changes[i].document(), changes[i].type(), old_index,
+                        new_index);
+  }
+  return result;
+}
+
 }  // namespace
 
 View::View(Query query, DocumentKeySet remote_documents)
     : query_(std::move(query)),
       document_set_(query_.Comparator()),
-      synced_documents_(std::move(remote_documents)) {
+      synced_documents_(DocumentKeyHashSet::FromKeysOf(remote_documents)) {
 }
 
 ComparisonResult View::Compare(const Document& lhs, const Document& rhs) const {
@@ -269,6 +415,7 @@ ViewChange View::ApplyChanges(const ViewDocumentChanges& doc_changes,
         }
         return util::Ascending(Compare(lhs.document(), rhs.document()));
       });
+  changes = WithChangeIndices(changes, old_documents, document_set_);
 
   ApplyTargetChange(target_change);
   std::vector<LimboDocumentChange> limbo_changes =
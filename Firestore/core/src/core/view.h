@@ -141,7 +141,7 @@ class View {
    * The set of remote documents that the server has told us belongs to the
    * target associated with this view.
    */
-  const model::DocumentKeySet& synced_documents() const {
+  const model::DocumentKeyHashSet& synced_documents() const {
     return synced_documents_;
   }
 
@@ -206,8 +206,11 @@ class View {
 
   model::DocumentSet document_set_;
 
-  /** Documents included in the remote target. */
-  model::DocumentKeySet synced_documents_;
+  /**
+   * Documents included in the remote target. This is only used for membership
+   * checks, so it need not be ordered.
+   */
+  model::DocumentKeyHashSet synced_documents_;
 
   /** Documents in the view but not in the remote target */
   model::DocumentKeySet limbo_documents_;
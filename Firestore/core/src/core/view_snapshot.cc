@@ -39,6 +39,17 @@ DocumentViewChange::DocumentViewChange(Document document, Type type)
     : document_{std::move(document)}, type_{type} {
 }
 
+DocumentViewChange::DocumentViewChange(Document document,
+                                       Type type,
+                                       size_t old_index,
+                                       size_t new_index)
+    : document_{std::move(document)},
+      type_{type},
+      has_indices_{true},
+      old_index_{old_index},
+      new_index_{new_index} {
+}
+
 const Document& DocumentViewChange::document() const {
   return document_;
 }
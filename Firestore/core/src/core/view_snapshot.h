@@ -51,17 +51,51 @@ class DocumentViewChange {
 
   DocumentViewChange(model::Document document, Type type);
 
+  /**
+   * Creates a change that also records where the document was and is in the
+   * query results, as computed by `View`. Indices refer to the results with
+   * all preceding changes of the snapshot applied.
+   */
+  DocumentViewChange(model::Document document,
+                     Type type,
+                     size_t old_index,
+                     size_t new_index);
+
   const model::Document& document() const;
   DocumentViewChange::Type type() const {
     return type_;
   }
 
+  /** Whether this change carries its old and new indices. */
+  bool has_indices() const {
+    return has_indices_;
+  }
+
+  /**
+   * The index of the document before this change, or `DocumentSet::npos` if
+   * it was added. Only meaningful if `has_indices()`.
+   */
+  size_t old_index() const {
+    return old_index_;
+  }
+
+  /**
+   * The index of the document after this change, or `DocumentSet::npos` if
+   * it was removed. Only meaningful if `has_indices()`.
+   */
+  size_t new_index() const {
+    return new_index_;
+  }
+
   std::string ToString() const;
   size_t Hash() const;
 
  private:
   model::Document document_;
   Type type_{};
+  bool has_indices_ = false;
+  size_t old_index_ = model::DocumentSet::npos;
+  size_t new_index_ = model::DocumentSet::npos;
 };
 
 bool operator==(const DocumentViewChange& lhs, const DocumentViewChange& rhs);
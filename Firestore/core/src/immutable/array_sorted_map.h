@@ -152,6 +152,21 @@ class ArraySortedMap : public SortedMapBase {
       : array_{SortedArray(entries, comparator)}, comparator_{comparator} {
   }
 
+  /**
+   * Creates an ArraySortedMap containing the entries in [begin, end), which
+   * must already be sorted by key and contain no more than kFixedSize entries.
+   */
+  template <typename Iterator>
+  static ArraySortedMap FromSortedRange(Iterator begin,
+                                        Iterator end,
+                                        const C& comparator) {
+    if (begin == end) {
+      return ArraySortedMap{comparator};
+    }
+    return ArraySortedMap{std::make_shared<const array_type>(begin, end),
+                          comparator};
+  }
+
   /** Returns true if the map contains no elements. */
   bool empty() const {
     return size() == 0;
@@ -255,6 +270,17 @@ class ArraySortedMap : public SortedMapBase {
     return found == end() ? npos : static_cast<size_type>(found - begin());
   }
 
+  /**
+   * Returns the entry at the given index in the map.
+   *
+   * @param index The index of the entry, which must be less than size().
+   */
+  const value_type& at(size_type index) const {
+    HARD_ASSERT(index < size(), "Index %s out of bounds for size %s", index,
+                size());
+    return begin()[index];
+  }
+
   /**
    * Finds the first entry in the map containing a key greater than or equal
    * to the given key.
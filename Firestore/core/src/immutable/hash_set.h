@@ -0,0 +1,507 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_IMMUTABLE_HASH_SET_H_
+#define FIRESTORE_CORE_SRC_IMMUTABLE_HASH_SET_H_
+
+#include <bitset>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/immutable/sorted_container.h"
+#include "absl/base/attributes.h"
+
+namespace firebase {
+namespace firestore {
+namespace immutable {
+
+/**
+ * HashSet is an immutable, unordered set. Like SortedSet, it has methods to
+ * efficiently create new sets that are mutations of it, sharing most of their
+ * structure with the original.
+ *
+ * HashSet is a hash array mapped trie (in the compressed "CHAMP" layout):
+ * each level of the trie consumes five bits of the hash of a key and holds up
+ * to 32 keys or subtries. Lookups take O(log32 n) steps and compare only keys
+ * with equal hashes, and inserting or erasing copies only the nodes on the
+ * path to the key. Unlike SortedSet, iteration order is unspecified, so use
+ * HashSet where only membership matters.
+ *
+ * @tparam H A stateless hash function for K.
+ * @tparam E A stateless equality predicate for K.
+ */
+template <typename K, typename H = std::hash<K>, typename E = std::equal_to<K>>
+class HashSet : public SortedContainer {
+ private:
+  struct Node;
+  using NodePtr = std::shared_ptr<const Node>;
+
+ public:
+  using value_type = K;
+
+  /** A forward iterator over the keys of a HashSet, in unspecified order. */
+  class const_iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = K;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const K*;
+    using reference = const K&;
+
+    const_iterator() = default;
+
+    reference operator*() const {
+      const Frame& frame = stack_.back();
+      return frame.node->entries[frame.entry].key;
+    }
+
+    pointer operator->() const {
+      return &**this;
+    }
+
+    const_iterator& operator++() {
+      ++stack_.back().entry;
+      SkipExhaustedNodes();
+      return *this;
+    }
+
+    const_iterator operator++(int) {
+      const_iterator result = *this;
+      ++*this;
+      return result;
+    }
+
+    friend bool operator==(const const_iterator& lhs,
+                           const const_iterator& rhs) {
+      if (lhs.stack_.empty() || rhs.stack_.empty()) {
+        return lhs.stack_.empty() == rhs.stack_.empty();
+      }
+      return lhs.stack_.back().node == rhs.stack_.back().node &&
+             lhs.stack_.back().entry == rhs.stack_.back().entry;
+    }
+
+    friend bool operator!=(const const_iterator& lhs,
+                           const const_iterator& rhs) {
+      return !(lhs == rhs);
+    }
+
+   private:
+    friend class HashSet;
+
+    struct Frame {
+      const Node* node;
+      size_t entry;
+      size_t child;
+    };
+
+    explicit const_iterator(const Node* root) {
+      stack_.push_back(Frame{root, 0, 0});
+      SkipExhaustedNodes();
+    }
+
+    /**
+     * Moves to the next node with keys left to visit if the current one has
+     * none, descending into subtries before moving on to siblings.
+     */
+    void SkipExhaustedNodes() {
+      while (!stack_.empty()) {
+        Frame& frame = stack_.back();
+        if (frame.entry < frame.node->entries.size()) {
+          return;
+        }
+        if (frame.child < frame.node->children.size()) {
+          const Node* child = frame.node->children[frame.child++].get();
+          stack_.push_back(Frame{child, 0, 0});
+        } else {
+          stack_.pop_back();
+        }
+      }
+    }
+
+    std::vector<Frame> stack_;
+  };
+
+  /** Creates an empty HashSet. */
+  HashSet() : root_{EmptyNode()} {
+  }
+
+  HashSet(std::initializer_list<K> keys) : HashSet{} {
+    for (const K& key : keys) {
+      *this = insert(key);
+    }
+  }
+
+  bool empty() const {
+    return size_ == 0;
+  }
+
+  size_type size() const {
+    return size_;
+  }
+
+  bool contains(const K& key) const {
+    size_t hash = H{}(key);
+    const Node* node = root_.get();
+    for (size_t shift = 0; shift < kHashBits; shift += kBitsPerLevel) {
+      uint32_t bit = BitFor(hash, shift);
+      if (node->data_map & bit) {
+        return Matches(node->entries[IndexOf(node->data_map, bit)], hash, key);
+      } else if (node->node_map & bit) {
+        node = node->children[IndexOf(node->node_map, bit)].get();
+      } else {
+        return false;
+      }
+    }
+
+    // All bits of the hash have been consumed: this is a collision node.
+    for (const Entry& entry : node->entries) {
+      if (E{}(entry.key, key)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * Finds the given key in the set, returning an iterator positioned at it, or
+   * end() if the key is not present.
+   */
+  const_iterator find(const K& key) const {
+    size_t hash = H{}(key);
+    const_iterator result;
+    const Node* node = root_.get();
+    for (size_t shift = 0; shift < kHashBits; shift += kBitsPerLevel) {
+      uint32_t bit = BitFor(hash, shift);
+      if (node->data_map & bit) {
+        size_t index = IndexOf(node->data_map, bit);
+        if (!Matches(node->entries[index], hash, key)) {
+          return end();
+        }
+        result.stack_.push_back({node, index, 0});
+        return result;
+      } else if (node->node_map & bit) {
+        // Iteration resumes with the next child once this one is exhausted.
+        size_t index = IndexOf(node->node_map, bit);
+        result.stack_.push_back({node, node->entries.size(), index + 1});
+        node = node->children[index].get();
+      } else {
+        return end();
+      }
+    }
+
+    for (size_t i = 0; i < node->entries.size(); ++i) {
+      if (E{}(node->entries[i].key, key)) {
+        result.stack_.push_back({node, i, 0});
+        return result;
+      }
+    }
+    return end();
+  }
+
+  /** Returns a set identical to this one, but with `key` added to it. */
+  ABSL_MUST_USE_RESULT HashSet insert(const K& key) const {
+    Entry entry{H{}(key), key};
+    bool added = false;
+    NodePtr new_root = Insert(*root_, std::move(entry), 0, &added);
+    if (!new_root) {
+      return *this;
+    }
+    return HashSet{std::move(new_root), size_ + (added ? 1 : 0)};
+  }
+
+  /** Returns a set identical to this one, but with `key` removed from it. */
+  ABSL_MUST_USE_RESULT HashSet erase(const K& key) const {
+    NodePtr new_root;
+    if (!Erase(*root_, key, H{}(key), 0, &new_root)) {
+      return *this;
+    }
+    return HashSet{std::move(new_root), size_ - 1};
+  }
+
+  /** Returns a set containing all keys of this set and `other`. */
+  ABSL_MUST_USE_RESULT HashSet union_with(const HashSet& other) const {
+    const HashSet* result_ptr = this;
+    const HashSet* other_ptr = &other;
+
+    // Insert the keys of the smaller set into the larger one.
+    if (result_ptr->size() < other_ptr->size()) {
+      std::swap(result_ptr, other_ptr);
+    }
+    if (result_ptr->root_ == other_ptr->root_) {
+      return *result_ptr;
+    }
+
+    HashSet result = *result_ptr;
+    for (const K& key : *other_ptr) {
+      result = result.insert(key);
+    }
+    return result;
+  }
+
+  /** Creates a HashSet containing all keys of the given container. */
+  template <typename Container>
+  static HashSet FromKeysOf(const Container& container) {
+    HashSet result;
+    for (const K& key : container) {
+      result = result.insert(key);
+    }
+    return result;
+  }
+
+  const_iterator begin() const {
+    return empty() ? const_iterator{} : const_iterator{root_.get()};
+  }
+
+  const_iterator end() const {
+    return const_iterator{};
+  }
+
+  friend bool operator==(const HashSet& lhs, const HashSet& rhs) {
+    if (lhs.size() != rhs.size()) {
+      return false;
+    }
+    if (lhs.root_ == rhs.root_) {
+      return true;
+    }
+    for (const K& key : lhs) {
+      if (!rhs.contains(key)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  friend bool operator!=(const HashSet& lhs, const HashSet& rhs) {
+    return !(lhs == rhs);
+  }
+
+ private:
+  static constexpr size_t kBitsPerLevel = 5;
+  static constexpr size_t kHashBits = sizeof(size_t) * CHAR_BIT;
+
+  struct Entry {
+    size_t hash;
+    K key;
+  };
+
+  /**
+   * A node of the trie. Each of the 32 slots of a node is either empty, holds
+   * a key (if its bit is set in `data_map`) or holds a subtrie (if its bit is
+   * set in `node_map`). Only occupied slots are stored, in slot order.
+   *
+   * Erasing keeps the trie canonical: a subtrie always holds at least two
+   * keys, so equal sets have equal shapes.
+   *
+   * Nodes below the last level of hash bits are collision nodes, which store
+   * keys with identical hashes in `entries` and don't use the maps.
+   */
+  struct Node {
+    uint32_t data_map = 0;
+    uint32_t node_map = 0;
+    std::vector<Entry> entries;
+    std::vector<NodePtr> children;
+  };
+
+  HashSet(NodePtr root, size_type size) : root_{std::move(root)}, size_{size} {
+  }
+
+  static const NodePtr& EmptyNode() {
+    static const NodePtr* empty = new NodePtr{std::make_shared<Node>()};
+    return *empty;
+  }
+
+  static uint32_t BitFor(size_t hash, size_t shift) {
+    return uint32_t{1} << ((hash >> shift) & 0x1f);
+  }
+
+  /** Returns the position of the slot for `bit` among the occupied ones. */
+  static size_t IndexOf(uint32_t map, uint32_t bit) {
+    return std::bitset<32>(map & (bit - 1)).count();
+  }
+
+  static bool Matches(const Entry& entry, size_t hash, const K& key) {
+    return entry.hash == hash && E{}(entry.key, key);
+  }
+
+  /**
+   * Inserts `entry` into the trie rooted at `node`, which is at the given
+   * shift. Returns nullptr if the key is already present.
+   */
+  static NodePtr Insert(const Node& node,
+                        Entry&& entry,
+                        size_t shift,
+                        bool* added) {
+    if (shift >= kHashBits) {
+      for (const Entry& existing : node.entries) {
+        if (E{}(existing.key, entry.key)) {
+          return nullptr;
+        }
+      }
+      auto result = std::make_shared<Node>(node);
+      result->entries.push_back(std::move(entry));
+      *added = true;
+      return result;
+    }
+
+    uint32_t bit = BitFor(entry.hash, shift);
+    if (node.data_map & bit) {
+      size_t index = IndexOf(node.data_map, bit);
+      const Entry& existing = node.entries[index];
+      if (Matches(existing, entry.hash, entry.key)) {
+        return nullptr;
+      }
+
+      // Push both keys down into a new subtrie.
+      NodePtr child =
+          MergeEntries(existing, std::move(entry), shift + kBitsPerLevel);
+      auto result = std::make_shared<Node>(node);
+      result->entries.erase(result->entries.begin() + index);
+      result->data_map ^= bit;
+      result->node_map |= bit;
+      result->children.insert(
+          result->children.begin() + IndexOf(result->node_map, bit),
+          std::move(child));
+      *added = true;
+      return result;
+    }
+
+    if (node.node_map & bit) {
+      size_t index = IndexOf(node.node_map, bit);
+      NodePtr child = Insert(*node.children[index], std::move(entry),
+                             shift + kBitsPerLevel, added);
+      if (!child) {
+        return nullptr;
+      }
+      auto result = std::make_shared<Node>(node);
+      result->children[index] = std::move(child);
+      return result;
+    }
+
+    auto result = std::make_shared<Node>(node);
+    result->entries.insert(
+        result->entries.begin() + IndexOf(node.data_map, bit),
+        std::move(entry));
+    result->data_map |= bit;
+    *added = true;
+    return result;
+  }
+
+  /** Creates a subtrie at the given shift containing two distinct keys. */
+  static NodePtr MergeEntries(const Entry& lhs, Entry&& rhs, size_t shift) {
+    auto result = std::make_shared<Node>();
+    if (shift >= kHashBits) {
+      result->entries.push_back(lhs);
+      result->entries.push_back(std::move(rhs));
+      return result;
+    }
+
+    uint32_t lhs_bit = BitFor(lhs.hash, shift);
+    uint32_t rhs_bit = BitFor(rhs.hash, shift);
+    if (lhs_bit == rhs_bit) {
+      result->node_map = lhs_bit;
+      result->children.push_back(
+          MergeEntries(lhs, std::move(rhs), shift + kBitsPerLevel));
+    } else {
+      result->data_map = lhs_bit | rhs_bit;
+      if (lhs_bit < rhs_bit) {
+        result->entries.push_back(lhs);
+        result->entries.push_back(std::move(rhs));
+      } else {
+        result->entries.push_back(std::move(rhs));
+        result->entries.push_back(lhs);
+      }
+    }
+    return result;
+  }
+
+  /**
+   * Erases `key` from the trie rooted at `node`, which is at the given shift.
+   * Returns false if the key is not present; otherwise stores the new trie in
+   * `result`.
+   */
+  static bool Erase(const Node& node,
+                    const K& key,
+                    size_t hash,
+                    size_t shift,
+                    NodePtr* result) {
+    if (shift >= kHashBits) {
+      for (size_t i = 0; i < node.entries.size(); ++i) {
+        if (E{}(node.entries[i].key, key)) {
+          auto copy = std::make_shared<Node>(node);
+          copy->entries.erase(copy->entries.begin() + i);
+          *result = std::move(copy);
+          return true;
+        }
+      }
+      return false;
+    }
+
+    uint32_t bit = BitFor(hash, shift);
+    if (node.data_map & bit) {
+      size_t index = IndexOf(node.data_map, bit);
+      if (!Matches(node.entries[index], hash, key)) {
+        return false;
+      }
+      auto copy = std::make_shared<Node>(node);
+      copy->entries.erase(copy->entries.begin() + index);
+      copy->data_map ^= bit;
+      *result = std::move(copy);
+      return true;
+    }
+
+    if (node.node_map & bit) {
+      size_t index = IndexOf(node.node_map, bit);
+      NodePtr child;
+      if (!Erase(*node.children[index], key, hash, shift + kBitsPerLevel,
+                 &child)) {
+        return false;
+      }
+
+      auto copy = std::make_shared<Node>(node);
+      if (child->children.empty() && child->entries.size() == 1) {
+        // Keep the trie canonical by pulling a lone key up into this node.
+        copy->children.erase(copy->children.begin() + index);
+        copy->node_map ^= bit;
+        copy->data_map |= bit;
+        copy->entries.insert(
+            copy->entries.begin() + IndexOf(copy->data_map, bit),
+            child->entries.front());
+      } else {
+        copy->children[index] = std::move(child);
+      }
+      *result = std::move(copy);
+      return true;
+    }
+
+    return false;
+  }
+
+  NodePtr root_;
+  size_type size_ = 0;
+};
+
+}  // namespace immutable
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_IMMUTABLE_HASH_SET_H_
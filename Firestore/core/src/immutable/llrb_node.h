@@ -17,10 +17,13 @@
 #ifndef FIRESTORE_CORE_SRC_IMMUTABLE_LLRB_NODE_H_
 #define FIRESTORE_CORE_SRC_IMMUTABLE_LLRB_NODE_H_
 
-#include <memory>
+#include <cstdint>
+#include <new>
 #include <utility>
 
 #include "Firestore/core/src/immutable/llrb_node_iterator.h"
+#include "Firestore/core/src/immutable/node_pool.h"
+#include "Firestore/core/src/immutable/ref_count.h"
 #include "Firestore/core/src/immutable/sorted_container.h"
 #include "Firestore/core/src/util/comparison.h"
 
@@ -39,8 +42,14 @@ enum Color : unsigned int {
 
 /**
  * LlrbNode is a node in a TreeSortedMap.
+ *
+ * Nodes are reference counted and shared between all trees that contain them.
+ * Their memory comes from a NodePool.
+ *
+ * @tparam R The type of the reference count of each node, either
+ *     AtomicRefCount or ThreadConfinedRefCount.
  */
-template <typename K, typename V>
+template <typename K, typename V, typename R = AtomicRefCount>
 class LlrbNode : public SortedMapBase {
  public:
   using first_type = K;
@@ -50,12 +59,39 @@ class LlrbNode : public SortedMapBase {
    * The type of the entries stored in the map.
    */
   using value_type = std::pair<K, V>;
-  using const_iterator = LlrbNodeIterator<LlrbNode<K, V>>;
+  using const_iterator = LlrbNodeIterator<LlrbNode<K, V, R>>;
 
   /**
    * Constructs an empty node.
    */
-  LlrbNode() : LlrbNode{EmptyRep()} {
+  LlrbNode() noexcept : rep_{EmptyRep()} {
+  }
+
+  LlrbNode(const LlrbNode& other) noexcept : rep_{other.rep_} {
+    Retain(rep_);
+  }
+
+  LlrbNode(LlrbNode&& other) noexcept : rep_{other.rep_} {
+    other.rep_ = nullptr;
+  }
+
+  ~LlrbNode() {
+    Release(rep_);
+  }
+
+  LlrbNode& operator=(const LlrbNode& other) noexcept {
+    // Retain first: releasing this node may destroy `other` if it is part of
+    // the subtree this node currently points to.
+    Rep* rep = other.rep_;
+    Retain(rep);
+    Release(rep_);
+    rep_ = rep;
+    return *this;
+  }
+
+  LlrbNode& operator=(LlrbNode&& other) noexcept {
+    std::swap(rep_, other.rep_);
+    return *this;
   }
 
   /** Returns true if this is an empty node--a leaf node in the tree. */
@@ -92,6 +128,16 @@ class LlrbNode : public SortedMapBase {
     return rep_->right_;
   }
 
+  /**
+   * Builds a tree containing the entries in [begin, end), which must be sorted
+   * and free of duplicate keys. This takes O(n) time and allocates each node
+   * once, unlike inserting the entries one by one.
+   *
+   * @tparam Iterator A random access iterator over `value_type`.
+   */
+  template <typename Iterator>
+  static LlrbNode FromSorted(Iterator begin, Iterator end);
+
   /** Returns a tree node with the given key-value pair set/updated. */
   template <typename Comparator>
   LlrbNode insert(const K& key,
@@ -119,24 +165,21 @@ class LlrbNode : public SortedMapBase {
 
  private:
   struct Rep {
-    Rep(value_type&& entry,
-        size_type color,
-        size_type size,
-        LlrbNode left,
-        LlrbNode right)
-        : entry_{std::move(entry)},
-          color_{color},
-          size_{size},
-          left_{std::move(left)},
-          right_{std::move(right)} {
+    /** Creates the Rep of the empty node. */
+    Rep()
+        : color_{Color::Black},
+          size_{0},
+          left_{static_cast<Rep*>(nullptr)},
+          right_{static_cast<Rep*>(nullptr)} {
     }
 
-    Rep(value_type&& entry, size_type color, LlrbNode left, LlrbNode right)
+    template <typename L, typename Rt>
+    Rep(value_type&& entry, size_type color, L&& left, Rt&& right)
         : entry_{std::move(entry)},
           color_{color},
           size_{left.size() + 1 + right.size()},
-          left_{std::move(left)},
-          right_{std::move(right)} {
+          left_{std::forward<L>(left)},
+          right_{std::forward<Rt>(right)} {
     }
 
     value_type entry_;
@@ -147,33 +190,56 @@ class LlrbNode : public SortedMapBase {
 
     LlrbNode left_;
     LlrbNode right_;
+
+    R ref_count_;
   };
 
-  explicit LlrbNode(Rep rep) : rep_{std::make_shared<Rep>(std::move(rep))} {
-  }
+  // Rep is only complete within member function bodies.
+  template <typename T = Rep>
+  using Pool = NodePool<sizeof(T), alignof(T)>;
 
-  explicit LlrbNode(const std::shared_ptr<Rep>& rep) : rep_{rep} {
+  /** Creates a node with a new Rep, constructed from the given arguments. */
+  template <typename... Args>
+  static LlrbNode MakeNode(Args&&... args) {
+    return LlrbNode{new (Pool<>::Allocate()) Rep(std::forward<Args>(args)...)};
   }
 
-  explicit LlrbNode(std::shared_ptr<Rep>&& rep) : rep_{std::move(rep)} {
+  /** Takes ownership of the given Rep without retaining it. */
+  explicit LlrbNode(Rep* rep) noexcept : rep_{rep} {
   }
 
   /**
    * Returns a shared Empty node, to cut down on allocations in the base case.
+   *
+   * The empty node is the only one with a size of zero and it is never
+   * destroyed, so it is exempt from reference counting. This also means that
+   * the empty node can be shared by trees on different threads even if they
+   * use ThreadConfinedRefCount.
    */
-  static const std::shared_ptr<Rep>& EmptyRep() {
-    static const std::shared_ptr<Rep>* empty_rep = [] {
-      auto rep = new Rep{std::pair<K, V>{}, Color::Black,
-                         /* size= */ 0u, LlrbNode{nullptr}, LlrbNode{nullptr}};
-      auto empty = new std::shared_ptr<Rep>{rep};
+  static Rep* EmptyRep() noexcept {
+    static Rep* empty_rep = [] {
+      auto rep = new Rep();
 
       // Set up the empty Rep such that you can traverse infinitely down left
       // and right links.
-      (*empty)->left_.rep_ = *empty;
-      (*empty)->right_.rep_ = *empty;
-      return empty;
+      rep->left_.rep_ = rep;
+      rep->right_.rep_ = rep;
+      return rep;
     }();
-    return *empty_rep;
+    return empty_rep;
+  }
+
+  static void Retain(Rep* rep) noexcept {
+    if (rep && rep->size_ != 0) {
+      rep->ref_count_.Increment();
+    }
+  }
+
+  static void Release(Rep* rep) noexcept {
+    if (rep && rep->size_ != 0 && rep->ref_count_.Decrement()) {
+      rep->~Rep();
+      Pool<>::Deallocate(rep);
+    }
   }
 
   /**
@@ -181,7 +247,7 @@ class LlrbNode : public SortedMapBase {
    * duplicating the left_ and right_ children.
    */
   LlrbNode Clone() const {
-    return LlrbNode{*rep_};
+    return LlrbNode{new (Pool<>::Allocate()) Rep(*rep_)};
   }
 
   void set_size(size_type size) {
@@ -213,6 +279,11 @@ class LlrbNode : public SortedMapBase {
     rep_->right_ = std::move(right);
   }
 
+  template <typename Iterator>
+  static LlrbNode BuildSorted(Iterator begin,
+                              size_type size,
+                              size_type black_height);
+
   template <typename Comparator>
   LlrbNode InnerInsert(const K& key,
                        const V& value,
@@ -236,26 +307,91 @@ class LlrbNode : public SortedMapBase {
     return rep_->color_ == Color::Red ? Color::Black : Color::Red;
   }
 
-  std::shared_ptr<Rep> rep_;
+  Rep* rep_;
 };
 
-template <typename K, typename V>
+template <typename K, typename V, typename R>
+template <typename Iterator>
+LlrbNode<K, V, R> LlrbNode<K, V, R>::FromSorted(Iterator begin, Iterator end) {
+  auto size = static_cast<size_type>(end - begin);
+
+  // Use the largest black height possible for `size` nodes, i.e. the largest
+  // `h` with `2^h - 1 <= size`. Since `size < 2^(h+1) - 1 <= 3^h - 1`, all
+  // nodes fit into a tree of that black height.
+  size_type black_height = 0;
+  while ((uint64_t{2} << black_height) - 1 <= size) {
+    ++black_height;
+  }
+  return BuildSorted(begin, size, black_height);
+}
+
+/**
+ * Builds a tree with the given black height out of the `size` entries starting
+ * at `begin`. A tree with black height `h` holds between `2^h - 1` entries
+ * (only black nodes) and `3^h - 1` entries (every black node has a red left
+ * child), and `size` must be within these bounds.
+ *
+ * The root is a black node with two subtrees of black height `h - 1` if the
+ * remaining entries fit into two such subtrees, and otherwise a black node
+ * with a red left child, which has room for three such subtrees. Entries are
+ * split evenly among the subtrees, which keeps them within their bounds too.
+ */
+template <typename K, typename V, typename R>
+template <typename Iterator>
+LlrbNode<K, V, R> LlrbNode<K, V, R>::BuildSorted(Iterator begin,
+                                                 size_type size,
+                                                 size_type black_height) {
+  if (size == 0) {
+    return LlrbNode{};
+  }
+
+  uint64_t max_subtree_size = 1;
+  for (size_type i = 1; i < black_height; ++i) {
+    max_subtree_size *= 3;
+  }
+  max_subtree_size -= 1;
+
+  size_type subtree_height = black_height - 1;
+  if (size - 1 <= 2 * max_subtree_size) {
+    size_type right_size = (size - 1) / 2;
+    size_type left_size = size - 1 - right_size;
+    LlrbNode left = BuildSorted(begin, left_size, subtree_height);
+    LlrbNode right =
+        BuildSorted(begin + left_size + 1, right_size, subtree_height);
+    return MakeNode(value_type(begin[left_size]), Color::Black,
+                    std::move(left), std::move(right));
+  }
+
+  size_type first_size = (size - 2 + 2) / 3;
+  size_type second_size = (size - 2 - first_size + 1) / 2;
+  size_type third_size = size - 2 - first_size - second_size;
+  Iterator second_begin = begin + first_size + 1;
+  Iterator third_begin = second_begin + second_size + 1;
+
+  LlrbNode first = BuildSorted(begin, first_size, subtree_height);
+  LlrbNode second = BuildSorted(second_begin, second_size, subtree_height);
+  LlrbNode red_left = MakeNode(value_type(begin[first_size]), Color::Red,
+                               std::move(first), std::move(second));
+  LlrbNode third = BuildSorted(third_begin, third_size, subtree_height);
+  return MakeNode(value_type(third_begin[-1]), Color::Black,
+                  std::move(red_left), std::move(third));
+}
+
+template <typename K, typename V, typename R>
 template <typename Comparator>
-LlrbNode<K, V> LlrbNode<K, V>::insert(const K& key,
-                                      const V& value,
-                                      const Comparator& comparator) const {
+LlrbNode<K, V, R> LlrbNode<K, V, R>::insert(
+    const K& key, const V& value, const Comparator& comparator) const {
   LlrbNode root = InnerInsert(key, value, comparator);
   root.FixRootColor();
   return root;
 }
 
-template <typename K, typename V>
+template <typename K, typename V, typename R>
 template <typename Comparator>
-LlrbNode<K, V> LlrbNode<K, V>::InnerInsert(const K& key,
-                                           const V& value,
-                                           const Comparator& comparator) const {
+LlrbNode<K, V, R> LlrbNode<K, V, R>::InnerInsert(
+    const K& key, const V& value, const Comparator& comparator) const {
   if (empty()) {
-    return LlrbNode{Rep{{key, value}, Color::Red, LlrbNode{}, LlrbNode{}}};
+    return MakeNode(value_type{key, value}, Color::Red, LlrbNode{}, LlrbNode{});
   }
 
   // Inserting is going to result in a copy but we can save some allocations by
@@ -280,19 +416,19 @@ LlrbNode<K, V> LlrbNode<K, V>::InnerInsert(const K& key,
   return result;
 }
 
-template <typename K, typename V>
+template <typename K, typename V, typename R>
 template <typename Comparator>
-LlrbNode<K, V> LlrbNode<K, V>::erase(const K& key,
-                                     const Comparator& comparator) const {
+LlrbNode<K, V, R> LlrbNode<K, V, R>::erase(const K& key,
+                                           const Comparator& comparator) const {
   LlrbNode root = InnerErase(key, comparator);
   root.FixRootColor();
   return root;
 }
 
-template <typename K, typename V>
+template <typename K, typename V, typename R>
 template <typename Comparator>
-LlrbNode<K, V> LlrbNode<K, V>::InnerErase(const K& key,
-                                          const Comparator& comparator) const {
+LlrbNode<K, V, R> LlrbNode<K, V, R>::InnerErase(
+    const K& key, const Comparator& comparator) const {
   if (empty()) {
     // Empty node already frozen
     return LlrbNode{};
@@ -336,8 +472,8 @@ LlrbNode<K, V> LlrbNode<K, V>::InnerErase(const K& key,
   return n;
 }
 
-template <typename K, typename V>
-void LlrbNode<K, V>::FixUp() {
+template <typename K, typename V, typename R>
+void LlrbNode<K, V, R>::FixUp() {
   set_size(left().size() + 1 + right().size());
 
   if (right().red() && !left().red()) {
@@ -360,15 +496,15 @@ void LlrbNode<K, V>::FixUp() {
  *   * If the key is found, InnerErase returns a new root, which is safe to
  *     modify.
  */
-template <typename K, typename V>
-void LlrbNode<K, V>::FixRootColor() {
+template <typename K, typename V, typename R>
+void LlrbNode<K, V, R>::FixRootColor() {
   if (red()) {
     rep_->color_ = Color::Black;
   }
 }
 
-template <typename K, typename V>
-void LlrbNode<K, V>::RemoveMin() {
+template <typename K, typename V, typename R>
+void LlrbNode<K, V, R>::RemoveMin() {
   // If the left node is empty then the right node must be empty (because the
   // tree is left-leaning) and this node must be the minimum.
   if (left().empty()) {
@@ -386,8 +522,8 @@ void LlrbNode<K, V>::RemoveMin() {
   FixUp();
 }
 
-template <typename K, typename V>
-void LlrbNode<K, V>::MoveRedLeft() {
+template <typename K, typename V, typename R>
+void LlrbNode<K, V, R>::MoveRedLeft() {
   FlipColor();
   if (right().left().red()) {
     LlrbNode new_right = right().Clone();
@@ -398,8 +534,8 @@ void LlrbNode<K, V>::MoveRedLeft() {
   }
 }
 
-template <typename K, typename V>
-void LlrbNode<K, V>::MoveRedRight() {
+template <typename K, typename V, typename R>
+void LlrbNode<K, V, R>::MoveRedRight() {
   FlipColor();
   if (left().left().red()) {
     RotateRight();
@@ -415,10 +551,10 @@ void LlrbNode<K, V>::MoveRedRight() {
  *        / \      / \
  *       RL RR     L RL
  */
-template <typename K, typename V>
-void LlrbNode<K, V>::RotateLeft() {
-  LlrbNode new_left{
-      Rep{std::move(rep_->entry_), Color::Red, left(), right().left()}};
+template <typename K, typename V, typename R>
+void LlrbNode<K, V, R>::RotateLeft() {
+  LlrbNode new_left =
+      MakeNode(std::move(rep_->entry_), Color::Red, left(), right().left());
 
   // size_ and color remain unchanged after a rotation.
   set_entry(right().entry());
@@ -434,10 +570,10 @@ void LlrbNode<K, V>::RotateLeft() {
  *  / \                  / \
  * LL LR                LR R
  */
-template <typename K, typename V>
-void LlrbNode<K, V>::RotateRight() {
-  LlrbNode new_right{
-      Rep{std::move(rep_->entry_), Color::Red, left().right(), right()}};
+template <typename K, typename V, typename R>
+void LlrbNode<K, V, R>::RotateRight() {
+  LlrbNode new_right =
+      MakeNode(std::move(rep_->entry_), Color::Red, left().right(), right());
 
   // size_ remains unchanged after a rotation. Preserve color too.
   set_entry(left().entry());
@@ -445,8 +581,8 @@ void LlrbNode<K, V>::RotateRight() {
   set_right(std::move(new_right));
 }
 
-template <typename K, typename V>
-void LlrbNode<K, V>::FlipColor() {
+template <typename K, typename V, typename R>
+void LlrbNode<K, V, R>::FlipColor() {
   LlrbNode new_left = left().Clone();
   new_left.set_color(left().OppositeColor());
 
@@ -0,0 +1,140 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_IMMUTABLE_NODE_POOL_H_
+#define FIRESTORE_CORE_SRC_IMMUTABLE_NODE_POOL_H_
+
+#include <cstddef>
+#include <new>
+
+#include "absl/base/config.h"
+
+namespace firebase {
+namespace firestore {
+namespace immutable {
+namespace impl {
+
+/**
+ * Allocates fixed-size blocks of memory for tree nodes.
+ *
+ * Persistent trees free about as many nodes as they allocate: every insert or
+ * erase copies the path to the modified node, and the old path is released as
+ * soon as the previous version of the tree is dropped. NodePool keeps freed
+ * blocks in a free list per thread and hands them out again, which turns most
+ * node allocations into a couple of pointer operations.
+ *
+ * Blocks may be freed on a different thread than the one that allocated them;
+ * they simply join the free list of the freeing thread. Each free list is
+ * bounded and released when its thread exits, so a burst of frees does not pin
+ * memory indefinitely.
+ *
+ * @tparam Size The size of the blocks.
+ * @tparam Alignment The alignment of the blocks, which must not exceed that of
+ *     `std::max_align_t`.
+ */
+template <size_t Size, size_t Alignment>
+class NodePool {
+  static_assert(Alignment <= alignof(std::max_align_t),
+                "NodePool does not support over-aligned blocks");
+
+ public:
+  /** The maximum size of each thread's free list, in bytes. */
+  static constexpr size_t kMaxCachedBytes = 256 * 1024;
+
+  static void* Allocate() {
+#if ABSL_HAVE_THREAD_LOCAL
+    FreeList& free_list = LocalFreeList();
+    if (free_list.head) {
+      Block* block = free_list.head;
+      free_list.head = block->next;
+      free_list.size--;
+      return block;
+    }
+#endif  // ABSL_HAVE_THREAD_LOCAL
+
+    return ::operator new(kBlockSize);
+  }
+
+  static void Deallocate(void* ptr) {
+#if ABSL_HAVE_THREAD_LOCAL
+    FreeList& free_list = LocalFreeList();
+    if (!free_list.closed && free_list.size < kMaxCachedBlocks) {
+      auto block = static_cast<Block*>(ptr);
+      block->next = free_list.head;
+      free_list.head = block;
+      free_list.size++;
+      return;
+    }
+#endif  // ABSL_HAVE_THREAD_LOCAL
+
+    ::operator delete(ptr);
+  }
+
+ private:
+  struct Block {
+    Block* next;
+  };
+
+  static constexpr size_t kBlockSize =
+      Size < sizeof(Block) ? sizeof(Block) : Size;
+  static constexpr size_t kMaxCachedBlocks = kMaxCachedBytes / kBlockSize;
+
+#if ABSL_HAVE_THREAD_LOCAL
+  /**
+   * The free list of a thread. This is trivially destructible so that it
+   * remains usable while other thread-local objects are destroyed, after the
+   * list itself has been closed.
+   */
+  struct FreeList {
+    Block* head;
+    size_t size;
+    bool closed;
+  };
+
+  /** Releases the blocks of a free list when its thread exits. */
+  class FreeListCloser {
+   public:
+    explicit FreeListCloser(FreeList* free_list) : free_list_(free_list) {
+    }
+
+    ~FreeListCloser() {
+      free_list_->closed = true;
+      while (free_list_->head) {
+        Block* block = free_list_->head;
+        free_list_->head = block->next;
+        ::operator delete(block);
+      }
+      free_list_->size = 0;
+    }
+
+   private:
+    FreeList* free_list_;
+  };
+
+  static FreeList& LocalFreeList() {
+    static thread_local FreeList free_list{};
+    static thread_local FreeListCloser closer{&free_list};
+    return free_list;
+  }
+#endif  // ABSL_HAVE_THREAD_LOCAL
+};
+
+}  // namespace impl
+}  // namespace immutable
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_IMMUTABLE_NODE_POOL_H_
@@ -0,0 +1,92 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_IMMUTABLE_REF_COUNT_H_
+#define FIRESTORE_CORE_SRC_IMMUTABLE_REF_COUNT_H_
+
+#include <atomic>
+#include <cstdint>
+
+namespace firebase {
+namespace firestore {
+namespace immutable {
+
+/**
+ * The reference count of a node that may be shared between threads. This is
+ * the default for all immutable containers.
+ *
+ * A new count starts at one, owned by whoever created the node. Copying a
+ * count yields a new count of one rather than duplicating the value, since the
+ * copy belongs to a new node.
+ */
+class AtomicRefCount {
+ public:
+  AtomicRefCount() noexcept = default;
+
+  AtomicRefCount(const AtomicRefCount&) noexcept {
+  }
+
+  AtomicRefCount& operator=(const AtomicRefCount&) = delete;
+
+  void Increment() noexcept {
+    count_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  /** Decrements the count and returns true if it dropped to zero. */
+  bool Decrement() noexcept {
+    return count_.fetch_sub(1, std::memory_order_acq_rel) == 1;
+  }
+
+ private:
+  std::atomic<uint32_t> count_{1};
+};
+
+/**
+ * The reference count of a node that is never shared between threads, which
+ * avoids the cost of atomic operations.
+ *
+ * Only use this for containers that are confined to a single thread (or a
+ * serial queue, such as the worker queue), including all copies of them and
+ * all containers derived from them. Handing any of these to another thread
+ * while the original is still in use is a data race.
+ */
+class ThreadConfinedRefCount {
+ public:
+  ThreadConfinedRefCount() noexcept = default;
+
+  ThreadConfinedRefCount(const ThreadConfinedRefCount&) noexcept {
+  }
+
+  ThreadConfinedRefCount& operator=(const ThreadConfinedRefCount&) = delete;
+
+  void Increment() noexcept {
+    ++count_;
+  }
+
+  /** Decrements the count and returns true if it dropped to zero. */
+  bool Decrement() noexcept {
+    return --count_ == 0;
+  }
+
+ private:
+  uint32_t count_ = 1;
+};
+
+}  // namespace immutable
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_IMMUTABLE_REF_COUNT_H_
@@ -17,10 +17,12 @@
 #ifndef FIRESTORE_CORE_SRC_IMMUTABLE_SORTED_MAP_H_
 #define FIRESTORE_CORE_SRC_IMMUTABLE_SORTED_MAP_H_
 
+#include <cstddef>
 #include <utility>
 
 #include "Firestore/core/src/immutable/array_sorted_map.h"
 #include "Firestore/core/src/immutable/keys_view.h"
+#include "Firestore/core/src/immutable/ref_count.h"
 #include "Firestore/core/src/immutable/sorted_container.h"
 #include "Firestore/core/src/immutable/sorted_map_iterator.h"
 #include "Firestore/core/src/immutable/tree_sorted_map.h"
@@ -35,8 +37,15 @@ namespace immutable {
 /**
  * SortedMap is a value type containing a map. It is immutable, but
  * has methods to efficiently create new maps that are mutations of it.
+ *
+ * @tparam R The reference count type of the nodes of large maps. Use
+ *     ThreadConfinedRefCount only for maps that never leave the thread (or
+ *     serial queue) that created them.
  */
-template <typename K, typename V, typename C = util::Comparator<K>>
+template <typename K,
+          typename V,
+          typename C = util::Comparator<K>,
+          typename R = AtomicRefCount>
 class SortedMap : public SortedMapBase {
  public:
   using key_type = K;
@@ -44,12 +53,12 @@ class SortedMap : public SortedMapBase {
   /** The type of the entries stored in the map. */
   using value_type = std::pair<K, V>;
   using array_type = impl::ArraySortedMap<K, V, C>;
-  using tree_type = impl::TreeSortedMap<K, V, C>;
+  using tree_type = impl::TreeSortedMap<K, V, C, R>;
 
   using const_iterator = impl::SortedMapIterator<
       value_type,
       typename impl::FixedArray<value_type>::const_iterator,
-      typename impl::LlrbNode<K, V>::const_iterator>;
+      typename impl::LlrbNode<K, V, R>::const_iterator>;
 
   using const_key_iterator = util::iterator_first<const_iterator>;
 
@@ -73,6 +82,24 @@ class SortedMap : public SortedMapBase {
     }
   }
 
+  /**
+   * Creates a SortedMap containing the entries in [begin, end), which must
+   * already be sorted by key according to `comparator` and free of duplicate
+   * keys. This takes linear time, unlike inserting the entries one by one.
+   *
+   * @tparam Iterator A random access iterator over `value_type`.
+   */
+  template <typename Iterator>
+  static SortedMap FromSortedRange(Iterator begin,
+                                   Iterator end,
+                                   const C& comparator = {}) {
+    if (end - begin <= static_cast<std::ptrdiff_t>(kFixedSize)) {
+      return SortedMap{array_type::FromSortedRange(begin, end, comparator)};
+    } else {
+      return SortedMap{tree_type::FromSortedRange(begin, end, comparator)};
+    }
+  }
+
   SortedMap(const SortedMap& other) : tag_{other.tag_} {
     switch (tag_) {
       case Tag::Array:
@@ -190,7 +217,8 @@ class SortedMap : public SortedMapBase {
           // exactly where this cut-off happens and just unconditionally
           // converting if the next insertion could overflow keeps things
           // simpler.
-          tree_type tree = tree_type::Create(array_, comparator());
+          tree_type tree = tree_type::FromSortedRange(
+              array_.begin(), array_.end(), comparator());
           return SortedMap{tree.insert(key, value)};
         } else {
           return SortedMap{array_.insert(key, value)};
@@ -265,6 +293,22 @@ class SortedMap : public SortedMapBase {
     UNREACHABLE();
   }
 
+  /**
+   * Returns the entry at the given index in the map, i.e. the inverse of
+   * `find_index`.
+   *
+   * @param index The index of the entry, which must be less than size().
+   */
+  const value_type& at(size_type index) const {
+    switch (tag_) {
+      case Tag::Array:
+        return array_.at(index);
+      case Tag::Tree:
+        return tree_.at(index);
+    }
+    UNREACHABLE();
+  }
+
   absl::optional<V> get(const K& key) const {
     auto found = find(key);
     if (found != end()) {
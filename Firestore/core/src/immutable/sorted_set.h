@@ -18,8 +18,13 @@
 #define FIRESTORE_CORE_SRC_IMMUTABLE_SORTED_SET_H_
 
 #include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
 #include <utility>
+#include <vector>
 
+#include "Firestore/core/src/immutable/ref_count.h"
 #include "Firestore/core/src/immutable/sorted_container.h"
 #include "Firestore/core/src/immutable/sorted_map.h"
 #include "Firestore/core/src/util/comparison.h"
@@ -32,10 +37,18 @@ namespace firebase {
 namespace firestore {
 namespace immutable {
 
-template <typename K, typename C = util::Comparator<K>>
+/**
+ * SortedSet is an immutable set, backed by a SortedMap.
+ *
+ * @tparam R The reference count type of the nodes of large sets; see
+ *     SortedMap.
+ */
+template <typename K,
+          typename C = util::Comparator<K>,
+          typename R = AtomicRefCount>
 class SortedSet : public SortedContainer {
  public:
-  using map_type = SortedMap<K, util::Empty, C>;
+  using map_type = SortedMap<K, util::Empty, C, R>;
 
   using size_type = typename map_type::size_type;
   using value_type = K;
@@ -58,6 +71,23 @@ class SortedSet : public SortedContainer {
     }
   }
 
+  /**
+   * Creates a SortedSet containing the keys in [begin, end), which must already
+   * be sorted according to `comparator` and free of duplicates. This takes
+   * linear time, unlike inserting the keys one by one.
+   */
+  template <typename Iterator>
+  static SortedSet FromSortedRange(Iterator begin,
+                                   Iterator end,
+                                   const C& comparator = {}) {
+    std::vector<entry_type> entries;
+    entries.reserve(static_cast<size_t>(std::distance(begin, end)));
+    for (; begin != end; ++begin) {
+      entries.emplace_back(*begin, util::Empty{});
+    }
+    return FromSortedEntries(std::move(entries), comparator);
+  }
+
   bool empty() const {
     return map_.empty();
   }
@@ -84,6 +114,39 @@ class SortedSet : public SortedContainer {
       other_ptr = this;
     }
 
+    if (other_ptr->empty()) {
+      return *result_ptr;
+    }
+
+    if (PreferRebuild(other_ptr->size(), result_ptr->size())) {
+      std::vector<entry_type> merged;
+      merged.reserve(result_ptr->size() + other_ptr->size());
+
+      const C& comparator = this->comparator();
+      auto lhs = begin();
+      auto lhs_end = end();
+      auto rhs = other.begin();
+      auto rhs_end = other.end();
+      while (lhs != lhs_end && rhs != rhs_end) {
+        util::ComparisonResult cmp = comparator.Compare(*lhs, *rhs);
+        if (util::Ascending(cmp)) {
+          merged.emplace_back(*lhs++, util::Empty{});
+        } else if (util::Descending(cmp)) {
+          merged.emplace_back(*rhs++, util::Empty{});
+        } else {
+          merged.emplace_back(*lhs++, util::Empty{});
+          ++rhs;
+        }
+      }
+      for (; lhs != lhs_end; ++lhs) {
+        merged.emplace_back(*lhs, util::Empty{});
+      }
+      for (; rhs != rhs_end; ++rhs) {
+        merged.emplace_back(*rhs, util::Empty{});
+      }
+      return FromSortedEntries(std::move(merged), comparator);
+    }
+
     auto result = *result_ptr;
     for (const auto& k : *other_ptr) {
       result = result.insert(k);
@@ -91,6 +154,42 @@ class SortedSet : public SortedContainer {
     return result;
   }
 
+  /**
+   * Returns a set containing the keys of this set that are not contained in
+   * `other`.
+   */
+  ABSL_MUST_USE_RESULT SortedSet difference(const SortedSet& other) const {
+    if (empty() || other.empty()) {
+      return *this;
+    }
+
+    if (PreferRebuild(other.size(), size())) {
+      std::vector<entry_type> remaining;
+      remaining.reserve(size());
+
+      const C& comparator = this->comparator();
+      auto rhs = other.begin();
+      auto rhs_end = other.end();
+      for (const K& key : *this) {
+        while (rhs != rhs_end &&
+               util::Ascending(comparator.Compare(*rhs, key))) {
+          ++rhs;
+        }
+        if (rhs == rhs_end ||
+            !util::Same(comparator.Compare(*rhs, key))) {
+          remaining.emplace_back(key, util::Empty{});
+        }
+      }
+      return FromSortedEntries(std::move(remaining), comparator);
+    }
+
+    auto result = *this;
+    for (const auto& k : other) {
+      result = result.erase(k);
+    }
+    return result;
+  }
+
   ABSL_MUST_USE_RESULT SortedSet erase(const K& key) const {
     return SortedSet{map_.erase(key)};
   }
@@ -107,6 +206,14 @@ class SortedSet : public SortedContainer {
     return map_.find_index(key);
   }
 
+  /**
+   * Returns the key at the given index in the set, i.e. the inverse of
+   * `find_index`.
+   */
+  const K& at(size_type index) const {
+    return map_.at(index).first;
+  }
+
   const_iterator min() const {
     return const_iterator{map_.min()};
   }
@@ -143,11 +250,13 @@ class SortedSet : public SortedContainer {
 
   template <typename MapType>
   static SortedSet FromKeysOf(const MapType& map) {
-    SortedSet result;
-    for (const K& key : map.keys()) {
-      result = result.insert(key);
-    }
-    return result;
+    // The keys of `map` are already in order if it sorts them with the same
+    // stateless comparator as this set.
+    using MapComparator =
+        typename std::decay<decltype(map.comparator())>::type;
+    using SameOrder = std::integral_constant<
+        bool, std::is_same<MapComparator, C>::value && std::is_empty<C>::value>;
+    return FromKeysOf(map, SameOrder{});
   }
 
   friend bool operator==(const SortedSet& lhs, const SortedSet& rhs) {
@@ -162,6 +271,51 @@ class SortedSet : public SortedContainer {
   }
 
  private:
+  using entry_type = typename map_type::value_type;
+
+  static SortedSet FromSortedEntries(std::vector<entry_type>&& entries,
+                                     const C& comparator) {
+    return SortedSet{map_type::FromSortedRange(
+        std::make_move_iterator(entries.begin()),
+        std::make_move_iterator(entries.end()), comparator)};
+  }
+
+  template <typename MapType>
+  static SortedSet FromKeysOf(const MapType& map, std::true_type) {
+    std::vector<entry_type> entries;
+    entries.reserve(map.size());
+    for (const K& key : map.keys()) {
+      entries.emplace_back(key, util::Empty{});
+    }
+    return FromSortedEntries(std::move(entries), C{});
+  }
+
+  template <typename MapType>
+  static SortedSet FromKeysOf(const MapType& map, std::false_type) {
+    SortedSet result;
+    for (const K& key : map.keys()) {
+      result = result.insert(key);
+    }
+    return result;
+  }
+
+  /**
+   * Returns true if applying `changes` insertions or removals to a set of
+   * `size` keys is more expensive than building the resulting set from
+   * scratch. Each insertion or removal copies a path of O(log n) nodes, while
+   * a rebuild allocates each of the O(n) nodes of the result once but also
+   * has to walk both inputs and buffer the result, which roughly doubles its
+   * cost per node (see sorted_map_benchmark.cc).
+   */
+  static bool PreferRebuild(size_type changes, size_type size) {
+    size_type log_size = 0;
+    while ((size >> log_size) > 0) {
+      ++log_size;
+    }
+    return static_cast<uint64_t>(changes) * log_size >
+           2 * (static_cast<uint64_t>(size) + changes);
+  }
+
   map_type map_;
 };
 
@@ -37,8 +37,13 @@ namespace impl {
 /**
  * TreeSortedMap is a value type containing a map. It is immutable, but has
  * methods to efficiently create new maps that are mutations of it.
+ *
+ * @tparam R The reference count type of the nodes of the tree; see LlrbNode.
  */
-template <typename K, typename V, typename C = util::Comparator<K>>
+template <typename K,
+          typename V,
+          typename C = util::Comparator<K>,
+          typename R = AtomicRefCount>
 class TreeSortedMap : public SortedMapBase, private util::CompressedMember<C> {
   using ComparatorMember = util::CompressedMember<C>;
 
@@ -51,7 +56,7 @@ class TreeSortedMap : public SortedMapBase, private util::CompressedMember<C> {
   /**
    * The type of the node containing entries of value_type.
    */
-  using node_type = LlrbNode<K, V>;
+  using node_type = LlrbNode<K, V, R>;
   using const_iterator = typename node_type::const_iterator;
   using const_key_iterator = util::iterator_first<const_iterator>;
 
@@ -74,6 +79,20 @@ class TreeSortedMap : public SortedMapBase, private util::CompressedMember<C> {
     return TreeSortedMap{std::move(node), comparator};
   }
 
+  /**
+   * Creates a TreeSortedMap from a range of pairs that are already sorted by
+   * key and free of duplicate keys. Unlike `Create`, this builds the tree in
+   * linear time.
+   *
+   * @tparam Iterator A random access iterator over `value_type`.
+   */
+  template <typename Iterator>
+  static TreeSortedMap FromSortedRange(Iterator begin,
+                                       Iterator end,
+                                       const C& comparator) {
+    return TreeSortedMap{node_type::FromSorted(begin, end), comparator};
+  }
+
   /** Returns true if the map contains no elements. */
   bool empty() const {
     return root_.empty();
@@ -178,6 +197,30 @@ class TreeSortedMap : public SortedMapBase, private util::CompressedMember<C> {
     return npos;
   }
 
+  /**
+   * Returns the entry at the given index in the map. This is the inverse of
+   * `find_index` and takes O(log n) time.
+   *
+   * @param index The index of the entry, which must be less than size().
+   */
+  const value_type& at(size_type index) const {
+    HARD_ASSERT(index < size(), "Index %s out of bounds for size %s", index,
+                size());
+
+    const node_type* node = &root_;
+    while (true) {
+      size_type left_size = node->left().size();
+      if (index < left_size) {
+        node = &node->left();
+      } else if (index == left_size) {
+        return node->entry();
+      } else {
+        index -= left_size + 1;
+        node = &node->right();
+      }
+    }
+  }
+
   /**
    * Finds the first entry in the map containing a key greater than or equal
    * to the given key.
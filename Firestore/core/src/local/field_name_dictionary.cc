@@ -0,0 +1,57 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/local/field_name_dictionary.h"
+
+#include "Firestore/Protos/nanopb/google/firestore/v1/document.nanopb.h"
+#include "Firestore/core/src/nanopb/field_scanner.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+using model::kFieldNameIdTag;
+using nanopb::AppendVarintField;
+using nanopb::FieldScanner;
+
+bool EncodeFieldNames(absl::string_view entry,
+                      const std::string& collection_group,
+                      FieldNameDictionary* dictionary,
+                      std::string* out) {
+  return model::TranscodeMapKeys(
+      entry,
+      [&](const FieldScanner& key, std::string* result) {
+        if (key.field_number() ==
+                google_firestore_v1_MapValue_FieldsEntry_key_tag &&
+            key.wire_type() == PB_WT_STRING) {
+          absl::optional<int32_t> id =
+              dictionary->GetOrAssignId(collection_group, key.bytes_value());
+          if (id) {
+            AppendVarintField(result, kFieldNameIdTag,
+                              static_cast<uint64_t>(*id));
+            return true;
+          }
+        }
+        absl::string_view field = key.encoded_field();
+        result->append(field.data(), field.size());
+        return true;
+      },
+      out);
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,79 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_LOCAL_FIELD_NAME_DICTIONARY_H_
+#define FIRESTORE_CORE_SRC_LOCAL_FIELD_NAME_DICTIONARY_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "Firestore/core/src/model/field_name_table.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+/**
+ * Maps the field names used by the documents of a collection group to small
+ * integer ids, so that persisted documents can refer to repetitive field names
+ * by id instead of spelling them out in every document.
+ *
+ * Ids are scoped to a collection group and never change once assigned.
+ */
+class FieldNameDictionary {
+ public:
+  virtual ~FieldNameDictionary() = default;
+
+  /**
+   * Returns the id of `field_name` within `collection_group`, assigning a new
+   * id if the field name has not been seen before. Returns `nullopt` if the
+   * field name should be stored verbatim instead, e.g. because the dictionary
+   * for the collection group is full.
+   */
+  virtual absl::optional<int32_t> GetOrAssignId(
+      const std::string& collection_group, absl::string_view field_name) = 0;
+
+  /**
+   * Returns the table that resolves the field name ids of `collection_group`.
+   * Documents keep the table to resolve ids once their fields are accessed,
+   * so it must remain usable after the dictionary is gone. Never returns
+   * null.
+   */
+  virtual std::shared_ptr<const model::FieldNameTable> GetFieldNames(
+      const std::string& collection_group) const = 0;
+};
+
+/**
+ * Appends the dictionary-encoded form of a serialized
+ * `google_firestore_v1_Document_FieldsEntry` to `out`, replacing the key of
+ * the entry and of all nested map entries by a field name id (see
+ * `model::kFieldNameIdTag`) from the collection group's dictionary.
+ *
+ * @return false if `entry` is malformed.
+ */
+bool EncodeFieldNames(absl::string_view entry,
+                      const std::string& collection_group,
+                      FieldNameDictionary* dictionary,
+                      std::string* out);
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_LOCAL_FIELD_NAME_DICTIONARY_H_
@@ -33,7 +33,9 @@ class SortedMap;
 namespace model {
 class DocumentKey;
 class FieldIndex;
+class FieldPath;
 class IndexOffset;
+class MutableDocument;
 class ResourcePath;
 }  // namespace model
 
@@ -140,6 +142,20 @@ class IndexManager {
   virtual absl::optional<std::vector<model::DocumentKey>>
   GetDocumentsMatchingTarget(const core::Target& target) = 0;
 
+  /**
+   * Returns the documents that match the given target as partial documents
+   * read from the entries of covering indexes, without loading the documents.
+   * The partial documents hold the values of `fields` and of the fields the
+   * indexes are ordered by, as of the time the documents were indexed.
+   *
+   * Returns `nullopt` if the target cannot be served from indexes that all
+   * cover `fields` (see `model::FieldIndex::Covers`).
+   */
+  virtual absl::optional<std::vector<model::MutableDocument>>
+  GetCoveredDocumentsMatchingTarget(
+      const core::Target& target,
+      const std::vector<model::FieldPath>& fields) = 0;
+
   /**
    * Returns the next collection group to update. Returns `nullopt` if no
    * group exists.
@@ -0,0 +1,146 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/local/leveldb_field_name_dictionary.h"
+
+#include <utility>
+
+#include "Firestore/core/src/local/leveldb_key.h"
+#include "Firestore/core/src/local/leveldb_transaction.h"
+#include "Firestore/core/src/util/hard_assert.h"
+#include "absl/strings/match.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+constexpr int32_t LevelDbFieldNameDictionary::kMaxFieldNamesPerCollectionGroup;
+
+absl::optional<int32_t>
+LevelDbFieldNameDictionary::CollectionGroupDictionary::FindId(
+    absl::string_view field_name) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto found = ids_.find(field_name);
+  if (found == ids_.end()) return absl::nullopt;
+  return found->second;
+}
+
+int32_t LevelDbFieldNameDictionary::CollectionGroupDictionary::Add(
+    std::string field_name) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto id = static_cast<int32_t>(field_names_.size());
+  ids_.emplace(field_name, id);
+  field_names_.push_back(std::move(field_name));
+  return id;
+}
+
+int32_t LevelDbFieldNameDictionary::CollectionGroupDictionary::size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return static_cast<int32_t>(field_names_.size());
+}
+
+const std::string*
+LevelDbFieldNameDictionary::CollectionGroupDictionary::GetFieldName(
+    int32_t field_name_id) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (field_name_id < 0 ||
+      field_name_id >= static_cast<int32_t>(field_names_.size())) {
+    return nullptr;
+  }
+  return &field_names_[field_name_id];
+}
+
+void LevelDbFieldNameDictionary::EnsureLoaded(LevelDbTransaction* transaction) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (loaded_) return;
+
+  std::string prefix = LevelDbFieldNameKey::KeyPrefix();
+  auto it = transaction->NewIterator();
+  LevelDbFieldNameKey key;
+  for (it->Seek(prefix); it->Valid() && absl::StartsWith(it->key(), prefix);
+       it->Next()) {
+    HARD_ASSERT(key.Decode(it->key()), "Failed to decode field name key");
+
+    std::shared_ptr<CollectionGroupDictionary>& dictionary =
+        collection_groups_[key.collection_group()];
+    if (!dictionary) {
+      dictionary = std::make_shared<CollectionGroupDictionary>();
+    }
+    HARD_ASSERT(key.field_name_id() == dictionary->size(),
+                "Field name ids for collection group %s are not contiguous",
+                key.collection_group());
+    dictionary->Add(it->value());
+  }
+
+  loaded_ = true;
+}
+
+void LevelDbFieldNameDictionary::SavePendingFieldNames(
+    LevelDbTransaction* transaction) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (const auto& entry : pending_) {
+    const CollectionGroupDictionary& dictionary =
+        *collection_groups_.at(entry.first);
+    transaction->Put(LevelDbFieldNameKey::Key(entry.first, entry.second),
+                     *dictionary.GetFieldName(entry.second));
+  }
+  pending_.clear();
+}
+
+void LevelDbFieldNameDictionary::Reset() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  loaded_ = false;
+  collection_groups_.clear();
+  pending_.clear();
+}
+
+absl::optional<int32_t> LevelDbFieldNameDictionary::GetOrAssignId(
+    const std::string& collection_group, absl::string_view field_name) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  HARD_ASSERT(loaded_, "Field names must be loaded before assigning ids");
+
+  std::shared_ptr<CollectionGroupDictionary>& dictionary =
+      collection_groups_[collection_group];
+  if (!dictionary) {
+    dictionary = std::make_shared<CollectionGroupDictionary>();
+  }
+
+  absl::optional<int32_t> found = dictionary->FindId(field_name);
+  if (found) return found;
+
+  if (dictionary->size() >= kMaxFieldNamesPerCollectionGroup) {
+    return absl::nullopt;
+  }
+
+  int32_t id = dictionary->Add(std::string{field_name});
+  pending_.emplace_back(collection_group, id);
+  return id;
+}
+
+std::shared_ptr<const model::FieldNameTable>
+LevelDbFieldNameDictionary::GetFieldNames(
+    const std::string& collection_group) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  HARD_ASSERT(loaded_, "Field names must be loaded before decoding ids");
+
+  auto found = collection_groups_.find(collection_group);
+  if (found == collection_groups_.end()) return empty_;
+  return found->second;
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
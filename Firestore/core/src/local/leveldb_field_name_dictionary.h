@@ -0,0 +1,118 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_LOCAL_LEVELDB_FIELD_NAME_DICTIONARY_H_
+#define FIRESTORE_CORE_SRC_LOCAL_LEVELDB_FIELD_NAME_DICTIONARY_H_
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/local/field_name_dictionary.h"
+#include "absl/container/flat_hash_map.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+class LevelDbTransaction;
+
+/**
+ * A FieldNameDictionary backed by the field_names table.
+ *
+ * The entire dictionary is kept in memory once loaded, so that documents can
+ * resolve field name ids concurrently without accessing LevelDB. Newly
+ * assigned ids are buffered until they are written with
+ * `SavePendingFieldNames()`, which must happen in the same transaction that
+ * writes the documents using them.
+ */
+class LevelDbFieldNameDictionary : public FieldNameDictionary {
+ public:
+  /**
+   * The maximum number of field names per collection group. Field names that
+   * are encountered once a collection group's dictionary is full, e.g. for
+   * maps that are keyed by user-provided ids, are stored verbatim.
+   */
+  static constexpr int32_t kMaxFieldNamesPerCollectionGroup = 1024;
+
+  /** Reads all field names from LevelDB, unless they were read before. */
+  void EnsureLoaded(LevelDbTransaction* transaction);
+
+  /** Writes all ids that were assigned since the last call. */
+  void SavePendingFieldNames(LevelDbTransaction* transaction);
+
+  /**
+   * Forgets all field names, e.g. after they have been deleted from LevelDB.
+   * Tables handed out earlier remain valid. The dictionary is read again on
+   * the next call to `EnsureLoaded()`.
+   */
+  void Reset();
+
+  absl::optional<int32_t> GetOrAssignId(const std::string& collection_group,
+                                        absl::string_view field_name) override;
+
+  std::shared_ptr<const model::FieldNameTable> GetFieldNames(
+      const std::string& collection_group) const override;
+
+ private:
+  /** The field names of a single collection group. */
+  class CollectionGroupDictionary : public model::FieldNameTable {
+   public:
+    /** Returns the id of `field_name`, or `nullopt` if it has none yet. */
+    absl::optional<int32_t> FindId(absl::string_view field_name) const;
+
+    /** Assigns the next id to `field_name` and returns it. */
+    int32_t Add(std::string field_name);
+
+    int32_t size() const;
+
+    const std::string* GetFieldName(int32_t field_name_id) const override;
+
+   private:
+    // Guards the members below. Ids are resolved on multiple threads, while
+    // new ids are assigned on the worker queue.
+    mutable std::mutex mutex_;
+
+    // A deque so that pointers to the names remain stable as names are added.
+    std::deque<std::string> field_names_;
+    absl::flat_hash_map<std::string, int32_t> ids_;
+  };
+
+  // Guards all members below.
+  mutable std::mutex mutex_;
+
+  bool loaded_ = false;
+  std::map<std::string, std::shared_ptr<CollectionGroupDictionary>>
+      collection_groups_;
+
+  // Handed out for collection groups that have no field names yet.
+  std::shared_ptr<const CollectionGroupDictionary> empty_ =
+      std::make_shared<CollectionGroupDictionary>();
+
+  // Field names that have not been written to LevelDB yet, as pairs of
+  // collection group and id.
+  std::vector<std::pair<std::string, int32_t>> pending_;
+};
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_LOCAL_LEVELDB_FIELD_NAME_DICTIONARY_H_
@@ -18,7 +18,9 @@
 
 #include <algorithm>
 #include <functional>
+#include <iterator>
 #include <memory>
+#include <queue>
 #include <set>
 #include <string>
 #include <unordered_set>
@@ -38,12 +40,16 @@
 #include "Firestore/core/src/model/document_set.h"
 #include "Firestore/core/src/model/field_index.h"
 #include "Firestore/core/src/model/model_fwd.h"
+#include "Firestore/core/src/model/mutable_document.h"
+#include "Firestore/core/src/model/object_value.h"
 #include "Firestore/core/src/model/resource_path.h"
 #include "Firestore/core/src/model/target_index_matcher.h"
+#include "Firestore/core/src/model/value_util.h"
 #include "Firestore/core/src/util/comparison.h"
 #include "Firestore/core/src/util/hard_assert.h"
 #include "Firestore/core/src/util/log.h"
 #include "Firestore/core/src/util/logic_utils.h"
+#include "Firestore/core/src/util/read_context.h"
 #include "Firestore/core/src/util/set_util.h"
 #include "Firestore/core/src/util/string_util.h"
 #include "Firestore/third_party/nlohmann_json/json.hpp"
@@ -64,7 +70,10 @@ using index::IndexEntry;
 using model::DocumentKey;
 using model::DocumentMap;
 using model::FieldIndex;
+using model::FieldPath;
 using model::IndexState;
+using model::MutableDocument;
+using model::ObjectValue;
 using model::ResourcePath;
 using model::SnapshotVersion;
 using model::TargetIndexMatcher;
@@ -279,6 +288,8 @@ void LevelDbIndexManager::Start() {
       }
 
       auto segments = serializer_->DecodeFieldIndexSegments(&reader, *message);
+      auto covered_fields =
+          serializer_->DecodeFieldIndexCoveredFields(&reader, *message);
       if (!reader.ok()) {
         HARD_FAIL("Index proto failed to decode: %s",
                   reader.status().ToString());
@@ -294,9 +305,9 @@ void LevelDbIndexManager::Start() {
 
       // Store the index and update `memoized_max_index_id_` and
       // `memoized_max_sequence_number_`.
-      MemoizeIndex(FieldIndex(config_key.index_id(),
-                              config_key.collection_group(),
-                              std::move(segments), state));
+      MemoizeIndex(FieldIndex(
+          config_key.index_id(), config_key.collection_group(),
+          std::move(segments), state, std::move(covered_fields)));
     }
   }
 
@@ -352,12 +363,14 @@ void LevelDbIndexManager::AddFieldIndex(const FieldIndex& index) {
 
   int next_index_id = memoized_max_index_id_ + 1;
   FieldIndex new_index(next_index_id, index.collection_group(),
-                       index.segments(), index.index_state());
+                       index.segments(), index.index_state(),
+                       index.covered_fields());
 
   auto config_key = LevelDbIndexConfigurationKey::Key(
       new_index.index_id(), new_index.collection_group());
   db_->current_transaction()->Put(
-      config_key, serializer_->EncodeFieldIndexSegments(new_index.segments()));
+      config_key, serializer_->EncodeFieldIndexSegments(
+                      new_index.segments(), new_index.covered_fields()));
 
   MemoizeIndex(std::move(new_index));
 }
@@ -558,9 +571,9 @@ IndexManager::IndexType LevelDbIndexManager::GetIndexType(
   return result;
 }
 
-absl::optional<std::vector<model::DocumentKey>>
-LevelDbIndexManager::GetDocumentsMatchingTarget(const core::Target& target) {
-  std::vector<std::pair<core::Target, model::FieldIndex>> indexes;
+absl::optional<std::vector<std::pair<Target, FieldIndex>>>
+LevelDbIndexManager::GetSubTargetIndexes(const Target& target) {
+  std::vector<std::pair<Target, FieldIndex>> indexes;
   for (const auto& sub_target : GetSubTargets(target)) {
     auto index_opt = GetFieldIndex(sub_target);
     if (!index_opt.has_value()) {
@@ -568,50 +581,209 @@ LevelDbIndexManager::GetDocumentsMatchingTarget(const core::Target& target) {
     }
     indexes.emplace_back(sub_target, index_opt.value());
   }
+  return indexes;
+}
 
-  std::vector<DocumentKey> result;
-  std::unordered_set<std::string> existing_keys;
-  for (const auto& entry : indexes) {
-    const Target& sub_target = entry.first;
-    const FieldIndex& index = entry.second;
-
-    LOG_DEBUG("Using index %s to execute target %s", index.collection_group(),
-              sub_target.CanonicalId());
+std::vector<LevelDbIndexManager::IndexRange>
+LevelDbIndexManager::GetIndexRanges(const Target& sub_target,
+                                    const FieldIndex& index) {
+  LOG_DEBUG("Using index %s to execute target %s", index.collection_group(),
+            sub_target.CanonicalId());
+
+  auto array_values = sub_target.GetArrayValues(index);
+  auto not_in_values = sub_target.GetNotInValues(index);
+  auto lower_bound = sub_target.GetLowerBound(index);
+  auto upper_bound = sub_target.GetUpperBound(index);
+
+  auto encoded_lower = EncodeBound(index, sub_target, lower_bound);
+  auto encoded_upper = EncodeBound(index, sub_target, upper_bound);
+  auto encoded_not_in = EncodeValues(index, sub_target, not_in_values);
+
+  return GenerateIndexRanges(index.index_id(), array_values, encoded_lower,
+                             lower_bound.inclusive, encoded_upper,
+                             upper_bound.inclusive, encoded_not_in);
+}
 
-    auto array_values = sub_target.GetArrayValues(index);
-    auto not_in_values = sub_target.GetNotInValues(index);
-    auto lower_bound = sub_target.GetLowerBound(index);
-    auto upper_bound = sub_target.GetUpperBound(index);
+std::vector<LevelDbIndexManager::IndexRange>
+LevelDbIndexManager::CoalesceRanges(std::vector<IndexRange> ranges) {
+  std::sort(ranges.begin(), ranges.end(),
+            [](const IndexRange& left, const IndexRange& right) {
+              return left.lower < right.lower;
+            });
 
-    auto encoded_lower = EncodeBound(index, sub_target, lower_bound);
-    auto encoded_upper = EncodeBound(index, sub_target, upper_bound);
-    auto encoded_not_in = EncodeValues(index, sub_target, not_in_values);
+  std::vector<IndexRange> result;
+  for (IndexRange& range : ranges) {
+    if (!result.empty() && range.lower <= result.back().upper) {
+      IndexRange& previous = result.back();
+      previous.upper = std::max(previous.upper, range.upper);
+      previous.directional_prefix_length =
+          std::min(previous.directional_prefix_length,
+                   range.directional_prefix_length);
+    } else {
+      result.push_back(std::move(range));
+    }
+  }
+  return result;
+}
 
-    auto index_ranges = GenerateIndexRanges(
-        index.index_id(), array_values, encoded_lower, lower_bound.inclusive,
-        encoded_upper, upper_bound.inclusive, encoded_not_in);
+void LevelDbIndexManager::ScanIndex(const Target& sub_target,
+                                    const FieldIndex& index,
+                                    bool read_values,
+                                    const IndexEntryVisitor& visitor) {
+  std::vector<IndexRange> ranges =
+      CoalesceRanges(GetIndexRanges(sub_target, index));
+  int32_t limit = sub_target.limit();
 
-    auto iter = db_->current_transaction()->NewIterator();
-    for (const auto& range : index_ranges) {
-      int32_t count = 0;
-      for (iter->Seek(range.lower); iter->Valid() && count < target.limit() &&
-                                    iter->key() <= range.upper;
-           iter->Next()) {
-        LevelDbIndexEntryKey entry_key;
-        if (!entry_key.Decode(iter->key())) {
-          break;
-        }
-
-        ++count;
-        if (existing_keys.find(entry_key.document_key()) ==
-            existing_keys.end()) {
-          result.push_back(
-              DocumentKey::FromPathString(entry_key.document_key()));
-          existing_keys.insert(entry_key.document_key());
-        }
+  // Read the ranges in key order, only seeking when the next range starts
+  // after the entry the iterator is positioned at.
+  auto iter = db_->current_transaction()->NewIterator();
+  LevelDbIndexEntryKey key;
+  auto scan_range = [&](const IndexRange& range,
+                        const IndexEntryVisitor& visit_range) {
+    if (!iter->Valid() || iter->key() < range.lower) {
+      iter->Seek(range.lower);
+    }
+    for (int32_t count = 0;
+         iter->Valid() && count < limit && iter->key() <= range.upper;
+         iter->Next(), ++count) {
+      if (!key.Decode(iter->key())) {
+        break;
       }
+      visit_range(key, iter->value());
+    }
+  };
+
+  // Entries of ranges that differ only in the values of `IN` (or
+  // `array-contains-any`) filters sort in query order once the directional
+  // prefix they share within their range is dropped. Merging them is only
+  // worthwhile if the scan can stop at the limit, and only correct if the
+  // filtered fields are not part of the query order.
+  bool mergeable = sub_target.HasLimit() && ranges.size() > 1 &&
+                   !sub_target.GetNotInValues(index).has_value();
+  for (const core::OrderBy& order_by : sub_target.order_bys()) {
+    mergeable = mergeable && !IsInFilter(sub_target, order_by.field());
+  }
+
+  if (!mergeable) {
+    for (const IndexRange& range : ranges) {
+      scan_range(range, visitor);
+    }
+    return;
+  }
+
+  std::vector<std::vector<ScannedEntry>> range_entries(ranges.size());
+  for (size_t i = 0; i < ranges.size(); ++i) {
+    std::vector<ScannedEntry>& entries = range_entries[i];
+    scan_range(ranges[i], [&](const LevelDbIndexEntryKey& entry_key,
+                              const std::string& value) {
+      entries.push_back(
+          ScannedEntry{entry_key, read_values ? value : std::string()});
+    });
+  }
+
+  using Cursor = std::pair<size_t, size_t>;  // (range, entry)
+  auto sort_key = [&](const Cursor& cursor) {
+    const LevelDbIndexEntryKey& entry_key =
+        range_entries[cursor.first][cursor.second].key;
+    absl::string_view directional_value = entry_key.directional_value();
+    directional_value.remove_prefix(
+        std::min(ranges[cursor.first].directional_prefix_length,
+                 directional_value.size()));
+    return std::make_pair(directional_value,
+                          absl::string_view(entry_key.ordered_document_key()));
+  };
+  auto comparator = [&](const Cursor& left, const Cursor& right) {
+    return sort_key(left) > sort_key(right);
+  };
+  std::priority_queue<Cursor, std::vector<Cursor>, decltype(comparator)> heap(
+      comparator);
+  for (size_t i = 0; i < range_entries.size(); ++i) {
+    if (!range_entries[i].empty()) {
+      heap.emplace(i, 0);
+    }
+  }
+
+  // A document that matches several ranges has the same sort key in each of
+  // them, so its duplicates are adjacent in the merged order.
+  const ScannedEntry* previous = nullptr;
+  int32_t count = 0;
+  while (!heap.empty() && count < limit) {
+    Cursor cursor = heap.top();
+    heap.pop();
+
+    const ScannedEntry& entry = range_entries[cursor.first][cursor.second];
+    if (!previous || previous->key.ordered_document_key() !=
+                         entry.key.ordered_document_key()) {
+      visitor(entry.key, entry.value);
+      previous = &entry;
+      ++count;
+    }
+
+    if (cursor.second + 1 < range_entries[cursor.first].size()) {
+      heap.emplace(cursor.first, cursor.second + 1);
     }
   }
+}
+
+absl::optional<std::vector<model::DocumentKey>>
+LevelDbIndexManager::GetDocumentsMatchingTarget(const core::Target& target) {
+  auto indexes = GetSubTargetIndexes(target);
+  if (!indexes.has_value()) {
+    return absl::nullopt;
+  }
+
+  // Entries are deduplicated by their encoded document key, so that only the
+  // keys of new documents are parsed.
+  std::vector<DocumentKey> result;
+  std::unordered_set<std::string> existing_keys;
+  for (const auto& entry : *indexes) {
+    ScanIndex(entry.first, entry.second, /* read_values= */ false,
+              [&](const LevelDbIndexEntryKey& key, const std::string&) {
+                if (existing_keys.insert(key.document_key()).second) {
+                  result.push_back(
+                      DocumentKey::FromPathString(key.document_key()));
+                }
+              });
+  }
+
+  return result;
+}
+
+absl::optional<std::vector<MutableDocument>>
+LevelDbIndexManager::GetCoveredDocumentsMatchingTarget(
+    const core::Target& target, const std::vector<FieldPath>& fields) {
+  auto indexes = GetSubTargetIndexes(target);
+  if (!indexes.has_value()) {
+    return absl::nullopt;
+  }
+  for (const auto& entry : *indexes) {
+    if (!entry.second.Covers(fields)) {
+      return absl::nullopt;
+    }
+  }
+
+  std::vector<MutableDocument> result;
+  std::unordered_set<std::string> existing_keys;
+  for (const auto& entry : *indexes) {
+    ScanIndex(
+        entry.first, entry.second, /* read_values= */ true,
+        [&](const LevelDbIndexEntryKey& key, const std::string& value) {
+          if (!existing_keys.insert(key.document_key()).second) {
+            return;
+          }
+
+          // The entry stores the covered fields as a partial document, so the
+          // document itself is never read.
+          util::ReadContext context;
+          MutableDocument document =
+              serializer_->DecodeMaybeDocument(&context, value);
+          if (!context.ok()) {
+            HARD_FAIL("Covered index entry failed to parse: %s",
+                      context.status().ToString());
+          }
+          result.push_back(std::move(document));
+        });
+  }
 
   return result;
 }
@@ -738,13 +910,21 @@ std::vector<LevelDbIndexManager::IndexRange> LevelDbIndexManager::CreateRange(
 
   std::vector<LevelDbIndexManager::IndexRange> ranges;
   for (size_t i = 0; i < bounds.size(); i += 2) {
+    const std::string& lower = bounds[i].directional_value();
+    const std::string& upper = bounds[i + 1].directional_value();
+    size_t prefix_length =
+        std::mismatch(lower.begin(),
+                      lower.begin() + std::min(lower.size(), upper.size()),
+                      upper.begin())
+            .first -
+        lower.begin();
+
     ranges.push_back(LevelDbIndexManager::IndexRange{
         LevelDbIndexEntryKey::KeyPrefix(bounds[i].index_id(), uid_,
-                                        bounds[i].array_value(),
-                                        bounds[i].directional_value()),
+                                        bounds[i].array_value(), lower),
         LevelDbIndexEntryKey::KeyPrefix(bounds[i + 1].index_id(), uid_,
-                                        bounds[i + 1].array_value(),
-                                        bounds[i + 1].directional_value())});
+                                        bounds[i + 1].array_value(), upper),
+        prefix_length});
   }
   return ranges;
 }
@@ -770,9 +950,10 @@ void LevelDbIndexManager::UpdateCollectionGroup(
     db_->current_transaction()->Put(std::move(state_key),
                                     EncodeIndexState(updated_state));
 
-    MemoizeIndex(FieldIndex{field_index.index_id(),
-                            field_index.collection_group(),
-                            field_index.segments(), std::move(updated_state)});
+    MemoizeIndex(FieldIndex{
+        field_index.index_id(), field_index.collection_group(),
+        field_index.segments(), std::move(updated_state),
+        field_index.covered_fields()});
   }
 }
 
@@ -790,8 +971,14 @@ void LevelDbIndexManager::UpdateIndexEntries(
     for (const auto& index : indexes) {
       auto existing_entries = GetExistingIndexEntries(kv.first, index);
       auto new_entries = ComputeIndexEntries(kv.second, index);
+      std::string covered_values = EncodeCoveredValues(index, kv.second);
       if (existing_entries != new_entries) {
-        UpdateEntries(kv.second, index, existing_entries, new_entries);
+        UpdateEntries(kv.second, index, existing_entries, new_entries,
+                      covered_values);
+      }
+      if (!index.covered_fields().empty()) {
+        UpdateCoveredValues(kv.second, index, existing_entries, new_entries,
+                            covered_values);
       }
     }
   }
@@ -878,34 +1065,96 @@ void LevelDbIndexManager::UpdateEntries(
     const model::Document& document,
     const FieldIndex& index,
     const std::set<IndexEntry>& existing_entries,
-    const std::set<IndexEntry>& new_entries) {
+    const std::set<IndexEntry>& new_entries,
+    const std::string& covered_values) {
   util::DiffSets<IndexEntry>(
       existing_entries, new_entries,
       [](const IndexEntry& left, const IndexEntry& right) {
         return left.CompareTo(right);
       },
-      [this, document, index](const IndexEntry& entry) {
-        this->AddIndexEntry(document, index, entry);
+      [this, document, index, &covered_values](const IndexEntry& entry) {
+        this->AddIndexEntry(document, index, entry, covered_values);
       },
       [this, document, index](const IndexEntry& entry) {
         this->DeleteIndexEntry(document, index, entry);
       });
 }
 
+void LevelDbIndexManager::UpdateCoveredValues(
+    const model::Document& document,
+    const FieldIndex& index,
+    const std::set<IndexEntry>& existing_entries,
+    const std::set<IndexEntry>& new_entries,
+    const std::string& covered_values) {
+  // Entries that were just added already store the current values, but
+  // entries that were kept may still store those of a previous version of the
+  // document. All entries of a document are written with the same values, so
+  // reading the values of one kept entry tells whether any are outdated.
+  bool outdated = false;
+  for (const IndexEntry& entry : new_entries) {
+    if (existing_entries.find(entry) == existing_entries.end()) {
+      continue;
+    }
+
+    std::string entry_key = IndexEntryKey(document, index, entry);
+    if (!outdated) {
+      std::string stored_values;
+      db_->current_transaction()->Get(entry_key, &stored_values);
+      if (stored_values == covered_values) {
+        return;
+      }
+      outdated = true;
+    }
+    db_->current_transaction()->Put(std::move(entry_key), covered_values);
+  }
+}
+
+std::string LevelDbIndexManager::EncodeCoveredValues(
+    const FieldIndex& index, const model::Document& document) {
+  if (index.covered_fields().empty()) {
+    return "";
+  }
+
+  ObjectValue values;
+  auto copy_field = [&](const FieldPath& field_path) {
+    auto value = document->field(field_path);
+    if (value.has_value()) {
+      values.Set(field_path, model::DeepClone(*value));
+    }
+  };
+  for (const auto& segment : index.GetDirectionalSegments()) {
+    copy_field(segment.field_path());
+  }
+  for (const auto& field_path : index.covered_fields()) {
+    copy_field(field_path);
+  }
+
+  return serializer_->EncodeMaybeDocumentToString(
+      MutableDocument::FoundDocument(document->key(), document->version(),
+                                     std::move(values)));
+}
+
+std::string LevelDbIndexManager::IndexEntryKey(const model::Document& document,
+                                               const FieldIndex& index,
+                                               const IndexEntry& entry) {
+  return LevelDbIndexEntryKey::Key(
+      entry.index_id(), uid_, entry.array_value(), entry.directional_value(),
+      EncodedDirectionalKey(index, document->key()),
+      document->key().path().CanonicalString());
+}
+
 void LevelDbIndexManager::AddIndexEntry(const model::Document& document,
                                         const FieldIndex& index,
-                                        const IndexEntry& entry) {
+                                        const IndexEntry& entry,
+                                        const std::string& covered_values) {
   std::string document_key = document->key().path().CanonicalString();
-  auto entry_key = LevelDbIndexEntryKey::Key(
-      entry.index_id(), uid_, entry.array_value(), entry.directional_value(),
-      EncodedDirectionalKey(index, document->key()), document_key);
-  db_->current_transaction()->Put(entry_key, "");
+  auto entry_key = IndexEntryKey(document, index, entry);
+  db_->current_transaction()->Put(entry_key, covered_values);
 
   auto document_key_index_prefix =
       LevelDbIndexEntryDocumentKeyIndexKey::KeyPrefix(entry.index_id(), uid_,
                                                       document_key);
-  std::unique_ptr<leveldb::Iterator> iter(
-      db_->ptr()->NewIterator(LevelDbTransaction::DefaultReadOptions()));
+  std::unique_ptr<leveldb::Iterator> iter = db_->NewCommittedIterator();
   iter->Seek(util::PrefixSuccessor(document_key_index_prefix));
   iter->Prev();
   absl::string_view raw_key;
@@ -942,10 +1191,7 @@ void LevelDbIndexManager::DeleteIndexEntry(const model::Document& document,
                                            const FieldIndex& index,
                                            const IndexEntry& entry) {
   std::string document_key = document->key().path().CanonicalString();
-  auto entry_key = LevelDbIndexEntryKey::Key(
-      entry.index_id(), uid_, entry.array_value(), entry.directional_value(),
-      EncodedDirectionalKey(index, document->key()), document_key);
-  db_->current_transaction()->Delete(entry_key);
+  db_->current_transaction()->Delete(IndexEntryKey(document, index, entry));
 
   auto document_key_index_prefix =
       LevelDbIndexEntryDocumentKeyIndexKey::KeyPrefix(entry.index_id(), uid_,
@@ -17,10 +17,12 @@
 #ifndef FIRESTORE_CORE_SRC_LOCAL_LEVELDB_INDEX_MANAGER_H_
 #define FIRESTORE_CORE_SRC_LOCAL_LEVELDB_INDEX_MANAGER_H_
 
+#include <functional>
 #include <queue>
 #include <set>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "Firestore/core/src/core/target.h"
@@ -83,6 +85,11 @@ class LevelDbIndexManager : public IndexManager {
   absl::optional<std::vector<model::DocumentKey>> GetDocumentsMatchingTarget(
       const core::Target& target) override;
 
+  absl::optional<std::vector<model::MutableDocument>>
+  GetCoveredDocumentsMatchingTarget(
+      const core::Target& target,
+      const std::vector<model::FieldPath>& fields) override;
+
   absl::optional<std::string> GetNextCollectionGroupToUpdate() const override;
 
   void UpdateCollectionGroup(const std::string& collection_group,
@@ -100,8 +107,24 @@ class LevelDbIndexManager : public IndexManager {
   struct IndexRange {
     std::string lower;
     std::string upper;
+
+    // The length of the prefix that the directional values of all entries in
+    // the range share.
+    size_t directional_prefix_length = 0;
   };
 
+  // An index entry buffered by `ScanIndex` to merge ranges.
+  struct ScannedEntry {
+    LevelDbIndexEntryKey key;
+
+    // The value of the entry, only read if requested.
+    std::string value;
+  };
+
+  // Receives the key and value of an index entry read by `ScanIndex`.
+  using IndexEntryVisitor = std::function<void(
+      const LevelDbIndexEntryKey& key, const std::string& value)>;
+
   /**
    * Stores the index in the memoized indexes table and updates
    * `next_index_to_update_` `memoized_max_index_id_` and
@@ -121,16 +144,41 @@ class LevelDbIndexManager : public IndexManager {
   /**
    * Updates the index entries for the provided document by deleting entries
    * that are no longer referenced in `new_entries` and adding all newly added
-   * entries.
+   * entries, which store `covered_values` (see `EncodeCoveredValues`).
    */
   void UpdateEntries(const model::Document& document,
                      const model::FieldIndex& index,
                      const std::set<index::IndexEntry>& existing_entries,
-                     const std::set<index::IndexEntry>& new_entries);
+                     const std::set<index::IndexEntry>& new_entries,
+                     const std::string& covered_values);
+
+  /**
+   * Rewrites the covered values stored in the entries of a covering index that
+   * exist in both `existing_entries` and `new_entries` if they differ from
+   * `covered_values`.
+   */
+  void UpdateCoveredValues(const model::Document& document,
+                           const model::FieldIndex& index,
+                           const std::set<index::IndexEntry>& existing_entries,
+                           const std::set<index::IndexEntry>& new_entries,
+                           const std::string& covered_values);
+
+  /**
+   * Returns the value stored in the index entries of `document`: for covering
+   * indexes, a partial document with only the covered fields and the fields of
+   * the directional segments; otherwise, an empty string.
+   */
+  std::string EncodeCoveredValues(const model::FieldIndex& index,
+                                  const model::Document& document);
+
+  std::string IndexEntryKey(const model::Document& document,
+                            const model::FieldIndex& index,
+                            const index::IndexEntry& entry);
 
   void AddIndexEntry(const model::Document& document,
                      const model::FieldIndex& index,
-                     const index::IndexEntry& entry);
+                     const index::IndexEntry& entry,
+                     const std::string& covered_values);
 
   void DeleteIndexEntry(const model::Document& document,
                         const model::FieldIndex& index,
@@ -156,6 +204,41 @@ class LevelDbIndexManager : public IndexManager {
 
   std::vector<core::Target> GetSubTargets(const core::Target& target);
 
+  /**
+   * Returns the sub-targets of `target` along with the index that serves each
+   * of them, or `nullopt` if one of them cannot be served from an index.
+   */
+  absl::optional<std::vector<std::pair<core::Target, model::FieldIndex>>>
+  GetSubTargetIndexes(const core::Target& target);
+
+  /** Returns the ranges of index entries that `index` holds for the target. */
+  std::vector<IndexRange> GetIndexRanges(const core::Target& sub_target,
+                                         const model::FieldIndex& index);
+
+  /**
+   * Sorts the given ranges and merges the ones that overlap, so that they can
+   * be read in key order.
+   */
+  static std::vector<IndexRange> CoalesceRanges(
+      std::vector<IndexRange> ranges);
+
+  /**
+   * Reads the entries of `index` that match `sub_target` and passes them to
+   * `visitor`, visiting all of its ranges in key order with a single iterator
+   * and reading at most `limit` entries per range.
+   *
+   * If the target has a limit and its ranges differ only in the values of `IN`
+   * or `array-contains-any` filters on fields that the target is not ordered
+   * by, the entries of all ranges are buffered and merged in query order, and
+   * the scan stops after `limit` distinct documents. In that case, values are
+   * only passed if `read_values` is true. Otherwise, the entries are streamed
+   * in key order and may contain duplicates.
+   */
+  void ScanIndex(const core::Target& sub_target,
+                 const model::FieldIndex& index,
+                 bool read_values,
+                 const IndexEntryVisitor& visitor);
+
   model::IndexOffset GetMinOffset(
       const std::vector<model::FieldIndex>& indexes) const;
 
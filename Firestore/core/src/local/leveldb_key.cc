@@ -66,6 +66,7 @@ const char* kDocumentOverlaysCollectionIndexTable =
 const char* kDocumentOverlaysCollectionGroupIndexTable =
     "document_overlays_collection_group_index";
 const char* kDataMigrationTable = "data_migration";
+const char* kFieldNamesTable = "field_names";
 
 /**
  * Labels for the components of keys. These serve to make keys self-describing.
@@ -165,6 +166,11 @@ enum ComponentLabel {
    */
   GlobalName = 26,
 
+  /**
+   * The id of a field name in a dictionary-encoded document.
+   */
+  FieldNameId = 27,
+
   /**
    * A path segment describes just a single segment in a resource path. Path
    * segments that occur sequentially in a key represent successive segments in
@@ -283,6 +289,10 @@ class Reader {
     return ReadLabeledString(ComponentLabel::DataMigrationName);
   }
 
+  int32_t ReadFieldNameId() {
+    return ReadLabeledInt32(ComponentLabel::FieldNameId);
+  }
+
   /**
    * Reads a snapshot version, encoded as a component label and a pair of
    * seconds (int64) and nanoseconds (int32).
@@ -697,6 +707,11 @@ std::string Reader::Describe() {
         absl::StrAppend(&description,
                         " data_migration_name=", std::move(value));
       }
+    } else if (label == ComponentLabel::FieldNameId) {
+      int32_t field_name_id = ReadFieldNameId();
+      if (ok_) {
+        absl::StrAppend(&description, " field_name_id=", field_name_id);
+      }
     } else {
       absl::StrAppend(&description, " unknown label=", static_cast<int>(label));
       Fail();
@@ -812,6 +827,10 @@ class Writer {
     WriteLabeledString(ComponentLabel::DataMigrationName, name);
   }
 
+  void WriteFieldNameId(int32_t id) {
+    WriteLabeledInt32(ComponentLabel::FieldNameId, id);
+  }
+
  private:
   /** Writes a component label to the given key destination. */
   void WriteComponentLabel(ComponentLabel label) {
@@ -1654,6 +1673,38 @@ bool LevelDbDataMigrationKey::Decode(absl::string_view key) {
   return reader.ok();
 }
 
+std::string LevelDbFieldNameKey::KeyPrefix() {
+  Writer writer;
+  writer.WriteTableName(kFieldNamesTable);
+  return writer.result();
+}
+
+std::string LevelDbFieldNameKey::KeyPrefix(absl::string_view collection_group) {
+  Writer writer;
+  writer.WriteTableName(kFieldNamesTable);
+  writer.WriteCollectionGroup(collection_group);
+  return writer.result();
+}
+
+std::string LevelDbFieldNameKey::Key(absl::string_view collection_group,
+                                     int32_t field_name_id) {
+  Writer writer;
+  writer.WriteTableName(kFieldNamesTable);
+  writer.WriteCollectionGroup(collection_group);
+  writer.WriteFieldNameId(field_name_id);
+  writer.WriteTerminator();
+  return writer.result();
+}
+
+bool LevelDbFieldNameKey::Decode(absl::string_view key) {
+  Reader reader{key};
+  reader.ReadTableNameMatching(kFieldNamesTable);
+  collection_group_ = reader.ReadCollectionGroup();
+  field_name_id_ = reader.ReadFieldNameId();
+  reader.ReadTerminator();
+  return reader.ok();
+}
+
 }  // namespace local
 }  // namespace firestore
 }  // namespace firebase
@@ -152,6 +152,11 @@ namespace local {
 // data_migration:
 //   - table_name: "data_migration"
 //   - migration_name: string
+//
+// field_names:
+//   - table_name: "field_names"
+//   - collection_group: string
+//   - field_name_id: int32_t
 
 /**
  * Parses the given key and returns a human readable description of its
@@ -1028,6 +1033,14 @@ class LevelDbIndexEntryKey {
     return directional_value_;
   }
 
+  /**
+   * The document key this entry points to, encoded so that it sorts in the
+   * direction of the index.
+   */
+  const std::string& ordered_document_key() const {
+    return ordered_document_key_;
+  }
+
   /** The document key this entry points to. */
   const std::string& document_key() const {
     return document_key_;
@@ -1375,6 +1388,55 @@ class LevelDbDataMigrationKey {
   std::string migration_name_;
 };
 
+/**
+ * A key in the field_names table, storing the field name that is represented
+ * by the given id in dictionary-encoded documents of a collection group.
+ */
+class LevelDbFieldNameKey {
+ public:
+  /**
+   * Creates a key prefix that points just before the first key of the table.
+   */
+  static std::string KeyPrefix();
+
+  /**
+   * Creates a key prefix that points just before the first key for the given
+   * collection group.
+   */
+  static std::string KeyPrefix(absl::string_view collection_group);
+
+  /**
+   * Creates a complete key that points to the field name with the given id.
+   */
+  static std::string Key(absl::string_view collection_group,
+                         int32_t field_name_id);
+
+  /**
+   * Decodes the given complete key, storing the decoded values in this
+   * instance.
+   *
+   * @return true if the key successfully decoded, false otherwise. If false is
+   * returned, this instance is in an undefined state until the next call to
+   * `Decode()`.
+   */
+  ABSL_MUST_USE_RESULT
+  bool Decode(absl::string_view key);
+
+  /** The collection group for this entry. */
+  const std::string& collection_group() const {
+    return collection_group_;
+  }
+
+  /** The id of the field name within its collection group. */
+  int32_t field_name_id() const {
+    return field_name_id_;
+  }
+
+ private:
+  std::string collection_group_;
+  int32_t field_name_id_ = 0;
+};
+
 }  // namespace local
 }  // namespace firestore
 }  // namespace firebase
@@ -56,10 +56,13 @@ using nanopb::Message;
 using nanopb::StringReader;
 
 BatchId LoadNextBatchIdFromDb(DB* db) {
+  return LoadNextBatchIdFromDb(std::unique_ptr<Iterator>(
+      db->NewIterator(LevelDbTransaction::DefaultReadOptions())));
+}
+
+BatchId LoadNextBatchIdFromDb(std::unique_ptr<Iterator> it) {
   // TODO(gsoltis): implement Prev() and SeekToLast() on
   // LevelDbTransaction::Iterator, then port this to a transaction.
-  std::unique_ptr<Iterator> it(
-      db->NewIterator(LevelDbTransaction::DefaultReadOptions()));
 
   std::string table_key = LevelDbMutationKey::KeyPrefix();
 
@@ -135,7 +138,7 @@ LevelDbMutationQueue::LevelDbMutationQueue(const User& user,
 }
 
 void LevelDbMutationQueue::Start() {
-  next_batch_id_ = LoadNextBatchIdFromDb(db_->ptr());
+  next_batch_id_ = LoadNextBatchIdFromDb(db_->NewCommittedIterator());
   metadata_ = MetadataForKey(mutation_queue_key());
 }
 
@@ -374,8 +377,7 @@ LevelDbMutationQueue::NextMutationBatchAfterBatchId(model::BatchId batch_id) {
 }
 
 BatchId LevelDbMutationQueue::GetHighestUnacknowledgedBatchId() {
-  std::unique_ptr<Iterator> it(
-      db_->ptr()->NewIterator(LevelDbTransaction::DefaultReadOptions()));
+  std::unique_ptr<Iterator> it = db_->NewCommittedIterator();
 
   std::string next_user_key =
       util::PrefixSuccessor(LevelDbMutationKey::KeyPrefix(user_id_));
@@ -17,6 +17,7 @@
 #ifndef FIRESTORE_CORE_SRC_LOCAL_LEVELDB_MUTATION_QUEUE_H_
 #define FIRESTORE_CORE_SRC_LOCAL_LEVELDB_MUTATION_QUEUE_H_
 
+#include <memory>
 #include <set>
 #include <string>
 #include <vector>
@@ -50,6 +51,9 @@ class LocalSerializer;
  */
 model::BatchId LoadNextBatchIdFromDb(leveldb::DB* db);
 
+/** Like above, but reads the mutations through the given iterator. */
+model::BatchId LoadNextBatchIdFromDb(std::unique_ptr<leveldb::Iterator> it);
+
 class LevelDbMutationQueue : public MutationQueue {
  public:
   LevelDbMutationQueue(const credentials::User& user,
@@ -28,12 +28,14 @@
 #include "Firestore/core/src/local/leveldb_util.h"
 #include "Firestore/core/src/local/listen_sequence.h"
 #include "Firestore/core/src/local/lru_garbage_collector.h"
+#include "Firestore/core/src/local/persistence_tracer.h"
 #include "Firestore/core/src/local/reference_delegate.h"
 #include "Firestore/core/src/local/sizer.h"
 #include "Firestore/core/src/util/filesystem.h"
 #include "Firestore/core/src/util/hard_assert.h"
 #include "Firestore/core/src/util/log.h"
 #include "Firestore/core/src/util/string_util.h"
+#include "absl/base/config.h"
 #include "absl/memory/memory.h"
 #include "absl/strings/match.h"
 
@@ -51,6 +53,19 @@ using util::Status;
 using util::StatusOr;
 using util::StringFormat;
 
+#if ABSL_HAVE_THREAD_LOCAL
+/**
+ * The read-only transaction that the current thread is running, if any. This
+ * is trivially destructible, so it needs no cleanup on thread exit.
+ */
+struct ReadOnlyTransaction {
+  const LevelDbPersistence* persistence;
+  LevelDbTransaction* transaction;
+};
+
+thread_local ReadOnlyTransaction current_read_only_transaction{};
+#endif  // ABSL_HAVE_THREAD_LOCAL
+
 /**
  * Finds all user ids in the database based on the existence of a mutation
  * queue.
@@ -169,7 +184,42 @@ StatusOr<std::unique_ptr<DB>> LevelDbPersistence::OpenDb(const Path& dir) {
 
 // MARK: - LevelDB utilities
 
+void LevelDbPersistence::EnableGroupCommit(WriteDurability durability) {
+  HARD_ASSERT(transaction_ == nullptr,
+              "Enabling group commit while a transaction is in progress");
+  write_queue_ = absl::make_unique<LevelDbWriteQueue>(db_.get(), durability);
+}
+
+void LevelDbPersistence::SetFieldNameDictionaryEnabled(bool enabled) {
+  HARD_ASSERT(transaction_ == nullptr,
+              "Changing the field name dictionary while a transaction is in "
+              "progress");
+  document_cache_->set_field_name_dictionary_enabled(enabled);
+  if (!enabled) {
+    document_cache_->RemoveFieldNameDictionary();
+  }
+}
+
+std::unique_ptr<leveldb::Iterator> LevelDbPersistence::NewCommittedIterator() {
+  std::unique_ptr<leveldb::Iterator> result(
+      db_->NewIterator(LevelDbTransaction::DefaultReadOptions()));
+  if (write_queue_) {
+    auto pending_writes = write_queue_->pending_writes();
+    if (!pending_writes->empty()) {
+      result = NewPendingWritesIterator(std::move(pending_writes),
+                                        std::move(result));
+    }
+  }
+  return result;
+}
+
 LevelDbTransaction* LevelDbPersistence::current_transaction() {
+#if ABSL_HAVE_THREAD_LOCAL
+  if (current_read_only_transaction.persistence == this) {
+    return current_read_only_transaction.transaction;
+  }
+#endif  // ABSL_HAVE_THREAD_LOCAL
+
   HARD_ASSERT(transaction_ != nullptr,
               "Attempting to access transaction before one has started");
   return transaction_.get();
@@ -231,6 +281,16 @@ model::ListenSequenceNumber LevelDbPersistence::current_sequence_number()
 void LevelDbPersistence::Shutdown() {
   HARD_ASSERT(started_, "LevelDbPersistence shutdown without start!");
   started_ = false;
+  if (write_queue_) {
+    write_queue_->Flush();
+    LevelDbWriteQueue::Metrics metrics = write_queue_->metrics();
+    LOG_DEBUG(
+        "Group commit wrote %s commits in %s writes (at most %s at once), "
+        "with a maximum commit latency of %sus",
+        metrics.commits, metrics.writes, metrics.max_commits_per_write,
+        metrics.max_commit_latency.count());
+  }
+  write_queue_.reset();
   db_.reset();
 }
 
@@ -328,16 +388,64 @@ void LevelDbPersistence::RunInternal(absl::string_view label,
   HARD_ASSERT(transaction_ == nullptr,
               "Starting a transaction while one is already in progress");
 
+  OperationTrace trace(tracer(), label);
   transaction_ = absl::make_unique<LevelDbTransaction>(db_.get(), label);
+  if (trace.active()) {
+    transaction_->EnableReadCounting();
+  }
+  if (write_queue_) {
+    transaction_->ReadThrough(write_queue_->pending_writes());
+  }
   reference_delegate_->OnTransactionStarted(label);
 
   block();
 
   reference_delegate_->OnTransactionCommitted();
-  transaction_->Commit();
+  if (trace.active()) {
+    trace.set_counters(transaction_->counters());
+  }
+  if (write_queue_) {
+    transaction_->CommitTo(write_queue_.get());
+  } else {
+    transaction_->Commit();
+  }
   transaction_.reset();
 }
 
+void LevelDbPersistence::RunReadOnlyInternal(absl::string_view label,
+                                             std::function<void()> block) {
+#if ABSL_HAVE_THREAD_LOCAL
+  HARD_ASSERT(current_read_only_transaction.persistence == nullptr,
+              "Starting a read while one is already in progress");
+
+  auto transaction = write_queue_
+                         ? write_queue_->CreateReadOnlyTransaction(label)
+                         : LevelDbTransaction::CreateReadOnly(db_.get(), label);
+  current_read_only_transaction = {this, transaction.get()};
+  OperationTrace trace(tracer(), label);
+  if (trace.active()) {
+    transaction->EnableReadCounting();
+  }
+
+  block();
+
+  current_read_only_transaction = {};
+  if (trace.active()) {
+    trace.set_counters(transaction->counters());
+  }
+#else
+  RunInternal(label, std::move(block));
+#endif  // ABSL_HAVE_THREAD_LOCAL
+}
+
+bool LevelDbPersistence::SupportsConcurrentReads() const {
+#if ABSL_HAVE_THREAD_LOCAL
+  return true;
+#else
+  return false;
+#endif  // ABSL_HAVE_THREAD_LOCAL
+}
+
 leveldb::ReadOptions StandardReadOptions() {
   // For now this is paranoid, but perhaps disable that in production builds.
   leveldb::ReadOptions options;
@@ -34,6 +34,7 @@
 #include "Firestore/core/src/local/leveldb_remote_document_cache.h"
 #include "Firestore/core/src/local/leveldb_target_cache.h"
 #include "Firestore/core/src/local/leveldb_transaction.h"
+#include "Firestore/core/src/local/leveldb_write_queue.h"
 #include "Firestore/core/src/local/local_serializer.h"
 #include "Firestore/core/src/local/persistence.h"
 #include "Firestore/core/src/util/path.h"
@@ -63,12 +64,51 @@ class LevelDbPersistence : public Persistence {
 
   ~LevelDbPersistence();
 
+  /**
+   * Returns the transaction of the calling thread: the read-only transaction
+   * it is running through `RunReadOnly`, if any, or else the transaction
+   * started by `Run`.
+   */
   LevelDbTransaction* current_transaction();
 
   leveldb::DB* ptr() {
     return db_.get();
   }
 
+  /**
+   * Switches to group commit: instead of writing each transaction as it
+   * commits, hands its changes to a `LevelDbWriteQueue` that writes them on a
+   * separate thread. Transactions keep observing all committed changes.
+   *
+   * Must be called while no transaction is in progress.
+   */
+  void EnableGroupCommit(WriteDurability durability);
+
+  /**
+   * Sets whether cached documents are written with dictionary-encoded field
+   * names, which SDK versions that predate dictionary encoding can't read.
+   *
+   * Disabling the dictionary rewrites the documents that an earlier run
+   * encoded in the regular format and deletes the dictionary, so that the
+   * cache can be read by older SDK versions again. This scans the entire
+   * remote document cache, but only once after the dictionary was used.
+   *
+   * Must be called while no transaction is in progress.
+   */
+  void SetFieldNameDictionaryEnabled(bool enabled);
+
+  /** Returns the write queue used for group commit, or null if disabled. */
+  LevelDbWriteQueue* write_queue() {
+    return write_queue_.get();
+  }
+
+  /**
+   * Returns an iterator over the committed contents of the database, outside
+   * of any transaction. Unlike iterating `ptr()` directly, this includes
+   * changes still waiting in the write queue.
+   */
+  std::unique_ptr<leveldb::Iterator> NewCommittedIterator();
+
   const std::set<std::string> users() const {
     return users_;
   }
@@ -81,6 +121,8 @@ class LevelDbPersistence : public Persistence {
 
   model::ListenSequenceNumber current_sequence_number() const override;
 
+  bool SupportsConcurrentReads() const override;
+
   void Shutdown() override;
 
   LevelDbBundleCache* bundle_cache() override;
@@ -109,6 +151,14 @@ class LevelDbPersistence : public Persistence {
   void RunInternal(absl::string_view label,
                    std::function<void()> block) override;
 
+  /**
+   * Runs `block` against a LevelDB snapshot. Reads don't take part in the
+   * transaction started by `Run`, so they may run on any thread while the
+   * worker queue keeps committing writes.
+   */
+  void RunReadOnlyInternal(absl::string_view label,
+                           std::function<void()> block) override;
+
  private:
   friend class LevelDbOverlayMigrationManagerTest;
   friend class LevelDbLocalStoreTest;
@@ -172,6 +222,10 @@ class LevelDbPersistence : public Persistence {
   std::unique_ptr<LevelDbLruReferenceDelegate> reference_delegate_;
 
   std::unique_ptr<LevelDbTransaction> transaction_;
+
+  // Declared after `db_` so that pending writes are written before the
+  // database is closed.
+  std::unique_ptr<LevelDbWriteQueue> write_queue_;
 };
 
 /** Returns a standard set of read options. */
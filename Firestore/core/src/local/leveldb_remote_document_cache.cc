@@ -16,11 +16,11 @@
 
 #include "Firestore/core/src/local/leveldb_remote_document_cache.h"
 
+#include <algorithm>
 #include <string>
 #include <thread>  // NOLINT(build/c++11)
 #include <utility>
 
-#include "Firestore/Protos/nanopb/firestore/local/maybe_document.nanopb.h"
 #include "Firestore/core/src/core/query.h"
 #include "Firestore/core/src/local/leveldb_key.h"
 #include "Firestore/core/src/local/leveldb_persistence.h"
@@ -30,12 +30,12 @@
 #include "Firestore/core/src/model/model_fwd.h"
 #include "Firestore/core/src/model/mutable_document.h"
 #include "Firestore/core/src/model/overlay.h"
-#include "Firestore/core/src/nanopb/message.h"
-#include "Firestore/core/src/nanopb/reader.h"
 #include "Firestore/core/src/util/background_queue.h"
 #include "Firestore/core/src/util/executor.h"
+#include "Firestore/core/src/util/read_context.h"
 #include "Firestore/core/src/util/status.h"
 #include "Firestore/core/src/util/string_util.h"
+#include "absl/strings/match.h"
 #include "leveldb/db.h"
 
 namespace firebase {
@@ -52,8 +52,7 @@ using model::MutableDocument;
 using model::MutableDocumentMap;
 using model::ResourcePath;
 using model::SnapshotVersion;
-using nanopb::Message;
-using nanopb::StringReader;
+using model::ToSortedMap;
 using util::BackgroundQueue;
 using util::Executor;
 
@@ -111,9 +110,19 @@ void LevelDbRemoteDocumentCache::Add(const MutableDocument& document,
   const DocumentKey& key = document.key();
   const ResourcePath& path = key.path();
 
+  // Documents are only dictionary-encoded as they are written, so enabling the
+  // dictionary doesn't require rewriting the cache.
   std::string ldb_document_key = LevelDbRemoteDocumentKey::Key(key);
-  db_->current_transaction()->Put(ldb_document_key,
-                                  serializer_->EncodeMaybeDocument(document));
+  if (field_name_dictionary_enabled_) {
+    LevelDbFieldNameDictionary* dictionary = field_names();
+    db_->current_transaction()->Put(
+        ldb_document_key,
+        serializer_->EncodeMaybeDocumentToString(document, dictionary));
+    dictionary->SavePendingFieldNames(db_->current_transaction());
+  } else {
+    db_->current_transaction()->Put(
+        ldb_document_key, serializer_->EncodeMaybeDocumentToString(document));
+  }
 
   std::string ldb_read_time_key = LevelDbRemoteDocumentReadTimeKey::Key(
       path.PopLast(), read_time, path.last_segment());
@@ -129,13 +138,20 @@ void LevelDbRemoteDocumentCache::Remove(const DocumentKey& key) {
 }
 
 MutableDocument LevelDbRemoteDocumentCache::Get(const DocumentKey& key) const {
+  return Get(db_->current_transaction(), field_names(), key);
+}
+
+MutableDocument LevelDbRemoteDocumentCache::Get(
+    LevelDbTransaction* transaction,
+    const LevelDbFieldNameDictionary* dictionary,
+    const DocumentKey& key) const {
   std::string ldb_key = LevelDbRemoteDocumentKey::Key(key);
   std::string value;
-  Status status = db_->current_transaction()->Get(ldb_key, &value);
+  Status status = transaction->Get(ldb_key, &value);
   if (status.IsNotFound()) {
     return MutableDocument::InvalidDocument(key);
   } else if (status.ok()) {
-    return DecodeMaybeDocument(value, key);
+    return DecodeMaybeDocument(value, key, dictionary);
   } else {
     HARD_FAIL("Fetch document for key (%s) failed with status: %s",
               key.ToString(), status.ToString());
@@ -144,6 +160,9 @@ MutableDocument LevelDbRemoteDocumentCache::Get(const DocumentKey& key) const {
 
 MutableDocumentMap LevelDbRemoteDocumentCache::GetAll(
     const DocumentKeySet& keys) const {
+  // The dictionary is resolved on this thread, which owns the transaction.
+  const LevelDbFieldNameDictionary* dictionary = field_names();
+
   BackgroundQueue tasks(executor_.get());
   AsyncResults<std::pair<DocumentKey, MutableDocument>> results;
 
@@ -158,30 +177,34 @@ MutableDocumentMap LevelDbRemoteDocumentCache::GetAll(
           std::make_pair(key, MutableDocument::InvalidDocument(key)));
     } else {
       const std::string& contents = it->value();
-      tasks.Execute([this, &results, &key, contents] {
-        results.Insert(std::make_pair(key, DecodeMaybeDocument(contents, key)));
+      tasks.Execute([this, dictionary, &results, &key, contents] {
+        results.Insert(std::make_pair(
+            key, DecodeMaybeDocument(contents, key, dictionary)));
       });
     }
   }
 
   tasks.AwaitAll();
 
-  MutableDocumentMap map;
-  for (const auto& entry : results.Result()) {
-    map = map.insert(entry.first, entry.second);
-  }
-  return map;
+  // The results arrive in no particular order.
+  return ToSortedMap(results.Result());
 }
 
 MutableDocumentMap LevelDbRemoteDocumentCache::GetAllExisting(
     DocumentVersionMap&& remote_map,
     const core::Query& query,
     const model::OverlayByDocumentKeyMap& mutated_docs) const {
+  // The transaction is tracked per thread, so the tasks below must not look it
+  // up themselves.
+  LevelDbTransaction* transaction = db_->current_transaction();
+  const LevelDbFieldNameDictionary* dictionary = field_names();
   BackgroundQueue tasks(executor_.get());
   AsyncResults<std::pair<DocumentKey, MutableDocument>> results;
   for (const auto& key_version : remote_map) {
-    tasks.Execute([this, &results, &key_version, query, &mutated_docs] {
-      auto document = Get(key_version.first).WithReadTime(key_version.second);
+    tasks.Execute([this, transaction, dictionary, &results, &key_version, query,
+                   &mutated_docs] {
+      auto document = Get(transaction, dictionary, key_version.first)
+                          .WithReadTime(key_version.second);
       if (document.is_found_document() &&
           // Either the document matches the given query, or it is mutated.
           (query.Matches(document) ||
@@ -192,11 +215,8 @@ MutableDocumentMap LevelDbRemoteDocumentCache::GetAllExisting(
   }
   tasks.AwaitAll();
 
-  MutableDocumentMap map;
-  for (const auto& entry : results.Result()) {
-    map = map.insert(entry.first, entry.second);
-  }
-  return map;
+  // The results arrive in no particular order.
+  return ToSortedMap(results.Result());
 }
 
 MutableDocumentMap LevelDbRemoteDocumentCache::GetAll(
@@ -238,23 +258,65 @@ MutableDocumentMap LevelDbRemoteDocumentCache::GetDocumentsMatchingQuery(
     absl::optional<QueryContext>& context,
     absl::optional<size_t> limit,
     const model::OverlayByDocumentKeyMap& mutated_docs) const {
-  // Use the query path as a prefix for testing if a document matches the query.
+  auto it = db_->current_transaction()->NewIterator();
+  DocumentVersionMap remote_map;
+  ScanCollection(it.get(), query.path(), offset, limit, &remote_map);
+
+  if (context.has_value()) {
+    // The next step is going to check every document in remote_map, so it will
+    // go through total of remote_map.size() documents.
+    context.value().IncrementDocumentReadCount(remote_map.size());
+  }
 
+  return LevelDbRemoteDocumentCache::GetAllExisting(std::move(remote_map),
+                                                    query, mutated_docs);
+}
+
+MutableDocumentMap
+LevelDbRemoteDocumentCache::GetDocumentsMatchingCollectionGroupQuery(
+    const core::Query& query,
+    const std::vector<ResourcePath>& collections,
+    const model::IndexOffset& offset,
+    absl::optional<QueryContext>& context,
+    const model::OverlayByDocumentKeyMap& mutated_docs) const {
+  // Scan the read time index of all collections with a single iterator, in
+  // key order, and then decode and match the documents of all collections
+  // at once. This keeps the concurrent executor busy even if every
+  // collection holds only a handful of documents.
+  std::vector<ResourcePath> sorted_collections(collections);
+  std::sort(sorted_collections.begin(), sorted_collections.end());
+
+  auto it = db_->current_transaction()->NewIterator();
+  DocumentVersionMap remote_map;
+  for (const ResourcePath& path : sorted_collections) {
+    ScanCollection(it.get(), path, offset, absl::nullopt, &remote_map);
+  }
+
+  if (context.has_value()) {
+    context.value().IncrementDocumentReadCount(remote_map.size());
+  }
+
+  return LevelDbRemoteDocumentCache::GetAllExisting(std::move(remote_map),
+                                                    query, mutated_docs);
+}
+
+void LevelDbRemoteDocumentCache::ScanCollection(
+    LevelDbTransaction::Iterator* it,
+    const ResourcePath& path,
+    const model::IndexOffset& offset,
+    absl::optional<size_t> limit,
+    DocumentVersionMap* remote_map) const {
   // Execute an index-free query and filter by read time. This is safe since
   // all document changes to queries that have a
   // last_limbo_free_snapshot_version (`since_read_time`) have a read time
   // set.
-  auto path = query.path();
   std::string start_key =
       LevelDbRemoteDocumentReadTimeKey::KeyPrefix(path, offset.read_time());
-  auto it = db_->current_transaction()->NewIterator();
   it->Seek(util::ImmediateSuccessor(start_key));
 
-  DocumentVersionMap remote_map;
-
   LevelDbRemoteDocumentReadTimeKey current_key;
   for (; it->Valid() && current_key.Decode(it->key()) &&
-         (!limit.has_value() || remote_map.size() < limit);
+         (!limit.has_value() || remote_map->size() < limit);
        it->Next()) {
     const ResourcePath& collection_path = current_key.collection_path();
     if (collection_path != path) {
@@ -264,36 +326,30 @@ MutableDocumentMap LevelDbRemoteDocumentCache::GetDocumentsMatchingQuery(
     const SnapshotVersion& read_time = current_key.read_time();
     if (read_time > offset.read_time()) {
       DocumentKey document_key(path.Append(current_key.document_id()));
-      remote_map[document_key] = read_time;
+      (*remote_map)[document_key] = read_time;
     } else if (read_time == offset.read_time()) {
       DocumentKey document_key(path.Append(current_key.document_id()));
       if (document_key > offset.document_key()) {
-        remote_map[document_key] = read_time;
+        (*remote_map)[document_key] = read_time;
       }
     }
   }
-
-  if (context.has_value()) {
-    // The next step is going to check every document in remote_map, so it will
-    // go through total of remote_map.size() documents.
-    context.value().IncrementDocumentReadCount(remote_map.size());
-  }
-
-  return LevelDbRemoteDocumentCache::GetAllExisting(std::move(remote_map),
-                                                    query, mutated_docs);
 }
 
 MutableDocument LevelDbRemoteDocumentCache::DecodeMaybeDocument(
-    absl::string_view encoded, const DocumentKey& key) const {
-  StringReader reader{encoded};
-
-  auto message = Message<firestore_client_MaybeDocument>::TryParse(&reader);
+    absl::string_view encoded,
+    const DocumentKey& key,
+    const LevelDbFieldNameDictionary* dictionary) const {
+  // Found documents are decoded lazily: their fields stay in serialized form
+  // until they are first accessed, so documents that are read but never
+  // examined (or written back unchanged) skip decoding altogether.
+  util::ReadContext context;
   MutableDocument maybe_document =
-      serializer_->DecodeMaybeDocument(&reader, *message);
+      serializer_->DecodeMaybeDocument(&context, encoded, dictionary);
 
-  if (!reader.ok()) {
+  if (!context.ok()) {
     HARD_FAIL("MaybeDocument proto failed to parse: %s",
-              reader.status().ToString());
+              context.status().ToString());
   }
   HARD_ASSERT(maybe_document.key() == key,
               "Read document has key (%s) instead of expected key (%s).",
@@ -302,6 +358,63 @@ MutableDocument LevelDbRemoteDocumentCache::DecodeMaybeDocument(
   return maybe_document;
 }
 
+void LevelDbRemoteDocumentCache::RemoveFieldNameDictionary() {
+  const size_t kDocumentsPerTransaction = 1000;
+
+  std::string field_names_prefix = LevelDbFieldNameKey::KeyPrefix();
+  bool has_field_names = db_->Run("Check field name dictionary", [&] {
+    auto it = db_->current_transaction()->NewIterator();
+    it->Seek(field_names_prefix);
+    return it->Valid() && absl::StartsWith(it->key(), field_names_prefix);
+  });
+  if (!has_field_names) return;
+
+  // Rewrite the documents in batches to bound the size of each transaction.
+  std::string start_key = LevelDbRemoteDocumentKey::KeyPrefix();
+  bool more_documents = true;
+  while (more_documents) {
+    db_->Run("Decode remote document field names", [&] {
+      LevelDbTransaction* transaction = db_->current_transaction();
+      const LevelDbFieldNameDictionary* dictionary = field_names();
+      auto it = transaction->NewIterator();
+
+      LevelDbRemoteDocumentKey key;
+      more_documents = false;
+      for (it->Seek(start_key); it->Valid() && key.Decode(it->key());
+           it->Next()) {
+        if (transaction->changed_keys() >= kDocumentsPerTransaction) {
+          start_key = it->key();
+          more_documents = true;
+          return;
+        }
+
+        // Found documents only lack regular encoded fields if their field
+        // names are dictionary-encoded.
+        MutableDocument document =
+            DecodeMaybeDocument(it->value(), key.document_key(), dictionary);
+        if (document.is_found_document() &&
+            !document.data().encoded_document()) {
+          transaction->Put(it->key(),
+                           serializer_->EncodeMaybeDocumentToString(document));
+        }
+      }
+
+      it->Seek(field_names_prefix);
+      for (; it->Valid() && absl::StartsWith(it->key(), field_names_prefix);
+           it->Next()) {
+        transaction->Delete(it->key());
+      }
+    });
+  }
+
+  field_names_.Reset();
+}
+
+LevelDbFieldNameDictionary* LevelDbRemoteDocumentCache::field_names() const {
+  field_names_.EnsureLoaded(db_->current_transaction());
+  return &field_names_;
+}
+
 void LevelDbRemoteDocumentCache::SetIndexManager(IndexManager* manager) {
   index_manager_ = NOT_NULL(manager);
 }
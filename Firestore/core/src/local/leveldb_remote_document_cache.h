@@ -23,7 +23,9 @@
 #include <vector>
 
 #include "Firestore/core/src/core/query.h"
+#include "Firestore/core/src/local/leveldb_field_name_dictionary.h"
 #include "Firestore/core/src/local/leveldb_index_manager.h"
+#include "Firestore/core/src/local/leveldb_transaction.h"
 #include "Firestore/core/src/local/remote_document_cache.h"
 #include "Firestore/core/src/model/model_fwd.h"
 #include "Firestore/core/src/model/overlay.h"
@@ -76,10 +78,43 @@ class LevelDbRemoteDocumentCache : public RemoteDocumentCache {
       absl::optional<QueryContext>& context,
       absl::optional<size_t> limit = absl::nullopt,
       const model::OverlayByDocumentKeyMap& mutated_docs = {}) const override;
+  model::MutableDocumentMap GetDocumentsMatchingCollectionGroupQuery(
+      const core::Query& query,
+      const std::vector<model::ResourcePath>& collections,
+      const model::IndexOffset& offset,
+      absl::optional<QueryContext>& context,
+      const model::OverlayByDocumentKeyMap& mutated_docs) const override;
 
   void SetIndexManager(IndexManager* manager) override;
 
+  /**
+   * Sets whether documents are written with dictionary-encoded field names
+   * (see `LevelDbFieldNameDictionary`). Existing documents keep their format
+   * until they are written again. Documents are read in either format.
+   */
+  void set_field_name_dictionary_enabled(bool enabled) {
+    field_name_dictionary_enabled_ = enabled;
+  }
+
+  /**
+   * Rewrites all documents with dictionary-encoded field names in the regular
+   * format and deletes the field name dictionary, unless it is empty. Must be
+   * called while no transaction is in progress.
+   */
+  void RemoveFieldNameDictionary();
+
  private:
+  /**
+   * Adds the keys and read times of the documents in the collection at `path`
+   * that sort after `offset` to `remote_map`, using `it` to scan the read time
+   * index. Stops once `remote_map` holds `limit` entries.
+   */
+  void ScanCollection(LevelDbTransaction::Iterator* it,
+                      const model::ResourcePath& path,
+                      const model::IndexOffset& offset,
+                      absl::optional<size_t> limit,
+                      model::DocumentVersionMap* remote_map) const;
+
   /**
    * Looks up a set of entries in the cache, returning only existing entries of
    * Type::Document together with its SnapshotVersion.
@@ -89,8 +124,26 @@ class LevelDbRemoteDocumentCache : public RemoteDocumentCache {
       const core::Query& query,
       const model::OverlayByDocumentKeyMap& mutated_docs = {}) const;
 
+  /**
+   * Reads the document with the given key in `transaction`. Background tasks
+   * pass the transaction and dictionary of the thread that started them,
+   * since the current transaction is tracked per thread.
+   */
+  model::MutableDocument Get(LevelDbTransaction* transaction,
+                             const LevelDbFieldNameDictionary* dictionary,
+                             const model::DocumentKey& key) const;
+
   model::MutableDocument DecodeMaybeDocument(
-      absl::string_view encoded, const model::DocumentKey& key) const;
+      absl::string_view encoded,
+      const model::DocumentKey& key,
+      const LevelDbFieldNameDictionary* dictionary) const;
+
+  /**
+   * Returns the field name dictionary, reading it in the current transaction
+   * if this is the first access. Only call this on the thread that owns the
+   * transaction, never from a background task.
+   */
+  LevelDbFieldNameDictionary* field_names() const;
 
   // The LevelDbRemoteDocumentCache instance is owned by LevelDbPersistence.
   LevelDbPersistence* db_;
@@ -100,6 +153,11 @@ class LevelDbRemoteDocumentCache : public RemoteDocumentCache {
   LocalSerializer* serializer_ = nullptr;
 
   std::unique_ptr<util::Executor> executor_;
+
+  bool field_name_dictionary_enabled_ = false;
+
+  // Loaded on first use, since the cache is created outside of a transaction.
+  mutable LevelDbFieldNameDictionary field_names_;
 };
 
 }  // namespace local
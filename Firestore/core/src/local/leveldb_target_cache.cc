@@ -45,6 +45,7 @@ using model::DocumentKeySet;
 using model::ListenSequenceNumber;
 using model::SnapshotVersion;
 using model::TargetId;
+using nanopb::MakeStdString;
 using nanopb::Message;
 using nanopb::StringReader;
 
@@ -128,6 +129,7 @@ void LevelDbTargetCache::RemoveTarget(const TargetData& target_data) {
 
   std::string key = LevelDbTargetKey::Key(target_id);
   db_->current_transaction()->Delete(key);
+  encoded_targets_.erase(target_id);
 
   std::string index_key =
       LevelDbQueryTargetKey::Key(target_data.target().CanonicalId(), target_id);
@@ -227,6 +229,7 @@ size_t LevelDbTargetCache::RemoveTargets(
       RemoveMatchingKeysForTarget(target_id);
       // Remove the TargetId to Target mapping
       db_->current_transaction()->Delete(it->key());
+      encoded_targets_.erase(target_id);
 
       removed_targets.insert(target_id);
     }
@@ -402,8 +405,21 @@ void LevelDbTargetCache::EnumerateOrphanedDocuments(
 void LevelDbTargetCache::Save(const TargetData& target_data) {
   TargetId target_id = target_data.target_id();
   std::string key = LevelDbTargetKey::Key(target_id);
-  db_->current_transaction()->Put(key,
-                                  serializer_->EncodeTargetData(target_data));
+
+  // A target ID always refers to the same target, whose encoding may be
+  // expensive (e.g. a query with many filters), so it is encoded only once.
+  // The checkpoint goes after it: concatenated protos are merged when parsed,
+  // so the row decodes exactly like `EncodeTargetData`.
+  auto found = encoded_targets_.find(target_id);
+  if (found == encoded_targets_.end()) {
+    std::string definition =
+        MakeStdString(serializer_->EncodeTargetDefinition(target_data));
+    found = encoded_targets_.emplace(target_id, std::move(definition)).first;
+  }
+  db_->current_transaction()->Put(
+      std::move(key),
+      found->second +
+          MakeStdString(serializer_->EncodeTargetCheckpoint(target_data)));
 }
 
 bool LevelDbTargetCache::UpdateMetadata(const TargetData& target_data) {
@@ -17,6 +17,7 @@
 #ifndef FIRESTORE_CORE_SRC_LOCAL_LEVELDB_TARGET_CACHE_H_
 #define FIRESTORE_CORE_SRC_LOCAL_LEVELDB_TARGET_CACHE_H_
 
+#include <string>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -152,6 +153,12 @@ class LevelDbTargetCache : public TargetCache {
   /** A write-through cached copy of the metadata for the target cache. */
   nanopb::Message<firestore_client_TargetGlobal> metadata_;
 
+  /**
+   * The serialized `EncodeTargetDefinition` of the targets saved so far, so
+   * that saving a new resume token only encodes the target's checkpoint.
+   */
+  std::unordered_map<model::TargetId, std::string> encoded_targets_;
+
   model::SnapshotVersion last_remote_snapshot_version_;
 };
 
@@ -19,6 +19,7 @@
 #include "Firestore/core/src/local/leveldb_transaction.h"
 
 #include "Firestore/core/src/local/leveldb_key.h"
+#include "Firestore/core/src/local/leveldb_write_queue.h"
 #include "Firestore/core/src/util/hard_assert.h"
 #include "Firestore/core/src/util/log.h"
 #include "absl/memory/memory.h"
@@ -37,8 +38,187 @@ namespace firebase {
 namespace firestore {
 namespace local {
 
+namespace {
+
+/**
+ * Merges committed changes that have not been written yet with the rows of a
+ * leveldb iterator. Both underlying iterators are kept positioned just past
+ * the current entry, whose key and value are copied.
+ */
+class PendingWritesIterator : public leveldb::Iterator {
+ public:
+  PendingWritesIterator(std::shared_ptr<const PendingWrites> pending_writes,
+                        std::unique_ptr<leveldb::Iterator> db_iterator)
+      : pending_writes_(std::move(pending_writes)),
+        pending_iter_(pending_writes_->end()),
+        db_iter_(std::move(db_iterator)) {
+  }
+
+  bool Valid() const override {
+    return valid_;
+  }
+
+  void SeekToFirst() override {
+    db_iter_->SeekToFirst();
+    pending_iter_ = pending_writes_->begin();
+    FindNextVisible();
+  }
+
+  void SeekToLast() override {
+    FindPreviousVisible(absl::nullopt);
+  }
+
+  void Seek(const Slice& target) override {
+    db_iter_->Seek(target);
+    pending_iter_ = pending_writes_->lower_bound(target.ToString());
+    FindNextVisible();
+  }
+
+  void Next() override {
+    HARD_ASSERT(valid_, "Next() called on invalid iterator");
+    FindNextVisible();
+  }
+
+  void Prev() override {
+    HARD_ASSERT(valid_, "Prev() called on invalid iterator");
+    FindPreviousVisible(key_);
+  }
+
+  Slice key() const override {
+    return key_;
+  }
+
+  Slice value() const override {
+    return value_;
+  }
+
+  Status status() const override {
+    return db_iter_->status();
+  }
+
+ private:
+  /** Moves to the first visible entry at or after the underlying iterators. */
+  void FindNextVisible() {
+    while (true) {
+      bool has_db = db_iter_->Valid();
+      bool has_pending = pending_iter_ != pending_writes_->end();
+      if (!has_db && !has_pending) {
+        valid_ = false;
+        return;
+      }
+
+      int cmp = !has_pending ? -1
+                : !has_db    ? 1
+                             : db_iter_->key().compare(pending_iter_->first);
+      if (cmp < 0) {
+        SetCurrent(db_iter_->key().ToString(), db_iter_->value().ToString());
+        db_iter_->Next();
+        return;
+      }
+
+      // The pending write shadows any row with the same key.
+      if (cmp == 0) {
+        db_iter_->Next();
+      }
+      const PendingWrite& write = pending_iter_->second;
+      if (write.value) {
+        SetCurrent(pending_iter_->first, *write.value);
+        ++pending_iter_;
+        return;
+      }
+      ++pending_iter_;
+    }
+  }
+
+  /** Moves to the last visible entry before `bound`, if any. */
+  void FindPreviousVisible(absl::optional<std::string> bound) {
+    while (true) {
+      if (bound) {
+        db_iter_->Seek(*bound);
+        if (db_iter_->Valid()) {
+          db_iter_->Prev();
+        } else {
+          db_iter_->SeekToLast();
+        }
+      } else {
+        db_iter_->SeekToLast();
+      }
+
+      const PendingWrites::value_type* pending = FindPendingBefore(bound);
+      bool has_pending = pending != nullptr;
+      bool has_db = db_iter_->Valid();
+      if (!has_db && !has_pending) {
+        valid_ = false;
+        return;
+      }
+
+      int cmp = !has_pending ? 1
+                : !has_db    ? -1
+                             : db_iter_->key().compare(pending->first);
+      if (cmp > 0) {
+        SetCurrent(db_iter_->key().ToString(), db_iter_->value().ToString());
+      } else if (pending->second.value) {
+        SetCurrent(pending->first, *pending->second.value);
+      } else {
+        bound = pending->first;
+        continue;
+      }
+
+      // Restore the invariant that both iterators are past the current entry.
+      db_iter_->Seek(key_);
+      if (db_iter_->Valid() && db_iter_->key() == Slice(key_)) {
+        db_iter_->Next();
+      }
+      pending_iter_ = pending_writes_->lower_bound(key_);
+      if (pending_iter_ != pending_writes_->end() &&
+          pending_iter_->first == key_) {
+        ++pending_iter_;
+      }
+      return;
+    }
+  }
+
+  /**
+   * Returns the last pending write before `bound`, or the last of all pending
+   * writes if there is no bound. Returns `nullptr` if there is no such write.
+   */
+  const PendingWrites::value_type* FindPendingBefore(
+      const absl::optional<std::string>& bound) const {
+    size_t index = pending_writes_->size();
+    if (bound) {
+      auto found = pending_writes_->lower_bound(*bound);
+      if (found != pending_writes_->end()) {
+        index = pending_writes_->find_index(found->first);
+      }
+    }
+    return index == 0 ? nullptr : &pending_writes_->at(index - 1);
+  }
+
+  void SetCurrent(std::string key, std::string value) {
+    key_ = std::move(key);
+    value_ = std::move(value);
+    valid_ = true;
+  }
+
+  std::shared_ptr<const PendingWrites> pending_writes_;
+  PendingWrites::const_iterator pending_iter_;
+  std::unique_ptr<leveldb::Iterator> db_iter_;
+  std::string key_;
+  std::string value_;
+  bool valid_ = false;
+};
+
+}  // namespace
+
+std::unique_ptr<leveldb::Iterator> NewPendingWritesIterator(
+    std::shared_ptr<const PendingWrites> pending_writes,
+    std::unique_ptr<leveldb::Iterator> db_iterator) {
+  return absl::make_unique<PendingWritesIterator>(std::move(pending_writes),
+                                                  std::move(db_iterator));
+}
+
 LevelDbTransaction::Iterator::Iterator(LevelDbTransaction* txn)
-    : db_iter_(txn->db_->NewIterator(txn->read_options_)),
+    : db_iter_(txn->NewDbIterator()),
       last_version_(txn->version_),
       txn_(txn),
       mutations_iter_(txn->mutations_.begin()),
@@ -69,6 +249,7 @@ void LevelDbTransaction::Iterator::UpdateCurrent() {
       current_ = *mutations_iter_;
     } else {
       current_ = {db_iter_->key().ToString(), db_iter_->value().ToString()};
+      txn_->CountRead(current_.second);
     }
   }
 }
@@ -148,6 +329,33 @@ LevelDbTransaction::LevelDbTransaction(DB* db,
       label_(label) {
 }
 
+LevelDbTransaction::~LevelDbTransaction() {
+  if (snapshot_) {
+    db_->ReleaseSnapshot(snapshot_);
+  }
+}
+
+std::unique_ptr<LevelDbTransaction> LevelDbTransaction::CreateReadOnly(
+    DB* db, absl::string_view label) {
+  auto result = absl::make_unique<LevelDbTransaction>(db, label);
+  result->snapshot_ = db->GetSnapshot();
+  result->read_options_.snapshot = result->snapshot_;
+  return result;
+}
+
+void LevelDbTransaction::ReadThrough(
+    std::shared_ptr<const PendingWrites> pending_writes) {
+  pending_writes_ = std::move(pending_writes);
+}
+
+std::unique_ptr<leveldb::Iterator> LevelDbTransaction::NewDbIterator() {
+  std::unique_ptr<leveldb::Iterator> result(db_->NewIterator(read_options_));
+  if (pending_writes_ && !pending_writes_->empty()) {
+    result = NewPendingWritesIterator(pending_writes_, std::move(result));
+  }
+  return result;
+}
+
 const ReadOptions& LevelDbTransaction::DefaultReadOptions() {
   static_assert(std::is_trivially_destructible<ReadOptions>::value,
                 "ReadOptions should be trivially-destructible; otherwise, it "
@@ -169,6 +377,7 @@ const WriteOptions& LevelDbTransaction::DefaultWriteOptions() {
 }
 
 void LevelDbTransaction::Put(std::string key, std::string value) {
+  HARD_ASSERT(!read_only(), "Writing to read-only transaction %s", label_);
   deletions_.erase(key);
   mutations_[std::move(key)] = std::move(value);
   version_++;
@@ -188,13 +397,50 @@ Status LevelDbTransaction::Get(absl::string_view key, std::string* value) {
     if (iter != mutations_.end()) {
       *value = iter->second;
       return Status::OK();
-    } else {
-      return db_->Get(read_options_, key_string, value);
     }
   }
+
+  if (pending_writes_) {
+    auto pending = pending_writes_->find(key_string);
+    if (pending != pending_writes_->end()) {
+      if (!pending->second.value) {
+        return Status::NotFound(key_string + " is not present in the database");
+      }
+      *value = *pending->second.value;
+      CountRead(*value);
+      return Status::OK();
+    }
+  }
+
+  Status status = db_->Get(read_options_, key_string, value);
+  if (status.ok()) {
+    CountRead(*value);
+  }
+  return status;
+}
+
+void LevelDbTransaction::CountRead(const std::string& value) {
+  if (!count_reads_) {
+    return;
+  }
+  rows_read_.fetch_add(1, std::memory_order_relaxed);
+  bytes_read_.fetch_add(static_cast<int64_t>(value.size()),
+                        std::memory_order_relaxed);
+}
+
+OperationCounters LevelDbTransaction::counters() const {
+  OperationCounters result;
+  result.rows_read = rows_read_.load(std::memory_order_relaxed);
+  result.bytes_read = bytes_read_.load(std::memory_order_relaxed);
+  result.rows_written = static_cast<int64_t>(changed_keys());
+  for (const auto& entry : mutations_) {
+    result.bytes_written += static_cast<int64_t>(entry.second.size());
+  }
+  return result;
 }
 
 void LevelDbTransaction::Delete(absl::string_view key) {
+  HARD_ASSERT(!read_only(), "Deleting in read-only transaction %s", label_);
   std::string to_delete(key);
   deletions_.insert(to_delete);
   mutations_.erase(to_delete);
@@ -202,6 +448,7 @@ void LevelDbTransaction::Delete(absl::string_view key) {
 }
 
 void LevelDbTransaction::Commit() {
+  HARD_ASSERT(!read_only(), "Committing read-only transaction %s", label_);
   WriteBatch batch;
   for (const auto& deletion : deletions_) {
     batch.Delete(deletion);
@@ -218,6 +465,15 @@ void LevelDbTransaction::Commit() {
               ToString(), status.ToString());
 }
 
+void LevelDbTransaction::CommitTo(LevelDbWriteQueue* write_queue) {
+  HARD_ASSERT(!read_only(), "Committing read-only transaction %s", label_);
+  LOG_DEBUG("Committing transaction: %s", ToString());
+
+  write_queue->Enqueue(std::move(deletions_), std::move(mutations_));
+  deletions_.clear();
+  mutations_.clear();
+}
+
 std::string LevelDbTransaction::ToString() {
   std::string dest = absl::StrCat("<LevelDbTransaction ", label_, ": ");
   size_t changes = deletions_.size() + mutations_.size();
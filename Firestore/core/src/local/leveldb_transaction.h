@@ -17,6 +17,7 @@
 #ifndef FIRESTORE_CORE_SRC_LOCAL_LEVELDB_TRANSACTION_H_
 #define FIRESTORE_CORE_SRC_LOCAL_LEVELDB_TRANSACTION_H_
 
+#include <atomic>
 #include <cstdint>
 #include <map>
 #include <memory>
@@ -24,16 +25,57 @@
 #include <string>
 #include <utility>
 
+#include "Firestore/core/src/immutable/sorted_map.h"
+#include "Firestore/core/src/local/persistence_tracer.h"
 #include "Firestore/core/src/nanopb/byte_string.h"
 #include "Firestore/core/src/nanopb/message.h"
 #include "Firestore/core/src/nanopb/writer.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
 #include "leveldb/db.h"
 
 namespace firebase {
 namespace firestore {
 namespace local {
 
+class LevelDbWriteQueue;
+
+/**
+ * A change that has been committed through a `LevelDbWriteQueue` but has not
+ * been written to leveldb yet.
+ */
+struct PendingWrite {
+  /** Identifies the commit that made the change. Ids increase over time. */
+  uint64_t commit_id = 0;
+
+  /** The new value of the row, or nullopt if the row was deleted. */
+  absl::optional<std::string> value;
+
+  friend bool operator==(const PendingWrite& lhs, const PendingWrite& rhs) {
+    return lhs.commit_id == rhs.commit_id && lhs.value == rhs.value;
+  }
+};
+
+/**
+ * Committed changes that have not been written to leveldb yet, by key. These
+ * shadow the contents of leveldb until they are written.
+ *
+ * The map is immutable, so that every commit can publish a new version that
+ * shares its unchanged entries with the previous one.
+ */
+using PendingWrites = immutable::SortedMap<std::string, PendingWrite>;
+
+/**
+ * Returns an iterator over the rows of `db_iterator` as changed by
+ * `pending_writes`. The iterator takes ownership of `db_iterator`.
+ *
+ * Besides forward iteration, the result supports `Prev()` and `SeekToLast()`,
+ * though each such step seeks `db_iterator` anew.
+ */
+std::unique_ptr<leveldb::Iterator> NewPendingWritesIterator(
+    std::shared_ptr<const PendingWrites> pending_writes,
+    std::unique_ptr<leveldb::Iterator> db_iterator);
+
 /**
  * LevelDBTransaction tracks pending changes to entries in leveldb, including
  * deletions. It also provides an Iterator to traverse a merged view of pending
@@ -135,6 +177,34 @@ class LevelDbTransaction {
 
   LevelDbTransaction& operator=(const LevelDbTransaction& other) = delete;
 
+  ~LevelDbTransaction();
+
+  /**
+   * Creates a transaction that reads from a snapshot of the database taken
+   * when it is created, and that cannot be written to or committed.
+   *
+   * All reads through the transaction observe exactly the writes committed
+   * before it was created, no matter what other transactions commit while it
+   * is in use. Since it has no pending changes, it may be read from several
+   * threads at once.
+   */
+  static std::unique_ptr<LevelDbTransaction> CreateReadOnly(
+      leveldb::DB* db, absl::string_view label);
+
+  /**
+   * Makes this transaction read through `pending_writes`, which then take
+   * precedence over the contents of leveldb. Must be called before reading
+   * from the transaction.
+   */
+  void ReadThrough(std::shared_ptr<const PendingWrites> pending_writes);
+
+  /**
+   * Returns true if this transaction reads from a snapshot.
+   */
+  bool read_only() const {
+    return snapshot_ != nullptr;
+  }
+
   /**
    * Returns a default set of ReadOptions
    */
@@ -149,6 +219,22 @@ class LevelDbTransaction {
     return mutations_.size() + deletions_.size();
   }
 
+  /**
+   * Starts counting the rows read from leveldb. Reads are not counted by
+   * default so that untraced transactions don't pay for it. Must be called
+   * before the transaction is used.
+   */
+  void EnableReadCounting() {
+    count_reads_ = true;
+  }
+
+  /**
+   * Returns the rows read from leveldb so far (which excludes the rows changed
+   * in this transaction, and is zero unless `EnableReadCounting` was called)
+   * and the rows this transaction would write if it committed now.
+   */
+  OperationCounters counters() const;
+
   /**
    * Remove the database entry (if any) for "key".  It is not an error if "key"
    * did not exist in the database.
@@ -190,16 +276,39 @@ class LevelDbTransaction {
    */
   void Commit();
 
+  /**
+   * Commits the transaction by handing all pending changes to `write_queue`,
+   * which writes them to leveldb later on. The transaction should not be used
+   * after calling this method.
+   */
+  void CommitTo(LevelDbWriteQueue* write_queue);
+
   std::string ToString();
 
  private:
+  /**
+   * Returns an iterator over leveldb as changed by `pending_writes_`, which
+   * ignores the changes made in this transaction.
+   */
+  std::unique_ptr<leveldb::Iterator> NewDbIterator();
+
+  /** Counts a row read from leveldb. Thread-safe. */
+  void CountRead(const std::string& value);
+
   leveldb::DB* db_ = nullptr;
   Mutations mutations_;
   Deletions deletions_;
   leveldb::ReadOptions read_options_;
   leveldb::WriteOptions write_options_;
+  const leveldb::Snapshot* snapshot_ = nullptr;
+  std::shared_ptr<const PendingWrites> pending_writes_;
   int32_t version_ = 0;
   std::string label_;
+
+  bool count_reads_ = false;
+  // Atomic because read-only transactions may be read from several threads.
+  std::atomic<int64_t> rows_read_{0};
+  std::atomic<int64_t> bytes_read_{0};
 };
 
 /**
@@ -0,0 +1,176 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/local/leveldb_write_queue.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "Firestore/core/src/util/executor.h"
+#include "Firestore/core/src/util/hard_assert.h"
+#include "Firestore/core/src/util/log.h"
+#include "absl/memory/memory.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+using std::chrono::duration_cast;
+using std::chrono::microseconds;
+using util::Executor;
+
+constexpr size_t LevelDbWriteQueue::kMaxPendingWrites;
+
+LevelDbWriteQueue::LevelDbWriteQueue(leveldb::DB* db,
+                                     WriteDurability durability)
+    : db_(NOT_NULL(db)),
+      write_options_(LevelDbTransaction::DefaultWriteOptions()),
+      writer_(Executor::CreateSerial("com.google.firebase.firestore.writer")),
+      pending_writes_(std::make_shared<PendingWrites>()),
+      batch_(absl::make_unique<leveldb::WriteBatch>()) {
+  write_options_.sync = durability == WriteDurability::kSync;
+}
+
+LevelDbWriteQueue::~LevelDbWriteQueue() {
+  Flush();
+  writer_->Dispose();
+}
+
+void LevelDbWriteQueue::Enqueue(std::set<std::string> deletions,
+                                std::map<std::string, std::string> mutations) {
+  if (deletions.empty() && mutations.empty()) return;
+
+  Clock::time_point now = Clock::now();
+  bool schedule_write = false;
+  size_t pending_size = 0;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint64_t commit_id = ++last_commit_id_;
+
+    // Shares all entries this commit doesn't change with the previous
+    // version, which readers may still be using.
+    PendingWrites pending_writes = *pending_writes_;
+    for (const std::string& key : deletions) {
+      batch_->Delete(key);
+      batch_keys_.push_back(key);
+      pending_writes =
+          pending_writes.insert(key, PendingWrite{commit_id, absl::nullopt});
+    }
+    for (const auto& entry : mutations) {
+      batch_->Put(entry.first, entry.second);
+      batch_keys_.push_back(entry.first);
+      pending_writes = pending_writes.insert(
+          entry.first, PendingWrite{commit_id, entry.second});
+    }
+    pending_size = pending_writes.size();
+    pending_writes_ =
+        std::make_shared<const PendingWrites>(std::move(pending_writes));
+    batch_commit_times_.push_back(now);
+
+    if (!write_scheduled_) {
+      write_scheduled_ = true;
+      schedule_write = true;
+    }
+  }
+
+  if (schedule_write) {
+    writer_->Execute([this] { WritePendingBatch(); });
+  }
+
+  // Bound the memory held by changes that have not been written yet if the
+  // writer falls behind.
+  if (pending_size > kMaxPendingWrites) {
+    Flush();
+  }
+}
+
+std::shared_ptr<const PendingWrites> LevelDbWriteQueue::pending_writes() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return pending_writes_;
+}
+
+std::unique_ptr<LevelDbTransaction>
+LevelDbWriteQueue::CreateReadOnlyTransaction(absl::string_view label) const {
+  // Taking the snapshot and the pending writes together guarantees that any
+  // change missing from the snapshot is still pending.
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto result = LevelDbTransaction::CreateReadOnly(db_, label);
+  result->ReadThrough(pending_writes_);
+  return result;
+}
+
+void LevelDbWriteQueue::Flush() {
+  // The writer is serial, so this runs after any write already scheduled.
+  writer_->ExecuteBlocking([] {});
+}
+
+LevelDbWriteQueue::Metrics LevelDbWriteQueue::metrics() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return metrics_;
+}
+
+void LevelDbWriteQueue::WritePendingBatch() {
+  auto batch = absl::make_unique<leveldb::WriteBatch>();
+  std::vector<std::string> keys;
+  std::vector<Clock::time_point> commit_times;
+  uint64_t last_commit_id = 0;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::swap(batch, batch_);
+    std::swap(keys, batch_keys_);
+    std::swap(commit_times, batch_commit_times_);
+    last_commit_id = last_commit_id_;
+    write_scheduled_ = false;
+  }
+
+  if (commit_times.empty()) return;
+
+  leveldb::Status status = db_->Write(write_options_, batch.get());
+  HARD_ASSERT(status.ok(), "Failed to write %s commits: %s",
+              commit_times.size(), status.ToString());
+  Clock::time_point written = Clock::now();
+
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  // Drop the written changes, unless a later commit changed them again.
+  PendingWrites pending_writes = *pending_writes_;
+  for (const std::string& key : keys) {
+    auto found = pending_writes.find(key);
+    if (found != pending_writes.end() &&
+        found->second.commit_id <= last_commit_id) {
+      pending_writes = pending_writes.erase(key);
+    }
+  }
+  pending_writes_ =
+      std::make_shared<const PendingWrites>(std::move(pending_writes));
+
+  metrics_.commits += commit_times.size();
+  metrics_.writes++;
+  metrics_.max_commits_per_write =
+      std::max<uint64_t>(metrics_.max_commits_per_write, commit_times.size());
+  for (Clock::time_point committed : commit_times) {
+    auto latency = duration_cast<microseconds>(written - committed);
+    metrics_.total_commit_latency += latency;
+    metrics_.max_commit_latency =
+        std::max(metrics_.max_commit_latency, latency);
+  }
+
+  LOG_DEBUG("Wrote %s commits in a single batch", commit_times.size());
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,144 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_LOCAL_LEVELDB_WRITE_QUEUE_H_
+#define FIRESTORE_CORE_SRC_LOCAL_LEVELDB_WRITE_QUEUE_H_
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <set>
+#include <string>
+#include <vector>
+
+#include "Firestore/core/src/local/leveldb_transaction.h"
+#include "Firestore/core/src/local/write_durability.h"
+#include "absl/strings/string_view.h"
+#include "leveldb/db.h"
+#include "leveldb/write_batch.h"
+
+namespace firebase {
+namespace firestore {
+
+namespace util {
+class Executor;
+}  // namespace util
+
+namespace local {
+
+/**
+ * Writes committed transactions to leveldb on a dedicated writer thread,
+ * merging the changes of all transactions committed while the previous write
+ * was in progress into a single `leveldb::WriteBatch` ("group commit").
+ *
+ * Committing a transaction only records its changes in memory. Until they are
+ * written, the changes are available as `pending_writes()`, and transactions
+ * that read through them (see `LevelDbTransaction::ReadThrough`) observe all
+ * committed changes, whether or not they have been written yet.
+ *
+ * Transactions must be committed from a single thread (the worker queue).
+ */
+class LevelDbWriteQueue {
+ public:
+  /** Statistics about the writes performed so far. */
+  struct Metrics {
+    /** The number of committed transactions that were written. */
+    uint64_t commits = 0;
+
+    /** The number of leveldb writes, each of which wrote a group of commits. */
+    uint64_t writes = 0;
+
+    /** The largest number of commits written at once. */
+    uint64_t max_commits_per_write = 0;
+
+    /** The total time from commit to write, summed over all commits. */
+    std::chrono::microseconds total_commit_latency{0};
+
+    /** The longest time from commit to write of a single commit. */
+    std::chrono::microseconds max_commit_latency{0};
+  };
+
+  LevelDbWriteQueue(leveldb::DB* db, WriteDurability durability);
+
+  /** Writes all pending changes before returning. */
+  ~LevelDbWriteQueue();
+
+  /**
+   * Records the given changes of a committed transaction and schedules them to
+   * be written. If too many changes are already waiting to be written, blocks
+   * until they have been written.
+   */
+  void Enqueue(std::set<std::string> deletions,
+               std::map<std::string, std::string> mutations);
+
+  /** Returns the changes that have been committed but not written yet. */
+  std::shared_ptr<const PendingWrites> pending_writes() const;
+
+  /**
+   * Creates a read-only transaction (see `LevelDbTransaction::CreateReadOnly`)
+   * that also observes the changes that have been committed but not written
+   * yet.
+   */
+  std::unique_ptr<LevelDbTransaction> CreateReadOnlyTransaction(
+      absl::string_view label) const;
+
+  /** Blocks until all changes committed so far have been written. */
+  void Flush();
+
+  Metrics metrics() const;
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  /**
+   * Writes all changes enqueued so far in a single batch. Runs on the writer
+   * thread.
+   */
+  void WritePendingBatch();
+
+  /** The number of pending writes above which `Enqueue` waits. */
+  static constexpr size_t kMaxPendingWrites = 10000;
+
+  leveldb::DB* db_ = nullptr;
+  leveldb::WriteOptions write_options_;
+  std::unique_ptr<util::Executor> writer_;
+
+  mutable std::mutex mutex_;
+
+  /**
+   * Replaced rather than modified, so that readers can keep using a copy
+   * without holding `mutex_`. Successive versions share their unchanged
+   * entries.
+   */
+  std::shared_ptr<const PendingWrites> pending_writes_;
+
+  // The changes enqueued since the writer last started a write.
+  std::unique_ptr<leveldb::WriteBatch> batch_;
+  std::vector<std::string> batch_keys_;
+  std::vector<Clock::time_point> batch_commit_times_;
+
+  uint64_t last_commit_id_ = 0;
+  bool write_scheduled_ = false;
+  Metrics metrics_;
+};
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_LOCAL_LEVELDB_WRITE_QUEUE_H_
@@ -17,6 +17,7 @@
 #include "Firestore/core/src/local/local_documents_view.h"
 
 #include <algorithm>
+#include <limits>
 #include <map>
 #include <memory>
 #include <set>
@@ -114,21 +115,25 @@ model::DocumentMap LocalDocumentsView::GetDocumentsMatchingCollectionGroupQuery(
   const std::string& collection_id = *query.collection_group();
   std::vector<ResourcePath> parents =
       index_manager_->GetCollectionParents(collection_id);
-  DocumentMap results;
-
-  // Perform a collection query against each parent that contains the
-  // collection_id and aggregate the results.
+  std::vector<ResourcePath> collections;
+  collections.reserve(parents.size());
   for (const ResourcePath& parent : parents) {
-    Query collection_query =
-        query.AsCollectionQueryAtPath(parent.Append(collection_id));
-    DocumentMap collection_results =
-        GetDocumentsMatchingCollectionQuery(collection_query, offset, context);
-    for (const auto& kv : collection_results) {
-      const DocumentKey& key = kv.first;
-      results = results.insert(key, Document(kv.second));
-    }
+    collections.push_back(parent.Append(collection_id));
   }
-  return results;
+
+  // Get locally mutated documents of the whole collection group in one scan.
+  OverlayByDocumentKeyMap overlays = document_overlay_cache_->GetOverlays(
+      collection_id, offset.largest_batch_id(),
+      std::numeric_limits<size_t>::max());
+
+  // Read the remote documents of all collections at once rather than running
+  // a collection query per parent, since collection groups may span tens of
+  // thousands of parents with only a few documents each.
+  MutableDocumentMap remote_documents =
+      remote_document_cache_->GetDocumentsMatchingCollectionGroupQuery(
+          query, collections, offset, context, overlays);
+
+  return ApplyOverlaysAndMatch(query, std::move(remote_documents), overlays);
 }
 
 LocalWriteResult LocalDocumentsView::GetNextDocuments(
@@ -162,6 +167,45 @@ LocalWriteResult LocalDocumentsView::GetNextDocuments(
                                                   std::move(local_docs));
 }
 
+DocumentMap LocalDocumentsView::GetChangedDocuments(
+    const Query& query, const IndexOffset& offset) const {
+  const std::string& collection_group = query.collection_group()
+                                            ? *query.collection_group()
+                                            : query.path().last_segment();
+  bool is_collection_group_query = query.IsCollectionGroupQuery();
+
+  // Only read the mutations of the queried collection, rather than those of
+  // every collection in its group.
+  OverlayByDocumentKeyMap overlays =
+      is_collection_group_query
+          ? document_overlay_cache_->GetOverlays(
+                collection_group, offset.largest_batch_id(),
+                std::numeric_limits<size_t>::max())
+          : document_overlay_cache_->GetOverlays(query.path(),
+                                                 offset.largest_batch_id());
+
+  MutableDocumentMap docs;
+  for (const auto& entry : remote_document_cache_->GetAll(
+           collection_group, offset, std::numeric_limits<size_t>::max())) {
+    if (is_collection_group_query ||
+        query.path().IsImmediateParentOf(entry.first.path())) {
+      docs = docs.insert(entry.first, entry.second);
+    }
+  }
+  for (const auto& entry : overlays) {
+    if (docs.find(entry.first) == docs.end()) {
+      docs =
+          docs.insert(entry.first, GetBaseDocument(entry.first, entry.second));
+    }
+  }
+
+  PopulateOverlays(overlays, DocumentKeySet::FromKeysOf(docs));
+  return LocalWriteResult::FromOverlayedDocuments(
+             IndexOffset::InitialLargestBatchId(),
+             ComputeViews(docs, std::move(overlays), DocumentKeySet{}))
+      .changes();
+}
+
 DocumentMap LocalDocumentsView::GetDocumentsMatchingCollectionQuery(
     const Query& query,
     const IndexOffset& offset,
@@ -173,6 +217,13 @@ DocumentMap LocalDocumentsView::GetDocumentsMatchingCollectionQuery(
       remote_document_cache_->GetDocumentsMatchingQuery(
           query, offset, context, absl::nullopt, overlays);
 
+  return ApplyOverlaysAndMatch(query, std::move(remote_documents), overlays);
+}
+
+DocumentMap LocalDocumentsView::ApplyOverlaysAndMatch(
+    const Query& query,
+    MutableDocumentMap remote_documents,
+    const OverlayByDocumentKeyMap& overlays) const {
   // As documents might match the query because of their overlay we need to
   // include documents for all overlays in the initial document set.
   for (const auto& entry : overlays) {
@@ -101,6 +101,18 @@ class LocalDocumentsView {
                                            const model::IndexOffset& offset,
                                            size_t count) const;
 
+  /**
+   * Returns the local view of the documents in the collection (or collection
+   * group) of `query` whose remote version changed after `offset`, and of the
+   * documents in it with mutations in batches after the offset's largest batch
+   * id.
+   *
+   * Unlike `GetDocumentsMatchingQuery`, the result is not matched against the
+   * query and includes deleted documents.
+   */
+  model::DocumentMap GetChangedDocuments(
+      const core::Query& query, const model::IndexOffset& offset) const;
+
   /**
    * Similar to `GetDocuments`, but creates the local view from the given
    * `base_docs` without retrieving documents from the local store.
@@ -180,6 +192,15 @@ class LocalDocumentsView {
       const model::IndexOffset& offset,
       absl::optional<QueryContext>& context);
 
+  /**
+   * Applies the given overlays to `remote_documents`, including documents
+   * that only exist locally, and returns the documents that match `query`.
+   */
+  model::DocumentMap ApplyOverlaysAndMatch(
+      const core::Query& query,
+      model::MutableDocumentMap remote_documents,
+      const model::OverlayByDocumentKeyMap& overlays) const;
+
   RemoteDocumentCache* remote_document_cache() {
     return remote_document_cache_;
   }
@@ -32,14 +32,18 @@
 #include "Firestore/core/src/bundle/bundle_metadata.h"
 #include "Firestore/core/src/bundle/named_query.h"
 #include "Firestore/core/src/core/query.h"
+#include "Firestore/core/src/local/field_name_dictionary.h"
 #include "Firestore/core/src/local/target_data.h"
 #include "Firestore/core/src/model/field_path.h"
 #include "Firestore/core/src/model/mutable_document.h"
 #include "Firestore/core/src/model/mutation_batch.h"
 #include "Firestore/core/src/model/snapshot_version.h"
 #include "Firestore/core/src/nanopb/byte_string.h"
+#include "Firestore/core/src/nanopb/field_scanner.h"
 #include "Firestore/core/src/nanopb/message.h"
 #include "Firestore/core/src/nanopb/nanopb_util.h"
+#include "Firestore/core/src/nanopb/reader.h"
+#include "Firestore/core/src/nanopb/writer.h"
 #include "Firestore/core/src/util/hard_assert.h"
 #include "Firestore/core/src/util/statusor.h"
 #include "Firestore/core/src/util/string_format.h"
@@ -55,6 +59,8 @@ using bundle::BundleMetadata;
 using bundle::NamedQuery;
 using core::Target;
 using model::DeepClone;
+using model::DocumentKey;
+using model::FieldNameTable;
 using model::FieldPath;
 using model::FieldTransform;
 using model::MutableDocument;
@@ -63,19 +69,33 @@ using model::MutationBatch;
 using model::ObjectValue;
 using model::Segment;
 using model::SnapshotVersion;
+using nanopb::AppendBytesField;
+using nanopb::AppendVarintField;
 using nanopb::ByteString;
 using nanopb::CheckedSize;
 using nanopb::CopyBytesArray;
+using nanopb::FieldScanner;
 using nanopb::MakeArray;
+using nanopb::MakeStdString;
+using nanopb::MakeStringView;
 using nanopb::Message;
 using nanopb::Reader;
 using nanopb::ReleaseFieldOwnership;
 using nanopb::SafeReadBoolean;
 using nanopb::SetRepeatedField;
+using nanopb::StringReader;
+using nanopb::StringWriter;
 using nanopb::Writer;
+using util::ReadContext;
 using util::Status;
 using util::StringFormat;
 
+/**
+ * The field number of dictionary-encoded documents in MaybeDocument. These are
+ * not part of the generated Nanopb message; see maybe_document.proto.
+ */
+constexpr uint32_t kDictionaryEncodedDocumentTag = 5;
+
 }  // namespace
 
 Message<firestore_client_MaybeDocument> LocalSerializer::EncodeMaybeDocument(
@@ -135,6 +155,159 @@ MutableDocument LocalSerializer::DecodeMaybeDocument(
   UNREACHABLE();
 }
 
+std::string LocalSerializer::EncodeMaybeDocumentToString(
+    const MutableDocument& document, FieldNameDictionary* dictionary) const {
+  if (!document.is_found_document()) {
+    return MakeStdString(EncodeMaybeDocument(document));
+  }
+
+  std::string collection_group;
+  std::shared_ptr<const FieldNameTable> field_names;
+  if (dictionary) {
+    collection_group = document.key().GetCollectionGroup().value();
+    field_names = dictionary->GetFieldNames(collection_group);
+  }
+
+  // Documents that were read with the same dictionary keep their encoded
+  // field names as well.
+  const ByteString* encoded_document =
+      document.data().encoded_document(field_names.get());
+  bool encode_field_names = dictionary && !encoded_document;
+  if (!encoded_document) {
+    encoded_document = document.data().encoded_document();
+  }
+  if (!encoded_document && !dictionary) {
+    return MakeStdString(EncodeMaybeDocument(document));
+  }
+
+  // Assemble the Document from its name, its fields and its update time. If
+  // the document retains its serialized form, this produces the same bytes as
+  // `EncodeDocument` but copies the fields, which make up the bulk of the
+  // document, verbatim.
+  ByteString encoded_fields;
+  if (!encoded_document) {
+    Message<google_firestore_v1_Document> proto{EncodeDocument(document)};
+    encoded_fields = nanopb::MakeByteString(proto);
+    encoded_document = &encoded_fields;
+  }
+
+  std::string document_bytes;
+  document_bytes.reserve(encoded_document->size());
+
+  ByteString name = ByteString::Take(rpc_serializer_.EncodeKey(document.key()));
+  AppendBytesField(&document_bytes, google_firestore_v1_Document_name_tag,
+                   MakeStringView(name));
+
+  FieldScanner fields{MakeStringView(*encoded_document)};
+  while (fields.NextField(google_firestore_v1_Document_fields_tag)) {
+    if (encode_field_names) {
+      std::string entry;
+      bool encoded = EncodeFieldNames(fields.bytes_value(), collection_group,
+                                      dictionary, &entry);
+      HARD_ASSERT(encoded, "Failed to encode field names of %s",
+                  document.key().ToString());
+      AppendBytesField(&document_bytes, google_firestore_v1_Document_fields_tag,
+                       entry);
+    } else {
+      absl::string_view field = fields.encoded_field();
+      document_bytes.append(field.data(), field.size());
+    }
+  }
+  HARD_ASSERT(fields.ok(), "Retained document for %s is malformed",
+              document.key().ToString());
+
+  google_protobuf_Timestamp update_time =
+      rpc_serializer_.EncodeVersion(document.version());
+  StringWriter update_time_writer;
+  update_time_writer.Write(google_protobuf_Timestamp_fields, &update_time);
+  AppendBytesField(&document_bytes,
+                   google_firestore_v1_Document_update_time_tag,
+                   update_time_writer.Release());
+
+  std::string result;
+  result.reserve(document_bytes.size() + 8);
+  AppendBytesField(&result,
+                   dictionary ? kDictionaryEncodedDocumentTag
+                              : firestore_client_MaybeDocument_document_tag,
+                   document_bytes);
+  if (document.has_committed_mutations()) {
+    AppendVarintField(
+        &result, firestore_client_MaybeDocument_has_committed_mutations_tag, 1);
+  }
+  return result;
+}
+
+MutableDocument LocalSerializer::DecodeMaybeDocument(
+    ReadContext* context,
+    absl::string_view encoded,
+    const FieldNameDictionary* dictionary) const {
+  if (!context->ok()) return {};
+
+  absl::string_view document_bytes;
+  bool is_found_document = false;
+  bool is_dictionary_encoded = false;
+  bool has_committed_mutations = false;
+
+  FieldScanner scanner{encoded};
+  while (scanner.Next()) {
+    switch (scanner.field_number()) {
+      case firestore_client_MaybeDocument_document_tag:
+        document_bytes = scanner.bytes_value();
+        is_found_document = true;
+        is_dictionary_encoded = false;
+        break;
+
+      case kDictionaryEncodedDocumentTag:
+        document_bytes = scanner.bytes_value();
+        is_found_document = true;
+        is_dictionary_encoded = true;
+        break;
+
+      case firestore_client_MaybeDocument_no_document_tag:
+      case firestore_client_MaybeDocument_unknown_document_tag:
+        // `document_type` is a oneof; the last member on the wire wins.
+        is_found_document = false;
+        is_dictionary_encoded = false;
+        break;
+
+      case firestore_client_MaybeDocument_has_committed_mutations_tag:
+        has_committed_mutations = scanner.varint_value() != 0;
+        break;
+
+      default:
+        break;
+    }
+  }
+
+  if (!scanner.ok()) {
+    context->Fail("Invalid MaybeDocument: malformed field");
+    return {};
+  }
+
+  if (is_dictionary_encoded && !dictionary) {
+    context->Fail(
+        "Invalid MaybeDocument: field names are dictionary-encoded but no "
+        "dictionary is available");
+    return {};
+  }
+
+  if (is_found_document) {
+    return DecodeEncodedDocument(context, document_bytes,
+                                 has_committed_mutations,
+                                 is_dictionary_encoded ? dictionary : nullptr);
+  }
+
+  // Deleted and unknown documents have no fields, so there is nothing to gain
+  // from decoding them lazily.
+  StringReader reader{encoded};
+  auto message = Message<firestore_client_MaybeDocument>::TryParse(&reader);
+  MutableDocument result = DecodeMaybeDocument(&reader, *message);
+  if (!reader.ok()) {
+    context->set_status(reader.status());
+  }
+  return result;
+}
+
 google_firestore_v1_Document LocalSerializer::EncodeDocument(
     const MutableDocument& doc) const {
   google_firestore_v1_Document result{};
@@ -179,6 +352,55 @@ MutableDocument LocalSerializer::DecodeDocument(
   return document;
 }
 
+MutableDocument LocalSerializer::DecodeEncodedDocument(
+    ReadContext* context,
+    absl::string_view encoded,
+    bool has_committed_mutations,
+    const FieldNameDictionary* dictionary) const {
+  ByteString name;
+  google_protobuf_Timestamp update_time{};
+
+  FieldScanner scanner{encoded};
+  while (scanner.Next()) {
+    if (scanner.field_number() == google_firestore_v1_Document_name_tag) {
+      name = ByteString{scanner.bytes_value()};
+    } else if (scanner.field_number() ==
+               google_firestore_v1_Document_update_time_tag) {
+      // Timestamps don't own any dynamically-allocated memory.
+      StringReader reader{scanner.bytes_value()};
+      reader.Read(google_protobuf_Timestamp_fields, &update_time);
+      if (!reader.ok()) {
+        context->set_status(reader.status());
+      }
+    }
+  }
+
+  if (!scanner.ok()) {
+    context->Fail("Invalid Document: malformed field");
+  }
+  if (!context->ok()) return {};
+
+  SnapshotVersion version = rpc_serializer_.DecodeVersion(context, update_time);
+  DocumentKey key = rpc_serializer_.DecodeKey(context, name.get());
+  if (!context->ok()) return {};
+
+  // Field name ids are scoped to the collection group of the document. They
+  // are resolved once the fields are accessed.
+  std::shared_ptr<const FieldNameTable> field_names;
+  if (dictionary) {
+    field_names = dictionary->GetFieldNames(key.GetCollectionGroup().value());
+  }
+
+  MutableDocument document = MutableDocument::FoundDocument(
+      std::move(key), version,
+      ObjectValue::FromEncodedDocument(ByteString{encoded},
+                                       std::move(field_names)));
+  if (has_committed_mutations) {
+    document.SetHasCommittedMutations();
+  }
+  return document;
+}
+
 firestore_client_NoDocument LocalSerializer::EncodeNoDocument(
     const MutableDocument& no_doc) const {
   firestore_client_NoDocument result{};
@@ -225,6 +447,24 @@ MutableDocument LocalSerializer::DecodeUnknownDocument(
 
 Message<firestore_client_Target> LocalSerializer::EncodeTargetData(
     const TargetData& target_data) const {
+  Message<firestore_client_Target> result = EncodeTargetCheckpoint(target_data);
+  EncodeTarget(target_data.target(), result.get());
+  return result;
+}
+
+Message<firestore_client_Target> LocalSerializer::EncodeTargetDefinition(
+    const TargetData& target_data) const {
+  HARD_ASSERT(target_data.purpose() == QueryPurpose::Listen,
+              "Only queries with purpose %s may be stored, got %s",
+              QueryPurpose::Listen, target_data.purpose());
+
+  Message<firestore_client_Target> result;
+  EncodeTarget(target_data.target(), result.get());
+  return result;
+}
+
+Message<firestore_client_Target> LocalSerializer::EncodeTargetCheckpoint(
+    const TargetData& target_data) const {
   HARD_ASSERT(target_data.purpose() == QueryPurpose::Listen,
               "Only queries with purpose %s may be stored, got %s",
               QueryPurpose::Listen, target_data.purpose());
@@ -242,16 +482,18 @@ Message<firestore_client_Target> LocalSerializer::EncodeTargetData(
   result->resume_token =
       nanopb::CopyBytesArray(target_data.resume_token().get());
 
-  const Target& target = target_data.target();
+  return result;
+}
+
+void LocalSerializer::EncodeTarget(const Target& target,
+                                   firestore_client_Target* proto) const {
   if (target.IsDocumentQuery()) {
-    result->which_target_type = firestore_client_Target_documents_tag;
-    result->documents = rpc_serializer_.EncodeDocumentsTarget(target);
+    proto->which_target_type = firestore_client_Target_documents_tag;
+    proto->documents = rpc_serializer_.EncodeDocumentsTarget(target);
   } else {
-    result->which_target_type = firestore_client_Target_query_tag;
-    result->query = rpc_serializer_.EncodeQueryTarget(target);
+    proto->which_target_type = firestore_client_Target_query_tag;
+    proto->query = rpc_serializer_.EncodeQueryTarget(target);
   }
-
-  return result;
 }
 
 TargetData LocalSerializer::DecodeTargetData(
@@ -465,6 +707,10 @@ std::vector<model::Segment> LocalSerializer::DecodeFieldIndexSegments(
   std::vector<model::Segment> result;
   for (size_t i = 0; i < index.fields_count; ++i) {
     const auto& field = index.fields[i];
+    if (field.which_value_mode == 0) {
+      // A covered field rather than a segment.
+      continue;
+    }
 
     util::StatusOr<FieldPath> field_path =
         FieldPath::FromServerFormat(nanopb::MakeString(field.field_path));
@@ -492,9 +738,33 @@ std::vector<model::Segment> LocalSerializer::DecodeFieldIndexSegments(
   return result;
 }
 
+std::vector<FieldPath> LocalSerializer::DecodeFieldIndexCoveredFields(
+    nanopb::Reader* reader, google_firestore_admin_v1_Index& index) const {
+  std::vector<FieldPath> result;
+  for (size_t i = 0; i < index.fields_count; ++i) {
+    const auto& field = index.fields[i];
+    if (field.which_value_mode != 0) {
+      continue;
+    }
+
+    util::StatusOr<FieldPath> field_path =
+        FieldPath::FromServerFormat(nanopb::MakeString(field.field_path));
+    if (!field_path.ok()) {
+      reader->Fail(
+          StringFormat("Failed to read field path for covered field: %s",
+                       nanopb::MakeString(field.field_path)));
+      return {};
+    }
+    result.push_back(field_path.ValueOrDie());
+  }
+
+  return result;
+}
+
 nanopb::Message<google_firestore_admin_v1_Index>
 LocalSerializer::EncodeFieldIndexSegments(
-    const std::vector<model::Segment>& segments) const {
+    const std::vector<model::Segment>& segments,
+    const std::vector<FieldPath>& covered_fields) const {
   Message<google_firestore_admin_v1_Index> result;
 
   result->query_scope =
@@ -502,10 +772,11 @@ LocalSerializer::EncodeFieldIndexSegments(
 
   // Explicitly cast the result of segments.size() to suppress compiler warnings
   // about implicit conversion resulting in potential loss of precision.
-  const auto segments_size = static_cast<pb_size_t>(segments.size());
-  result->fields_count = segments_size;
+  const auto fields_size =
+      static_cast<pb_size_t>(segments.size() + covered_fields.size());
+  result->fields_count = fields_size;
   result->fields =
-      MakeArray<google_firestore_admin_v1_Index_IndexField>(segments_size);
+      MakeArray<google_firestore_admin_v1_Index_IndexField>(fields_size);
   int i = 0;
   for (const auto& segment : segments) {
     google_firestore_admin_v1_Index_IndexField field;
@@ -541,6 +812,13 @@ LocalSerializer::EncodeFieldIndexSegments(
     ++i;
   }
 
+  for (const auto& covered_field : covered_fields) {
+    google_firestore_admin_v1_Index_IndexField field{};
+    field.field_path = nanopb::MakeBytesArray(covered_field.CanonicalString());
+    result->fields[i] = field;
+    ++i;
+  }
+
   return result;
 }
 
@@ -26,6 +26,7 @@
 #include "Firestore/core/src/model/types.h"
 #include "Firestore/core/src/remote/serializer.h"
 #include "Firestore/core/src/util/status_fwd.h"
+#include "absl/strings/string_view.h"
 
 namespace firebase {
 namespace firestore {
@@ -60,6 +61,7 @@ class NamedQuery;
 
 namespace local {
 
+class FieldNameDictionary;
 class TargetData;
 
 /**
@@ -100,6 +102,40 @@ class LocalSerializer {
   model::MutableDocument DecodeMaybeDocument(
       nanopb::Reader* reader, firestore_client_MaybeDocument& proto) const;
 
+  /**
+   * @brief Encodes a MaybeDocument model directly to its serialized form for
+   * local storage.
+   *
+   * Found documents that still retain the serialized Document they were
+   * created from (see `model::ObjectValue::encoded_document()`) reuse the
+   * serialized fields as-is instead of encoding them again.
+   *
+   * If `dictionary` is given, the field names of found documents are replaced
+   * by ids from the dictionary of the document's collection group. Such
+   * documents can only be decoded with the same dictionary, and not at all by
+   * SDK versions that predate dictionary encoding. Documents that were read
+   * with the same dictionary reuse their encoded fields as-is.
+   */
+  std::string EncodeMaybeDocumentToString(
+      const model::MutableDocument& maybe_doc,
+      FieldNameDictionary* dictionary = nullptr) const;
+
+  /**
+   * @brief Decodes a serialized MaybeDocument proto to the equivalent model.
+   *
+   * Unlike `DecodeMaybeDocument(Reader*, proto)`, the fields of found
+   * documents are not decoded eagerly. The resulting document retains its
+   * serialized form and decodes its fields once they are first accessed.
+   *
+   * Documents whose field names are dictionary-encoded fail to decode unless
+   * `dictionary` is given. Their field name ids are only resolved once their
+   * fields are accessed.
+   */
+  model::MutableDocument DecodeMaybeDocument(
+      util::ReadContext* context,
+      absl::string_view encoded,
+      const FieldNameDictionary* dictionary = nullptr) const;
+
   /**
    * @brief Encodes a TargetData to the equivalent nanopb proto, representing a
    * ::firestore::proto::Target, for local storage.
@@ -107,6 +143,23 @@ class LocalSerializer {
   nanopb::Message<firestore_client_Target> EncodeTargetData(
       const TargetData& target_data) const;
 
+  /**
+   * Encodes only the target of `target_data`, i.e. its query or documents.
+   * Since a target ID always refers to the same target, the result can be
+   * reused across saves of the same target ID.
+   */
+  nanopb::Message<firestore_client_Target> EncodeTargetDefinition(
+      const TargetData& target_data) const;
+
+  /**
+   * Encodes everything but the target of `target_data`: its versions, resume
+   * token and sequence number. Appending the serialized checkpoint to the
+   * serialized `EncodeTargetDefinition` of the same target data yields a
+   * message that decodes like `EncodeTargetData`.
+   */
+  nanopb::Message<firestore_client_Target> EncodeTargetCheckpoint(
+      const TargetData& target_data) const;
+
   /**
    * @brief Decodes nanopb proto representing a ::firestore::proto::Target proto
    * to the equivalent TargetData.
@@ -151,12 +204,20 @@ class LocalSerializer {
   bundle::NamedQuery DecodeNamedQuery(nanopb::Reader* reader,
                                       firestore_NamedQuery& proto) const;
 
+  /**
+   * Encodes the segments and covered fields of a field index. Covered fields
+   * are encoded as index fields without a value mode.
+   */
   nanopb::Message<google_firestore_admin_v1_Index> EncodeFieldIndexSegments(
-      const std::vector<model::Segment>& segments) const;
+      const std::vector<model::Segment>& segments,
+      const std::vector<model::FieldPath>& covered_fields = {}) const;
 
   std::vector<model::Segment> DecodeFieldIndexSegments(
       nanopb::Reader* reader, google_firestore_admin_v1_Index& index) const;
 
+  std::vector<model::FieldPath> DecodeFieldIndexCoveredFields(
+      nanopb::Reader* reader, google_firestore_admin_v1_Index& index) const;
+
   /**
    * @brief Encodes a `Mutation` to the equivalent nanopb proto for local
    * storage.
@@ -188,6 +249,21 @@ class LocalSerializer {
                                         google_firestore_v1_Document& proto,
                                         bool has_committed_mutations) const;
 
+  /** Sets the query or documents target of `proto`. */
+  void EncodeTarget(const core::Target& target,
+                    firestore_client_Target* proto) const;
+
+  /**
+   * Decodes the name and update time of the serialized Document and returns a
+   * document whose fields are decoded lazily from `encoded`. If `dictionary`
+   * is given, the field names of the Document are dictionary-encoded.
+   */
+  model::MutableDocument DecodeEncodedDocument(
+      util::ReadContext* context,
+      absl::string_view encoded,
+      bool has_committed_mutations,
+      const FieldNameDictionary* dictionary) const;
+
   firestore_client_NoDocument EncodeNoDocument(
       const model::MutableDocument& no_doc) const;
 
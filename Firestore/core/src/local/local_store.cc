@@ -78,12 +78,24 @@ using nanopb::ByteString;
 using remote::TargetChange;
 
 /**
- * The maximum time to leave a resume token buffered without writing it out.
- * This value is arbitrary: it's long enough to avoid several writes (possibly
- * indefinitely if updates come more frequently than this) but short enough that
- * restarting after crashing will still have a pretty recent resume token.
+ * Returns the size of the documents that `change` adds or modifies, as they
+ * were serialized by the backend.
  */
-const int64_t kResumeTokenMaxAgeSeconds = 5 * 60;  // 5 minutes
+int64_t ReceivedBytes(const remote::RemoteEvent& remote_event,
+                      const TargetChange& change) {
+  int64_t bytes = 0;
+  for (const DocumentKeySet* keys :
+       {&change.added_documents(), &change.modified_documents()}) {
+    for (const DocumentKey& key : *keys) {
+      auto found = remote_event.document_updates().find(key);
+      if (found == remote_event.document_updates().end()) continue;
+
+      const ByteString* encoded = found->second.data().encoded_document();
+      if (encoded) bytes += static_cast<int64_t>(encoded->size());
+    }
+  }
+  return bytes;
+}
 
 DocumentKeySet GetKeysWithTransformResults(
     const MutationBatchResult& batch_result) {
@@ -151,6 +163,8 @@ DocumentMap LocalStore::HandleUserChange(const User& user) {
   std::vector<MutationBatch> old_batches = persistence_->Run(
       "OldBatches", [&] { return mutation_queue_->AllMutationBatches(); });
 
+  absl::MutexLock lock(&user_components_mutex_);
+
   // The old one has a reference to the mutation queue, so null it out first.
   local_documents_.reset();
   index_manager_ = persistence_->GetIndexManager(user);
@@ -362,10 +376,20 @@ model::DocumentMap LocalStore::ApplyRemoteEvent(
 
       target_data_by_target_[target_id] = new_target_data;
 
-      // Update the target data if there are target changes (or if sufficient
-      // time has passed since the last update).
-      if (ShouldPersistTargetData(new_target_data, old_target_data, change)) {
+      CheckpointProgress& progress = checkpoint_progress_[target_id];
+      progress.documents +=
+          static_cast<int64_t>(change.added_documents().size() +
+                               change.modified_documents().size() +
+                               change.removed_documents().size());
+      if (checkpoint_policy_.bytes > 0) {
+        progress.bytes += ReceivedBytes(remote_event, change);
+      }
+
+      // Update the target data if enough has changed since the last update
+      // (or if sufficient time has passed).
+      if (ShouldPersistTargetData(new_target_data, old_target_data, progress)) {
         target_cache_->UpdateTarget(new_target_data);
+        progress = CheckpointProgress{};
       }
     }
 
@@ -400,9 +424,10 @@ model::DocumentMap LocalStore::ApplyRemoteEvent(
   });
 }
 
-bool LocalStore::ShouldPersistTargetData(const TargetData& new_target_data,
-                                         const TargetData& old_target_data,
-                                         const TargetChange& change) const {
+bool LocalStore::ShouldPersistTargetData(
+    const TargetData& new_target_data,
+    const TargetData& old_target_data,
+    const CheckpointProgress& progress) const {
   // Always persist target data if we don't already have a resume token.
   if (old_target_data.resume_token().empty()) return true;
 
@@ -415,7 +440,8 @@ bool LocalStore::ShouldPersistTargetData(const TargetData& new_target_data,
   int64_t old_seconds =
       old_target_data.snapshot_version().timestamp().seconds();
   int64_t time_delta = new_seconds - old_seconds;
-  if (time_delta >= kResumeTokenMaxAgeSeconds) return true;
+  int64_t max_age = checkpoint_policy_.max_age_seconds;
+  if (max_age > 0 && time_delta >= max_age) return true;
 
   // Update the target cache if sufficient time has passed since the last
   // LastLimboFreeSnapshotVersion
@@ -425,17 +451,19 @@ bool LocalStore::ShouldPersistTargetData(const TargetData& new_target_data,
       old_target_data.last_limbo_free_snapshot_version().timestamp().seconds();
   int64_t limbo_free_time_delta =
       new_limbo_free_seconds - old_limbo_free_seconds;
-  if (limbo_free_time_delta >= kResumeTokenMaxAgeSeconds) return true;
+  if (max_age > 0 && limbo_free_time_delta >= max_age) return true;
 
-  // Otherwise if the only thing that has changed about a target is its resume
+  // Otherwise only persist once enough documents have changed since the last
+  // write: if the only thing that has changed about a target is its resume
   // token then it's not worth persisting. Note that the RemoteStore keeps an
   // in-memory view of the currently active targets which includes the current
   // resume token, so stream failure or user changes will still use an
   // up-to-date resume token regardless of what we do here.
-  size_t changes = change.added_documents().size() +
-                   change.modified_documents().size() +
-                   change.removed_documents().size();
-  return changes > 0;
+  int64_t documents = checkpoint_policy_.documents;
+  if (documents > 0 && progress.documents >= documents) return true;
+
+  int64_t bytes = checkpoint_policy_.bytes;
+  return bytes > 0 && progress.bytes >= bytes;
 }
 
 absl::optional<TargetData> LocalStore::GetTargetData(
@@ -496,6 +524,13 @@ const Document LocalStore::ReadDocument(const DocumentKey& key) {
                            [&] { return local_documents_->GetDocument(key); });
 }
 
+Document LocalStore::ReadDocumentFromSnapshot(const DocumentKey& key) {
+  absl::ReaderMutexLock lock(&user_components_mutex_);
+  return persistence_->RunReadOnly(
+      "ReadDocumentFromSnapshot",
+      [&] { return local_documents_->GetDocument(key); });
+}
+
 BatchId LocalStore::GetHighestUnacknowledgedBatchId() {
   return persistence_->Run("GetHighestUnacknowledgedBatchId", [&] {
     return mutation_queue_->GetHighestUnacknowledgedBatchId();
@@ -548,6 +583,7 @@ void LocalStore::ReleaseTarget(TargetId target_id) {
     persistence_->reference_delegate()->RemoveTarget(target_data);
     target_data_by_target_.erase(target_id);
     target_id_by_target_.erase(target_data.target());
+    checkpoint_progress_.erase(target_id);
   });
 }
 
@@ -573,12 +609,44 @@ QueryResult LocalStore::ExecuteQuery(const Query& query,
   });
 }
 
+QueryResult LocalStore::ExecuteQueryFromSnapshot(const Query& query) {
+  absl::ReaderMutexLock lock(&user_components_mutex_);
+  return persistence_->RunReadOnly("ExecuteQueryFromSnapshot", [&] {
+    absl::optional<TargetData> target_data =
+        target_cache_->GetTarget(query.ToTarget());
+    SnapshotVersion last_limbo_free_snapshot_version;
+    DocumentKeySet remote_keys;
+
+    if (target_data) {
+      last_limbo_free_snapshot_version =
+          target_data->last_limbo_free_snapshot_version();
+      remote_keys = target_cache_->GetMatchingKeys(target_data->target_id());
+    }
+
+    model::DocumentMap documents =
+        query_engine_->GetDocumentsMatchingQueryWithoutIndexes(
+            query, last_limbo_free_snapshot_version, remote_keys);
+    return QueryResult(std::move(documents), std::move(remote_keys));
+  });
+}
+
 DocumentKeySet LocalStore::GetRemoteDocumentKeys(TargetId target_id) {
   return persistence_->Run("RemoteDocumentKeysForTarget", [&] {
     return target_cache_->GetMatchingKeys(target_id);
   });
 }
 
+int64_t LocalStore::GetRemoteDocumentsSize(const DocumentKeySet& keys) {
+  return persistence_->Run("GetRemoteDocumentsSize", [&] {
+    int64_t size = 0;
+    for (const auto& entry : remote_document_cache_->GetAll(keys)) {
+      const ByteString* encoded = entry.second.data().encoded_document();
+      if (encoded) size += static_cast<int64_t>(encoded->size());
+    }
+    return size;
+  });
+}
+
 LruResults LocalStore::CollectGarbage(LruGarbageCollector* garbage_collector) {
   return persistence_->Run("Collect garbage", [&] {
     return garbage_collector->Collect(target_data_by_target_);
@@ -625,7 +693,6 @@ DocumentMap LocalStore::ApplyBundledDocuments(
       versions.emplace(key, doc.version());
     }
 
-    target_cache_->RemoveMatchingKeysForTarget(umbrella_target.target_id());
     target_cache_->AddMatchingKeys(keys, umbrella_target.target_id());
 
     auto result = PopulateDocumentChanges(document_updates, versions,
@@ -636,6 +703,13 @@ DocumentMap LocalStore::ApplyBundledDocuments(
   });
 }
 
+void LocalStore::ResetBundledDocuments(const std::string& bundle_id) {
+  TargetData umbrella_target = AllocateTarget(NewUmbrellaTarget(bundle_id));
+  persistence_->Run("Reset bundle documents", [&] {
+    target_cache_->RemoveMatchingKeysForTarget(umbrella_target.target_id());
+  });
+}
+
 void LocalStore::SaveNamedQuery(const bundle::NamedQuery& query,
                                 const model::DocumentKeySet& keys) {
   // Allocate a target for the named query such that it can be resumed from
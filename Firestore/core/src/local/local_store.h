@@ -29,9 +29,11 @@
 #include "Firestore/core/src/local/document_overlay_cache.h"
 #include "Firestore/core/src/local/overlay_migration_manager.h"
 #include "Firestore/core/src/local/reference_set.h"
+#include "Firestore/core/src/local/resume_token_checkpoint_policy.h"
 #include "Firestore/core/src/local/target_data.h"
 #include "Firestore/core/src/model/document.h"
 #include "Firestore/core/src/model/model_fwd.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/types/optional.h"
 
 namespace firebase {
@@ -140,6 +142,17 @@ class LocalStore : public bundle::BundleCallback {
    */
   const model::Document ReadDocument(const model::DocumentKey& key);
 
+  /**
+   * Like `ReadDocument`, but reads from a consistent snapshot of the
+   * persistence layer in a read-only transaction.
+   *
+   * If `Persistence::SupportsConcurrentReads()` is true, this may be called
+   * from any thread, concurrently with the worker queue and with other reads.
+   * The result reflects all writes committed before the read started and none
+   * of the writes committed after it.
+   */
+  model::Document ReadDocumentFromSnapshot(const model::DocumentKey& key);
+
   /**
    * Acknowledges the given batch.
    *
@@ -197,6 +210,13 @@ class LocalStore : public bundle::BundleCallback {
    */
   model::DocumentKeySet GetRemoteDocumentKeys(model::TargetId target_id);
 
+  /**
+   * Returns the total size of the given documents in the remote document
+   * cache, as they were serialized by the backend. The documents are read in
+   * a single transaction; those that are not cached count as 0.
+   */
+  int64_t GetRemoteDocumentsSize(const model::DocumentKeySet& keys);
+
   /**
    * Assigns a target an internal ID so that its results can be pinned so they
    * don't get GC'd. A target must be allocated in the local store before the
@@ -224,6 +244,20 @@ class LocalStore : public bundle::BundleCallback {
    */
   QueryResult ExecuteQuery(const core::Query& query, bool use_previous_results);
 
+  /**
+   * Like `ExecuteQuery`, but reads from a consistent snapshot of the
+   * persistence layer in a read-only transaction.
+   *
+   * This only relies on persisted state: it uses the target data stored in the
+   * target cache rather than the in-memory copies of active targets, and it
+   * neither reads nor creates client-side indexes. If
+   * `Persistence::SupportsConcurrentReads()` is true, this may be called from
+   * any thread, concurrently with the worker queue and with other reads. The
+   * result reflects all writes committed before the read started and none of
+   * the writes committed after it.
+   */
+  QueryResult ExecuteQueryFromSnapshot(const core::Query& query);
+
   /**
    * Notify the local store of the changed views to locally pin / unpin
    * documents.
@@ -276,6 +310,12 @@ class LocalStore : public bundle::BundleCallback {
       const model::MutableDocumentMap& documents,
       const std::string& bundle_id) override;
 
+  /**
+   * Removes all documents from the target that retains the documents of the
+   * bundle with the given ID.
+   */
+  void ResetBundledDocuments(const std::string& bundle_id) override;
+
   /** Saves the given `NamedQuery` to local persistence. */
   void SaveNamedQuery(const bundle::NamedQuery& query,
                       const model::DocumentKeySet& keys) override;
@@ -290,9 +330,21 @@ class LocalStore : public bundle::BundleCallback {
 
   void SetIndexAutoCreationEnabled(bool is_enabled) const;
 
+  /** Sets how often the target data of active targets is persisted. */
+  void SetResumeTokenCheckpointPolicy(
+      const ResumeTokenCheckpointPolicy& policy) {
+    checkpoint_policy_ = policy;
+  }
+
   void DeleteAllFieldIndexes() const;
 
  private:
+  /** What an active target received since its target data was persisted. */
+  struct CheckpointProgress {
+    int64_t documents = 0;
+    int64_t bytes = 0;
+  };
+
   friend class IndexBackfiller;
   friend class IndexBackfillerTest;
   friend class LocalStoreTestBase;
@@ -330,12 +382,12 @@ class LocalStore : public bundle::BundleCallback {
    * While the target is active, TargetData updates can be omitted when nothing
    * about the target has changed except metadata like the resume token or
    * snapshot version. Occasionally it's worth the extra write to prevent these
-   * values from getting too stale after a crash, but this doesn't have to be
-   * too frequent.
+   * values from getting too stale after a crash; `checkpoint_policy_` decides
+   * how often, given the `progress` made since the last write.
    */
   bool ShouldPersistTargetData(const TargetData& new_target_data,
                                const TargetData& old_target_data,
-                               const remote::TargetChange& change) const;
+                               const CheckpointProgress& progress) const;
 
   /**
    * Returns the TargetData as seen by the LocalStore, including updates that
@@ -422,6 +474,13 @@ class LocalStore : public bundle::BundleCallback {
    */
   std::unique_ptr<LocalDocumentsView> local_documents_;
 
+  /**
+   * Guards the user-specific components (`local_documents_` and the state of
+   * `query_engine_`) against snapshot reads while `HandleUserChange` swaps
+   * them out. Everything else only changes on the worker queue.
+   */
+  absl::Mutex user_components_mutex_;
+
   /**
    * Implements the steps for backfilling indexes.
    */
@@ -435,6 +494,11 @@ class LocalStore : public bundle::BundleCallback {
 
   /** Maps a target to its targetID. */
   std::unordered_map<core::Target, model::TargetId> target_id_by_target_;
+
+  ResumeTokenCheckpointPolicy checkpoint_policy_;
+
+  /** The progress of active targets since their last checkpoint. */
+  std::unordered_map<model::TargetId, CheckpointProgress> checkpoint_progress_;
 };
 
 }  // namespace local
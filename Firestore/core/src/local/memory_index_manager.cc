@@ -24,6 +24,7 @@
 #include "Firestore/core/src/core/target.h"
 #include "Firestore/core/src/model/field_index.h"
 #include "Firestore/core/src/model/model_fwd.h"
+#include "Firestore/core/src/model/mutable_document.h"
 #include "Firestore/core/src/model/resource_path.h"
 #include "Firestore/core/src/util/hard_assert.h"
 
@@ -113,6 +114,13 @@ MemoryIndexManager::GetDocumentsMatchingTarget(const core::Target&) {
   return absl::nullopt;
 }
 
+absl::optional<std::vector<model::MutableDocument>>
+MemoryIndexManager::GetCoveredDocumentsMatchingTarget(
+    const core::Target&, const std::vector<model::FieldPath>&) {
+  // Field indices are not supported with memory persistence.
+  return absl::nullopt;
+}
+
 absl::optional<std::string> MemoryIndexManager::GetNextCollectionGroupToUpdate()
     const {
   return absl::nullopt;
@@ -80,6 +80,10 @@ class MemoryIndexManager : public IndexManager {
   absl::optional<std::vector<model::DocumentKey>> GetDocumentsMatchingTarget(
       const core::Target&) override;
 
+  absl::optional<std::vector<model::MutableDocument>>
+  GetCoveredDocumentsMatchingTarget(
+      const core::Target&, const std::vector<model::FieldPath>&) override;
+
   absl::optional<std::string> GetNextCollectionGroupToUpdate() const override;
 
   void UpdateCollectionGroup(const std::string&, model::IndexOffset) override;
@@ -23,6 +23,7 @@
 
 #include "Firestore/core/include/firebase/firestore/timestamp.h"
 #include "Firestore/core/src/credentials/user.h"
+#include "Firestore/core/src/immutable/ref_count.h"
 #include "Firestore/core/src/immutable/sorted_set.h"
 #include "Firestore/core/src/local/document_key_reference.h"
 #include "Firestore/core/src/local/mutation_queue.h"
@@ -90,8 +91,12 @@ class MemoryMutationQueue : public MutationQueue {
   void SetLastStreamToken(nanopb::ByteString token) override;
 
  private:
+  // The queue is only used on the worker queue and never hands out its
+  // indexes, so they don't need atomic reference counts.
   using DocumentKeyReferenceSet =
-      immutable::SortedSet<DocumentKeyReference, DocumentKeyReference::ByKey>;
+      immutable::SortedSet<DocumentKeyReference,
+                           DocumentKeyReference::ByKey,
+                           immutable::ThreadConfinedRefCount>;
 
   std::vector<model::MutationBatch> AllMutationBatchesWithIds(
       const std::set<model::BatchId>& batch_ids);
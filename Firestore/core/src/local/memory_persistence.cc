@@ -26,6 +26,7 @@
 #include "Firestore/core/src/local/memory_mutation_queue.h"
 #include "Firestore/core/src/local/memory_remote_document_cache.h"
 #include "Firestore/core/src/local/memory_target_cache.h"
+#include "Firestore/core/src/local/persistence_tracer.h"
 #include "Firestore/core/src/local/reference_delegate.h"
 #include "Firestore/core/src/local/sizer.h"
 #include "Firestore/core/src/local/target_data.h"
@@ -147,6 +148,7 @@ void MemoryPersistence::DeleteAllFieldIndexes() {
 
 void MemoryPersistence::RunInternal(absl::string_view label,
                                     std::function<void()> block) {
+  OperationTrace trace(tracer(), label);
   TransactionGuard guard(reference_delegate_.get(), label);
 
   block();
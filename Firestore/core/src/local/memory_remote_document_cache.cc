@@ -16,6 +16,9 @@
 
 #include "Firestore/core/src/local/memory_remote_document_cache.h"
 
+#include <utility>
+#include <vector>
+
 #include "Firestore/core/src/core/query.h"
 #include "Firestore/core/src/local/memory_lru_reference_delegate.h"
 #include "Firestore/core/src/local/memory_persistence.h"
@@ -36,7 +39,15 @@ using model::DocumentKeySet;
 using model::ListenSequenceNumber;
 using model::MutableDocument;
 using model::MutableDocumentMap;
+using model::ResourcePath;
 using model::SnapshotVersion;
+using model::ToSortedMap;
+
+namespace {
+
+using DocumentEntries = std::vector<std::pair<DocumentKey, MutableDocument>>;
+
+}  // namespace
 
 MemoryRemoteDocumentCache::MemoryRemoteDocumentCache(
     MemoryPersistence* persistence) {
@@ -45,16 +56,42 @@ MemoryRemoteDocumentCache::MemoryRemoteDocumentCache(
 
 void MemoryRemoteDocumentCache::Add(const MutableDocument& document,
                                     const model::SnapshotVersion& read_time) {
+  const DocumentKey& key = document.key();
+  const auto& existing = docs_.get(key);
+  if (existing) {
+    RemoveFromCollection(*existing);
+  }
+
   // Note: We create an explicit copy to prevent further modifications.
-  docs_ =
-      docs_.insert(document.key(), document.Clone().WithReadTime(read_time));
+  MutableDocument copy = document.Clone().WithReadTime(read_time);
+  CollectionDocuments& collection = collections_[key.path().PopLast()];
+  collection = collection.insert(ReadTimeKey{read_time, key}, copy);
+  docs_ = docs_.insert(key, std::move(copy));
 
   NOT_NULL(index_manager_);
   index_manager_->AddToCollectionParentIndex(document.key().path().PopLast());
 }
 
 void MemoryRemoteDocumentCache::Remove(const DocumentKey& key) {
-  docs_ = docs_.erase(key);
+  const auto& existing = docs_.get(key);
+  if (existing) {
+    RemoveFromCollection(*existing);
+    docs_ = docs_.erase(key);
+  }
+}
+
+void MemoryRemoteDocumentCache::RemoveFromCollection(
+    const MutableDocument& document) {
+  auto collection = collections_.find(document.key().path().PopLast());
+  HARD_ASSERT(collection != collections_.end(),
+              "Cached document %s is missing from its collection",
+              document.key().ToString());
+
+  collection->second = collection->second.erase(
+      ReadTimeKey{document.read_time(), document.key()});
+  if (collection->second.empty()) {
+    collections_.erase(collection);
+  }
 }
 
 MutableDocument MemoryRemoteDocumentCache::Get(const DocumentKey& key) const {
@@ -98,32 +135,52 @@ MutableDocumentMap MemoryRemoteDocumentCache::GetDocumentsMatchingQuery(
     const core::Query& query,
     const model::IndexOffset& offset,
     absl::optional<QueryContext>&,
-    absl::optional<size_t>,
+    absl::optional<size_t> limit,
     const model::OverlayByDocumentKeyMap& mutated_docs) const {
-  MutableDocumentMap results;
+  DocumentEntries results;
+  ScanCollection(query.path(), query, offset, limit, mutated_docs, &results);
+  return ToSortedMap(std::move(results));
+}
 
-  // Documents are ordered by key, so we can use a prefix scan to narrow down
-  // the documents we need to match the query against.
-  auto path = query.path();
-  DocumentKey prefix{path.Append("")};
-  size_t immediate_children_path_length = path.size() + 1;
-  for (auto it = docs_.lower_bound(prefix); it != docs_.end(); ++it) {
-    const DocumentKey& key = it->first;
-    if (!path.IsPrefixOf(key.path())) {
-      break;
-    }
-    const MutableDocument& document = it->second;
-    if (key.path().size() > immediate_children_path_length) {
-      // Exclude entries from subcollections.
-      continue;
-    }
+MutableDocumentMap
+MemoryRemoteDocumentCache::GetDocumentsMatchingCollectionGroupQuery(
+    const core::Query& query,
+    const std::vector<model::ResourcePath>& collections,
+    const model::IndexOffset& offset,
+    absl::optional<QueryContext>&,
+    const model::OverlayByDocumentKeyMap& mutated_docs) const {
+  DocumentEntries results;
+  for (const ResourcePath& path : collections) {
+    ScanCollection(path, query, offset, absl::nullopt, mutated_docs, &results);
+  }
+  return ToSortedMap(std::move(results));
+}
 
-    if (model::IndexOffset::FromDocument(document).CompareTo(offset) !=
-        util::ComparisonResult::Descending) {
-      // The document sorts before the offset.
-      continue;
-    }
+void MemoryRemoteDocumentCache::ScanCollection(
+    const ResourcePath& path,
+    const core::Query& query,
+    const model::IndexOffset& offset,
+    absl::optional<size_t> limit,
+    const model::OverlayByDocumentKeyMap& mutated_docs,
+    DocumentEntries* results) const {
+  auto collection = collections_.find(path);
+  if (collection == collections_.end()) {
+    return;
+  }
 
+  // Documents are ordered by read time and key, so the ones that sort after
+  // the offset form a contiguous range starting right after it.
+  const CollectionDocuments& documents = collection->second;
+  ReadTimeKey start{offset.read_time(), offset.document_key()};
+  auto it = documents.lower_bound(start);
+  auto end = documents.end();
+  if (it != end && it->first == start) {
+    ++it;
+  }
+
+  for (size_t scanned = 0; it != end && (!limit || scanned < *limit);
+       ++it, ++scanned) {
+    const MutableDocument& document = it->second;
     if (mutated_docs.find(document.key()) == mutated_docs.end() &&
         !query.Matches(document)) {
       continue;
@@ -131,9 +188,8 @@ MutableDocumentMap MemoryRemoteDocumentCache::GetDocumentsMatchingQuery(
 
     // Note: We create an explicit copy to prevent modifications on the backing
     // data.
-    results = results.insert(key, document.Clone());
+    results->emplace_back(document.key(), document.Clone());
   }
-  return results;
 }
 
 std::vector<DocumentKey> MemoryRemoteDocumentCache::RemoveOrphanedDocuments(
@@ -144,6 +200,7 @@ std::vector<DocumentKey> MemoryRemoteDocumentCache::RemoveOrphanedDocuments(
   for (const auto& kv : docs_) {
     const DocumentKey& key = kv.first;
     if (!reference_delegate->IsPinnedAtSequenceNumber(upper_bound, key)) {
+      RemoveFromCollection(kv.second);
       updated_docs = updated_docs.erase(key);
       removed.push_back(key);
     }
@@ -17,6 +17,7 @@
 #ifndef FIRESTORE_CORE_SRC_LOCAL_MEMORY_REMOTE_DOCUMENT_CACHE_H_
 #define FIRESTORE_CORE_SRC_LOCAL_MEMORY_REMOTE_DOCUMENT_CACHE_H_
 
+#include <map>
 #include <string>
 #include <utility>
 #include <vector>
@@ -28,6 +29,8 @@
 #include "Firestore/core/src/model/model_fwd.h"
 #include "Firestore/core/src/model/mutable_document.h"
 #include "Firestore/core/src/model/overlay.h"
+#include "Firestore/core/src/model/resource_path.h"
+#include "Firestore/core/src/model/snapshot_version.h"
 #include "Firestore/core/src/model/types.h"
 
 namespace firebase {
@@ -64,6 +67,12 @@ class MemoryRemoteDocumentCache : public RemoteDocumentCache {
       absl::optional<QueryContext>&,
       absl::optional<size_t> limit = absl::nullopt,
       const model::OverlayByDocumentKeyMap& mutated_docs = {}) const override;
+  model::MutableDocumentMap GetDocumentsMatchingCollectionGroupQuery(
+      const core::Query& query,
+      const std::vector<model::ResourcePath>& collections,
+      const model::IndexOffset& offset,
+      absl::optional<QueryContext>& context,
+      const model::OverlayByDocumentKeyMap& mutated_docs) const override;
 
   void SetIndexManager(IndexManager* manager) override;
 
@@ -74,9 +83,42 @@ class MemoryRemoteDocumentCache : public RemoteDocumentCache {
   int64_t CalculateByteSize(const Sizer& sizer);
 
  private:
-  /** Underlying cache of documents and their read times. */
+  /**
+   * Orders the documents of a collection by read time and then by key, like
+   * the read time index of the LevelDB cache (and like `IndexOffset`).
+   */
+  using ReadTimeKey = std::pair<model::SnapshotVersion, model::DocumentKey>;
+
+  using CollectionDocuments =
+      immutable::SortedMap<ReadTimeKey, model::MutableDocument>;
+
+  /**
+   * Adds the documents in the collection at `path` that sort after `offset`
+   * and either match `query` or are in `mutated_docs` to `results`, scanning
+   * at most `limit` documents that sort after `offset`.
+   */
+  void ScanCollection(
+      const model::ResourcePath& path,
+      const core::Query& query,
+      const model::IndexOffset& offset,
+      absl::optional<size_t> limit,
+      const model::OverlayByDocumentKeyMap& mutated_docs,
+      std::vector<std::pair<model::DocumentKey, model::MutableDocument>>*
+          results) const;
+
+  /** Removes the given cached document from its collection. */
+  void RemoveFromCollection(const model::MutableDocument& document);
+
+  /** Underlying cache of documents and their read times, by key. */
   immutable::SortedMap<model::DocumentKey, model::MutableDocument> docs_;
 
+  /**
+   * The same documents, partitioned by their parent collection so that
+   * queries only visit the direct children of their collection, and can seek
+   * directly to the documents that sort after their offset.
+   */
+  std::map<model::ResourcePath, CollectionDocuments> collections_;
+
   // This instance is owned by MemoryPersistence; avoid a retain cycle.
   MemoryPersistence* persistence_;
   // This instance is also owned by MemoryPersistence.
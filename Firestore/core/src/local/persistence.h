@@ -40,6 +40,7 @@ class GlobalsCache;
 class IndexManager;
 class MutationQueue;
 class OverlayMigrationManager;
+class PersistenceTracer;
 class ReferenceDelegate;
 class RemoteDocumentCache;
 class TargetCache;
@@ -82,6 +83,17 @@ class Persistence {
  public:
   virtual ~Persistence() = default;
 
+  /**
+   * Sets the tracer that records the latency and the work of every
+   * transaction run by this persistence layer, or null to record nothing. The
+   * tracer must outlive this persistence layer.
+   *
+   * Must be called before starting any transaction.
+   */
+  void set_tracer(PersistenceTracer* tracer) {
+    tracer_ = tracer;
+  }
+
   virtual model::ListenSequenceNumber current_sequence_number() const = 0;
 
   /** Releases any resources held during eager shutdown. */
@@ -196,10 +208,54 @@ class Persistence {
     return result;
   }
 
+  /**
+   * Returns true if `RunReadOnly` may be called from any thread, concurrently
+   * with other reads and with the transactions started by `Run`.
+   */
+  virtual bool SupportsConcurrentReads() const {
+    return false;
+  }
+
+  /**
+   * Accepts a function that only reads from persistence and runs it against a
+   * consistent view of the persisted state: the block observes every
+   * transaction committed before the read started and none committed after.
+   *
+   * The block must not write, and must not use in-memory state of the caches
+   * that transactions on other threads may change.
+   *
+   * If `SupportsConcurrentReads()` returns false, this is equivalent to `Run`
+   * and has the same threading requirements.
+   *
+   * @param label A semi-unique name for the read, for logging.
+   * @param block A function to be executed against the snapshot whose return
+   *     value will be the result of the read. The type of the return value
+   *     must be default constructible and copy- or move-assignable.
+   * @return The value returned from the invocation of `block`.
+   */
+  template <typename F>
+  auto RunReadOnly(absl::string_view label, F block) -> decltype(block()) {
+    decltype(block()) result;
+
+    RunReadOnlyInternal(label, [&]() mutable { result = block(); });
+
+    return result;
+  }
+
+ protected:
+  PersistenceTracer* tracer() const {
+    return tracer_;
+  }
+
  private:
   virtual void RunInternal(absl::string_view label,
                            std::function<void()> block) = 0;
 
+  virtual void RunReadOnlyInternal(absl::string_view label,
+                                   std::function<void()> block) {
+    RunInternal(label, std::move(block));
+  }
+
   /**
    * Removes all persistent cache indexes. This feature is implemented in
    * `Persistence` instead of `IndexManager` like other SDKs. The reason for
@@ -209,6 +265,8 @@ class Persistence {
    * in one transaction.
    */
   virtual void DeleteAllFieldIndexes() = 0;
+
+  PersistenceTracer* tracer_ = nullptr;
 };
 
 }  // namespace local
@@ -0,0 +1,225 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/local/persistence_tracer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+#include "Firestore/core/src/util/filesystem.h"
+#include "Firestore/core/src/util/path.h"
+#include "Firestore/core/src/util/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+namespace {
+
+using std::chrono::duration_cast;
+using std::chrono::microseconds;
+
+int64_t Microseconds(PersistenceTracer::Clock::duration duration) {
+  return duration_cast<microseconds>(duration).count();
+}
+
+/** Appends `value` as a quoted JSON string. */
+void AppendJsonString(std::string* out, absl::string_view value) {
+  out->push_back('"');
+  for (char c : value) {
+    switch (c) {
+      case '"':
+        out->append("\\\"");
+        break;
+      case '\\':
+        out->append("\\\\");
+        break;
+      case '\n':
+        out->append("\\n");
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          absl::StrAppendFormat(out, "\\u%04x", static_cast<int>(c));
+        } else {
+          out->push_back(c);
+        }
+    }
+  }
+  out->push_back('"');
+}
+
+}  // namespace
+
+// MARK: - OperationCounters
+
+OperationCounters& OperationCounters::operator+=(
+    const OperationCounters& other) {
+  rows_read += other.rows_read;
+  bytes_read += other.bytes_read;
+  rows_written += other.rows_written;
+  bytes_written += other.bytes_written;
+  return *this;
+}
+
+// MARK: - LatencyHistogram
+
+constexpr size_t LatencyHistogram::kBucketCount;
+
+void LatencyHistogram::Record(microseconds latency) {
+  int64_t value = std::max<int64_t>(latency.count(), 0);
+  size_t bucket = 0;
+  while (value > 0 && bucket < kBucketCount - 1) {
+    value >>= 1;
+    ++bucket;
+  }
+
+  buckets_[bucket]++;
+  count_++;
+  total_ += latency;
+  max_ = std::max(max_, latency);
+}
+
+microseconds LatencyHistogram::Percentile(double percentile) const {
+  if (count_ == 0) return microseconds{0};
+
+  auto rank = static_cast<int64_t>(
+      std::ceil(count_ * std::min(std::max(percentile, 0.0), 100.0) / 100.0));
+  rank = std::max<int64_t>(rank, 1);
+
+  int64_t seen = 0;
+  for (size_t i = 0; i < kBucketCount; ++i) {
+    seen += buckets_[i];
+    if (seen >= rank) {
+      // Bucket i holds latencies below 2^i microseconds.
+      auto upper_bound = microseconds{(int64_t{1} << i) - 1};
+      return std::min(upper_bound, max_);
+    }
+  }
+  return max_;
+}
+
+// MARK: - PersistenceTracer
+
+constexpr size_t PersistenceTracer::kMaxTraceEvents;
+
+PersistenceTracer::PersistenceTracer() : epoch_(Clock::now()) {
+}
+
+void PersistenceTracer::Enable(bool record_trace_events) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  record_trace_events_ = record_trace_events;
+  enabled_.store(true, std::memory_order_relaxed);
+}
+
+void PersistenceTracer::Disable() {
+  enabled_.store(false, std::memory_order_relaxed);
+}
+
+void PersistenceTracer::Record(absl::string_view label,
+                               Clock::time_point start,
+                               Clock::time_point end,
+                               const OperationCounters& counters) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  OperationStats& stats = stats_[std::string(label)];
+  stats.latency.Record(duration_cast<microseconds>(end - start));
+  stats.totals += counters;
+  stats.max_rows_written =
+      std::max(stats.max_rows_written, counters.rows_written);
+
+  if (record_trace_events_) {
+    if (trace_events_.size() < kMaxTraceEvents) {
+      trace_events_.push_back(TraceEvent{std::string(label), start, end,
+                                         std::this_thread::get_id(), counters});
+    } else {
+      dropped_trace_events_++;
+    }
+  }
+}
+
+std::map<std::string, OperationStats> PersistenceTracer::GetStats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+void PersistenceTracer::Reset() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  stats_.clear();
+  trace_events_.clear();
+  dropped_trace_events_ = 0;
+  epoch_ = Clock::now();
+}
+
+std::string PersistenceTracer::ToChromeTraceJson() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  // Chrome traces identify threads by small integers.
+  std::unordered_map<std::thread::id, int> thread_ids;
+
+  std::string result = "{\"traceEvents\":[";
+  bool first = true;
+  for (const TraceEvent& event : trace_events_) {
+    auto inserted = thread_ids.emplace(
+        event.thread, static_cast<int>(thread_ids.size()) + 1);
+    int tid = inserted.first->second;
+
+    if (!first) result.push_back(',');
+    first = false;
+
+    result.append("\n{\"name\":");
+    AppendJsonString(&result, event.label);
+    absl::StrAppend(
+        &result, ",\"cat\":\"persistence\",\"ph\":\"X\",\"pid\":1",
+        ",\"tid\":", tid, ",\"ts\":", Microseconds(event.start - epoch_),
+        ",\"dur\":", Microseconds(event.end - event.start),
+        ",\"args\":{\"rows_read\":", event.counters.rows_read,
+        ",\"bytes_read\":", event.counters.bytes_read,
+        ",\"rows_written\":", event.counters.rows_written,
+        ",\"bytes_written\":", event.counters.bytes_written, "}}");
+  }
+  absl::StrAppend(&result, "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{",
+                  "\"dropped_events\":", dropped_trace_events_, "}}\n");
+  return result;
+}
+
+util::Status PersistenceTracer::WriteChromeTrace(
+    const util::Path& path) const {
+  return util::Filesystem::Default()->WriteFile(path, ToChromeTraceJson());
+}
+
+// MARK: - OperationTrace
+
+OperationTrace::OperationTrace(PersistenceTracer* tracer,
+                               absl::string_view label) {
+  if (tracer && tracer->enabled()) {
+    tracer_ = tracer;
+    label_ = label;
+    start_ = PersistenceTracer::Clock::now();
+  }
+}
+
+OperationTrace::~OperationTrace() {
+  if (tracer_) {
+    tracer_->Record(label_, start_, PersistenceTracer::Clock::now(), counters_);
+  }
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,215 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_LOCAL_PERSISTENCE_TRACER_H_
+#define FIRESTORE_CORE_SRC_LOCAL_PERSISTENCE_TRACER_H_
+
+#include <array>
+#include <atomic>
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstdint>
+#include <map>
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "absl/strings/string_view.h"
+
+namespace firebase {
+namespace firestore {
+
+namespace util {
+class Path;
+class Status;
+}  // namespace util
+
+namespace local {
+
+/** Counts the work done by persistence operations. */
+struct OperationCounters {
+  /** The number of rows read, whether by key or by iterating. */
+  int64_t rows_read = 0;
+
+  /** The number of bytes in the values of the rows read. */
+  int64_t bytes_read = 0;
+
+  /** The number of rows written or deleted when committing. */
+  int64_t rows_written = 0;
+
+  /** The number of bytes in the values of the rows written. */
+  int64_t bytes_written = 0;
+
+  OperationCounters& operator+=(const OperationCounters& other);
+};
+
+/**
+ * A histogram of latencies. Bucket 0 counts latencies below 1 microsecond, and
+ * bucket `i > 0` counts latencies in `[2^(i-1), 2^i)` microseconds. The last
+ * bucket also counts everything longer.
+ */
+class LatencyHistogram {
+ public:
+  static constexpr size_t kBucketCount = 32;
+
+  using Buckets = std::array<int64_t, kBucketCount>;
+
+  void Record(std::chrono::microseconds latency);
+
+  int64_t count() const {
+    return count_;
+  }
+
+  std::chrono::microseconds total() const {
+    return total_;
+  }
+
+  std::chrono::microseconds max() const {
+    return max_;
+  }
+
+  const Buckets& buckets() const {
+    return buckets_;
+  }
+
+  /**
+   * Returns an upper bound for the given percentile (between 0 and 100) of the
+   * recorded latencies: the upper end of the bucket it falls into, capped to
+   * the largest latency recorded.
+   */
+  std::chrono::microseconds Percentile(double percentile) const;
+
+ private:
+  Buckets buckets_{};
+  int64_t count_ = 0;
+  std::chrono::microseconds total_{0};
+  std::chrono::microseconds max_{0};
+};
+
+/** Statistics about all persistence operations that share a label. */
+struct OperationStats {
+  LatencyHistogram latency;
+
+  /** The work done by all operations combined. */
+  OperationCounters totals;
+
+  /** The largest number of rows written by a single operation. */
+  int64_t max_rows_written = 0;
+};
+
+/**
+ * Records the latency and work of persistence operations by label (the label
+ * passed to `Persistence::Run`), and optionally keeps every operation as a
+ * trace event to export in the Chrome trace event format.
+ *
+ * Tracing is disabled initially. All methods are thread-safe.
+ */
+class PersistenceTracer {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  /** The maximum number of trace events kept; later events are dropped. */
+  static constexpr size_t kMaxTraceEvents = 100000;
+
+  PersistenceTracer();
+
+  /**
+   * Starts recording statistics and, if `record_trace_events` is true, trace
+   * events.
+   */
+  void Enable(bool record_trace_events);
+
+  /** Stops recording. Statistics and events recorded so far are kept. */
+  void Disable();
+
+  bool enabled() const {
+    return enabled_.load(std::memory_order_relaxed);
+  }
+
+  /** Records an operation that ran from `start` to `end`. */
+  void Record(absl::string_view label,
+              Clock::time_point start,
+              Clock::time_point end,
+              const OperationCounters& counters);
+
+  /** Returns the statistics recorded so far, by label. */
+  std::map<std::string, OperationStats> GetStats() const;
+
+  /** Discards all statistics and trace events recorded so far. */
+  void Reset();
+
+  /**
+   * Returns the trace events recorded so far as a JSON object in the Chrome
+   * trace event format, which chrome://tracing and Perfetto can load.
+   */
+  std::string ToChromeTraceJson() const;
+
+  /** Writes the result of `ToChromeTraceJson` to the file at `path`. */
+  util::Status WriteChromeTrace(const util::Path& path) const;
+
+ private:
+  struct TraceEvent {
+    std::string label;
+    Clock::time_point start;
+    Clock::time_point end;
+    std::thread::id thread;
+    OperationCounters counters;
+  };
+
+  std::atomic<bool> enabled_{false};
+
+  mutable std::mutex mutex_;
+  bool record_trace_events_ = false;
+  Clock::time_point epoch_;
+  std::map<std::string, OperationStats> stats_;
+  std::vector<TraceEvent> trace_events_;
+  int64_t dropped_trace_events_ = 0;
+};
+
+/**
+ * Measures a single persistence operation, from construction to destruction,
+ * and records it with a `PersistenceTracer`. Does nothing if the tracer is
+ * null or disabled.
+ */
+class OperationTrace {
+ public:
+  OperationTrace(PersistenceTracer* tracer, absl::string_view label);
+
+  OperationTrace(const OperationTrace&) = delete;
+  OperationTrace& operator=(const OperationTrace&) = delete;
+
+  ~OperationTrace();
+
+  bool active() const {
+    return tracer_ != nullptr;
+  }
+
+  void set_counters(const OperationCounters& counters) {
+    counters_ = counters;
+  }
+
+ private:
+  PersistenceTracer* tracer_ = nullptr;
+  absl::string_view label_;
+  PersistenceTracer::Clock::time_point start_;
+  OperationCounters counters_;
+};
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_LOCAL_PERSISTENCE_TRACER_H_
@@ -17,6 +17,7 @@
 #include "Firestore/core/src/local/query_engine.h"
 
 #include <utility>
+#include <vector>
 
 #include "Firestore/core/src/core/query.h"
 #include "Firestore/core/src/core/target.h"
@@ -24,8 +25,11 @@
 #include "Firestore/core/src/local/query_context.h"
 #include "Firestore/core/src/model/document.h"
 #include "Firestore/core/src/model/document_set.h"
+#include "Firestore/core/src/model/field_index.h"
 #include "Firestore/core/src/model/mutable_document.h"
+#include "Firestore/core/src/model/object_value.h"
 #include "Firestore/core/src/model/snapshot_version.h"
+#include "Firestore/core/src/model/value_util.h"
 #include "Firestore/core/src/util/log.h"
 
 namespace firebase {
@@ -44,6 +48,26 @@ static const int kDefaultIndexAutoCreationMinCollectionSize = 100;
  */
 
 static const double KDefaultRelativeIndexReadCostPerDocument = 3.4;
+
+/** Returns a copy of `document` that only holds the given fields. */
+model::Document ProjectDocument(const model::Document& document,
+                                const std::vector<model::FieldPath>& fields) {
+  model::ObjectValue values;
+  for (const model::FieldPath& field_path : fields) {
+    auto value = document->field(field_path);
+    if (value.has_value()) {
+      values.Set(field_path, model::DeepClone(*value));
+    }
+  }
+
+  model::MutableDocument result = model::MutableDocument::FoundDocument(
+      document->key(), document->version(), std::move(values));
+  if (document->has_local_mutations()) {
+    result.SetHasLocalMutations();
+  }
+  return result;
+}
+
 }  // namespace
 
 using core::LimitType;
@@ -91,6 +115,93 @@ const DocumentMap QueryEngine::GetDocumentsMatchingQuery(
   return full_scan_result;
 }
 
+const DocumentMap QueryEngine::GetDocumentsMatchingQueryWithoutIndexes(
+    const Query& query,
+    const SnapshotVersion& last_limbo_free_snapshot_version,
+    const DocumentKeySet& remote_keys) const {
+  HARD_ASSERT(local_documents_view_, "Initialize() not called");
+
+  const absl::optional<DocumentMap> key_result = PerformQueryUsingRemoteKeys(
+      query, remote_keys, last_limbo_free_snapshot_version);
+  if (key_result.has_value()) {
+    return key_result.value();
+  }
+
+  absl::optional<QueryContext> context;
+  return ExecuteFullCollectionScan(query, context);
+}
+
+absl::optional<DocumentMap> QueryEngine::GetProjectedDocumentsMatchingQuery(
+    const Query& query, const std::vector<model::FieldPath>& fields) const {
+  HARD_ASSERT(local_documents_view_ && index_manager_,
+              "Initialize() not called");
+
+  if (query.MatchesAllDocuments()) {
+    return absl::nullopt;
+  }
+
+  // Index entries cannot be filtered any further without the documents, so
+  // the index must serve every filter and order-by of the query.
+  const core::Target& target = query.ToTarget();
+  if (index_manager_->GetIndexType(target) != IndexManager::IndexType::FULL) {
+    return absl::nullopt;
+  }
+
+  // The results must hold the values they are sorted by.
+  std::vector<model::FieldPath> projected_fields = fields;
+  for (const core::OrderBy& order_by : query.normalized_order_bys()) {
+    if (!order_by.field().IsKeyFieldPath()) {
+      projected_fields.push_back(order_by.field());
+    }
+  }
+
+  absl::optional<std::vector<MutableDocument>> indexed_documents =
+      index_manager_->GetCoveredDocumentsMatchingTarget(target,
+                                                        projected_fields);
+  if (!indexed_documents.has_value()) {
+    return absl::nullopt;
+  }
+
+  // Index entries are only up to date as of the index offset. Documents that
+  // changed since then (and all documents with pending writes, whose local
+  // state the entries do not track) are read in full instead.
+  model::IndexOffset offset = index_manager_->GetMinOffset(target);
+  DocumentMap changed_documents = local_documents_view_->GetChangedDocuments(
+      query,
+      model::IndexOffset(offset.read_time(), offset.document_key(),
+                         model::IndexOffset::InitialLargestBatchId()));
+
+  DocumentMap results;
+  bool dropped_indexed_document = false;
+  for (MutableDocument& indexed_document : *indexed_documents) {
+    Document document(std::move(indexed_document));
+    if (!query.MatchesPathAndCollectionGroup(document) ||
+        changed_documents.contains(document->key())) {
+      dropped_indexed_document = true;
+      continue;
+    }
+    results = results.insert(document->key(), document);
+  }
+
+  if (dropped_indexed_document && query.has_limit()) {
+    // The dropped entries counted towards the limit of the index scan, which
+    // may have left out entries that belong in the results.
+    return GetProjectedDocumentsMatchingQuery(
+        query.WithLimitToFirst(core::Target::kNoLimit), fields);
+  }
+
+  for (const auto& entry : changed_documents) {
+    const Document& document = entry.second;
+    if (document->is_found_document() && query.Matches(document)) {
+      results = results.insert(entry.first,
+                               ProjectDocument(document, projected_fields));
+    }
+  }
+
+  LOG_DEBUG("Used covering indexes to execute query: %s", query.ToString());
+  return results;
+}
+
 void QueryEngine::CreateCacheIndexes(const core::Query& query,
                                      const QueryContext& context,
                                      size_t result_size) const {
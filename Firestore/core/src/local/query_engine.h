@@ -17,6 +17,8 @@
 #ifndef FIRESTORE_CORE_SRC_LOCAL_QUERY_ENGINE_H_
 #define FIRESTORE_CORE_SRC_LOCAL_QUERY_ENGINE_H_
 
+#include <vector>
+
 #include "Firestore/core/src/model/model_fwd.h"
 
 namespace firebase {
@@ -79,6 +81,30 @@ class QueryEngine {
       const model::SnapshotVersion& last_limbo_free_snapshot_version,
       const model::DocumentKeySet& remote_keys) const;
 
+  /**
+   * Like `GetDocumentsMatchingQuery`, but never reads or creates indexes. This
+   * only relies on persisted state, so it can run in a read-only transaction
+   * concurrently with writes (see `Persistence::RunReadOnly`).
+   */
+  const model::DocumentMap GetDocumentsMatchingQueryWithoutIndexes(
+      const core::Query& query,
+      const model::SnapshotVersion& last_limbo_free_snapshot_version,
+      const model::DocumentKeySet& remote_keys) const;
+
+  /**
+   * Returns the documents matching `query` as partial documents that only hold
+   * `fields` and the fields the query is ordered by, read from the entries of
+   * covering indexes (see `model::FieldIndex::covered_fields()`) instead of
+   * loading the documents. Documents changed since they were indexed, and
+   * documents with pending writes, are read in full and projected.
+   *
+   * Returns `nullopt` if the query cannot be served entirely from covering
+   * indexes; callers should then use `GetDocumentsMatchingQuery`.
+   */
+  absl::optional<model::DocumentMap> GetProjectedDocumentsMatchingQuery(
+      const core::Query& query,
+      const std::vector<model::FieldPath>& fields) const;
+
   void SetIndexAutoCreationEnabled(bool is_enabled);
 
  private:
@@ -17,6 +17,7 @@
 #ifndef FIRESTORE_CORE_SRC_LOCAL_REFERENCE_SET_H_
 #define FIRESTORE_CORE_SRC_LOCAL_REFERENCE_SET_H_
 
+#include "Firestore/core/src/immutable/ref_count.h"
 #include "Firestore/core/src/immutable/sorted_set.h"
 #include "Firestore/core/src/local/document_key_reference.h"
 #include "Firestore/core/src/model/model_fwd.h"
@@ -82,9 +83,14 @@ class ReferenceSet {
  private:
   void RemoveReference(const DocumentKeyReference& reference);
 
-  immutable::SortedSet<DocumentKeyReference, DocumentKeyReference::ByKey>
-      by_key_;
-  immutable::SortedSet<DocumentKeyReference, DocumentKeyReference::ById> by_id_;
+  // Reference sets are only used on the worker queue and never hand out their
+  // internal sets, so the sets don't need atomic reference counts.
+  template <typename C>
+  using ReferenceSortedSet = immutable::
+      SortedSet<DocumentKeyReference, C, immutable::ThreadConfinedRefCount>;
+
+  ReferenceSortedSet<DocumentKeyReference::ByKey> by_key_;
+  ReferenceSortedSet<DocumentKeyReference::ById> by_id_;
 };
 
 }  // namespace local
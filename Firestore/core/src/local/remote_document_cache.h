@@ -18,10 +18,12 @@
 #define FIRESTORE_CORE_SRC_LOCAL_REMOTE_DOCUMENT_CACHE_H_
 
 #include <string>
+#include <vector>
 
 #include "Firestore/core/src/model/document_key.h"
 #include "Firestore/core/src/model/model_fwd.h"
 #include "Firestore/core/src/model/overlay.h"
+#include "Firestore/core/src/model/resource_path.h"
 
 namespace firebase {
 namespace firestore {
@@ -144,6 +146,32 @@ class RemoteDocumentCache {
       absl::optional<size_t> limit = absl::nullopt,
       const model::OverlayByDocumentKeyMap& mutated_docs = {}) const = 0;
 
+  /**
+   * Executes a collection group query against the cached Document entries of
+   * the given collections.
+   *
+   * This is equivalent to calling `GetDocumentsMatchingQuery` for each of
+   * `collections` and merging the results, but lets implementations process
+   * all collections at once. Collection groups can span tens of thousands of
+   * parent collections with only a few documents each.
+   *
+   * @param query The collection group query to match documents against.
+   * @param collections The collections of the collection group to scan.
+   * @param offset The read time and document key to start scanning at
+   * (exclusive).
+   * @param context A optional tracker to keep a record of important details
+   * during database local query execution.
+   * @param mutated_docs The documents with local mutations, they are read
+   * regardless if the remote version matches the given query.
+   * @return The set of matching documents.
+   */
+  virtual model::MutableDocumentMap GetDocumentsMatchingCollectionGroupQuery(
+      const core::Query& query,
+      const std::vector<model::ResourcePath>& collections,
+      const model::IndexOffset& offset,
+      absl::optional<QueryContext>& context,
+      const model::OverlayByDocumentKeyMap& mutated_docs) const = 0;
+
   /**
    * Sets the index manager used by remote document cache.
    *
@@ -0,0 +1,70 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_LOCAL_RESUME_TOKEN_CHECKPOINT_POLICY_H_
+#define FIRESTORE_CORE_SRC_LOCAL_RESUME_TOKEN_CHECKPOINT_POLICY_H_
+
+#include <cstdint>
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+/**
+ * Decides how often the target data of an active target, including its resume
+ * token, is persisted while changes keep arriving for it. Target data is
+ * always persisted when the target has no resume token yet and when it is
+ * released; in between, it is persisted as soon as one of the thresholds
+ * below is reached. A threshold of 0 disables it.
+ *
+ * Checkpointing more often means fewer documents are sent again when the
+ * target is resumed after a restart, at the cost of more writes to the target
+ * cache.
+ */
+struct ResumeTokenCheckpointPolicy {
+  /**
+   * The number of seconds a snapshot version may advance without being
+   * persisted. Long enough to avoid frequent writes, but short enough that a
+   * client restarting after a crash still has a recent resume token.
+   */
+  int64_t max_age_seconds = 5 * 60;
+
+  /** The number of documents received since the last checkpoint. */
+  int64_t documents = 1;
+
+  /**
+   * The total size of the documents received since the last checkpoint, as
+   * serialized by the backend.
+   */
+  int64_t bytes = 0;
+};
+
+inline bool operator==(const ResumeTokenCheckpointPolicy& lhs,
+                       const ResumeTokenCheckpointPolicy& rhs) {
+  return lhs.max_age_seconds == rhs.max_age_seconds &&
+         lhs.documents == rhs.documents && lhs.bytes == rhs.bytes;
+}
+
+inline bool operator!=(const ResumeTokenCheckpointPolicy& lhs,
+                       const ResumeTokenCheckpointPolicy& rhs) {
+  return !(lhs == rhs);
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_LOCAL_RESUME_TOKEN_CHECKPOINT_POLICY_H_
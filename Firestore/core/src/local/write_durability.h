@@ -0,0 +1,51 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_LOCAL_WRITE_DURABILITY_H_
+#define FIRESTORE_CORE_SRC_LOCAL_WRITE_DURABILITY_H_
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+/**
+ * How durable the writes of a `LevelDbWriteQueue` are once written.
+ */
+enum class WriteDurability {
+  /**
+   * Groups of writes are handed to the operating system without waiting for
+   * them to reach the disk.
+   *
+   * Committed changes are only held in memory until the writer thread gets to
+   * them, so a crash of the process loses the changes committed since the
+   * last group was written. Written groups survive a crash of the process,
+   * but the most recent ones may be lost if the machine crashes.
+   */
+  kAsync,
+
+  /**
+   * Every group of writes is synced to disk before the next one is written.
+   * Changes committed since the last group was written are still lost if the
+   * process crashes.
+   */
+  kSync,
+};
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_LOCAL_WRITE_DURABILITY_H_
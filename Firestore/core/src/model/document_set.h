@@ -116,6 +116,14 @@ class DocumentSet : public immutable::SortedContainer {
    */
   size_t IndexOf(const DocumentKey& key) const;
 
+  /**
+   * Returns the document at the given index in the document set, i.e. the
+   * inverse of `IndexOf`. The index must be less than `size()`.
+   */
+  const Document& at(size_t index) const {
+    return sorted_set_.at(static_cast<size_type>(index));
+  }
+
   /** Returns a new DocumentSet that contains the given document. */
   DocumentSet insert(const absl::optional<Document>& document) const;
 
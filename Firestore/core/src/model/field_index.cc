@@ -16,6 +16,8 @@
 
 #include "Firestore/core/src/model/field_index.h"
 
+#include <algorithm>
+
 namespace firebase {
 namespace firestore {
 namespace model {
@@ -113,7 +115,27 @@ util::ComparisonResult FieldIndex::SemanticCompare(const FieldIndex& left,
                : util::ComparisonResult::Descending;
   }
 
-  return util::ComparisonResult::Same;
+  return util::CompareContainer(left.covered_fields(), right.covered_fields());
+}
+
+bool FieldIndex::Covers(const std::vector<FieldPath>& fields) const {
+  if (covered_fields_.empty()) {
+    return false;
+  }
+
+  for (const FieldPath& field : fields) {
+    bool covered =
+        std::find(covered_fields_.begin(), covered_fields_.end(), field) !=
+        covered_fields_.end();
+    for (const Segment& segment : segments_) {
+      covered = covered || (segment.kind() != Segment::kContains &&
+                            segment.field_path() == field);
+    }
+    if (!covered) {
+      return false;
+    }
+  }
+  return true;
 }
 
 absl::optional<Segment> FieldIndex::GetArraySegment() const {
@@ -221,6 +221,11 @@ inline bool operator!=(const IndexState& lhs, const IndexState& rhs) {
  * Unlike the backend, the SDK does not differentiate between collection or
  * collection group-scoped indices. Every index can be used for both single
  * collection and collection group queries.
+ *
+ * An index can also "cover" additional fields, whose values are stored in its
+ * entries alongside those of its directional segments. Queries that only need
+ * covered fields can then be answered from the index entries alone, without
+ * loading the documents.
  */
 class FieldIndex {
  public:
@@ -237,8 +242,8 @@ class FieldIndex {
   }
 
   /**
-   * Compares indexes by collection group and segments. Ignores update time
-   * and index ID.
+   * Compares indexes by collection group, segments and covered fields. Ignores
+   * update time and index ID.
    */
   static util::ComparisonResult SemanticCompare(const FieldIndex& left,
                                                 const FieldIndex& right);
@@ -256,6 +261,18 @@ class FieldIndex {
         state_(std::move(state)) {
   }
 
+  FieldIndex(int32_t index_id,
+             std::string collection_group,
+             std::vector<Segment> segments,
+             IndexState state,
+             std::vector<FieldPath> covered_fields)
+      : index_id_(index_id),
+        collection_group_(std::move(collection_group)),
+        segments_(std::move(segments)),
+        state_(std::move(state)),
+        covered_fields_(std::move(covered_fields)) {
+  }
+
   /**
    * The index ID. Returns -1 if the index ID is not available (e.g. the index
    * has not yet been persisted).
@@ -279,6 +296,21 @@ class FieldIndex {
     return state_;
   }
 
+  /**
+   * Returns the fields whose values are stored in the index entries in
+   * addition to the fields of the directional segments.
+   */
+  const std::vector<FieldPath>& covered_fields() const {
+    return covered_fields_;
+  }
+
+  /**
+   * Returns true if the entries of this index store the values of all of the
+   * given fields, either as covered fields or as directional segments. Indexes
+   * without covered fields store no values and cover nothing.
+   */
+  bool Covers(const std::vector<FieldPath>& fields) const;
+
   /** Returns all directional (ascending/descending) segments for this index. */
   std::vector<Segment> GetDirectionalSegments() const;
 
@@ -308,12 +340,14 @@ class FieldIndex {
   std::string collection_group_;
   std::vector<Segment> segments_;
   IndexState state_;
+  std::vector<FieldPath> covered_fields_;
 };
 
 inline bool operator==(const FieldIndex& lhs, const FieldIndex& rhs) {
   return lhs.index_id_ == rhs.index_id_ &&
          lhs.collection_group_ == rhs.collection_group_ &&
-         lhs.segments_ == rhs.segments_ && lhs.state_ == rhs.state_;
+         lhs.segments_ == rhs.segments_ && lhs.state_ == rhs.state_ &&
+         lhs.covered_fields_ == rhs.covered_fields_;
 }
 
 inline bool operator!=(const FieldIndex& lhs, const FieldIndex& rhs) {
@@ -0,0 +1,225 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/model/field_name_table.h"
+
+#include <limits>
+
+#include "Firestore/Protos/nanopb/google/firestore/v1/document.nanopb.h"
+#include "Firestore/core/src/nanopb/field_scanner.h"
+
+namespace firebase {
+namespace firestore {
+namespace model {
+namespace {
+
+using nanopb::AppendBytesField;
+using nanopb::FieldScanner;
+
+void Append(absl::string_view bytes, std::string* out) {
+  out->append(bytes.data(), bytes.size());
+}
+
+/**
+ * Rewrites the keys of all map entries within a serialized map entry or
+ * value, including the entries of nested maps. All other fields are copied
+ * verbatim.
+ */
+class FieldNameTranscoder {
+ public:
+  explicit FieldNameTranscoder(const MapKeyTranscoder& transcode_key)
+      : transcode_key_(transcode_key) {
+  }
+
+  bool TranscodeEntry(absl::string_view entry, std::string* out) const {
+    FieldScanner scanner{entry};
+    while (scanner.Next()) {
+      switch (scanner.field_number()) {
+        case google_firestore_v1_MapValue_FieldsEntry_key_tag:
+        case kFieldNameIdTag:
+          if (!transcode_key_(scanner, out)) return false;
+          break;
+
+        case google_firestore_v1_MapValue_FieldsEntry_value_tag:
+          if (!TranscodeNested(scanner, &FieldNameTranscoder::TranscodeValue,
+                               out)) {
+            return false;
+          }
+          break;
+
+        default:
+          Append(scanner.encoded_field(), out);
+          break;
+      }
+    }
+    return scanner.ok();
+  }
+
+  bool TranscodeValue(absl::string_view value, std::string* out) const {
+    FieldScanner scanner{value};
+    while (scanner.Next()) {
+      bool ok = true;
+      if (scanner.field_number() == google_firestore_v1_Value_map_value_tag) {
+        ok = TranscodeNested(scanner, &FieldNameTranscoder::TranscodeMap, out);
+      } else if (scanner.field_number() ==
+                 google_firestore_v1_Value_array_value_tag) {
+        ok =
+            TranscodeNested(scanner, &FieldNameTranscoder::TranscodeArray, out);
+      } else {
+        Append(scanner.encoded_field(), out);
+      }
+      if (!ok) return false;
+    }
+    return scanner.ok();
+  }
+
+ private:
+  using Method = bool (FieldNameTranscoder::*)(absl::string_view,
+                                               std::string*) const;
+
+  bool TranscodeMap(absl::string_view map, std::string* out) const {
+    return TranscodeRepeated(map, google_firestore_v1_MapValue_fields_tag,
+                             &FieldNameTranscoder::TranscodeEntry, out);
+  }
+
+  bool TranscodeArray(absl::string_view array, std::string* out) const {
+    return TranscodeRepeated(array, google_firestore_v1_ArrayValue_values_tag,
+                             &FieldNameTranscoder::TranscodeValue, out);
+  }
+
+  /**
+   * Transcodes all fields with the given field number in `message` with
+   * `method`, and copies all other fields.
+   */
+  bool TranscodeRepeated(absl::string_view message,
+                         uint32_t field_number,
+                         Method method,
+                         std::string* out) const {
+    FieldScanner scanner{message};
+    while (scanner.Next()) {
+      if (scanner.field_number() == field_number) {
+        if (!TranscodeNested(scanner, method, out)) return false;
+      } else {
+        Append(scanner.encoded_field(), out);
+      }
+    }
+    return scanner.ok();
+  }
+
+  /**
+   * Transcodes the contents of the current field of `scanner` with `method`
+   * and appends the result under the same field number.
+   */
+  bool TranscodeNested(const FieldScanner& scanner,
+                       Method method,
+                       std::string* out) const {
+    if (scanner.wire_type() != PB_WT_STRING) return false;
+
+    std::string contents;
+    if (!(this->*method)(scanner.bytes_value(), &contents)) return false;
+    AppendBytesField(out, scanner.field_number(), contents);
+    return true;
+  }
+
+  const MapKeyTranscoder& transcode_key_;
+};
+
+/**
+ * Returns the field name the current field of `key` stands for, or `nullptr`
+ * if it is not a valid field name id.
+ */
+const std::string* LookUpFieldName(const FieldScanner& key,
+                                   const FieldNameTable* field_names) {
+  if (!field_names || key.wire_type() != PB_WT_VARINT ||
+      key.varint_value() >
+          static_cast<uint64_t>(std::numeric_limits<int32_t>::max())) {
+    return nullptr;
+  }
+  return field_names->GetFieldName(static_cast<int32_t>(key.varint_value()));
+}
+
+MapKeyTranscoder FieldNameResolver(const FieldNameTable& field_names) {
+  return [&field_names](const FieldScanner& key, std::string* out) {
+    if (key.field_number() != kFieldNameIdTag) {
+      Append(key.encoded_field(), out);
+      return true;
+    }
+
+    const std::string* field_name = LookUpFieldName(key, &field_names);
+    if (!field_name) return false;
+
+    AppendBytesField(out, google_firestore_v1_MapValue_FieldsEntry_key_tag,
+                     *field_name);
+    return true;
+  };
+}
+
+}  // namespace
+
+bool TranscodeMapKeys(absl::string_view entry,
+                      const MapKeyTranscoder& transcode_key,
+                      std::string* out) {
+  return FieldNameTranscoder{transcode_key}.TranscodeEntry(entry, out);
+}
+
+bool ResolveFieldNames(absl::string_view entry,
+                       const FieldNameTable& field_names,
+                       std::string* out) {
+  return TranscodeMapKeys(entry, FieldNameResolver(field_names), out);
+}
+
+bool ResolveValueFieldNames(absl::string_view value,
+                            const FieldNameTable& field_names,
+                            std::string* out) {
+  MapKeyTranscoder resolver = FieldNameResolver(field_names);
+  return FieldNameTranscoder{resolver}.TranscodeValue(value, out);
+}
+
+bool ReadMapEntry(absl::string_view entry,
+                  const FieldNameTable* field_names,
+                  absl::string_view* key,
+                  absl::string_view* value) {
+  *key = {};
+  *value = {};
+
+  FieldScanner scanner{entry};
+  while (scanner.Next()) {
+    switch (scanner.field_number()) {
+      case google_firestore_v1_MapValue_FieldsEntry_key_tag:
+        *key = scanner.bytes_value();
+        break;
+
+      case kFieldNameIdTag: {
+        const std::string* field_name = LookUpFieldName(scanner, field_names);
+        if (!field_name) return false;
+        *key = *field_name;
+        break;
+      }
+
+      case google_firestore_v1_MapValue_FieldsEntry_value_tag:
+        *value = scanner.bytes_value();
+        break;
+
+      default:
+        break;
+    }
+  }
+  return scanner.ok();
+}
+
+}  // namespace model
+}  // namespace firestore
+}  // namespace firebase
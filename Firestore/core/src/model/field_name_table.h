@@ -0,0 +1,117 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_MODEL_FIELD_NAME_TABLE_H_
+#define FIRESTORE_CORE_SRC_MODEL_FIELD_NAME_TABLE_H_
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+#include "absl/strings/string_view.h"
+
+namespace firebase {
+namespace firestore {
+
+namespace nanopb {
+class FieldScanner;
+}  // namespace nanopb
+
+namespace model {
+
+/**
+ * The field number that holds the field name id in dictionary-encoded map
+ * entries. It is not used by either `google_firestore_v1_Document_FieldsEntry`
+ * or `google_firestore_v1_MapValue_FieldsEntry`.
+ *
+ * Dictionary-encoded documents use the same wire format as regular documents,
+ * except that the `key` of any map entry may be replaced by a varint field
+ * with this number that holds the id of the key in a `FieldNameTable`.
+ */
+constexpr uint32_t kFieldNameIdTag = 3;
+
+/**
+ * Maps the field name ids used by the dictionary-encoded documents of a
+ * collection group to the field names they stand for.
+ *
+ * Ids never change once assigned, so documents can keep a table and resolve
+ * ids long after they were read. Implementations must be thread-safe.
+ */
+class FieldNameTable {
+ public:
+  virtual ~FieldNameTable() = default;
+
+  /**
+   * Returns the field name with the given id, or `nullptr` if there is no such
+   * id. The returned pointer remains valid for the lifetime of the table.
+   */
+  virtual const std::string* GetFieldName(int32_t field_name_id) const = 0;
+};
+
+/**
+ * Transcodes the key of a map entry, given as either its `key` or its field
+ * name id field, and appends the result to `out`.
+ */
+using MapKeyTranscoder =
+    std::function<bool(const nanopb::FieldScanner& key, std::string* out)>;
+
+/**
+ * Appends the serialized map entry `entry` to `out`, replacing the keys of
+ * the entry and of all maps nested in its value with the output of
+ * `transcode_key`. All other fields are copied verbatim.
+ *
+ * @return false if `entry` is malformed or `transcode_key` fails.
+ */
+bool TranscodeMapKeys(absl::string_view entry,
+                      const MapKeyTranscoder& transcode_key,
+                      std::string* out);
+
+/**
+ * Appends the serialized map entry `entry` to `out`, replacing all field name
+ * ids with the field names they stand for. Entries without ids are copied
+ * as-is.
+ *
+ * @return false if `entry` is malformed or refers to an unknown id.
+ */
+bool ResolveFieldNames(absl::string_view entry,
+                       const FieldNameTable& field_names,
+                       std::string* out);
+
+/**
+ * Like `ResolveFieldNames()`, but for a serialized `google_firestore_v1_Value`
+ * instead of a map entry.
+ */
+bool ResolveValueFieldNames(absl::string_view value,
+                            const FieldNameTable& field_names,
+                            std::string* out);
+
+/**
+ * Reads the key and the serialized value of the serialized map entry `entry`.
+ * If the key is given as a field name id, it is looked up in `field_names`,
+ * which may be null for entries that are known not to use ids.
+ *
+ * @return false if `entry` is malformed or refers to an unknown id.
+ */
+bool ReadMapEntry(absl::string_view entry,
+                  const FieldNameTable* field_names,
+                  absl::string_view* key,
+                  absl::string_view* value);
+
+}  // namespace model
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_MODEL_FIELD_NAME_TABLE_H_
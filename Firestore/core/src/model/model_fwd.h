@@ -18,6 +18,7 @@
 #define FIRESTORE_CORE_SRC_MODEL_MODEL_FWD_H_
 
 #include <cstdint>
+#include <functional>
 #include <map>
 #include <unordered_map>
 
@@ -41,12 +42,17 @@ struct Comparator;
 
 namespace immutable {
 
-template <typename K, typename V, typename C>
+class AtomicRefCount;
+
+template <typename K, typename V, typename C, typename R>
 class SortedMap;
 
-template <typename K, typename C>
+template <typename K, typename C, typename R>
 class SortedSet;
 
+template <typename K, typename H, typename E>
+class HashSet;
+
 }  // namespace immutable
 
 namespace nanopb {
@@ -92,14 +98,22 @@ using BatchId = int32_t;
 using ListenSequenceNumber = int64_t;
 using TargetId = int32_t;
 
-using DocumentKeySet =
-    immutable::SortedSet<DocumentKey, util::Comparator<DocumentKey>>;
+using DocumentKeySet = immutable::SortedSet<DocumentKey,
+                                            util::Comparator<DocumentKey>,
+                                            immutable::AtomicRefCount>;
+
+using DocumentKeyHashSet = immutable::
+    HashSet<DocumentKey, DocumentKeyHash, std::equal_to<DocumentKey>>;
 
-using MutableDocumentMap = immutable::
-    SortedMap<DocumentKey, MutableDocument, util::Comparator<DocumentKey>>;
+using MutableDocumentMap = immutable::SortedMap<DocumentKey,
+                                                MutableDocument,
+                                                util::Comparator<DocumentKey>,
+                                                immutable::AtomicRefCount>;
 
-using DocumentMap =
-    immutable::SortedMap<DocumentKey, Document, util::Comparator<DocumentKey>>;
+using DocumentMap = immutable::SortedMap<DocumentKey,
+                                         Document,
+                                         util::Comparator<DocumentKey>,
+                                         immutable::AtomicRefCount>;
 
 using DocumentVersionMap =
     std::unordered_map<DocumentKey, SnapshotVersion, DocumentKeyHash>;
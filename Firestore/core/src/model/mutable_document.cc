@@ -16,9 +16,12 @@
 
 #include "Firestore/core/src/model/mutable_document.h"
 
+#include <algorithm>
+#include <iterator>
 #include <ostream>
 #include <sstream>
 
+#include "Firestore/core/src/immutable/sorted_map.h"
 #include "Firestore/core/src/model/value_util.h"
 
 namespace firebase {
@@ -164,6 +167,18 @@ std::ostream& operator<<(std::ostream& os,
   UNREACHABLE();
 }
 
+MutableDocumentMap ToSortedMap(
+    std::vector<std::pair<DocumentKey, MutableDocument>> entries) {
+  std::sort(entries.begin(), entries.end(),
+            [](const std::pair<DocumentKey, MutableDocument>& lhs,
+               const std::pair<DocumentKey, MutableDocument>& rhs) {
+              return lhs.first < rhs.first;
+            });
+  return MutableDocumentMap::FromSortedRange(
+      std::make_move_iterator(entries.begin()),
+      std::make_move_iterator(entries.end()));
+}
+
 }  // namespace model
 }  // namespace firestore
 }  // namespace firebase
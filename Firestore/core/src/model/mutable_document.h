@@ -21,9 +21,11 @@
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "Firestore/Protos/nanopb/google/firestore/v1/document.nanopb.h"
 #include "Firestore/core/src/model/document_key.h"
+#include "Firestore/core/src/model/model_fwd.h"
 #include "Firestore/core/src/model/object_value.h"
 #include "Firestore/core/src/model/snapshot_version.h"
 
@@ -248,6 +250,14 @@ inline bool operator!=(const MutableDocument& lhs, const MutableDocument& rhs) {
   return !(lhs == rhs);
 }
 
+/**
+ * Returns a map of the given documents, which may be in any order. Sorting
+ * them allows building the map in a single pass instead of inserting the
+ * documents one by one.
+ */
+MutableDocumentMap ToSortedMap(
+    std::vector<std::pair<DocumentKey, MutableDocument>> entries);
+
 }  // namespace model
 }  // namespace firestore
 }  // namespace firebase
@@ -23,9 +23,11 @@
 #include "Firestore/Protos/nanopb/google/firestore/v1/document.nanopb.h"
 #include "Firestore/core/src/model/value_util.h"
 #include "Firestore/core/src/nanopb/byte_string.h"
+#include "Firestore/core/src/nanopb/field_scanner.h"
 #include "Firestore/core/src/nanopb/fields_array.h"
 #include "Firestore/core/src/nanopb/message.h"
 #include "Firestore/core/src/nanopb/nanopb_util.h"
+#include "Firestore/core/src/nanopb/reader.h"
 #include "Firestore/core/src/util/hashing.h"
 
 #include "absl/strings/str_format.h"
@@ -40,6 +42,7 @@ namespace {
 using model::DeepClone;
 using nanopb::ByteString;
 using nanopb::CheckedSize;
+using nanopb::FieldScanner;
 using nanopb::FreeFieldsArray;
 using nanopb::FreeNanopbMessage;
 using nanopb::MakeArray;
@@ -49,6 +52,7 @@ using nanopb::MakeStringView;
 using nanopb::Message;
 using nanopb::ReleaseFieldOwnership;
 using nanopb::SetRepeatedField;
+using nanopb::StringReader;
 
 struct MapEntryKeyCompare {
   bool operator()(const google_firestore_v1_MapValue_FieldsEntry& entry,
@@ -84,6 +88,113 @@ google_firestore_v1_MapValue_FieldsEntry* FindEntry(
   return found.first;
 }
 
+/**
+ * Returns the value at `path` within `value`, or `nullopt` if there is no such
+ * value.
+ */
+absl::optional<google_firestore_v1_Value> FindValue(
+    const google_firestore_v1_Value& value, const FieldPath& path) {
+  google_firestore_v1_Value nested_value = value;
+  for (const std::string& segment : path) {
+    google_firestore_v1_MapValue_FieldsEntry* entry =
+        FindEntry(nested_value, segment);
+    if (!entry) return absl::nullopt;
+    nested_value = entry->value;
+  }
+  return nested_value;
+}
+
+/**
+ * Finds an entry by key in a serialized map, given as the serialized message
+ * that contains the repeated `entry_tag` map entries. Both
+ * `google_firestore_v1_Document` and `google_firestore_v1_MapValue` use the
+ * same layout for their entries. Keys given as field name ids are resolved
+ * with `field_names`. Returns the serialized value of the entry or `nullopt`
+ * if the entry does not exist.
+ */
+absl::optional<absl::string_view> FindEncodedEntry(
+    absl::string_view map,
+    uint32_t entry_tag,
+    absl::string_view segment,
+    const FieldNameTable* field_names) {
+  FieldScanner map_scanner{map};
+  while (map_scanner.NextField(entry_tag)) {
+    absl::string_view key;
+    absl::string_view value;
+    bool ok =
+        ReadMapEntry(map_scanner.bytes_value(), field_names, &key, &value);
+    HARD_ASSERT(ok, "Failed to decode map entry");
+
+    if (key == segment) return value;
+  }
+  HARD_ASSERT(map_scanner.ok(), "Failed to decode map");
+  return absl::nullopt;
+}
+
+/**
+ * Returns the serialized MapValue of the given serialized Value, or `nullopt`
+ * if the Value is not a map.
+ */
+absl::optional<absl::string_view> FindEncodedMapValue(
+    absl::string_view value) {
+  // All fields of a Value are members of the `value_type` oneof, so the last
+  // field determines the type.
+  absl::optional<absl::string_view> map_value;
+  FieldScanner scanner{value};
+  while (scanner.Next()) {
+    if (scanner.field_number() == google_firestore_v1_Value_map_value_tag) {
+      map_value = scanner.bytes_value();
+    } else {
+      map_value = absl::nullopt;
+    }
+  }
+  HARD_ASSERT(scanner.ok(), "Failed to decode value");
+  return map_value;
+}
+
+/**
+ * Decodes only the value at `path` from the serialized Document, or returns
+ * `nullopt` if the document does not contain a value at `path`.
+ */
+absl::optional<Message<google_firestore_v1_Value>> DecodeDocumentField(
+    const ByteString& encoded_document,
+    const FieldNameTable* field_names,
+    const FieldPath& path) {
+  absl::optional<absl::string_view> encoded_value;
+  absl::string_view map = MakeStringView(encoded_document);
+  uint32_t entry_tag = google_firestore_v1_Document_fields_tag;
+
+  for (const std::string& segment : path) {
+    if (encoded_value) {
+      absl::optional<absl::string_view> nested_map =
+          FindEncodedMapValue(*encoded_value);
+      if (!nested_map) return absl::nullopt;
+      map = *nested_map;
+      entry_tag = google_firestore_v1_MapValue_fields_tag;
+    }
+
+    encoded_value = FindEncodedEntry(map, entry_tag, segment, field_names);
+    if (!encoded_value) return absl::nullopt;
+  }
+
+  // Maps nested in the value may use field name ids as well.
+  std::string resolved_value;
+  if (field_names) {
+    bool ok =
+        ResolveValueFieldNames(*encoded_value, *field_names, &resolved_value);
+    HARD_ASSERT(ok, "Failed to resolve the field names of document field %s",
+                path.CanonicalString());
+    encoded_value = resolved_value;
+  }
+
+  StringReader reader{*encoded_value};
+  auto value = Message<google_firestore_v1_Value>::TryParse(&reader);
+  HARD_ASSERT(reader.ok(), "Failed to decode document field %s: %s",
+              path.CanonicalString(), reader.status().ToString());
+  SortFields(*value);
+  return value;
+}
+
 size_t CalculateSizeOfUnion(
     const google_firestore_v1_MapValue& map_value,
     const std::map<std::string, Message<google_firestore_v1_Value>>& upserts,
@@ -185,6 +296,60 @@ void ApplyChanges(
   parent->fields_count = CheckedSize(target_count);
 }
 
+/**
+ * Creates a MapValue that takes ownership of the provided document fields and
+ * zeroes out the pointers in `fields_entry`.
+ */
+Message<google_firestore_v1_Value> MakeMapValue(
+    google_firestore_v1_Document_FieldsEntry* fields_entry, pb_size_t count) {
+  Message<google_firestore_v1_Value> value;
+  value->which_value_type = google_firestore_v1_Value_map_value_tag;
+  SetRepeatedField(
+      &value->map_value.fields, &value->map_value.fields_count,
+      absl::Span<google_firestore_v1_Document_FieldsEntry>(fields_entry, count),
+      [](const google_firestore_v1_Document_FieldsEntry& entry) {
+        return google_firestore_v1_MapValue_FieldsEntry{entry.key, entry.value};
+      });
+  // Prevent double-freeing of the document's fields. The fields are now owned
+  // by the returned value.
+  ReleaseFieldOwnership(fields_entry, count);
+  return value;
+}
+
+/** Decodes the fields of the serialized Document into a MapValue. */
+Message<google_firestore_v1_Value> DecodeDocumentFields(
+    const ByteString& encoded_document, const FieldNameTable* field_names) {
+  if (field_names) {
+    // Restore the regular Document before decoding it in one go.
+    std::string resolved;
+    resolved.reserve(encoded_document.size() * 2);
+    FieldScanner scanner{MakeStringView(encoded_document)};
+    while (scanner.Next()) {
+      if (scanner.field_number() == google_firestore_v1_Document_fields_tag) {
+        std::string entry;
+        bool ok =
+            ResolveFieldNames(scanner.bytes_value(), *field_names, &entry);
+        HARD_ASSERT(ok, "Failed to resolve the field names of document fields");
+        nanopb::AppendBytesField(
+            &resolved, google_firestore_v1_Document_fields_tag, entry);
+      } else {
+        absl::string_view field = scanner.encoded_field();
+        resolved.append(field.data(), field.size());
+      }
+    }
+    HARD_ASSERT(scanner.ok(), "Failed to decode document fields");
+    return DecodeDocumentFields(ByteString{resolved}, nullptr);
+  }
+
+  StringReader reader{encoded_document};
+  auto document = Message<google_firestore_v1_Document>::TryParse(&reader);
+  HARD_ASSERT(reader.ok(), "Failed to decode document fields: %s",
+              reader.status().ToString());
+  auto value = MakeMapValue(document->fields, document->fields_count);
+  SortFields(*value);
+  return value;
+}
+
 }  // namespace
 
 ObjectValue::ObjectValue() {
@@ -199,8 +364,19 @@ ObjectValue::ObjectValue(Message<google_firestore_v1_Value> value)
   SortFields(*value_);
 }
 
-ObjectValue::ObjectValue(const ObjectValue& other)
-    : value_(DeepClone(*other.value_)) {
+ObjectValue::ObjectValue(const ObjectValue& other) {
+  if (other.encoded_ && !other.encoded_->decoded.load()) {
+    // Share the serialized bytes and leave decoding to the copy.
+    encoded_ = absl::make_unique<EncodedDocument>(
+        other.encoded_->bytes, other.encoded_->field_names, false);
+    return;
+  }
+
+  value_ = DeepClone(other.value());
+  if (other.encoded_) {
+    encoded_ = absl::make_unique<EncodedDocument>(
+        other.encoded_->bytes, other.encoded_->field_names, true);
+  }
 }
 
 ObjectValue ObjectValue::FromMapValue(
@@ -213,18 +389,32 @@ ObjectValue ObjectValue::FromMapValue(
 
 ObjectValue ObjectValue::FromFieldsEntry(
     google_firestore_v1_Document_FieldsEntry* fields_entry, pb_size_t count) {
-  Message<google_firestore_v1_Value> value;
-  value->which_value_type = google_firestore_v1_Value_map_value_tag;
-  SetRepeatedField(
-      &value->map_value.fields, &value->map_value.fields_count,
-      absl::Span<google_firestore_v1_Document_FieldsEntry>(fields_entry, count),
-      [](const google_firestore_v1_Document_FieldsEntry& entry) {
-        return google_firestore_v1_MapValue_FieldsEntry{entry.key, entry.value};
-      });
-  // Prevent double-freeing of the document's fields. The fields are now owned
-  // by ObjectValue.
-  ReleaseFieldOwnership(fields_entry, count);
-  return ObjectValue{std::move(value)};
+  return ObjectValue{MakeMapValue(fields_entry, count)};
+}
+
+ObjectValue ObjectValue::FromFieldsEntry(
+    google_firestore_v1_Document_FieldsEntry* fields_entry,
+    pb_size_t count,
+    ByteString encoded_document) {
+  ObjectValue result{MakeMapValue(fields_entry, count)};
+  result.encoded_ = absl::make_unique<EncodedDocument>(
+      std::make_shared<const ByteString>(std::move(encoded_document)), nullptr,
+      true);
+  return result;
+}
+
+ObjectValue ObjectValue::FromEncodedDocument(ByteString encoded_document) {
+  return FromEncodedDocument(std::move(encoded_document), nullptr);
+}
+
+ObjectValue ObjectValue::FromEncodedDocument(
+    ByteString encoded_document,
+    std::shared_ptr<const FieldNameTable> field_names) {
+  ObjectValue result;
+  result.encoded_ = absl::make_unique<EncodedDocument>(
+      std::make_shared<const ByteString>(std::move(encoded_document)),
+      std::move(field_names), false);
+  return result;
 }
 
 ObjectValue ObjectValue::FromAggregateFieldsEntry(
@@ -258,8 +448,49 @@ ObjectValue ObjectValue::FromAggregateFieldsEntry(
   return ObjectValue{std::move(value)};
 }
 
+const google_firestore_v1_Value& ObjectValue::value() const {
+  if (encoded_ && !encoded_->decoded.load(std::memory_order_acquire)) {
+    std::lock_guard<std::mutex> lock(encoded_->mutex);
+    if (!encoded_->decoded.load(std::memory_order_relaxed)) {
+      value_ = DecodeDocumentFields(*encoded_->bytes,
+                                    encoded_->field_names.get());
+      encoded_->decoded.store(true, std::memory_order_release);
+    }
+  }
+  return *value_;
+}
+
+absl::optional<google_firestore_v1_Value> ObjectValue::GetEncoded(
+    const FieldPath& path) const {
+  std::lock_guard<std::mutex> lock(encoded_->mutex);
+  if (encoded_->decoded.load(std::memory_order_relaxed)) {
+    return FindValue(*value_, path);
+  }
+
+  std::string canonical_path = path.CanonicalString();
+  auto found = encoded_->fields.find(canonical_path);
+  if (found == encoded_->fields.end()) {
+    found = encoded_->fields
+                .emplace(std::move(canonical_path),
+                         DecodeDocumentField(*encoded_->bytes,
+                                             encoded_->field_names.get(), path))
+                .first;
+  }
+
+  const absl::optional<Message<google_firestore_v1_Value>>& field =
+      found->second;
+  if (!field) return absl::nullopt;
+  return **field;
+}
+
+google_firestore_v1_Value* ObjectValue::mutable_value() {
+  value();
+  encoded_.reset();
+  return value_.get();
+}
+
 FieldMask ObjectValue::ToFieldMask() const {
-  return ExtractFieldMask(value_->map_value);
+  return ExtractFieldMask(value().map_value);
 }
 
 FieldMask ObjectValue::ExtractFieldMask(
@@ -293,28 +524,28 @@ FieldMask ObjectValue::ExtractFieldMask(
 absl::optional<google_firestore_v1_Value> ObjectValue::Get(
     const FieldPath& path) const {
   if (path.empty()) {
-    return *value_;
+    return value();
   }
 
-  google_firestore_v1_Value nested_value = *value_;
-  for (const std::string& segment : path) {
-    google_firestore_v1_MapValue_FieldsEntry* entry =
-        FindEntry(nested_value, segment);
-    if (!entry) return absl::nullopt;
-    nested_value = entry->value;
+  if (encoded_ && !encoded_->decoded.load(std::memory_order_acquire)) {
+    return GetEncoded(path);
   }
-  return nested_value;
+  return FindValue(*value_, path);
 }
 
 absl::optional<google_firestore_v1_Value> ObjectValue::Get(
     const std::string& key) const {
+  if (encoded_ && !encoded_->decoded.load(std::memory_order_acquire)) {
+    return GetEncoded(FieldPath{key});
+  }
+
   google_firestore_v1_MapValue_FieldsEntry* entry = FindEntry(*value_, key);
   if (!entry) return absl::nullopt;
   return entry->value;
 }
 
 google_firestore_v1_Value ObjectValue::Get() const {
-  return *value_;
+  return value();
 }
 
 void ObjectValue::Set(const FieldPath& path,
@@ -363,7 +594,10 @@ void ObjectValue::SetAll(TransformMap data) {
 void ObjectValue::Delete(const FieldPath& path) {
   HARD_ASSERT(!path.empty(), "Cannot delete field with empty path");
 
-  google_firestore_v1_Value* nested_value = value_.get();
+  // Keep the serialized bytes if there is nothing to delete.
+  if (!Get(path)) return;
+
+  google_firestore_v1_Value* nested_value = mutable_value();
   for (const std::string& segment : path.PopLast()) {
     auto* entry = FindEntry(*nested_value, segment);
     // If the entry is not found, exit early. There is nothing to delete.
@@ -379,15 +613,15 @@ void ObjectValue::Delete(const FieldPath& path) {
 }
 
 std::string ObjectValue::ToString() const {
-  return CanonicalId(*value_);
+  return CanonicalId(value());
 }
 
 size_t ObjectValue::Hash() const {
-  return util::Hash(CanonicalId(*value_));
+  return util::Hash(CanonicalId(value()));
 }
 
 google_firestore_v1_MapValue* ObjectValue::ParentMap(const FieldPath& path) {
-  google_firestore_v1_Value* parent = value_.get();
+  google_firestore_v1_Value* parent = mutable_value();
 
   // Find a or create a parent map entry for `path`.
   for (const std::string& segment : path) {
@@ -17,17 +17,23 @@
 #ifndef FIRESTORE_CORE_SRC_MODEL_OBJECT_VALUE_H_
 #define FIRESTORE_CORE_SRC_MODEL_OBJECT_VALUE_H_
 
+#include <atomic>
 #include <map>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
 #include <ostream>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <utility>
 
 #include "Firestore/Protos/nanopb/google/firestore/v1/document.nanopb.h"
 #include "Firestore/core/src/model/field_mask.h"
+#include "Firestore/core/src/model/field_name_table.h"
 #include "Firestore/core/src/model/field_path.h"
 #include "Firestore/core/src/model/model_fwd.h"
 #include "Firestore/core/src/model/value_util.h"
+#include "Firestore/core/src/nanopb/byte_string.h"
 #include "Firestore/core/src/nanopb/message.h"
 #include "Firestore/core/src/util/hard_assert.h"
 
@@ -69,6 +75,40 @@ class ObjectValue {
   static ObjectValue FromFieldsEntry(
       google_firestore_v1_Document_FieldsEntry* fields_entry, pb_size_t count);
 
+  /**
+   * Creates a new ObjectValue that is backed by the provided document fields,
+   * like `FromFieldsEntry()`, and that additionally retains
+   * `encoded_document`, the serialized `google_firestore_v1_Document` the
+   * fields were decoded from. This allows the document to be persisted without
+   * encoding its fields again, at the cost of keeping the bytes in memory
+   * until the value is modified.
+   */
+  static ObjectValue FromFieldsEntry(
+      google_firestore_v1_Document_FieldsEntry* fields_entry,
+      pb_size_t count,
+      nanopb::ByteString encoded_document);
+
+  /**
+   * Creates a new ObjectValue that is backed by the serialized
+   * `google_firestore_v1_Document` in `encoded_document`. All other members
+   * of the Document (such as its name and update time) are ignored.
+   *
+   * The fields of the document are decoded on demand: `Get()` with a field
+   * path only decodes the value at that path, while all other accessors
+   * decode the entire document.
+   */
+  static ObjectValue FromEncodedDocument(nanopb::ByteString encoded_document);
+
+  /**
+   * Creates a new ObjectValue that is backed by the serialized
+   * `google_firestore_v1_Document` in `encoded_document`, like
+   * `FromEncodedDocument()`, whose map keys may be given as field name ids
+   * from `field_names`. Ids are resolved as the fields are decoded.
+   */
+  static ObjectValue FromEncodedDocument(
+      nanopb::ByteString encoded_document,
+      std::shared_ptr<const FieldNameTable> field_names);
+
   /**
    * Creates a new ObjectValue that is backed by the provided aggregation
    * result. ObjectValue takes on ownership of the data and zeroes out the
@@ -134,6 +174,29 @@ class ObjectValue {
    */
   void Delete(const FieldPath& path);
 
+  /**
+   * Returns the serialized `google_firestore_v1_Document` whose fields back
+   * this ObjectValue, or `nullptr` if this ObjectValue was not created from
+   * serialized bytes, if it has been modified since, or if its field names
+   * are dictionary-encoded.
+   */
+  const nanopb::ByteString* encoded_document() const {
+    return encoded_document(nullptr);
+  }
+
+  /**
+   * Returns the serialized `google_firestore_v1_Document` whose fields back
+   * this ObjectValue if its field names are dictionary-encoded with
+   * `field_names` (or not dictionary-encoded at all if `field_names` is null),
+   * or `nullptr` otherwise.
+   */
+  const nanopb::ByteString* encoded_document(
+      const FieldNameTable* field_names) const {
+    return encoded_ && encoded_->field_names.get() == field_names
+               ? encoded_->bytes.get()
+               : nullptr;
+  }
+
   std::string ToString() const;
 
   size_t Hash() const;
@@ -143,6 +206,61 @@ class ObjectValue {
                                   const ObjectValue& object_value);
 
  private:
+  /**
+   * The serialized form of an ObjectValue created via `FromEncodedDocument()`
+   * or `FromFieldsEntry()` with encoded bytes. The bytes are immutable and are
+   * shared between copies; the decoding state is specific to each instance.
+   */
+  struct EncodedDocument {
+    EncodedDocument(std::shared_ptr<const nanopb::ByteString> bytes,
+                    std::shared_ptr<const FieldNameTable> field_names,
+                    bool decoded)
+        : bytes(std::move(bytes)),
+          field_names(std::move(field_names)),
+          decoded(decoded) {
+    }
+
+    std::shared_ptr<const nanopb::ByteString> bytes;
+
+    // Resolves the field name ids in `bytes`, or null if the field names are
+    // not dictionary-encoded.
+    std::shared_ptr<const FieldNameTable> field_names;
+
+    // Guards decoding, which may be triggered from multiple threads when
+    // documents are shared with the API layer.
+    std::mutex mutex;
+    std::atomic<bool> decoded;
+
+    // Values that have been decoded individually before the document was
+    // decoded in its entirety, keyed by their canonical field path. Missing
+    // fields are cached as `nullopt`. The values are kept alive until the
+    // ObjectValue is modified since `Get()` hands out shallow copies.
+    std::unordered_map<
+        std::string,
+        absl::optional<nanopb::Message<google_firestore_v1_Value>>>
+        fields;
+  };
+
+  /**
+   * Returns the decoded MapValue, decoding the serialized document first if
+   * it has not been decoded yet.
+   */
+  const google_firestore_v1_Value& value() const;
+
+  /**
+   * Returns the decoded MapValue for modification. Since the result no longer
+   * corresponds to the serialized document, the serialized bytes are dropped.
+   */
+  google_firestore_v1_Value* mutable_value();
+
+  /**
+   * Returns the value at the given path by decoding only the map entries
+   * along `path` from the serialized document. Falls back to the decoded
+   * MapValue if the document has been decoded in the meantime.
+   */
+  absl::optional<google_firestore_v1_Value> GetEncoded(
+      const FieldPath& path) const;
+
   /** Returns the field mask for the provided map value. */
   FieldMask ExtractFieldMask(const google_firestore_v1_MapValue& value) const;
 
@@ -152,11 +270,19 @@ class ObjectValue {
    */
   google_firestore_v1_MapValue* ParentMap(const FieldPath& path);
 
-  nanopb::Message<google_firestore_v1_Value> value_;
+  // Lazily populated from `encoded_` if this ObjectValue is backed by a
+  // serialized document that has not been decoded yet.
+  mutable nanopb::Message<google_firestore_v1_Value> value_;
+  std::unique_ptr<EncodedDocument> encoded_;
 };
 
 inline bool operator==(const ObjectValue& lhs, const ObjectValue& rhs) {
-  return *lhs.value_ == *rhs.value_;
+  // Copies of the same serialized document share their bytes.
+  if (lhs.encoded_ && rhs.encoded_ &&
+      lhs.encoded_->bytes == rhs.encoded_->bytes) {
+    return true;
+  }
+  return lhs.value() == rhs.value();
 }
 
 inline bool operator!=(const ObjectValue& lhs, const ObjectValue& rhs) {
@@ -165,7 +291,7 @@ inline bool operator!=(const ObjectValue& lhs, const ObjectValue& rhs) {
 
 inline std::ostream& operator<<(std::ostream& out,
                                 const ObjectValue& object_value) {
-  return out << "ObjectValue(" << *object_value.value_ << ")";
+  return out << "ObjectValue(" << object_value.value() << ")";
 }
 
 }  // namespace model
@@ -0,0 +1,133 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/nanopb/field_scanner.h"
+
+namespace firebase {
+namespace firestore {
+namespace nanopb {
+namespace {
+
+// A varint is at most 10 bytes long (64 bits in 7-bit groups).
+constexpr int kMaxVarintBytes = 10;
+
+}  // namespace
+
+bool FieldScanner::Next() {
+  if (!ok_ || pos_ >= message_.size()) {
+    return false;
+  }
+
+  size_t start = pos_;
+  uint64_t tag = 0;
+  if (!ReadVarint(&tag)) return Fail();
+
+  field_number_ = static_cast<uint32_t>(tag >> 3);
+  wire_type_ = static_cast<pb_wire_type_t>(tag & 0x7);
+  varint_value_ = 0;
+  bytes_value_ = {};
+  if (field_number_ == 0) return Fail();
+
+  switch (wire_type_) {
+    case PB_WT_VARINT:
+      if (!ReadVarint(&varint_value_)) return Fail();
+      break;
+
+    case PB_WT_64BIT:
+      if (!Skip(8)) return Fail();
+      break;
+
+    case PB_WT_32BIT:
+      if (!Skip(4)) return Fail();
+      break;
+
+    case PB_WT_STRING: {
+      uint64_t length = 0;
+      if (!ReadVarint(&length)) return Fail();
+      if (length > message_.size() - pos_) return Fail();
+      bytes_value_ = message_.substr(pos_, static_cast<size_t>(length));
+      pos_ += static_cast<size_t>(length);
+      break;
+    }
+
+    default:
+      // Groups are deprecated and never used by Firestore.
+      return Fail();
+  }
+
+  encoded_field_ = message_.substr(start, pos_ - start);
+  return true;
+}
+
+bool FieldScanner::NextField(uint32_t field_number) {
+  while (Next()) {
+    if (field_number_ == field_number) return true;
+  }
+  return false;
+}
+
+bool FieldScanner::ReadVarint(uint64_t* value) {
+  uint64_t result = 0;
+  for (int i = 0; i < kMaxVarintBytes; ++i) {
+    if (pos_ >= message_.size()) return false;
+
+    auto byte = static_cast<uint8_t>(message_[pos_++]);
+    result |= static_cast<uint64_t>(byte & 0x7F) << (7 * i);
+    if ((byte & 0x80) == 0) {
+      *value = result;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool FieldScanner::Skip(size_t count) {
+  if (count > message_.size() - pos_) return false;
+  pos_ += count;
+  return true;
+}
+
+bool FieldScanner::Fail() {
+  ok_ = false;
+  return false;
+}
+
+void AppendVarint(std::string* out, uint64_t value) {
+  while (value >= 0x80) {
+    out->push_back(static_cast<char>((value & 0x7F) | 0x80));
+    value >>= 7;
+  }
+  out->push_back(static_cast<char>(value));
+}
+
+void AppendBytesField(std::string* out,
+                      uint32_t field_number,
+                      absl::string_view contents) {
+  AppendVarint(out, (static_cast<uint64_t>(field_number) << 3) | PB_WT_STRING);
+  AppendVarint(out, contents.size());
+  out->append(contents.data(), contents.size());
+}
+
+void AppendVarintField(std::string* out,
+                       uint32_t field_number,
+                       uint64_t value) {
+  AppendVarint(out, (static_cast<uint64_t>(field_number) << 3) | PB_WT_VARINT);
+  AppendVarint(out, value);
+}
+
+}  // namespace nanopb
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,139 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_NANOPB_FIELD_SCANNER_H_
+#define FIRESTORE_CORE_SRC_NANOPB_FIELD_SCANNER_H_
+
+#include <pb.h>
+
+#include <cstdint>
+#include <string>
+
+#include "absl/strings/string_view.h"
+
+namespace firebase {
+namespace firestore {
+namespace nanopb {
+
+/**
+ * Walks the top-level fields of a serialized protocol buffer message without
+ * decoding it into a Nanopb proto.
+ *
+ * Length-delimited fields (strings, bytes and nested messages) are exposed as
+ * views into the original buffer. This makes it possible to copy or decode
+ * only the parts of a message that are actually needed, e.g. to pick a single
+ * entry out of a serialized `MapValue`.
+ *
+ * The buffer passed to the constructor must remain valid for the lifetime of
+ * the `FieldScanner`.
+ */
+class FieldScanner {
+ public:
+  explicit FieldScanner(absl::string_view message) : message_(message) {
+  }
+
+  /**
+   * Advances to the next field of the message. Returns false once the end of
+   * the message has been reached or if the message is malformed; use `ok()` to
+   * distinguish between the two.
+   */
+  bool Next();
+
+  /**
+   * Advances to the next field with the given field number, skipping all
+   * other fields. Returns false if there is no such field.
+   */
+  bool NextField(uint32_t field_number);
+
+  /** The field number of the current field. */
+  uint32_t field_number() const {
+    return field_number_;
+  }
+
+  /** The wire type of the current field. */
+  pb_wire_type_t wire_type() const {
+    return wire_type_;
+  }
+
+  /**
+   * The value of the current field if it has the `PB_WT_VARINT` wire type, or
+   * zero otherwise.
+   */
+  uint64_t varint_value() const {
+    return varint_value_;
+  }
+
+  /**
+   * The contents of the current field, without its tag or length prefix, if it
+   * has the `PB_WT_STRING` wire type, or an empty view otherwise.
+   */
+  absl::string_view bytes_value() const {
+    return bytes_value_;
+  }
+
+  /**
+   * The complete encoding of the current field, including its tag. Appending
+   * this to another message of the same type copies the field verbatim.
+   */
+  absl::string_view encoded_field() const {
+    return encoded_field_;
+  }
+
+  /** Returns false if a malformed field was encountered. */
+  bool ok() const {
+    return ok_;
+  }
+
+ private:
+  bool ReadVarint(uint64_t* value);
+  bool Skip(size_t count);
+  bool Fail();
+
+  absl::string_view message_;
+  size_t pos_ = 0;
+  bool ok_ = true;
+
+  uint32_t field_number_ = 0;
+  pb_wire_type_t wire_type_ = PB_WT_VARINT;
+  uint64_t varint_value_ = 0;
+  absl::string_view bytes_value_;
+  absl::string_view encoded_field_;
+};
+
+/**
+ * Appends the encoding of a varint to `out`.
+ */
+void AppendVarint(std::string* out, uint64_t value);
+
+/**
+ * Appends a tag and length prefix followed by the given `contents` to `out`,
+ * forming a length-delimited field with the given field number.
+ */
+void AppendBytesField(std::string* out,
+                      uint32_t field_number,
+                      absl::string_view contents);
+
+/**
+ * Appends a tag followed by the given `value` to `out`, forming a varint field
+ * with the given field number.
+ */
+void AppendVarintField(std::string* out, uint32_t field_number, uint64_t value);
+
+}  // namespace nanopb
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_NANOPB_FIELD_SCANNER_H_
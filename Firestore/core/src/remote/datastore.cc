@@ -16,6 +16,8 @@
 
 #include "Firestore/core/src/remote/datastore.h"
 
+#include <algorithm>
+#include <map>
 #include <unordered_set>
 #include <utility>
 
@@ -24,6 +26,7 @@
 #include "Firestore/core/src/core/query.h"
 #include "Firestore/core/src/credentials/auth_token.h"
 #include "Firestore/core/src/model/aggregate_field.h"
+#include "Firestore/core/src/model/document.h"
 #include "Firestore/core/src/model/document_key.h"
 #include "Firestore/core/src/model/mutation.h"
 #include "Firestore/core/src/remote/connectivity_monitor.h"
@@ -51,13 +54,16 @@ using core::DatabaseInfo;
 using credentials::AuthCredentialsProvider;
 using credentials::AuthToken;
 using model::AggregateField;
+using model::Document;
 using model::DocumentKey;
 using model::Mutation;
+using model::SnapshotVersion;
 using util::AsyncQueue;
 using util::Executor;
 using util::LogIsDebugEnabled;
 using util::Status;
 using util::StatusOr;
+using util::TimerId;
 
 const auto kRpcNameCommit = "/google.firestore.v1.Firestore/Commit";
 const auto kRpcNameLookup = "/google.firestore.v1.Firestore/BatchGetDocuments";
@@ -119,6 +125,12 @@ void Datastore::Start() {
 void Datastore::Shutdown() {
   is_shut_down_ = true;
 
+  // Lookups that have not been sent yet are dropped, just like the calls
+  // finished below.
+  lookup_batch_timer_.Cancel();
+  pending_lookups_.clear();
+  pending_lookup_keys_.clear();
+
   // Order matters here: shutting down `grpc_connection_`, which will quickly
   // finish any pending gRPC calls, must happen before shutting down the gRPC
   // queue.
@@ -131,6 +143,12 @@ void Datastore::Shutdown() {
   // Drain the executor to make sure it extracted all the operations from gRPC
   // completion queue.
   rpc_executor_->ExecuteBlocking([] {});
+
+  // Responses still being decoded are dropped once they reach the worker
+  // queue; just make sure none is decoded after shutdown.
+  if (watch_decode_executor_) {
+    watch_decode_executor_->ExecuteBlocking([] {});
+  }
 }
 
 void Datastore::PollGrpcQueue() {
@@ -152,9 +170,16 @@ void Datastore::PollGrpcQueue() {
 
 std::shared_ptr<WatchStream> Datastore::CreateWatchStream(
     WatchStreamCallback* callback) {
-  return std::make_shared<WatchStream>(
+  auto stream = std::make_shared<WatchStream>(
       worker_queue_, auth_credentials_, app_check_credentials_,
       datastore_serializer_.serializer(), &grpc_connection_, callback);
+  if (watch_decode_executor_) {
+    stream->DecodeResponsesOn(watch_decode_executor_);
+  }
+  if (retain_encoded_watch_documents_) {
+    stream->RetainEncodedDocuments();
+  }
+  return stream;
 }
 
 std::shared_ptr<WriteStream> Datastore::CreateWriteStream(
@@ -205,18 +230,161 @@ void Datastore::CommitMutationsWithCredentials(
       });
 }
 
+void Datastore::EnableBackgroundWatchDecoding() {
+  if (!watch_decode_executor_) {
+    watch_decode_executor_ =
+        Executor::CreateSerial("com.google.firebase.firestore.watch_decode");
+  }
+}
+
+void Datastore::EnableLookupBatching(size_t max_batch_size,
+                                     AsyncQueue::Milliseconds max_delay) {
+  max_lookup_batch_size_ = max_batch_size;
+  max_lookup_delay_ = max_delay;
+}
+
 void Datastore::LookupDocuments(const std::vector<DocumentKey>& keys,
                                 LookupCallback&& user_callback) {
+  if (max_lookup_batch_size_ <= 1) {
+    SendLookup(keys, absl::nullopt, std::move(user_callback));
+    return;
+  }
+
+  // Transactions may look up documents from any thread; batches are gathered
+  // on the worker queue.
+  std::weak_ptr<Datastore> weak_this{shared_from_this()};
+  // TODO(c++14): move into lambda.
+  worker_queue_->EnqueueRelaxed([weak_this, keys, user_callback]() mutable {
+    auto strong_this = weak_this.lock();
+    if (strong_this && !strong_this->is_shut_down_) {
+      strong_this->AddToLookupBatch(keys, std::move(user_callback));
+    }
+  });
+}
+
+void Datastore::LookupDocumentFields(const std::vector<DocumentKey>& keys,
+                                     model::FieldMask mask,
+                                     FieldLookupCallback&& user_callback) {
+  SendLookupWithReadTime(keys, std::move(mask), std::move(user_callback));
+}
+
+void Datastore::AddToLookupBatch(const std::vector<DocumentKey>& keys,
+                                 LookupCallback&& user_callback) {
+  size_t new_keys = std::count_if(
+      keys.begin(), keys.end(), [this](const DocumentKey& key) {
+        return pending_lookup_keys_.find(key) == pending_lookup_keys_.end();
+      });
+  if (!pending_lookups_.empty() &&
+      pending_lookup_keys_.size() + new_keys > max_lookup_batch_size_) {
+    FlushLookupBatch();
+  }
+
+  pending_lookups_.push_back(PendingLookup{keys, std::move(user_callback)});
+  pending_lookup_keys_.insert(keys.begin(), keys.end());
+
+  if (pending_lookup_keys_.size() >= max_lookup_batch_size_) {
+    FlushLookupBatch();
+  } else if (!lookup_batch_timer_) {
+    std::weak_ptr<Datastore> weak_this{shared_from_this()};
+    lookup_batch_timer_ = worker_queue_->EnqueueAfterDelay(
+        max_lookup_delay_, TimerId::LookupBatchDelay, [weak_this] {
+          auto strong_this = weak_this.lock();
+          if (strong_this && !strong_this->is_shut_down_) {
+            strong_this->FlushLookupBatch();
+          }
+        });
+  }
+}
+
+void Datastore::FlushLookupBatch() {
+  lookup_batch_timer_.Cancel();
+  if (pending_lookups_.empty()) return;
+
+  auto lookups =
+      std::make_shared<std::vector<PendingLookup>>(std::move(pending_lookups_));
+  pending_lookups_.clear();
+  std::vector<DocumentKey> keys(pending_lookup_keys_.begin(),
+                                pending_lookup_keys_.end());
+  pending_lookup_keys_.clear();
+
+  if (lookups->size() == 1) {
+    SendLookup(lookups->front().keys, absl::nullopt,
+               std::move(lookups->front().callback));
+    return;
+  }
+
+  std::weak_ptr<Datastore> weak_this{shared_from_this()};
+  auto callback = [weak_this,
+                   lookups](const StatusOr<std::vector<Document>>& result) {
+    if (!result.ok()) {
+      // A permanent error may be caused by the keys of a single lookup (for
+      // example, a document that the user is not allowed to read), so resend
+      // the lookups one by one to fail only the ones at fault. Other errors
+      // would fail the individual lookups as well.
+      auto strong_this = weak_this.lock();
+      if (strong_this && !strong_this->is_shut_down_ &&
+          IsPermanentError(result.status())) {
+        for (PendingLookup& lookup : *lookups) {
+          strong_this->SendLookup(lookup.keys, absl::nullopt,
+                                  std::move(lookup.callback));
+        }
+        return;
+      }
+
+      for (const PendingLookup& lookup : *lookups) {
+        lookup.callback(result.status());
+      }
+      return;
+    }
+
+    std::map<DocumentKey, Document> documents;
+    for (const Document& document : result.ValueOrDie()) {
+      documents.emplace(document->key(), document);
+    }
+
+    // Hand every caller its own documents, sorted by key and without
+    // duplicates, as a lookup of its own would have.
+    for (const PendingLookup& lookup : *lookups) {
+      std::set<DocumentKey> lookup_keys(lookup.keys.begin(), lookup.keys.end());
+      std::vector<Document> lookup_documents;
+      lookup_documents.reserve(lookup_keys.size());
+      for (const DocumentKey& key : lookup_keys) {
+        auto found = documents.find(key);
+        if (found != documents.end()) {
+          lookup_documents.push_back(found->second);
+        }
+      }
+      lookup.callback(std::move(lookup_documents));
+    }
+  };
+  SendLookup(keys, absl::nullopt, std::move(callback));
+}
+
+void Datastore::SendLookup(const std::vector<DocumentKey>& keys,
+                           absl::optional<model::FieldMask> mask,
+                           LookupCallback&& user_callback) {
+  // TODO(c++14): move into lambda.
+  SendLookupWithReadTime(
+      keys, std::move(mask),
+      [user_callback](const StatusOr<std::vector<Document>>& result,
+                      const SnapshotVersion&) { user_callback(result); });
+}
+
+void Datastore::SendLookupWithReadTime(
+    const std::vector<DocumentKey>& keys,
+    absl::optional<model::FieldMask> mask,
+    FieldLookupCallback&& user_callback) {
   ResumeRpcWithCredentials(
       // TODO(c++14): move into lambda.
-      [this, keys, user_callback](const StatusOr<AuthToken>& auth_token,
-                                  const std::string& app_check_token) mutable {
+      [this, keys, mask, user_callback](
+          const StatusOr<AuthToken>& auth_token,
+          const std::string& app_check_token) mutable {
         if (!auth_token.ok()) {
-          user_callback(auth_token.status());
+          user_callback(auth_token.status(), SnapshotVersion::None());
           return;
         }
         LookupDocumentsWithCredentials(auth_token.ValueOrDie(), app_check_token,
-                                       keys, std::move(user_callback));
+                                       keys, mask, std::move(user_callback));
       });
 }
 
@@ -224,9 +392,10 @@ void Datastore::LookupDocumentsWithCredentials(
     const credentials::AuthToken& auth_token,
     const std::string& app_check_token,
     const std::vector<DocumentKey>& keys,
-    LookupCallback&& user_callback) {
+    const absl::optional<model::FieldMask>& mask,
+    FieldLookupCallback&& user_callback) {
   grpc::ByteBuffer message =
-      MakeByteBuffer(datastore_serializer_.EncodeLookupRequest(keys));
+      MakeByteBuffer(datastore_serializer_.EncodeLookupRequest(keys, mask));
 
   std::unique_ptr<GrpcStreamingReader> call_owning =
       grpc_connection_.CreateStreamingReader(
@@ -237,14 +406,17 @@ void Datastore::LookupDocumentsWithCredentials(
   // TODO(c++14): lambda captures using move.
   auto responses_callback =
       [this, user_callback](const std::vector<grpc::ByteBuffer>& result) {
-        user_callback(datastore_serializer_.MergeLookupResponses(result));
+        SnapshotVersion read_time;
+        auto documents =
+            datastore_serializer_.MergeLookupResponses(result, &read_time);
+        user_callback(documents, read_time);
       };
 
   auto close_callback = [this, user_callback, call](const util::Status& status,
                                                     bool callback_fired) {
     // Trigger user_callback with an error status
     if (!callback_fired) {
-      user_callback(status);
+      user_callback(status, SnapshotVersion::None());
     }
     if (!status.ok()) {
       LogGrpcCallFinished("BatchGetDocuments", call, status);
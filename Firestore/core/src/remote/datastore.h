@@ -19,6 +19,7 @@
 
 #include <functional>
 #include <memory>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -28,6 +29,7 @@
 #include "Firestore/core/src/credentials/credentials_fwd.h"
 #include "Firestore/core/src/credentials/credentials_provider.h"
 #include "Firestore/core/src/model/document_key.h"
+#include "Firestore/core/src/model/snapshot_version.h"
 #include "Firestore/core/src/remote/grpc_call.h"
 #include "Firestore/core/src/remote/grpc_connection.h"
 #include "Firestore/core/src/remote/remote_objc_bridge.h"
@@ -72,6 +74,14 @@ class Datastore : public std::enable_shared_from_this<Datastore> {
  public:
   using LookupCallback =
       std::function<void(const util::StatusOr<std::vector<model::Document>>&)>;
+  /**
+   * Receives the documents of a lookup together with the snapshot version at
+   * which the backend read them, which is `SnapshotVersion::None()` if the
+   * lookup failed.
+   */
+  using FieldLookupCallback =
+      std::function<void(const util::StatusOr<std::vector<model::Document>>&,
+                          const model::SnapshotVersion& read_time)>;
   using CommitCallback = std::function<void(const util::Status&)>;
 
   Datastore(
@@ -108,6 +118,42 @@ class Datastore : public std::enable_shared_from_this<Datastore> {
   void LookupDocuments(const std::vector<model::DocumentKey>& keys,
                        LookupCallback&& user_callback);
 
+  /**
+   * Makes `LookupDocuments` coalesce the lookups requested within `max_delay`
+   * of the first pending one into a single `BatchGetDocuments` call for up to
+   * `max_batch_size` distinct keys. Each caller still receives only the
+   * documents it asked for, and only the errors its own keys cause.
+   *
+   * Lookups are sent right away if `max_batch_size` is 1 or less, which is the
+   * default.
+   */
+  void EnableLookupBatching(size_t max_batch_size,
+                            util::AsyncQueue::Milliseconds max_delay);
+
+  /**
+   * Looks up `keys` with a single `BatchGetDocuments` call that only returns
+   * the fields in `mask` of the documents found. These lookups are never
+   * coalesced with others.
+   */
+  void LookupDocumentFields(const std::vector<model::DocumentKey>& keys,
+                            model::FieldMask mask,
+                            FieldLookupCallback&& user_callback);
+
+  /**
+   * Makes the watch streams created from now on decode their responses on a
+   * dedicated serial executor instead of the worker queue. See
+   * `WatchStream::DecodeResponsesOn`.
+   */
+  void EnableBackgroundWatchDecoding();
+
+  /**
+   * Makes the watch streams created from now on retain the serialized form of
+   * the documents they receive. See `WatchStream::RetainEncodedDocuments`.
+   */
+  void RetainEncodedWatchDocuments() {
+    retain_encoded_watch_documents_ = true;
+  }
+
   void RunAggregateQuery(const core::Query& query,
                          const std::vector<model::AggregateField>& aggregates,
                          api::AggregateQueryCallback&& result_callback);
@@ -182,11 +228,35 @@ class Datastore : public std::enable_shared_from_this<Datastore> {
       const std::vector<model::Mutation>& mutations,
       CommitCallback&& callback);
 
+  /** A `LookupDocuments` call waiting for its batch to be sent. */
+  struct PendingLookup {
+    std::vector<model::DocumentKey> keys;
+    LookupCallback callback;
+  };
+
+  void SendLookup(const std::vector<model::DocumentKey>& keys,
+                  absl::optional<model::FieldMask> mask,
+                  LookupCallback&& user_callback);
+  void SendLookupWithReadTime(const std::vector<model::DocumentKey>& keys,
+                              absl::optional<model::FieldMask> mask,
+                              FieldLookupCallback&& user_callback);
+
+  /** Adds a lookup to the pending batch. Must be called on the worker queue. */
+  void AddToLookupBatch(const std::vector<model::DocumentKey>& keys,
+                        LookupCallback&& user_callback);
+
+  /**
+   * Sends all pending lookups as a single call. If the call fails with a
+   * permanent error, each lookup is resent by itself.
+   */
+  void FlushLookupBatch();
+
   void LookupDocumentsWithCredentials(
       const credentials::AuthToken& auth_token,
       const std::string& app_check_token,
       const std::vector<model::DocumentKey>& keys,
-      LookupCallback&& user_callback);
+      const absl::optional<model::FieldMask>& mask,
+      FieldLookupCallback&& user_callback);
 
   void RunAggregateQueryWithCredentials(
       const credentials::AuthToken& auth_token,
@@ -215,6 +285,8 @@ class Datastore : public std::enable_shared_from_this<Datastore> {
   // A separate executor dedicated to polling gRPC completion queue (which is
   // shared for all spawned gRPC streams and calls).
   std::unique_ptr<util::Executor> rpc_executor_;
+  std::shared_ptr<util::Executor> watch_decode_executor_;
+  bool retain_encoded_watch_documents_ = false;
   grpc::CompletionQueue grpc_queue_;
   ConnectivityMonitor* connectivity_monitor_ = nullptr;
   core::DatabaseInfo database_info_;
@@ -222,6 +294,12 @@ class Datastore : public std::enable_shared_from_this<Datastore> {
 
   std::vector<std::unique_ptr<GrpcCall>> active_calls_;
   DatastoreSerializer datastore_serializer_;
+
+  size_t max_lookup_batch_size_ = 1;
+  util::AsyncQueue::Milliseconds max_lookup_delay_{0};
+  std::vector<PendingLookup> pending_lookups_;
+  std::set<model::DocumentKey> pending_lookup_keys_;
+  util::DelayedOperation lookup_batch_timer_;
 };
 
 }  // namespace remote
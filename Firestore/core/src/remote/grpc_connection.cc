@@ -341,6 +341,11 @@ std::unique_ptr<GrpcStream> GrpcConnection::CreateStream(
   EnsureActiveStub();
 
   auto context = CreateContext(auth_token, app_check_token);
+  // Only the long-lived streams are compressed: their messages (mutations and
+  // listen requests) add up, while unary calls are mostly small and one-off.
+  if (database_info_->compression_enabled()) {
+    context->set_compression_algorithm(GRPC_COMPRESS_GZIP);
+  }
   auto call =
       grpc_stub_->PrepareCall(context.get(), MakeString(rpc_name), grpc_queue_);
   return absl::make_unique<GrpcStream>(std::move(context), std::move(call),
@@ -16,25 +16,26 @@
 
 #include "Firestore/core/src/remote/grpc_nanopb.h"
 
+#include <algorithm>
+#include <cstring>
 #include <vector>
 
 #include "Firestore/core/include/firebase/firestore/firestore_errors.h"
 #include "Firestore/core/src/nanopb/writer.h"
 #include "Firestore/core/src/remote/grpc_util.h"
+#include "Firestore/core/src/util/hard_assert.h"
 #include "Firestore/core/src/util/status.h"
+#include "grpc/slice.h"
 #include "grpcpp/support/status.h"
 
 namespace firebase {
 namespace firestore {
 namespace remote {
 
-using nanopb::ByteString;
-using nanopb::ByteStringWriter;
 using util::Status;
 
 ByteBufferReader::ByteBufferReader(const grpc::ByteBuffer& buffer) {
-  std::vector<grpc::Slice> slices;
-  grpc::Status status = buffer.Dump(&slices);
+  grpc::Status status = buffer.Dump(&slices_);
   // Conversion may fail if compression is used and gRPC tries to decompress an
   // ill-formed buffer.
   if (!status.ok()) {
@@ -45,14 +46,14 @@ ByteBufferReader::ByteBufferReader(const grpc::ByteBuffer& buffer) {
     return;
   }
 
-  ByteStringWriter writer;
-  writer.Reserve(buffer.Length());
-  for (const auto& slice : slices) {
-    writer.Append(slice.begin(), slice.size());
+  size_ = buffer.Length();
+  if (slices_.size() == 1) {
+    stream_ = pb_istream_from_buffer(slices_[0].begin(), size_);
+  } else {
+    stream_.callback = ReadFromSlices;
+    stream_.state = this;
+    stream_.bytes_left = size_;
   }
-
-  bytes_ = writer.Release();
-  stream_ = pb_istream_from_buffer(bytes_.data(), bytes_.size());
 }
 
 void ByteBufferReader::Read(const pb_field_t* fields, void* dest_struct) {
@@ -63,30 +64,116 @@ void ByteBufferReader::Read(const pb_field_t* fields, void* dest_struct) {
   }
 }
 
-namespace {
+absl::string_view ByteBufferReader::bytes() const {
+  if (slices_.size() == 1) {
+    return {reinterpret_cast<const char*>(slices_[0].begin()),
+            slices_[0].size()};
+  }
+
+  if (flattened_.size() != size_) {
+    flattened_.clear();
+    flattened_.reserve(size_);
+    for (const grpc::Slice& slice : slices_) {
+      flattened_.append(reinterpret_cast<const char*>(slice.begin()),
+                        slice.size());
+    }
+  }
+  return flattened_;
+}
 
-bool AppendToGrpcBuffer(pb_ostream_t* stream,
-                        const pb_byte_t* buf,
-                        size_t count) {
-  auto buffer = static_cast<std::vector<grpc::Slice>*>(stream->state);
-  buffer->emplace_back(buf, count);
+bool ByteBufferReader::ReadFromSlices(pb_istream_t* stream,
+                                      pb_byte_t* buf,
+                                      size_t count) {
+  auto reader = static_cast<ByteBufferReader*>(stream->state);
+  while (count > 0) {
+    if (reader->slice_index_ == reader->slices_.size()) {
+      return false;
+    }
+
+    const grpc::Slice& slice = reader->slices_[reader->slice_index_];
+    size_t chunk = std::min(count, slice.size() - reader->slice_offset_);
+    if (buf) {
+      std::memcpy(buf, slice.begin() + reader->slice_offset_, chunk);
+      buf += chunk;
+    }
+    count -= chunk;
+    reader->slice_offset_ += chunk;
+
+    if (reader->slice_offset_ == slice.size()) {
+      reader->slice_index_++;
+      reader->slice_offset_ = 0;
+    }
+  }
   return true;
 }
 
-}  // namespace
+constexpr size_t ByteBufferWriter::kSlabSize;
 
 ByteBufferWriter::ByteBufferWriter() {
-  stream_.callback = AppendToGrpcBuffer;
-  stream_.state = &buffer_;
+  stream_.callback = AppendToSlab;
+  stream_.state = this;
   stream_.max_size = SIZE_MAX;
 }
 
+void ByteBufferWriter::Write(const pb_field_t* fields,
+                             const void* src_struct) {
+  size_t size = 0;
+  if (!pb_get_encoded_size(&size, fields, src_struct)) {
+    HARD_FAIL("Unable to compute the encoded size of a message");
+  }
+
+  // Keep anything written to `stream_` before this message in order.
+  FlushSlab();
+
+  grpc_slice slice = grpc_slice_malloc(size);
+  pb_ostream_t stream =
+      pb_ostream_from_buffer(GRPC_SLICE_START_PTR(slice), size);
+  if (!pb_encode(&stream, fields, src_struct)) {
+    grpc_slice_unref(slice);
+    HARD_FAIL(PB_GET_ERROR(&stream));
+  }
+  HARD_ASSERT(stream.bytes_written == size,
+              "Encoded %s bytes, but expected %s", stream.bytes_written, size);
+
+  buffer_.emplace_back(slice, grpc::Slice::STEAL_REF);
+}
+
 grpc::ByteBuffer ByteBufferWriter::Release() {
+  FlushSlab();
   grpc::ByteBuffer result{buffer_.data(), buffer_.size()};
   buffer_.clear();
   return result;
 }
 
+bool ByteBufferWriter::AppendToSlab(pb_ostream_t* stream,
+                                    const pb_byte_t* buf,
+                                    size_t count) {
+  auto writer = static_cast<ByteBufferWriter*>(stream->state);
+  if (count > writer->slab_capacity_ - writer->slab_size_) {
+    writer->FlushSlab();
+
+    size_t capacity = std::max(kSlabSize, count);
+    grpc_slice slice = grpc_slice_malloc(capacity);
+    writer->slab_data_ = GRPC_SLICE_START_PTR(slice);
+    writer->slab_ = grpc::Slice(slice, grpc::Slice::STEAL_REF);
+    writer->slab_capacity_ = capacity;
+  }
+
+  std::memcpy(writer->slab_data_ + writer->slab_size_, buf, count);
+  writer->slab_size_ += count;
+  return true;
+}
+
+void ByteBufferWriter::FlushSlab() {
+  if (slab_size_ > 0) {
+    buffer_.push_back(slab_.sub(0, slab_size_));
+  }
+  slab_ = grpc::Slice();
+  slab_data_ = nullptr;
+  slab_size_ = 0;
+  slab_capacity_ = 0;
+}
+
 }  // namespace remote
 }  // namespace firestore
 }  // namespace firebase
@@ -20,44 +20,95 @@
 #include <pb.h>
 #include <pb_decode.h>
 
+#include <cstdint>
+#include <string>
 #include <vector>
 
 #include "Firestore/core/src/nanopb/byte_string.h"
 #include "Firestore/core/src/nanopb/message.h"
 #include "Firestore/core/src/nanopb/reader.h"
 #include "Firestore/core/src/nanopb/writer.h"
+#include "absl/strings/string_view.h"
 #include "grpcpp/support/byte_buffer.h"
 
 namespace firebase {
 namespace firestore {
 namespace remote {
 
-/** A `Reader` that reads from the given `grpc::ByteBuffer`. */
+/**
+ * A `Reader` that reads from the given `grpc::ByteBuffer`.
+ *
+ * The reader decodes straight from the slices of the buffer, without first
+ * copying them into contiguous memory. The slices are reference-counted, so
+ * the reader stays valid after the buffer is destroyed.
+ */
 class ByteBufferReader : public nanopb::Reader {
  public:
-  /**
-   * Copies the given `buffer` and associates the resulting stream with this
-   * `ByteBufferReader`.
-   */
-  // TODO(varconst): avoid copying the buffer.
   explicit ByteBufferReader(const grpc::ByteBuffer& buffer);
 
+  ByteBufferReader(const ByteBufferReader&) = delete;
+  ByteBufferReader& operator=(const ByteBufferReader&) = delete;
+
   void Read(const pb_field_t* fields, void* dest_struct) override;
 
+  /**
+   * Returns the serialized message this reader reads from. If the message
+   * spans several slices, they are copied into a single buffer the first time
+   * this is called.
+   */
+  absl::string_view bytes() const;
+
  private:
-  nanopb::ByteString bytes_;
+  static bool ReadFromSlices(pb_istream_t* stream,
+                             pb_byte_t* buf,
+                             size_t count);
+
+  std::vector<grpc::Slice> slices_;
+  size_t size_ = 0;
+
+  // The position of the next byte to read from `slices_`.
+  size_t slice_index_ = 0;
+  size_t slice_offset_ = 0;
+
+  mutable std::string flattened_;
   pb_istream_t stream_{};
 };
 
-/** A `Writer` that writes into a `grpc::ByteBuffer`. */
+/**
+ * A `Writer` that writes into a `grpc::ByteBuffer`.
+ *
+ * Every message is encoded into a single slice of the exact size of the
+ * message, so encoding it allocates once and never copies. Bytes written to
+ * the underlying stream directly are copied into large slices instead.
+ */
 class ByteBufferWriter : public nanopb::Writer {
  public:
   ByteBufferWriter();
 
+  /**
+   * Writes a Nanopb proto into a new slice sized with `pb_get_encoded_size()`.
+   */
+  void Write(const pb_field_t* fields, const void* src_struct);
+
   grpc::ByteBuffer Release();
 
  private:
+  /** The size of the slices that stream writes are copied into. */
+  static constexpr size_t kSlabSize = 16 * 1024;
+
+  static bool AppendToSlab(pb_ostream_t* stream,
+                           const pb_byte_t* buf,
+                           size_t count);
+
+  /** Appends the used part of the current slab to `buffer_`. */
+  void FlushSlab();
+
   std::vector<grpc::Slice> buffer_;
+
+  grpc::Slice slab_;
+  uint8_t* slab_data_ = nullptr;
+  size_t slab_size_ = 0;
+  size_t slab_capacity_ = 0;
 };
 
 /**
@@ -285,6 +285,18 @@ bool GrpcStream::TryLastWrite(grpc::ByteBuffer&& message) {
   return status == std::future_status::ready;
 }
 
+void GrpcStream::PauseReading() {
+  is_reading_paused_ = true;
+}
+
+void GrpcStream::ResumeReading() {
+  is_reading_paused_ = false;
+  if (has_deferred_read_ && !is_grpc_call_finished_) {
+    has_deferred_read_ = false;
+    Read();
+  }
+}
+
 GrpcStream::Metadata GrpcStream::GetResponseHeaders() const {
   return context_->GetServerInitialMetadata();
 }
@@ -297,7 +309,11 @@ void GrpcStream::OnRead(const grpc::ByteBuffer& message) {
     // interested observer.
     // Order is important here -- any call to observer can potentially end this
     // stream's lifetime, so call `Read` before notifying.
-    Read();
+    if (is_reading_paused_) {
+      has_deferred_read_ = true;
+    } else {
+      Read();
+    }
     observer_->OnStreamRead(message);
   }
 }
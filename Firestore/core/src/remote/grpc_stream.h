@@ -165,6 +165,17 @@ class GrpcStream : public GrpcCall {
    */
   bool WriteAndFinish(grpc::ByteBuffer&& message);
 
+  /**
+   * Stops reading new messages from the server until `ResumeReading` is
+   * called. A message that is already being read is still delivered to the
+   * observer. Lets the observer bound the number of messages it has received
+   * but not processed yet.
+   */
+  void PauseReading();
+
+  /** Continues reading messages from the server after `PauseReading`. */
+  void ResumeReading();
+
   bool IsFinished() const {
     return observer_ == nullptr;
   }
@@ -239,6 +250,10 @@ class GrpcStream : public GrpcCall {
 
   // gRPC asserts that a call is finished exactly once.
   bool is_grpc_call_finished_ = false;
+
+  bool is_reading_paused_ = false;
+  // Whether a read was skipped while reading was paused.
+  bool has_deferred_read_ = false;
 };
 
 }  // namespace remote
@@ -33,6 +33,7 @@ using local::QueryPurpose;
 using local::TargetData;
 using model::DatabaseId;
 using model::DocumentKey;
+using model::DocumentKeyHashSet;
 using model::DocumentKeySet;
 using model::MutableDocument;
 using model::SnapshotVersion;
@@ -106,6 +107,11 @@ void TargetState::MarkCurrent() {
   current_ = true;
 }
 
+void TargetState::MarkNotCurrent() {
+  has_pending_changes_ = true;
+  current_ = false;
+}
+
 void TargetState::AddDocumentChange(const DocumentKey& document_key,
                                     DocumentViewChange::Type type) {
   has_pending_changes_ = true;
@@ -127,6 +133,7 @@ WatchChangeAggregator::WatchChangeAggregator(
 void WatchChangeAggregator::HandleDocumentChange(
     const DocumentWatchChange& document_change) {
   for (TargetId target_id : document_change.updated_target_ids()) {
+    RecordReconciliationConflict(target_id, document_change.document_key());
     const auto& new_doc = document_change.new_document();
     if (new_doc && new_doc->is_found_document()) {
       AddDocumentToTarget(target_id, *new_doc);
@@ -137,6 +144,7 @@ void WatchChangeAggregator::HandleDocumentChange(
   }
 
   for (TargetId target_id : document_change.removed_target_ids()) {
+    RecordReconciliationConflict(target_id, document_change.document_key());
     RemoveDocumentFromTarget(target_id, document_change.document_key(),
                              document_change.new_document());
   }
@@ -178,7 +186,13 @@ void WatchChangeAggregator::HandleTargetChange(
         continue;
       case WatchTargetChangeState::Current:
         if (IsActiveTarget(target_id)) {
-          target_state.MarkCurrent();
+          auto reconciliation = target_reconciliations_.find(target_id);
+          if (reconciliation != target_reconciliations_.end()) {
+            // The target only becomes current once reconciled.
+            reconciliation->second.current = true;
+          } else {
+            target_state.MarkCurrent();
+          }
           target_state.UpdateResumeToken(target_change.resume_token());
         }
         continue;
@@ -275,7 +289,33 @@ void WatchChangeAggregator::HandleExistenceFilter(
                 ? ApplyBloomFilter(bloom_filter.value(), existence_filter,
                                    current_size)
                 : BloomFilterApplicationStatus::kSkipped;
-        if (status != BloomFilterApplicationStatus::kSuccess) {
+        if (status == BloomFilterApplicationStatus::kFalsePositive &&
+            reconcile_mismatches_ && !target.HasLimit() &&
+            GetCurrentDocumentCountForTarget(target_id) > expected_count) {
+          // Some of the documents the bloom filter kept were removed as well.
+          // Rather than downloading the whole target again, have them looked
+          // up to find out which. If lookups are in flight already, the next
+          // existence filter checks their result.
+          if (target_reconciliations_.find(target_id) ==
+              target_reconciliations_.end()) {
+            TargetState& target_state = EnsureTargetState(target_id);
+            TargetChange target_change = target_state.ToTargetChange();
+            DocumentKeySet candidates;
+            for (const DocumentKey& key :
+                 target_metadata_provider_->GetRemoteKeysForTarget(
+                     target_id)) {
+              if (!target_change.removed_documents().contains(key)) {
+                candidates = candidates.insert(key);
+              }
+            }
+            pending_target_reconciliations_[target_id] = std::move(candidates);
+
+            // The target is known to be inconsistent until the removed
+            // documents are found.
+            target_reconciliations_[target_id].current = target_state.current();
+            target_state.MarkNotCurrent();
+          }
+        } else if (status != BloomFilterApplicationStatus::kSuccess) {
           // If bloom filter application fails, we reset the mapping and
           // trigger re-run of the query.
           ResetTarget(target_id);
@@ -337,9 +377,32 @@ BloomFilterApplicationStatus WatchChangeAggregator::ApplyBloomFilter(
              : BloomFilterApplicationStatus::kFalsePositive;
 }
 
+void WatchChangeAggregator::HandleReconciledDocuments(
+    TargetId target_id,
+    const DocumentKeySet& removed,
+    const SnapshotVersion& read_time) {
+  auto found = target_reconciliations_.find(target_id);
+  if (found == target_reconciliations_.end()) return;
+
+  found->second.removed_documents = removed;
+  found->second.read_time = read_time;
+}
+
+void WatchChangeAggregator::HandleFailedReconciliation(TargetId target_id) {
+  if (target_reconciliations_.erase(target_id) == 0 ||
+      !IsActiveTarget(target_id)) {
+    return;
+  }
+
+  EnsureTargetState(target_id);
+  ResetTarget(target_id);
+  pending_target_resets_.insert(
+      {target_id, QueryPurpose::ExistenceFilterMismatchBloom});
+}
+
 int WatchChangeAggregator::FilterRemovedDocuments(
     const BloomFilter& bloom_filter, int target_id) {
-  const DocumentKeySet existing_keys =
+  const DocumentKeyHashSet existing_keys =
       target_metadata_provider_->GetRemoteKeysForTarget(target_id);
   int removalCount = 0;
   for (const DocumentKey& key : existing_keys) {
@@ -357,8 +420,50 @@ int WatchChangeAggregator::FilterRemovedDocuments(
   return removalCount;
 }
 
+void WatchChangeAggregator::RecordReconciliationConflict(
+    TargetId target_id, const DocumentKey& key) {
+  auto found = target_reconciliations_.find(target_id);
+  if (found == target_reconciliations_.end()) return;
+
+  TargetReconciliation& reconciliation = found->second;
+  reconciliation.changed_documents =
+      reconciliation.changed_documents.insert(key);
+}
+
+void WatchChangeAggregator::ApplyReconciliations(
+    const SnapshotVersion& snapshot_version) {
+  for (auto it = target_reconciliations_.begin();
+       it != target_reconciliations_.end();) {
+    const TargetReconciliation& reconciliation = it->second;
+    // Removals found by lookups that read past this snapshot would not be
+    // consistent with it.
+    if (!reconciliation.removed_documents ||
+        reconciliation.read_time > snapshot_version) {
+      ++it;
+      continue;
+    }
+
+    TargetId target_id = it->first;
+    if (IsActiveTarget(target_id)) {
+      for (const DocumentKey& key : *reconciliation.removed_documents) {
+        // Watch has sent a more recent state of the document.
+        if (reconciliation.changed_documents.contains(key)) continue;
+
+        RemoveDocumentFromTarget(target_id, key,
+                                 /*updated_document=*/absl::nullopt);
+      }
+      if (reconciliation.current) {
+        EnsureTargetState(target_id).MarkCurrent();
+      }
+    }
+    it = target_reconciliations_.erase(it);
+  }
+}
+
 RemoteEvent WatchChangeAggregator::CreateRemoteEvent(
     const SnapshotVersion& snapshot_version) {
+  ApplyReconciliations(snapshot_version);
+
   std::unordered_map<TargetId, TargetChange> target_changes;
 
   for (auto& entry : target_states_) {
@@ -418,13 +523,15 @@ RemoteEvent WatchChangeAggregator::CreateRemoteEvent(
   RemoteEvent remote_event{snapshot_version, std::move(target_changes),
                            std::move(pending_target_resets_),
                            std::move(pending_document_updates_),
-                           std::move(resolved_limbo_documents)};
+                           std::move(resolved_limbo_documents),
+                           std::move(pending_target_reconciliations_)};
 
   // Re-initialize the current state to ensure that we do not modify the
   // generated `RemoteEvent`.
   pending_document_updates_.clear();
   pending_document_target_mappings_.clear();
   pending_target_resets_.clear();
+  pending_target_reconciliations_.clear();
 
   return remote_event;
 }
@@ -472,6 +579,7 @@ void WatchChangeAggregator::RemoveDocumentFromTarget(
 
 void WatchChangeAggregator::RemoveTarget(TargetId target_id) {
   target_states_.erase(target_id);
+  target_reconciliations_.erase(target_id);
 }
 
 int WatchChangeAggregator::GetCurrentDocumentCountForTarget(
@@ -513,11 +621,12 @@ void WatchChangeAggregator::ResetTarget(TargetId target_id) {
               "Should only reset active targets");
 
   target_states_[target_id] = {};
+  target_reconciliations_.erase(target_id);
 
   // Trigger removal for any documents currently mapped to this target. These
   // removals will be part of the initial snapshot if Watch does not resend
   // these documents.
-  DocumentKeySet existing_keys =
+  DocumentKeyHashSet existing_keys =
       target_metadata_provider_->GetRemoteKeysForTarget(target_id);
 
   for (const DocumentKey& key : existing_keys) {
@@ -527,9 +636,8 @@ void WatchChangeAggregator::ResetTarget(TargetId target_id) {
 
 bool WatchChangeAggregator::TargetContainsDocument(TargetId target_id,
                                                    const DocumentKey& key) {
-  const DocumentKeySet& existing_keys =
-      target_metadata_provider_->GetRemoteKeysForTarget(target_id);
-  return existing_keys.contains(key);
+  return target_metadata_provider_->GetRemoteKeysForTarget(target_id).contains(
+      key);
 }
 
 }  // namespace remote
@@ -55,7 +55,7 @@ class TargetMetadataProvider {
    * Returns the set of remote document keys for the given target ID as of the
    * last raised snapshot.
    */
-  virtual model::DocumentKeySet GetRemoteKeysForTarget(
+  virtual model::DocumentKeyHashSet GetRemoteKeysForTarget(
       model::TargetId target_id) const = 0;
 
   /**
@@ -209,6 +209,7 @@ class TargetState {
   void RecordPendingTargetRequest();
   void RecordTargetResponse();
   void MarkCurrent();
+  void MarkNotCurrent();
 
  private:
   /**
@@ -250,15 +251,19 @@ class RemoteEvent {
   using TargetChangeMap = std::unordered_map<model::TargetId, TargetChange>;
   using TargetMismatchMap =
       std::unordered_map<model::TargetId, local::QueryPurpose>;
+  using TargetReconciliationMap =
+      std::unordered_map<model::TargetId, model::DocumentKeySet>;
 
   RemoteEvent(model::SnapshotVersion snapshot_version,
               TargetChangeMap target_changes,
               TargetMismatchMap target_mismatches,
               model::DocumentUpdateMap document_updates,
-              model::DocumentKeySet limbo_document_changes)
+              model::DocumentKeySet limbo_document_changes,
+              TargetReconciliationMap target_reconciliations = {})
       : snapshot_version_{snapshot_version},
         target_changes_{std::move(target_changes)},
         target_mismatches_{std::move(target_mismatches)},
+        target_reconciliations_{std::move(target_reconciliations)},
         document_updates_{std::move(document_updates)},
         limbo_document_changes_{std::move(limbo_document_changes)} {
   }
@@ -282,6 +287,17 @@ class RemoteEvent {
     return target_mismatches_;
   }
 
+  /**
+   * A map of targets with existence filter mismatches that can be reconciled
+   * without re-listening, and the documents of each target that may no longer
+   * be part of it. The documents that are not should be reported with
+   * `WatchChangeAggregator::HandleReconciledDocuments`. Until then, the target
+   * is not current.
+   */
+  const TargetReconciliationMap& target_reconciliations() const {
+    return target_reconciliations_;
+  }
+
   /**
    * A set of which documents have changed or been deleted, along with the doc's
    * new values (if not deleted).
@@ -301,6 +317,7 @@ class RemoteEvent {
   model::SnapshotVersion snapshot_version_;
   TargetChangeMap target_changes_;
   TargetMismatchMap target_mismatches_;
+  TargetReconciliationMap target_reconciliations_;
   model::DocumentUpdateMap document_updates_;
   model::DocumentKeySet limbo_document_changes_;
 };
@@ -327,11 +344,39 @@ class WatchChangeAggregator {
   /**
    * Handles existence filters and synthesizes deletes for filter mismatches.
    * Targets that are invalidated by filter mismatches are added to
-   * `pending_target_resets_`.
+   * `pending_target_resets_`, or to `pending_target_reconciliations_` if they
+   * can be reconciled.
    */
   void HandleExistenceFilter(
       const ExistenceFilterWatchChange& existence_filter);
 
+  /**
+   * Makes existence filter mismatches that the bloom filter cannot resolve
+   * reported as target reconciliations instead of resetting the target, as
+   * long as the target has no limit and the client has more documents than
+   * the backend. See `RemoteEvent::target_reconciliations`.
+   */
+  void EnableMismatchReconciliation() {
+    reconcile_mismatches_ = true;
+  }
+
+  /**
+   * Removes the documents that a reconciliation found to no longer be part of
+   * the target, as of `read_time`. The removals are raised with the first
+   * remote event at or after `read_time`, which marks the target current
+   * again if watch considers it current. Documents that received a watch
+   * change since the mismatch are left to watch.
+   */
+  void HandleReconciledDocuments(model::TargetId target_id,
+                                 const model::DocumentKeySet& removed,
+                                 const model::SnapshotVersion& read_time);
+
+  /**
+   * Resets a target whose reconciliation failed, as if the bloom filter had
+   * not been able to reconcile it.
+   */
+  void HandleFailedReconciliation(model::TargetId target_id);
+
   /**
    * Converts the current state into a remote event with the snapshot version
    * taken from the initializer. Resets the accumulated changes before
@@ -412,6 +457,19 @@ class WatchChangeAggregator {
    */
   void ResetTarget(model::TargetId target_id);
 
+  /**
+   * Records that watch changed a document of a target that is being
+   * reconciled, so that the reconciliation does not override the change.
+   */
+  void RecordReconciliationConflict(model::TargetId target_id,
+                                    const model::DocumentKey& key);
+
+  /**
+   * Applies the reconciliations whose lookups completed at or before
+   * `snapshot_version`.
+   */
+  void ApplyReconciliations(const model::SnapshotVersion& snapshot_version);
+
   /** Returns whether the local store considers the document to be part of the
    * specified target. */
   bool TargetContainsDocument(model::TargetId target_id,
@@ -458,6 +516,33 @@ class WatchChangeAggregator {
    */
   RemoteEvent::TargetMismatchMap pending_target_resets_;
 
+  /**
+   * A map of targets with existence filter mismatches to reconcile, and the
+   * documents that may no longer be part of each.
+   */
+  RemoteEvent::TargetReconciliationMap pending_target_reconciliations_;
+
+  /** The state of a target whose existence filter mismatch is reconciled. */
+  struct TargetReconciliation {
+    /** Whether watch considers the target current. */
+    bool current = false;
+
+    /** The documents that received a watch change since the mismatch. */
+    model::DocumentKeySet changed_documents;
+
+    /** The documents found removed, once the lookups completed. */
+    absl::optional<model::DocumentKeySet> removed_documents;
+
+    /** The snapshot version at which the lookups read the documents. */
+    model::SnapshotVersion read_time;
+  };
+
+  /** The targets being reconciled, which are not current until applied. */
+  std::unordered_map<model::TargetId, TargetReconciliation>
+      target_reconciliations_;
+
+  bool reconcile_mismatches_ = false;
+
   TargetMetadataProvider* target_metadata_provider_ = nullptr;
 };
 
@@ -16,6 +16,7 @@
 
 #include "Firestore/core/src/remote/remote_objc_bridge.h"
 
+#include <algorithm>
 #include <map>
 
 #include "Firestore/core/src/core/database_info.h"
@@ -112,8 +113,10 @@ WatchStreamSerializer::ParseResponse(Reader* reader) const {
 
 std::unique_ptr<WatchChange> WatchStreamSerializer::DecodeWatchChange(
     nanopb::Reader* reader,
-    google_firestore_v1_ListenResponse& response) const {
-  return serializer_.DecodeWatchChange(reader->context(), response);
+    google_firestore_v1_ListenResponse& response,
+    absl::string_view encoded_response) const {
+  return serializer_.DecodeWatchChange(reader->context(), response,
+                                       encoded_response);
 }
 
 SnapshotVersion WatchStreamSerializer::DecodeSnapshotVersion(
@@ -225,7 +228,8 @@ DatastoreSerializer::EncodeCommitRequest(
 
 Message<google_firestore_v1_BatchGetDocumentsRequest>
 DatastoreSerializer::EncodeLookupRequest(
-    const std::vector<DocumentKey>& keys) const {
+    const std::vector<DocumentKey>& keys,
+    const absl::optional<model::FieldMask>& mask) const {
   Message<google_firestore_v1_BatchGetDocumentsRequest> result;
 
   result->database = serializer_.EncodeDatabaseName();
@@ -238,13 +242,17 @@ DatastoreSerializer::EncodeLookupRequest(
       ++i;
     }
   }
+  if (mask) {
+    result->mask = Serializer::EncodeFieldMask(*mask);
+  }
 
   return result;
 }
 
 StatusOr<std::vector<model::Document>>
 DatastoreSerializer::MergeLookupResponses(
-    const std::vector<grpc::ByteBuffer>& responses) const {
+    const std::vector<grpc::ByteBuffer>& responses,
+    SnapshotVersion* read_time) const {
   // Sort by key.
   std::map<DocumentKey, Document> results;
 
@@ -255,6 +263,11 @@ DatastoreSerializer::MergeLookupResponses(
             &reader);
 
     Document doc = serializer_.DecodeMaybeDocument(reader.context(), *message);
+    if (read_time) {
+      *read_time = std::max(
+          *read_time,
+          Serializer::DecodeVersion(reader.context(), message->read_time));
+    }
     if (!reader.ok()) {
       return reader.status();
     }
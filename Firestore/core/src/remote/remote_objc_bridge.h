@@ -24,6 +24,7 @@
 
 #include "Firestore/Protos/nanopb/google/firestore/v1/firestore.nanopb.h"
 #include "Firestore/core/src/core/core_fwd.h"
+#include "Firestore/core/src/model/field_mask.h"
 #include "Firestore/core/src/model/types.h"
 #include "Firestore/core/src/nanopb/byte_string.h"
 #include "Firestore/core/src/nanopb/message.h"
@@ -33,6 +34,7 @@
 #include "grpcpp/support/byte_buffer.h"
 
 #include "absl/container/flat_hash_map.h"
+#include "absl/types/optional.h"
 
 namespace firebase {
 namespace firestore {
@@ -80,10 +82,15 @@ class WatchStreamSerializer {
   /**
    * Decodes the listen response. Modifies the provided proto to release
    * ownership of any Value messages.
+   *
+   * If given, `encoded_response` must contain the serialized form of
+   * `response`; documents in the response then retain their serialized form
+   * so that they can be persisted without being encoded again.
    */
   std::unique_ptr<WatchChange> DecodeWatchChange(
       nanopb::Reader* reader,
-      google_firestore_v1_ListenResponse& response) const;
+      google_firestore_v1_ListenResponse& response,
+      absl::string_view encoded_response = {}) const;
   model::SnapshotVersion DecodeSnapshotVersion(
       nanopb::Reader* reader,
       const google_firestore_v1_ListenResponse& response) const;
@@ -126,15 +133,23 @@ class DatastoreSerializer {
   nanopb::Message<google_firestore_v1_CommitRequest> EncodeCommitRequest(
       const std::vector<model::Mutation>& mutations) const;
 
+  /**
+   * Encodes a lookup of `keys`. If `mask` is given, only the fields in it are
+   * returned for the documents found.
+   */
   nanopb::Message<google_firestore_v1_BatchGetDocumentsRequest>
-  EncodeLookupRequest(const std::vector<model::DocumentKey>& keys) const;
+  EncodeLookupRequest(
+      const std::vector<model::DocumentKey>& keys,
+      const absl::optional<model::FieldMask>& mask = absl::nullopt) const;
 
   /**
    * Merges results of the streaming read together. The array is sorted by the
-   * document key.
+   * document key. If `read_time` is given, it receives the latest read time
+   * of the responses.
    */
   util::StatusOr<std::vector<model::Document>> MergeLookupResponses(
-      const std::vector<grpc::ByteBuffer>& responses) const;
+      const std::vector<grpc::ByteBuffer>& responses,
+      model::SnapshotVersion* read_time = nullptr) const;
 
   nanopb::Message<google_firestore_v1_RunAggregationQueryRequest>
   EncodeAggregateQueryRequest(
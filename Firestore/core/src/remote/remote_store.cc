@@ -16,12 +16,18 @@
 
 #include "Firestore/core/src/remote/remote_store.h"
 
+#include <algorithm>
+#include <set>
 #include <string>
 #include <utility>
+#include <vector>
 
+#include "Firestore/core/src/core/query.h"
 #include "Firestore/core/src/core/transaction.h"
 #include "Firestore/core/src/local/local_store.h"
 #include "Firestore/core/src/local/target_data.h"
+#include "Firestore/core/src/model/document.h"
+#include "Firestore/core/src/model/field_mask.h"
 #include "Firestore/core/src/model/mutation_batch.h"
 #include "Firestore/core/src/model/mutation_batch_result.h"
 #include "Firestore/core/src/nanopb/nanopb_util.h"
@@ -41,7 +47,11 @@ using local::QueryPurpose;
 using local::TargetData;
 using model::AggregateField;
 using model::BatchId;
+using model::Document;
+using model::DocumentKey;
+using model::DocumentKeyHashSet;
 using model::DocumentKeySet;
+using model::FieldPath;
 using model::kBatchIdUnknown;
 using model::MutationBatch;
 using model::MutationBatchResult;
@@ -52,6 +62,7 @@ using model::TargetId;
 using nanopb::ByteString;
 using util::AsyncQueue;
 using util::Status;
+using util::StatusOr;
 
 /**
  * The maximum number of pending writes to allow.
@@ -223,6 +234,9 @@ void RemoteStore::StartWatchStream() {
   HARD_ASSERT(ShouldStartWatchStream(),
               "StartWatchStream called when ShouldStartWatchStream is false.");
   watch_change_aggregator_ = absl::make_unique<WatchChangeAggregator>(this);
+  if (reconciliation_batch_size_ > 0) {
+    watch_change_aggregator_->EnableMismatchReconciliation();
+  }
   watch_stream_->Start();
 
   online_state_tracker_.HandleWatchStreamStart();
@@ -359,10 +373,157 @@ void RemoteStore::RaiseWatchSnapshot(const SnapshotVersion& snapshot_version) {
     SendWatchRequest(request_target_data);
   }
 
+  for (const auto& entry : remote_event.target_reconciliations()) {
+    ReconcileTarget(entry.first, entry.second);
+  }
+
   // Finally handle remote event
   sync_engine_->ApplyRemoteEvent(remote_event);
 }
 
+/** The state of the lookups that reconcile a target. */
+struct RemoteStore::Reconciliation {
+  TargetId target_id = 0;
+
+  /** The watch stream's close count when the first lookup was sent. */
+  int stream_close_count = 0;
+
+  /** The query of the target, without its limit. */
+  core::Query query;
+
+  /** The fields the query depends on, which are all the lookups fetch. */
+  model::FieldMask mask;
+
+  DocumentKeySet candidates;
+
+  /** The `candidates`, in the order they are looked up. */
+  std::vector<DocumentKey> keys;
+
+  /** The number of candidates looked up so far. */
+  size_t looked_up = 0;
+
+  /** The candidates that are no longer part of the target. */
+  DocumentKeySet removed;
+
+  /** The latest read time of the lookups so far. */
+  SnapshotVersion read_time;
+
+  int64_t lookup_bytes = 0;
+};
+
+void RemoteStore::ReconcileTarget(TargetId target_id,
+                                  const DocumentKeySet& candidates) {
+  auto found = listen_targets_.find(target_id);
+  if (found == listen_targets_.end()) {
+    // A watched target might have been removed already.
+    return;
+  }
+
+  const core::Target& target = found->second.target();
+  auto reconciliation = std::make_shared<Reconciliation>();
+  reconciliation->target_id = target_id;
+  reconciliation->stream_close_count = watch_stream_->close_count();
+  reconciliation->query =
+      core::Query(target.path(), target.collection_group(), target.filters(),
+                  target.order_bys(), core::Target::kNoLimit,
+                  core::LimitType::None, target.start_at(), target.end_at());
+
+  // Only the fields that the query filters and orders by are needed to tell
+  // whether a document still matches it. The document key is always part of
+  // the response, so it isn't requested as a field.
+  std::set<FieldPath> fields;
+  for (const core::Filter& filter : target.filters()) {
+    for (const core::FieldFilter& field_filter :
+         filter.GetFlattenedFilters()) {
+      if (!field_filter.field().IsKeyFieldPath()) {
+        fields.insert(field_filter.field());
+      }
+    }
+  }
+  for (const core::OrderBy& order_by : target.order_bys()) {
+    if (!order_by.field().IsKeyFieldPath()) {
+      fields.insert(order_by.field());
+    }
+  }
+  reconciliation->mask = model::FieldMask(std::move(fields));
+  reconciliation->candidates = candidates;
+  reconciliation->keys.assign(candidates.begin(), candidates.end());
+  reconciliation->removed = candidates;
+
+  LOG_DEBUG("RemoteStore %x reconciling target %s by looking up %s documents",
+            this, target_id, candidates.size());
+  LookUpReconciliationBatch(reconciliation);
+}
+
+void RemoteStore::LookUpReconciliationBatch(
+    const std::shared_ptr<Reconciliation>& reconciliation) {
+  const std::vector<DocumentKey>& all_keys = reconciliation->keys;
+  size_t begin = reconciliation->looked_up;
+  size_t end = std::min(all_keys.size(), begin + reconciliation_batch_size_);
+  std::vector<DocumentKey> keys(all_keys.begin() + begin,
+                                all_keys.begin() + end);
+
+  datastore_->LookupDocumentFields(
+      keys, reconciliation->mask,
+      [this, reconciliation,
+       end](const StatusOr<std::vector<Document>>& result,
+            const SnapshotVersion& read_time) {
+        if (!watch_change_aggregator_ ||
+            watch_stream_->close_count() !=
+                reconciliation->stream_close_count) {
+          // The watch stream was closed or restarted since the lookups began;
+          // the resumed target will be checked by the next existence filter.
+          return;
+        }
+
+        TargetId target_id = reconciliation->target_id;
+        if (!result.ok()) {
+          LOG_WARN("Reconciling target %s failed: %s", target_id,
+                   result.status().ToString());
+          reconciliation_stats_.lookups_failed++;
+          watch_change_aggregator_->HandleFailedReconciliation(target_id);
+          return;
+        }
+
+        reconciliation->read_time =
+            std::max(reconciliation->read_time, read_time);
+        for (const Document& document : result.ValueOrDie()) {
+          if (const ByteString* encoded = document->data().encoded_document()) {
+            reconciliation->lookup_bytes +=
+                static_cast<int64_t>(encoded->size());
+          }
+          if (document->is_found_document() &&
+              reconciliation->query.Matches(document)) {
+            reconciliation->removed =
+                reconciliation->removed.erase(document->key());
+          }
+        }
+
+        reconciliation->looked_up = end;
+        if (end < reconciliation->keys.size()) {
+          LookUpReconciliationBatch(reconciliation);
+        } else {
+          FinishReconciliation(*reconciliation);
+        }
+      });
+}
+
+void RemoteStore::FinishReconciliation(const Reconciliation& reconciliation) {
+  int64_t cached_bytes =
+      local_store_->GetRemoteDocumentsSize(reconciliation.candidates);
+
+  reconciliation_stats_.resets_avoided++;
+  reconciliation_stats_.documents_looked_up +=
+      reconciliation.candidates.size();
+  reconciliation_stats_.documents_removed += reconciliation.removed.size();
+  reconciliation_stats_.bytes_saved +=
+      cached_bytes - reconciliation.lookup_bytes;
+
+  watch_change_aggregator_->HandleReconciledDocuments(
+      reconciliation.target_id, reconciliation.removed,
+      reconciliation.read_time);
+}
+
 void RemoteStore::ProcessTargetError(const WatchTargetChange& change) {
   HARD_ASSERT(!change.cause().ok(), "Handling target error without a cause");
 
@@ -561,7 +722,8 @@ std::shared_ptr<Transaction> RemoteStore::CreateTransaction() {
   return std::make_shared<Transaction>(datastore_);
 }
 
-DocumentKeySet RemoteStore::GetRemoteKeysForTarget(TargetId target_id) const {
+DocumentKeyHashSet RemoteStore::GetRemoteKeysForTarget(
+    TargetId target_id) const {
   return sync_engine_->GetRemoteKeys(target_id);
 }
 
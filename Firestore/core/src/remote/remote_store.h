@@ -17,6 +17,7 @@
 #ifndef FIRESTORE_CORE_SRC_REMOTE_REMOTE_STORE_H_
 #define FIRESTORE_CORE_SRC_REMOTE_REMOTE_STORE_H_
 
+#include <cstdint>
 #include <memory>
 #include <unordered_map>
 #include <vector>
@@ -104,7 +105,7 @@ class RemoteStoreCallback {
    * includes the documents that were assigned to the target when we received
    * the last snapshot.
    */
-  virtual model::DocumentKeySet GetRemoteKeys(
+  virtual model::DocumentKeyHashSet GetRemoteKeys(
       model::TargetId target_id) const = 0;
 };
 
@@ -112,6 +113,27 @@ class RemoteStore : public TargetMetadataProvider,
                     public WatchStreamCallback,
                     public WriteStreamCallback {
  public:
+  /** Counters of the existence filter mismatches reconciled by lookups. */
+  struct ReconciliationStats {
+    /** The number of target resets avoided. */
+    int64_t resets_avoided = 0;
+
+    /** The number of targets reset because a lookup failed. */
+    int64_t lookups_failed = 0;
+
+    /** The number of documents looked up to reconcile targets. */
+    int64_t documents_looked_up = 0;
+
+    /** The number of looked up documents removed from their target. */
+    int64_t documents_removed = 0;
+
+    /**
+     * An estimate of the bytes not downloaded: the cached size of the looked
+     * up documents minus the size of the lookup results.
+     */
+    int64_t bytes_saved = 0;
+  };
+
   RemoteStore(local::LocalStore* local_store,
               std::shared_ptr<Datastore> datastore,
               const std::shared_ptr<util::AsyncQueue>& worker_queue,
@@ -122,6 +144,24 @@ class RemoteStore : public TargetMetadataProvider,
     sync_engine_ = sync_engine;
   }
 
+  /**
+   * Makes existence filter mismatches that the bloom filter cannot resolve
+   * be reconciled by looking up the documents that may have been removed from
+   * the target, instead of listening to the target again from scratch. The
+   * lookups only fetch the fields the query depends on, and are sent one
+   * `BatchGetDocuments` call of at most `max_batch_size` documents at a time,
+   * which must be positive. The documents they find removed are raised with
+   * the first global snapshot at or after the lookups' read time; the target
+   * is not current until then.
+   */
+  void EnableExistenceFilterReconciliation(size_t max_batch_size) {
+    reconciliation_batch_size_ = max_batch_size;
+  }
+
+  const ReconciliationStats& reconciliation_stats() const {
+    return reconciliation_stats_;
+  }
+
   /**
    * Starts up the remote store, creating streams, restoring state from
    * `LocalStore`, etc.
@@ -193,7 +233,7 @@ class RemoteStore : public TargetMetadataProvider,
   // `Transaction` into lambdas.
   std::shared_ptr<core::Transaction> CreateTransaction();
 
-  model::DocumentKeySet GetRemoteKeysForTarget(
+  model::DocumentKeyHashSet GetRemoteKeysForTarget(
       model::TargetId target_id) const override;
   absl::optional<local::TargetData> GetTargetDataForTarget(
       model::TargetId target_id) const override;
@@ -229,6 +269,22 @@ class RemoteStore : public TargetMetadataProvider,
    */
   void RaiseWatchSnapshot(const model::SnapshotVersion& snapshot_version);
 
+  struct Reconciliation;
+
+  /**
+   * Looks up the `candidates` that may no longer be part of the target and
+   * removes those that are not from the target.
+   */
+  void ReconcileTarget(model::TargetId target_id,
+                       const model::DocumentKeySet& candidates);
+
+  /** Looks up the next batch of the candidates of `reconciliation`. */
+  void LookUpReconciliationBatch(
+      const std::shared_ptr<Reconciliation>& reconciliation);
+
+  /** Reports the documents that all lookups of `reconciliation` found. */
+  void FinishReconciliation(const Reconciliation& reconciliation);
+
   /** Process a target error and passes the error along to `SyncEngine`. */
   void ProcessTargetError(const WatchTargetChange& change);
 
@@ -295,6 +351,10 @@ class RemoteStore : public TargetMetadataProvider,
   std::shared_ptr<WriteStream> write_stream_;
   std::unique_ptr<WatchChangeAggregator> watch_change_aggregator_;
 
+  /** The reconciliation lookup batch size, or 0 if reconciliation is off. */
+  size_t reconciliation_batch_size_ = 0;
+  ReconciliationStats reconciliation_stats_;
+
   /**
    * A list of up to `kMaxPendingWrites` writes that we have fetched from the
    * `LocalStore` via `FillWritePipeline` and have or will send to the write
@@ -47,6 +47,7 @@
 #include "Firestore/core/src/model/value_util.h"
 #include "Firestore/core/src/model/verify_mutation.h"
 #include "Firestore/core/src/nanopb/byte_string.h"
+#include "Firestore/core/src/nanopb/field_scanner.h"
 #include "Firestore/core/src/nanopb/nanopb_util.h"
 #include "Firestore/core/src/nanopb/reader.h"
 #include "Firestore/core/src/nanopb/writer.h"
@@ -103,6 +104,7 @@ using model::TransformOperation;
 using model::VerifyMutation;
 using nanopb::ByteString;
 using nanopb::CheckedSize;
+using nanopb::FieldScanner;
 using nanopb::MakeArray;
 using nanopb::MakeMessage;
 using nanopb::MakeSharedMessage;
@@ -1298,13 +1300,16 @@ std::string Serializer::EncodeLabel(QueryPurpose purpose) const {
 
 std::unique_ptr<WatchChange> Serializer::DecodeWatchChange(
     ReadContext* context,
-    google_firestore_v1_ListenResponse& watch_change) const {
+    google_firestore_v1_ListenResponse& watch_change,
+    absl::string_view encoded_response) const {
   switch (watch_change.which_response_type) {
     case google_firestore_v1_ListenResponse_target_change_tag:
       return DecodeTargetChange(context, watch_change.target_change);
 
     case google_firestore_v1_ListenResponse_document_change_tag:
-      return DecodeDocumentChange(context, watch_change.document_change);
+      return DecodeDocumentChange(
+          context, watch_change.document_change,
+          FindEncodedDocument(encoded_response));
 
     case google_firestore_v1_ListenResponse_document_delete_tag:
       return DecodeDocumentDelete(context, watch_change.document_delete);
@@ -1379,22 +1384,41 @@ WatchTargetChangeState Serializer::DecodeTargetChangeState(
   UNREACHABLE();
 }
 
+absl::string_view Serializer::FindEncodedDocument(
+    absl::string_view encoded_response) {
+  FieldScanner response{encoded_response};
+  if (!response.NextField(
+          google_firestore_v1_ListenResponse_document_change_tag)) {
+    return {};
+  }
+
+  FieldScanner change{response.bytes_value()};
+  if (!change.NextField(google_firestore_v1_DocumentChange_document_tag)) {
+    return {};
+  }
+  return change.bytes_value();
+}
+
 std::unique_ptr<WatchChange> Serializer::DecodeDocumentChange(
-    ReadContext* context, google_firestore_v1_DocumentChange& change) const {
-  ObjectValue value = ObjectValue::FromFieldsEntry(
-      change.document.fields, change.document.fields_count);
+    ReadContext* context,
+    google_firestore_v1_DocumentChange& change,
+    absl::string_view encoded_document) const {
+  // Like other platforms, retain the serialized `change.document` (when
+  // available) so that the remote document cache can persist it without
+  // encoding every field again.
+  ObjectValue value =
+      encoded_document.empty()
+          ? ObjectValue::FromFieldsEntry(change.document.fields,
+                                         change.document.fields_count)
+          : ObjectValue::FromFieldsEntry(change.document.fields,
+                                         change.document.fields_count,
+                                         ByteString{encoded_document});
   DocumentKey key = DecodeKey(context, change.document.name);
 
   HARD_ASSERT(change.document.has_update_time,
               "Got a document change with no snapshot version");
   SnapshotVersion version = DecodeVersion(context, change.document.update_time);
 
-  // TODO(b/142956770): other platforms memoize `change.document` inside the
-  // `Document`. This currently cannot be implemented efficiently because it
-  // would require a reference-counted ownership model for the proto (copying it
-  // would defeat the purpose). Note, however, that even without this
-  // optimization C++ implementation is on par with the preceding Objective-C
-  // implementation.
   MutableDocument document =
       MutableDocument::FoundDocument(key, version, std::move(value));
 
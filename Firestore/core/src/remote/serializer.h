@@ -207,10 +207,15 @@ class Serializer {
   /**
    * Decodes the watch change. Modifies the provided proto to release
    * ownership of any Value messages.
+   *
+   * If given, `encoded_response` must contain the serialized form of
+   * `watch_change`. Changed documents then retain their serialized form (see
+   * `model::ObjectValue::encoded_document()`).
    */
   std::unique_ptr<remote::WatchChange> DecodeWatchChange(
       util::ReadContext* context,
-      google_firestore_v1_ListenResponse& watch_change) const;
+      google_firestore_v1_ListenResponse& watch_change,
+      absl::string_view encoded_response = {}) const;
 
   model::SnapshotVersion DecodeVersionFromListenResponse(
       util::ReadContext* context,
@@ -328,9 +333,17 @@ class Serializer {
       util::ReadContext* context,
       const google_firestore_v1_TargetChange_TargetChangeType state);
 
+  /**
+   * Returns the serialized `DocumentChange.document` within the serialized
+   * ListenResponse, or an empty view if there is none.
+   */
+  static absl::string_view FindEncodedDocument(
+      absl::string_view encoded_response);
+
   std::unique_ptr<remote::WatchChange> DecodeDocumentChange(
       util::ReadContext* context,
-      google_firestore_v1_DocumentChange& change) const;
+      google_firestore_v1_DocumentChange& change,
+      absl::string_view encoded_document) const;
   std::unique_ptr<remote::WatchChange> DecodeDocumentDelete(
       util::ReadContext* context,
       const google_firestore_v1_DocumentDelete& change) const;
@@ -252,6 +252,9 @@ void Stream::OnStreamRead(const grpc::ByteBuffer& message) {
 
   HARD_ASSERT(IsStarted(), "OnStreamRead called for a stopped stream.");
 
+  ++message_stats_.messages_received;
+  message_stats_.bytes_received += static_cast<int64_t>(message.Length());
+
   if (LogIsDebugEnabled()) {
     LOG_DEBUG("%s headers (allowlisted): %s", GetDebugDescription(),
               Datastore::GetAllowlistedHeadersAsString(
@@ -260,11 +263,7 @@ void Stream::OnStreamRead(const grpc::ByteBuffer& message) {
 
   Status read_status = NotifyStreamResponse(message);
   if (!read_status.ok()) {
-    grpc_stream_->FinishImmediately();
-    // Don't expect gRPC to produce status -- since the error happened on the
-    // client, we have all the information we need.
-    OnStreamFinish(read_status);
-    return;
+    FinishWithClientError(read_status);
   }
 }
 
@@ -375,9 +374,34 @@ void Stream::Write(grpc::ByteBuffer&& message) {
   HARD_ASSERT(IsOpen(), "Cannot write when the stream is not open.");
 
   CancelIdleCheck();
+  ++message_stats_.messages_sent;
+  message_stats_.bytes_sent += static_cast<int64_t>(message.Length());
   grpc_stream_->Write(std::move(message));
 }
 
+void Stream::FinishWithClientError(const Status& status) {
+  EnsureOnQueue();
+
+  grpc_stream_->FinishImmediately();
+  // Don't expect gRPC to produce status -- since the error happened on the
+  // client, we have all the information we need.
+  OnStreamFinish(status);
+}
+
+void Stream::PauseReading() {
+  EnsureOnQueue();
+  if (grpc_stream_) {
+    grpc_stream_->PauseReading();
+  }
+}
+
+void Stream::ResumeReading() {
+  EnsureOnQueue();
+  if (grpc_stream_) {
+    grpc_stream_->ResumeReading();
+  }
+}
+
 std::string Stream::GetDebugDescription() const {
   EnsureOnQueue();
   return StringFormat("%s (%x)", GetDebugName(), this);
@@ -126,6 +126,18 @@ class Stream : public GrpcStreamObserver,
     Backoff
   };
 
+  /**
+   * The number and total size of the messages a stream has sent and received.
+   * Sizes are those of the serialized messages, before gRPC compresses them
+   * for the wire.
+   */
+  struct MessageStats {
+    int64_t messages_sent = 0;
+    int64_t bytes_sent = 0;
+    int64_t messages_received = 0;
+    int64_t bytes_received = 0;
+  };
+
   Stream(const std::shared_ptr<util::AsyncQueue>& worker_queue,
          std::shared_ptr<credentials::AuthCredentialsProvider>
              auth_credentials_provider,
@@ -198,6 +210,23 @@ class Stream : public GrpcStreamObserver,
    */
   void CancelIdleCheck();
 
+  /**
+   * Returns the messages this stream has sent and received so far, across all
+   * the times it has been (re)started.
+   */
+  const MessageStats& message_stats() const {
+    return message_stats_;
+  }
+
+  /**
+   * The number of times this stream has been closed. Callbacks that may run
+   * after the stream is stopped or restarted compare it to the count at the
+   * time they were created.
+   */
+  int close_count() const {
+    return close_count_;
+  }
+
   // `GrpcStreamObserver` interface -- do not use.
   void OnStreamStart() override;
   void OnStreamRead(const grpc::ByteBuffer& message) override;
@@ -209,6 +238,24 @@ class Stream : public GrpcStreamObserver,
   void Write(grpc::ByteBuffer&& message);
   std::string GetDebugDescription() const;
 
+  /**
+   * Finishes the stream because of an error on the client, such as a response
+   * that could not be decoded.
+   */
+  void FinishWithClientError(const util::Status& status);
+
+  /**
+   * Pauses and resumes reading responses from the server (see
+   * `GrpcStream::PauseReading`). Both do nothing unless the stream is open;
+   * a restarted stream always starts reading.
+   */
+  void PauseReading();
+  void ResumeReading();
+
+  const std::shared_ptr<util::AsyncQueue>& worker_queue() const {
+    return worker_queue_;
+  }
+
   ExponentialBackoff backoff_;
 
  private:
@@ -242,6 +289,7 @@ class Stream : public GrpcStreamObserver,
   void BackoffAndTryRestarting();
 
   State state_ = State::Initial;
+  MessageStats message_stats_;
 
   std::unique_ptr<GrpcStream> grpc_stream_;
 
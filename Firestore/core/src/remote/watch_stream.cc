@@ -36,6 +36,8 @@ using local::TargetData;
 using model::TargetId;
 using remote::ByteBufferReader;
 using util::AsyncQueue;
+using util::Executor;
+using util::LogIsDebugEnabled;
 using util::Status;
 using util::TimerId;
 
@@ -55,14 +57,15 @@ WatchStream::WatchStream(
              TimerId::ListenStreamConnectionBackoff,
              TimerId::ListenStreamIdle,
              TimerId::HealthCheckTimeout},
-      watch_serializer_{std::move(serializer)},
+      watch_serializer_{
+          std::make_shared<WatchStreamSerializer>(std::move(serializer))},
       callback_{NOT_NULL(callback)} {
 }
 
 void WatchStream::WatchQuery(const TargetData& query) {
   EnsureOnQueue();
 
-  auto request = watch_serializer_.EncodeWatchRequest(query);
+  auto request = watch_serializer_->EncodeWatchRequest(query);
   LOG_DEBUG("%s watch: %s", GetDebugDescription(), request.ToString());
   Write(MakeByteBuffer(request));
 }
@@ -70,7 +73,7 @@ void WatchStream::WatchQuery(const TargetData& query) {
 void WatchStream::UnwatchTargetId(TargetId target_id) {
   EnsureOnQueue();
 
-  auto request = watch_serializer_.EncodeUnwatchRequest(target_id);
+  auto request = watch_serializer_->EncodeUnwatchRequest(target_id);
 
   LOG_DEBUG("%s unwatch: %s", GetDebugDescription(), request.ToString());
   Write(MakeByteBuffer(request));
@@ -92,25 +95,111 @@ void WatchStream::NotifyStreamOpen() {
   callback_->OnWatchStreamOpen();
 }
 
+void WatchStream::DecodeResponsesOn(std::shared_ptr<Executor> executor) {
+  decode_executor_ = std::move(executor);
+}
+
 Status WatchStream::NotifyStreamResponse(const grpc::ByteBuffer& message) {
+  std::string description =
+      LogIsDebugEnabled() ? GetDebugDescription() : std::string{};
+
+  if (decode_executor_) {
+    DecodeInBackground(message, description);
+    return Status::OK();
+  }
+  return DeliverResponse(DecodeResponse(
+      *watch_serializer_, message, retain_encoded_documents_, description));
+}
+
+WatchStream::DecodedResponse WatchStream::DecodeResponse(
+    const WatchStreamSerializer& serializer,
+    const grpc::ByteBuffer& message,
+    bool retain_encoded_documents,
+    const std::string& description) {
+  DecodedResponse result;
+
   ByteBufferReader reader{message};
-  auto response = watch_serializer_.ParseResponse(&reader);
+  auto response = serializer.ParseResponse(&reader);
   if (!reader.ok()) {
-    return reader.status();
+    result.status = reader.status();
+    return result;
   }
 
-  LOG_DEBUG("%s response: %s", GetDebugDescription(), response.ToString());
+  LOG_DEBUG("%s response: %s", description, response.ToString());
 
-  // A successful response means the stream is healthy.
-  backoff_.Reset();
+  // Only document changes keep the serialized document, so avoid assembling
+  // the bytes of a message that arrived in several slices otherwise.
+  absl::string_view encoded_response;
+  if (retain_encoded_documents &&
+      response->which_response_type ==
+          google_firestore_v1_ListenResponse_document_change_tag) {
+    encoded_response = reader.bytes();
+  }
+  result.change =
+      serializer.DecodeWatchChange(&reader, *response, encoded_response);
+  result.version = serializer.DecodeSnapshotVersion(&reader, *response);
+  result.status = reader.status();
+  return result;
+}
 
-  auto watch_change = watch_serializer_.DecodeWatchChange(&reader, *response);
-  auto version = watch_serializer_.DecodeSnapshotVersion(&reader, *response);
-  if (!reader.ok()) {
-    return reader.status();
+void WatchStream::DecodeInBackground(const grpc::ByteBuffer& message,
+                                     const std::string& description) {
+  std::weak_ptr<Stream> weak_this{shared_from_this()};
+  std::shared_ptr<const WatchStreamSerializer> serializer = watch_serializer_;
+  std::shared_ptr<AsyncQueue> queue = worker_queue();
+  int initial_close_count = close_count();
+  bool retain_encoded_documents = retain_encoded_documents_;
+
+  // Responses of an earlier stream are dropped once decoded, so they no
+  // longer count.
+  if (decoding_close_count_ != initial_close_count) {
+    decoding_close_count_ = initial_close_count;
+    responses_being_decoded_ = 0;
   }
+  // Keep a fast server from queueing up an unbounded number of responses
+  // behind a slow decoder.
+  if (++responses_being_decoded_ >= kMaxResponsesBeingDecoded) {
+    PauseReading();
+  }
+
+  decode_executor_->Execute([weak_this, serializer, queue, initial_close_count,
+                             retain_encoded_documents, message, description] {
+    DecodedResponse response = DecodeResponse(
+        *serializer, message, retain_encoded_documents, description);
+
+    queue->Enqueue([weak_this, initial_close_count, response] {
+      auto strong_this =
+          std::static_pointer_cast<WatchStream>(weak_this.lock());
+      // The stream may have been stopped or restarted while decoding, in
+      // which case the change belongs to a stream that no longer exists.
+      if (!strong_this || strong_this->close_count() != initial_close_count) {
+        return;
+      }
+
+      strong_this->OnResponseDecoded();
+      Status status = strong_this->DeliverResponse(response);
+      if (!status.ok()) {
+        strong_this->FinishWithClientError(status);
+      }
+    });
+  });
+}
+
+void WatchStream::OnResponseDecoded() {
+  if (--responses_being_decoded_ < kMaxResponsesBeingDecoded) {
+    ResumeReading();
+  }
+}
+
+Status WatchStream::DeliverResponse(const DecodedResponse& response) {
+  if (!response.status.ok()) {
+    return response.status;
+  }
+
+  // A successful response means the stream is healthy.
+  backoff_.Reset();
 
-  callback_->OnWatchStreamChange(*watch_change, version);
+  callback_->OnWatchStreamChange(*response.change, response.version);
 
   return Status::OK();
 }
@@ -21,12 +21,14 @@
 #include <string>
 
 #include "Firestore/core/src/model/model_fwd.h"
+#include "Firestore/core/src/model/snapshot_version.h"
 #include "Firestore/core/src/remote/grpc_connection.h"
 #include "Firestore/core/src/remote/remote_objc_bridge.h"
 #include "Firestore/core/src/remote/stream.h"
 #include "Firestore/core/src/remote/watch_change.h"
 #include "Firestore/core/src/util/async_queue.h"
-#include "Firestore/core/src/util/status_fwd.h"
+#include "Firestore/core/src/util/executor.h"
+#include "Firestore/core/src/util/status.h"
 #include "absl/strings/string_view.h"
 #include "grpcpp/support/byte_buffer.h"
 
@@ -108,7 +110,52 @@ class WatchStream : public Stream {
   virtual /*virtual for tests only*/ void UnwatchTargetId(
       model::TargetId target_id);
 
+  /**
+   * Makes the stream decode its responses on `executor`, which must be serial,
+   * instead of on the worker queue, so that decoding a burst of documents
+   * overlaps with applying the changes decoded before it. Decoded changes are
+   * still delivered on the worker queue, in the order the responses arrived.
+   *
+   * Changes that are still being decoded when the stream closes are dropped,
+   * just like responses that gRPC has not delivered yet. The stream stops
+   * reading responses while `kMaxResponsesBeingDecoded` of them are waiting
+   * to be decoded or delivered.
+   */
+  void DecodeResponsesOn(std::shared_ptr<util::Executor> executor);
+
+  /**
+   * Makes the changed documents the stream receives retain their serialized
+   * form (see `model::ObjectValue::encoded_document()`), so that a persistent
+   * cache can store them without encoding them again. The bytes are kept for
+   * as long as the documents, so this only pays off with a persistent cache.
+   */
+  void RetainEncodedDocuments() {
+    retain_encoded_documents_ = true;
+  }
+
+  /** The number of responses that may wait to be decoded at a time. */
+  static constexpr int kMaxResponsesBeingDecoded = 64;
+
  private:
+  /** The result of decoding a `ListenResponse`. */
+  struct DecodedResponse {
+    util::Status status;
+    std::shared_ptr<WatchChange> change;
+    model::SnapshotVersion version;
+  };
+
+  /** Decodes `message`; may be called on any thread. */
+  static DecodedResponse DecodeResponse(const WatchStreamSerializer& serializer,
+                                        const grpc::ByteBuffer& message,
+                                        bool retain_encoded_documents,
+                                        const std::string& description);
+
+  void DecodeInBackground(const grpc::ByteBuffer& message,
+                          const std::string& description);
+  /** Called on the worker queue once a response of the open stream is done. */
+  void OnResponseDecoded();
+  util::Status DeliverResponse(const DecodedResponse& response);
+
   std::unique_ptr<GrpcStream> CreateGrpcStream(
       GrpcConnection* grpc_connection,
       const credentials::AuthToken& auth_token,
@@ -123,8 +170,17 @@ class WatchStream : public Stream {
     return "WatchStream";
   }
 
-  WatchStreamSerializer watch_serializer_;
+  // Shared with the responses being decoded in the background, which may
+  // outlive the stream.
+  std::shared_ptr<const WatchStreamSerializer> watch_serializer_;
   WatchStreamCallback* callback_;
+  std::shared_ptr<util::Executor> decode_executor_;
+  bool retain_encoded_documents_ = false;
+
+  // The number of responses of the stream opened as `decoding_close_count_`
+  // that are being decoded in the background and not yet delivered.
+  int responses_being_decoded_ = 0;
+  int decoding_close_count_ = 0;
 };
 
 }  // namespace remote
@@ -73,7 +73,12 @@ enum class TimerId {
   /**
    * A timer used to periodically attempt Index Backfill
    */
-  IndexBackfillDelay
+  IndexBackfillDelay,
+
+  /**
+   * A timer used in `Datastore` to send the lookups gathered for a batch.
+   */
+  LookupBatchDelay
 };
 
 // A serial queue that executes given operations asynchronously, one at a time.
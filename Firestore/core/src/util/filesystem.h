@@ -195,6 +195,12 @@ class Filesystem {
    */
   virtual StatusOr<std::string> ReadFile(const Path& path);
 
+  /**
+   * Creates or truncates the file at the given `path` and writes `contents`
+   * to it.
+   */
+  virtual Status WriteFile(const Path& path, absl::string_view contents);
+
  protected:
   Filesystem() = default;
 };
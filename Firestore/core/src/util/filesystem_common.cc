@@ -112,6 +112,25 @@ StatusOr<std::string> Filesystem::ReadFile(const Path& path) {
   return buffer.str();
 }
 
+Status Filesystem::WriteFile(const Path& path, absl::string_view contents) {
+  std::ofstream file{path.native_value(), std::ios::out | std::ios::trunc |
+                                              std::ios::binary};
+  if (!file) {
+    return Status{Error::kErrorUnknown,
+                  StringFormat("File at path '%s' cannot be opened",
+                               path.ToUtf8String())};
+  }
+
+  file.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+  file.close();
+  if (!file) {
+    return Status{Error::kErrorUnknown,
+                  StringFormat("Failed to write file at path '%s'",
+                               path.ToUtf8String())};
+  }
+  return Status::OK();
+}
+
 bool IsEmptyDir(const Path& path) {
   // If the DirectoryIterator is valid there's at least one entry.
   auto iter = DirectoryIterator::Create(path);
@@ -33,6 +33,13 @@ TEST(Settings, CopyConstructor) {
     settings.set_ssl_enabled(true);
     settings.set_persistence_enabled(true);
     settings.set_cache_size_bytes(100);
+    settings.set_compression_enabled(true);
+    settings.set_field_name_dictionary_enabled(true);
+    local::ResumeTokenCheckpointPolicy policy;
+    policy.documents = 100;
+    settings.set_resume_token_checkpoint_policy(policy);
+    settings.set_group_commit_enabled(true);
+    settings.set_group_commit_durability(local::WriteDurability::kSync);
 
     Settings copy(settings);
 
@@ -40,6 +47,14 @@ TEST(Settings, CopyConstructor) {
     EXPECT_EQ(settings.ssl_enabled(), copy.ssl_enabled());
     EXPECT_EQ(settings.persistence_enabled(), copy.persistence_enabled());
     EXPECT_EQ(settings.cache_size_bytes(), copy.cache_size_bytes());
+    EXPECT_EQ(settings.compression_enabled(), copy.compression_enabled());
+    EXPECT_EQ(settings.field_name_dictionary_enabled(),
+              copy.field_name_dictionary_enabled());
+    EXPECT_EQ(settings.resume_token_checkpoint_policy(),
+              copy.resume_token_checkpoint_policy());
+    EXPECT_EQ(settings.group_commit_enabled(), copy.group_commit_enabled());
+    EXPECT_EQ(settings.group_commit_durability(),
+              copy.group_commit_durability());
     EXPECT_EQ(settings.local_cache_settings(), copy.local_cache_settings());
   }
   {
@@ -149,6 +164,55 @@ TEST(Settings, EqualityAndHash) {
     EXPECT_NE(settings1, settings2);
     EXPECT_NE(settings1.Hash(), settings2.Hash());
   }
+  {
+    Settings settings1;
+    Settings settings2;
+    settings2.set_compression_enabled(true);
+
+    EXPECT_FALSE(settings1.compression_enabled());
+    EXPECT_NE(settings1, settings2);
+    EXPECT_NE(settings1.Hash(), settings2.Hash());
+  }
+  {
+    Settings settings1;
+    Settings settings2;
+    settings2.set_field_name_dictionary_enabled(true);
+
+    EXPECT_FALSE(settings1.field_name_dictionary_enabled());
+    EXPECT_NE(settings1, settings2);
+    EXPECT_NE(settings1.Hash(), settings2.Hash());
+  }
+  {
+    Settings settings1;
+    Settings settings2;
+    local::ResumeTokenCheckpointPolicy policy;
+    policy.bytes = 1024;
+    settings2.set_resume_token_checkpoint_policy(policy);
+
+    EXPECT_EQ(local::ResumeTokenCheckpointPolicy{},
+              settings1.resume_token_checkpoint_policy());
+    EXPECT_NE(settings1, settings2);
+    EXPECT_NE(settings1.Hash(), settings2.Hash());
+  }
+  {
+    Settings settings1;
+    Settings settings2;
+    settings2.set_group_commit_enabled(true);
+
+    EXPECT_FALSE(settings1.group_commit_enabled());
+    EXPECT_NE(settings1, settings2);
+    EXPECT_NE(settings1.Hash(), settings2.Hash());
+  }
+  {
+    Settings settings1;
+    Settings settings2;
+    settings2.set_group_commit_durability(local::WriteDurability::kSync);
+
+    EXPECT_EQ(local::WriteDurability::kAsync,
+              settings1.group_commit_durability());
+    EXPECT_NE(settings1, settings2);
+    EXPECT_NE(settings1.Hash(), settings2.Hash());
+  }
   {
     Settings settings1;
     settings1.set_host("host");
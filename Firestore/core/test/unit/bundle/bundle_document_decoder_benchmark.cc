@@ -0,0 +1,108 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string>
+
+#include "Firestore/core/src/bundle/bundle_serializer.h"
+#include "Firestore/core/src/model/database_id.h"
+#include "Firestore/core/src/remote/serializer.h"
+#include "Firestore/core/src/util/hard_assert.h"
+#include "Firestore/core/src/util/json_reader.h"
+#include "Firestore/third_party/nlohmann_json/json.hpp"
+#include "benchmark/benchmark.h"
+
+using firebase::firestore::bundle::BundleSerializer;
+using firebase::firestore::model::DatabaseId;
+using firebase::firestore::remote::Serializer;
+using firebase::firestore::util::JsonReader;
+
+namespace {
+
+std::string FieldJson(int i) {
+  std::string index = std::to_string(i);
+  switch (i % 5) {
+    case 0:
+      return R"({"integerValue": ")" + index + R"("})";
+    case 1:
+      return R"({"doubleValue": )" + index + R"(.5})";
+    case 2:
+      return R"({"stringValue": "value of field )" + index + R"("})";
+    case 3:
+      return R"({"timestampValue": "2021-02-03T04:05:06.000007Z"})";
+    default:
+      return R"({"mapValue": {"fields": {"nested": {"booleanValue": true}, )"
+             R"("list": {"arrayValue": {"values": [{"integerValue": "1"}, )"
+             R"({"stringValue": "two"}, {"nullValue": null}]}}}}})";
+  }
+}
+
+/** Builds a `document` bundle element with `field_count` fields. */
+std::string DocumentElementJson(int field_count) {
+  std::string fields;
+  for (int i = 0; i < field_count; ++i) {
+    if (i > 0) fields += ", ";
+    fields += "\"field_" + std::to_string(i) + "\": " + FieldJson(i);
+  }
+  return R"({"document": {"name": )"
+         R"("projects/p/databases/default/documents/coll/doc", )"
+         R"("fields": {)" +
+         fields +
+         R"(}, "createTime": "2021-02-03T04:05:06Z", )"
+         R"("updateTime": "2021-02-03T04:05:06Z"}})";
+}
+
+BundleSerializer CreateSerializer() {
+  return BundleSerializer(Serializer(DatabaseId("p", "default")));
+}
+
+}  // namespace
+
+static void BM_DecodeDocumentFromDom(benchmark::State& state) {
+  BundleSerializer serializer = CreateSerializer();
+  std::string element = DocumentElementJson(static_cast<int>(state.range(0)));
+
+  for (auto _ : state) {
+    JsonReader reader;
+    auto json = nlohmann::json::parse(element.begin(), element.end(),
+                                      /*callback=*/nullptr,
+                                      /*allow_exceptions=*/false);
+    auto document = serializer.DecodeDocument(reader, json.at("document"));
+    HARD_ASSERT(reader.ok());
+    benchmark::DoNotOptimize(document);
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          static_cast<int64_t>(element.size()));
+}
+BENCHMARK(BM_DecodeDocumentFromDom)->Arg(10)->Arg(100)->Arg(1000)->Arg(10000);
+
+static void BM_DecodeDocumentStreaming(benchmark::State& state) {
+  BundleSerializer serializer = CreateSerializer();
+  std::string element = DocumentElementJson(static_cast<int>(state.range(0)));
+
+  for (auto _ : state) {
+    JsonReader reader;
+    auto document = serializer.DecodeDocumentElement(reader, element);
+    HARD_ASSERT(reader.ok() && document.has_value());
+    benchmark::DoNotOptimize(document);
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          static_cast<int64_t>(element.size()));
+}
+BENCHMARK(BM_DecodeDocumentStreaming)
+    ->Arg(10)
+    ->Arg(100)
+    ->Arg(1000)
+    ->Arg(10000);
@@ -60,9 +60,15 @@ class BundleLoaderTest : public ::testing::Test {
       for (const auto& entry : documents) {
         parent_.last_documents_ = parent_.last_documents_.insert(entry.first);
       }
+      parent_.chunk_sizes_.push_back(documents.size());
       return DocumentMap{};
     }
 
+    void ResetBundledDocuments(const std::string& bundle_id) override {
+      (void)bundle_id;
+      ++parent_.resets_;
+    }
+
     void SaveNamedQuery(const NamedQuery& query,
                         const model::DocumentKeySet& keys) override {
       parent_.last_queries_.insert({query.query_name(), keys});
@@ -102,6 +108,8 @@ class BundleLoaderTest : public ::testing::Test {
  protected:
   std::unique_ptr<BundleCallback> callback_ = nullptr;
   DocumentKeySet last_documents_;
+  std::vector<size_t> chunk_sizes_;
+  int resets_ = 0;
   std::unordered_map<std::string, DocumentKeySet> last_queries_;
   std::unordered_map<std::string, BundleMetadata> last_bundles_;
   model::SnapshotVersion create_time_ =
@@ -175,6 +183,50 @@ TEST_F(BundleLoaderTest, AppliesDocumentChanges) {
   EXPECT_EQ(last_bundles_["bundle-1"], CreateMetadata(1));
 }
 
+TEST_F(BundleLoaderTest, AppliesDocumentsInChunks) {
+  BundleLoader loader(callback_.get(), CreateMetadata(3),
+                      /*documents_per_chunk=*/2);
+
+  for (const char* path : {"coll/doc1", "coll/doc2", "coll/doc3"}) {
+    EXPECT_OK(loader.AddElement(
+        absl::make_unique<BundledDocumentMetadata>(
+            testutil::Key(path), create_time_,
+            /*exists=*/true, /*queries=*/std::vector<std::string>{}),
+        /*byte_size=*/1));
+    EXPECT_OK(loader.AddElement(
+        absl::make_unique<BundleDocument>(testutil::Doc(path, 1)),
+        /*byte_size=*/2));
+    if (loader.HasFullChunk()) {
+      loader.ApplyDocumentChunk();
+    }
+  }
+  EXPECT_OK(loader.ApplyChanges());
+
+  EXPECT_EQ(chunk_sizes_, (std::vector<size_t>{2, 1}));
+  EXPECT_EQ(resets_, 1);
+  EXPECT_EQ(last_documents_,
+            (DocumentKeySet{testutil::Key("coll/doc1"),
+                            testutil::Key("coll/doc2"),
+                            testutil::Key("coll/doc3")}));
+  EXPECT_EQ(last_bundles_["bundle-1"], CreateMetadata(3));
+}
+
+TEST_F(BundleLoaderTest, VerifiesDocumentCountAcrossChunks) {
+  BundleLoader loader(callback_.get(), CreateMetadata(2),
+                      /*documents_per_chunk=*/1);
+
+  EXPECT_OK(loader.AddElement(
+      absl::make_unique<BundledDocumentMetadata>(
+          testutil::Key("coll/doc1"), create_time_,
+          /*exists=*/false, /*queries=*/std::vector<std::string>{}),
+      /*byte_size=*/1));
+  ASSERT_TRUE(loader.HasFullChunk());
+  loader.ApplyDocumentChunk();
+  EXPECT_FALSE(loader.HasFullChunk());
+
+  EXPECT_NOT_OK(loader.ApplyChanges());
+}
+
 TEST_F(BundleLoaderTest, AppliesNamedQueries) {
   BundleLoader loader(callback_.get(), CreateMetadata(2));
 
@@ -386,6 +386,49 @@ TEST_F(BundleReaderTest, ReadsQueryAndDocument) {
       *static_cast<BundleDocument*>(elements[3].get()), Document1());
 }
 
+TEST_F(BundleReaderTest, ReadsElementsInBatches) {
+  AddNamedQuery(LimitQuery());
+  AddDocumentMetadata(DocumentMetadata1());
+  AddDocument(Document1());
+  AddDocumentMetadata(DocumentMetadata2());
+  AddDocument(Document2());
+
+  const auto& bundle =
+      BuildBundle("bundle-1", testutil::Version(6000004000), 2);
+  BundleReader reader(bundle_serializer, ToByteStream(bundle));
+  auto metadata = reader.GetBundleMetadata();
+
+  std::vector<BundleReader::SizedElement> elements;
+  int64_t total_size = 0;
+  // A single byte per batch reads exactly one element at a time.
+  for (size_t max_bytes : {1, 1, 1000000}) {
+    auto batch = reader.GetNextElements(max_bytes);
+    EXPECT_OK(reader.reader_status());
+    for (auto& element : batch) {
+      total_size += element.byte_size;
+      elements.push_back(std::move(element));
+    }
+  }
+  EXPECT_TRUE(reader.GetNextElements(1000000).empty());
+  EXPECT_OK(reader.reader_status());
+
+  ASSERT_EQ(elements.size(), 5);
+  EXPECT_EQ(total_size, metadata.total_bytes());
+  EXPECT_EQ(reader.bytes_read(), metadata.total_bytes());
+  VerifyNamedQueryEncodesToOriginal(
+      *static_cast<NamedQuery*>(elements[0].element.get()), LimitQuery());
+  VerifyDocumentMetadataEquals(
+      *static_cast<BundledDocumentMetadata*>(elements[1].element.get()),
+      DocumentMetadata1());
+  VerifyDocumentEncodesToOriginal(
+      *static_cast<BundleDocument*>(elements[2].element.get()), Document1());
+  VerifyDocumentMetadataEquals(
+      *static_cast<BundledDocumentMetadata*>(elements[3].element.get()),
+      DocumentMetadata2());
+  VerifyDocumentEncodesToOriginal(
+      *static_cast<BundleDocument*>(elements[4].element.get()), Document2());
+}
+
 TEST_F(BundleReaderTest, ReadsQueryAndDocumentWithUnexpectedOrder) {
   AddDocumentMetadata(DocumentMetadata1());
   AddDocument(Document1());
@@ -578,6 +621,24 @@ TEST_F(BundleReaderTest, FailsWhenBundleIsSomehowCorrupted) {
   }
 }
 
+TEST_F(BundleReaderTest, FailsWhenBatchIsSomehowCorrupted) {
+  AddDocumentMetadata(DocumentMetadata1());
+  AddDocument(Document1());
+  AddNamedQuery(LimitQuery());
+
+  const auto& bundle =
+      BuildBundle("bundle-1", testutil::Version(6000004000), 0);
+
+  for (size_t i = 0; i < bundle.size(); ++i) {
+    std::string copy(bundle);
+    copy.insert(i, "1");
+    BundleReader reader(bundle_serializer, ToByteStream(copy));
+    while (!reader.GetNextElements(1000000).empty()) {
+    }
+    EXPECT_NOT_OK(reader.reader_status());
+  }
+}
+
 }  //  namespace
 }  //  namespace bundle
 }  //  namespace firestore
@@ -141,11 +141,23 @@ class BundleSerializerTest : public ::testing::Test {
     VerifyJsonStringDecodeFails(std::move(json_string));
   }
 
+  // Decodes the document both from a JSON DOM and as a streamed bundle
+  // element, and verifies that both agree.
   BundleDocument VerifyJsonStringDecodes(std::string json_string) {
     JsonReader reader;
     BundleDocument actual =
         bundle_serializer.DecodeDocument(reader, Parse(json_string));
     EXPECT_OK(reader.status());
+
+    JsonReader element_reader;
+    absl::optional<BundleDocument> streamed =
+        bundle_serializer.DecodeDocumentElement(
+            element_reader, "{\"document\":" + json_string + "}");
+    EXPECT_OK(element_reader.status());
+    EXPECT_TRUE(streamed.has_value());
+    if (streamed.has_value()) {
+      EXPECT_EQ(streamed->document(), actual.document());
+    }
     return actual;
   }
 
@@ -154,6 +166,13 @@ class BundleSerializerTest : public ::testing::Test {
     BundleDocument actual =
         bundle_serializer.DecodeDocument(reader, Parse(json_string));
     EXPECT_NOT_OK(reader.status());
+
+    JsonReader element_reader;
+    absl::optional<BundleDocument> streamed =
+        bundle_serializer.DecodeDocumentElement(
+            element_reader, "{\"document\":" + json_string + "}");
+    EXPECT_NOT_OK(element_reader.status());
+    EXPECT_FALSE(streamed.has_value());
   }
 
   // 1. Take a `Query` object, put it in a `NamedQuery` and encode it to byte
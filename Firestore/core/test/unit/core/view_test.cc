@@ -17,6 +17,7 @@
 #include "Firestore/core/src/core/view.h"
 
 #include <initializer_list>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -669,6 +670,52 @@ TEST(ViewTest, SuppressesWriteAcknowledgementIfWatchHasNotCaughtUp) {
                                      DocumentViewChange::Type::Metadata}));
 }
 
+TEST(ViewTest, ComputesIndicesOfChanges) {
+  Query query = QueryForMessages().AddingOrderBy(OrderBy("sort", "asc"));
+  View view(query, DocumentKeySet{});
+
+  std::vector<Document> initial;
+  for (int i = 1; i <= 8; ++i) {
+    initial.push_back(Doc("rooms/eros/messages/" + std::to_string(i), 0,
+                          Map("sort", i)));
+  }
+  ApplyChanges(&view, initial, absl::nullopt);
+
+  absl::optional<ViewSnapshot> snapshot = ApplyChanges(
+      &view,
+      {DeletedDoc("rooms/eros/messages/2"), DeletedDoc("rooms/eros/messages/7"),
+       Doc("rooms/eros/messages/1", 1, Map("sort", 10)),
+       Doc("rooms/eros/messages/8", 1, Map("sort", 0)),
+       Doc("rooms/eros/messages/4", 1, Map("sort", 4, "text", "edited")),
+       Doc("rooms/eros/messages/5", 1, Map("sort", 3)),
+       Doc("rooms/eros/messages/9", 1, Map("sort", 3.5)),
+       Doc("rooms/eros/messages/10", 1, Map("sort", 11))},
+      absl::nullopt);
+  ASSERT_TRUE(snapshot.has_value());
+
+  // The indices must be those of applying the changes one by one.
+  DocumentSet index_tracker = snapshot->old_documents();
+  for (const DocumentViewChange& change : snapshot->document_changes()) {
+    ASSERT_TRUE(change.has_indices());
+    const model::DocumentKey& key = change.document()->key();
+
+    size_t old_index = DocumentSet::npos;
+    size_t new_index = DocumentSet::npos;
+    if (change.type() != DocumentViewChange::Type::Added) {
+      old_index = index_tracker.IndexOf(key);
+      index_tracker = index_tracker.erase(key);
+    }
+    if (change.type() != DocumentViewChange::Type::Removed) {
+      index_tracker = index_tracker.insert(change.document());
+      new_index = index_tracker.IndexOf(key);
+    }
+
+    EXPECT_EQ(change.old_index(), old_index) << change.ToString();
+    EXPECT_EQ(change.new_index(), new_index) << change.ToString();
+  }
+  ASSERT_EQ(index_tracker, snapshot->documents());
+}
+
 }  // namespace core
 }  // namespace firestore
 }  // namespace firebase
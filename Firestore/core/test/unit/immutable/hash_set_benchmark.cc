@@ -0,0 +1,153 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Firestore/core/src/immutable/hash_set.h"
+#include "Firestore/core/src/immutable/sorted_set.h"
+#include "Firestore/core/src/model/document_key.h"
+#include "benchmark/benchmark.h"
+
+using firebase::firestore::immutable::HashSet;
+using firebase::firestore::immutable::SortedSet;
+using firebase::firestore::model::DocumentKey;
+using firebase::firestore::model::DocumentKeyHash;
+
+namespace {
+
+using KeyHashSet = HashSet<DocumentKey, DocumentKeyHash>;
+using KeySortedSet = SortedSet<DocumentKey>;
+
+/** Returns `size` distinct document keys in random order. */
+std::vector<DocumentKey> ShuffledKeys(int64_t size, const std::string& prefix) {
+  std::vector<DocumentKey> keys;
+  for (int64_t i = 0; i < size; ++i) {
+    keys.push_back(DocumentKey::FromPathString("rooms/eros/messages/" + prefix +
+                                               std::to_string(i)));
+  }
+  std::shuffle(keys.begin(), keys.end(), std::mt19937{});
+  return keys;
+}
+
+template <typename Set>
+Set MakeSet(const std::vector<DocumentKey>& keys) {
+  Set result;
+  for (const DocumentKey& key : keys) {
+    result = result.insert(key);
+  }
+  return result;
+}
+
+}  // namespace
+
+template <typename Set>
+void BM_Insert(benchmark::State& state) {
+  std::vector<DocumentKey> keys = ShuffledKeys(state.range(0), "doc");
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(MakeSet<Set>(keys));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK_TEMPLATE(BM_Insert, KeySortedSet)
+    ->Arg(10000)
+    ->Arg(100000)
+    ->Arg(1000000)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_Insert, KeyHashSet)
+    ->Arg(10000)
+    ->Arg(100000)
+    ->Arg(1000000)
+    ->Unit(benchmark::kMillisecond);
+
+/** Looks up keys in a set of `range(0)` keys, half of them present. */
+template <typename Set>
+void BM_Contains(benchmark::State& state) {
+  std::vector<DocumentKey> keys = ShuffledKeys(state.range(0), "doc");
+  Set set = MakeSet<Set>(keys);
+  std::vector<DocumentKey> missing = ShuffledKeys(state.range(0), "missing");
+
+  size_t next = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(set.contains(keys[next]));
+    benchmark::DoNotOptimize(set.contains(missing[next]));
+    next = (next + 1) % keys.size();
+  }
+  state.SetItemsProcessed(state.iterations() * 2);
+}
+BENCHMARK_TEMPLATE(BM_Contains, KeySortedSet)
+    ->Arg(10000)
+    ->Arg(100000)
+    ->Arg(1000000);
+BENCHMARK_TEMPLATE(BM_Contains, KeyHashSet)
+    ->Arg(10000)
+    ->Arg(100000)
+    ->Arg(1000000);
+
+/**
+ * Inserts and then erases keys in a set that holds `range(0)` keys in between,
+ * keeping the previous version alive like a view holding on to its snapshot.
+ */
+template <typename Set>
+void BM_InsertErase(benchmark::State& state) {
+  Set set = MakeSet<Set>(ShuffledKeys(state.range(0), "doc"));
+  std::vector<DocumentKey> added = ShuffledKeys(state.range(0), "added");
+
+  size_t next = 0;
+  for (auto _ : state) {
+    const DocumentKey& key = added[next];
+    next = (next + 1) % added.size();
+    Set modified = set.insert(key);
+    benchmark::DoNotOptimize(modified.erase(key));
+  }
+  state.SetItemsProcessed(state.iterations() * 2);
+}
+BENCHMARK_TEMPLATE(BM_InsertErase, KeySortedSet)
+    ->Arg(10000)
+    ->Arg(100000)
+    ->Arg(1000000);
+BENCHMARK_TEMPLATE(BM_InsertErase, KeyHashSet)
+    ->Arg(10000)
+    ->Arg(100000)
+    ->Arg(1000000);
+
+static void BM_IterateSortedSet(benchmark::State& state) {
+  KeySortedSet set = MakeSet<KeySortedSet>(ShuffledKeys(state.range(0), "doc"));
+
+  for (auto _ : state) {
+    for (const DocumentKey& key : set) {
+      benchmark::DoNotOptimize(key);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_IterateSortedSet)->Arg(10000)->Arg(100000)->Arg(1000000);
+
+static void BM_IterateHashSet(benchmark::State& state) {
+  KeyHashSet set = MakeSet<KeyHashSet>(ShuffledKeys(state.range(0), "doc"));
+
+  for (auto _ : state) {
+    for (const DocumentKey& key : set) {
+      benchmark::DoNotOptimize(key);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_IterateHashSet)->Arg(10000)->Arg(100000)->Arg(1000000);
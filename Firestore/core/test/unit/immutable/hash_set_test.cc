@@ -0,0 +1,220 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/immutable/hash_set.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <random>
+#include <unordered_set>
+#include <vector>
+
+#include "Firestore/core/test/unit/immutable/testing.h"
+
+namespace firebase {
+namespace firestore {
+namespace immutable {
+
+namespace {
+
+/** Maps every key to one of four hashes, so that most keys fully collide. */
+struct CollidingHash {
+  size_t operator()(int key) const {
+    return static_cast<size_t>(key % 4);
+  }
+};
+
+/** Hashes keys that only differ in the high bits of their hashes. */
+struct HighBitsHash {
+  size_t operator()(int key) const {
+    return static_cast<size_t>(key) << (sizeof(size_t) * 8 - 8);
+  }
+};
+
+template <typename Set>
+std::vector<int> SortedKeys(const Set& set) {
+  std::vector<int> result{set.begin(), set.end()};
+  std::sort(result.begin(), result.end());
+  return result;
+}
+
+template <typename Set>
+Set ToSet(const std::vector<int>& keys) {
+  Set result;
+  for (int key : keys) {
+    result = result.insert(key);
+  }
+  return result;
+}
+
+}  // namespace
+
+TEST(HashSetTest, EmptyBehavior) {
+  HashSet<int> set;
+
+  EXPECT_TRUE(set.empty());
+  EXPECT_EQ(0u, set.size());
+  EXPECT_EQ(set.begin(), set.end());
+
+  EXPECT_TRUE(NotFound(set, 1));
+}
+
+TEST(HashSetTest, InsertAndErase) {
+  std::mt19937 rand;
+  std::uniform_int_distribution<int> dist(0, 999);
+
+  std::unordered_set<int> expected;
+  HashSet<int> set;
+  for (int i = 0; i < 1000; ++i) {
+    int value = dist(rand);
+    if (dist(rand) % 3 == 0) {
+      expected.erase(value);
+      set = set.erase(value);
+      EXPECT_TRUE(NotFound(set, value));
+    } else {
+      expected.insert(value);
+      set = set.insert(value);
+      EXPECT_TRUE(Found(set, value));
+    }
+    ASSERT_EQ(expected.size(), set.size());
+  }
+
+  std::vector<int> expected_keys{expected.begin(), expected.end()};
+  std::sort(expected_keys.begin(), expected_keys.end());
+  EXPECT_EQ(expected_keys, SortedKeys(set));
+}
+
+TEST(HashSetTest, InsertIsPersistent) {
+  HashSet<int> original = ToSet<HashSet<int>>(Sequence(100));
+  HashSet<int> modified = original.insert(100).erase(0);
+
+  EXPECT_EQ(Sequence(100), SortedKeys(original));
+  EXPECT_EQ(Sequence(1, 101), SortedKeys(modified));
+}
+
+TEST(HashSetTest, InsertingExistingKeyIsNoOp) {
+  HashSet<int> set{1, 2, 3};
+  HashSet<int> result = set.insert(2);
+
+  EXPECT_EQ(3u, result.size());
+  EXPECT_EQ(set, result);
+}
+
+TEST(HashSetTest, ErasingMissingKeyIsNoOp) {
+  HashSet<int> set{1, 2, 3};
+  HashSet<int> result = set.erase(4);
+
+  EXPECT_EQ(3u, result.size());
+  EXPECT_EQ(set, result);
+}
+
+TEST(HashSetTest, HandlesFullHashCollisions) {
+  using Set = HashSet<int, CollidingHash>;
+  Set set = ToSet<Set>(Sequence(50));
+
+  EXPECT_EQ(50u, set.size());
+  EXPECT_EQ(Sequence(50), SortedKeys(set));
+  for (int i = 0; i < 50; ++i) {
+    EXPECT_TRUE(Found(set, i));
+  }
+  EXPECT_TRUE(NotFound(set, 50));
+
+  for (int i = 0; i < 50; i += 2) {
+    set = set.erase(i);
+  }
+  EXPECT_EQ(Sequence(1, 50, 2), SortedKeys(set));
+  EXPECT_TRUE(NotFound(set, 0));
+}
+
+TEST(HashSetTest, HandlesPartialHashCollisions) {
+  using Set = HashSet<int, HighBitsHash>;
+  Set set = ToSet<Set>(Sequence(256));
+
+  EXPECT_EQ(Sequence(256), SortedKeys(set));
+  for (int i = 0; i < 256; ++i) {
+    set = set.erase(i);
+    EXPECT_TRUE(NotFound(set, i));
+    EXPECT_EQ(static_cast<size_t>(255 - i), set.size());
+  }
+  EXPECT_TRUE(set.empty());
+}
+
+TEST(HashSetTest, Iterates) {
+  HashSet<int> set = ToSet<HashSet<int>>(Sequence(0, 10000, 3));
+
+  size_t count = 0;
+  for (auto it = set.begin(); it != set.end(); ++it) {
+    ++count;
+  }
+  EXPECT_EQ(set.size(), count);
+  EXPECT_EQ(Sequence(0, 10000, 3), SortedKeys(set));
+}
+
+TEST(HashSetTest, FindPositionsIteratorAtKey) {
+  HashSet<int> set = ToSet<HashSet<int>>(Sequence(1000));
+
+  // Iterating from a found key visits the rest of the set in order.
+  std::vector<int> all{set.begin(), set.end()};
+  for (size_t i = 0; i < all.size(); i += 97) {
+    std::vector<int> rest{set.find(all[i]), set.end()};
+    EXPECT_EQ(std::vector<int>(all.begin() + i, all.end()), rest);
+  }
+}
+
+TEST(HashSetTest, EqualityIgnoresHistory) {
+  HashSet<int> lhs = ToSet<HashSet<int>>(Sequence(500));
+  HashSet<int> rhs = ToSet<HashSet<int>>(Sequence(499, -1, -1));
+  EXPECT_EQ(lhs, rhs);
+
+  rhs = rhs.insert(1000).erase(1000);
+  EXPECT_EQ(lhs, rhs);
+
+  rhs = rhs.erase(250);
+  EXPECT_NE(lhs, rhs);
+
+  // Sets that reach the same keys through different edits iterate alike.
+  HashSet<int> shrunk = ToSet<HashSet<int>>(Sequence(1000));
+  for (int i = 500; i < 1000; ++i) {
+    shrunk = shrunk.erase(i);
+  }
+  EXPECT_EQ(std::vector<int>(lhs.begin(), lhs.end()),
+            std::vector<int>(shrunk.begin(), shrunk.end()));
+}
+
+TEST(HashSetTest, UnionWith) {
+  HashSet<int> lhs = ToSet<HashSet<int>>(Sequence(0, 100, 2));
+  HashSet<int> rhs = ToSet<HashSet<int>>(Sequence(0, 100, 3));
+
+  HashSet<int> result = lhs.union_with(rhs);
+  std::vector<int> expected;
+  for (int i = 0; i < 100; ++i) {
+    if (i % 2 == 0 || i % 3 == 0) expected.push_back(i);
+  }
+  EXPECT_EQ(expected, SortedKeys(result));
+  EXPECT_EQ(result, rhs.union_with(lhs));
+
+  EXPECT_EQ(lhs, lhs.union_with(HashSet<int>{}));
+  EXPECT_EQ(lhs, HashSet<int>{}.union_with(lhs));
+}
+
+TEST(HashSetTest, FromKeysOf) {
+  std::vector<int> keys = Sequence(0, 300, 7);
+  EXPECT_EQ(keys, SortedKeys(HashSet<int>::FromKeysOf(keys)));
+}
+
+}  // namespace immutable
+}  // namespace firestore
+}  // namespace firebase
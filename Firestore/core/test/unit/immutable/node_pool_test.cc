@@ -0,0 +1,94 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/immutable/node_pool.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "Firestore/core/src/immutable/tree_sorted_map.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace immutable {
+namespace impl {
+
+using Pool = NodePool<48, alignof(std::max_align_t)>;
+
+TEST(NodePoolTest, ReturnsAlignedDistinctBlocks) {
+  std::vector<void*> blocks;
+  for (int i = 0; i < 100; ++i) {
+    void* block = Pool::Allocate();
+    EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(block) %
+                      alignof(std::max_align_t));
+    std::memset(block, i, 48);
+    blocks.push_back(block);
+  }
+
+  for (size_t i = 0; i < blocks.size(); ++i) {
+    auto bytes = static_cast<unsigned char*>(blocks[i]);
+    EXPECT_EQ(static_cast<unsigned char>(i), bytes[47]);
+  }
+
+  for (void* block : blocks) {
+    Pool::Deallocate(block);
+  }
+}
+
+TEST(NodePoolTest, ReusesFreedBlocks) {
+  void* block = Pool::Allocate();
+  Pool::Deallocate(block);
+  EXPECT_EQ(block, Pool::Allocate());
+  Pool::Deallocate(block);
+}
+
+TEST(NodePoolTest, FreesBlocksFromOtherThreads) {
+  std::vector<void*> blocks;
+  for (int i = 0; i < 100; ++i) {
+    blocks.push_back(Pool::Allocate());
+  }
+
+  std::thread other{[&] {
+    for (void* block : blocks) {
+      Pool::Deallocate(block);
+    }
+  }};
+  other.join();
+}
+
+TEST(NodePoolTest, TreesOutliveTheirThread) {
+  TreeSortedMap<int, int> map;
+  std::thread other{[&] {
+    for (int i = 0; i < 1000; ++i) {
+      map = map.insert(i, i);
+    }
+  }};
+  other.join();
+
+  for (int i = 0; i < 1000; i += 2) {
+    map = map.erase(i);
+  }
+  EXPECT_EQ(500u, map.size());
+}
+
+}  // namespace impl
+}  // namespace immutable
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,205 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/immutable/ref_count.h"
+#include "Firestore/core/src/immutable/sorted_map.h"
+#include "Firestore/core/src/immutable/sorted_set.h"
+#include "Firestore/core/src/util/comparison.h"
+#include "benchmark/benchmark.h"
+
+using firebase::firestore::immutable::AtomicRefCount;
+using firebase::firestore::immutable::SortedMap;
+using firebase::firestore::immutable::SortedSet;
+using firebase::firestore::immutable::ThreadConfinedRefCount;
+using firebase::firestore::util::Comparator;
+
+namespace {
+
+using IntMap = SortedMap<int, int>;
+using IntSet = SortedSet<int>;
+
+std::vector<std::pair<int, int>> SortedPairs(int64_t size) {
+  std::vector<std::pair<int, int>> result;
+  for (int i = 0; i < size; ++i) {
+    result.emplace_back(i, i);
+  }
+  return result;
+}
+
+/** Returns `size` distinct keys in random order. */
+std::vector<int> ShuffledKeys(int64_t size) {
+  std::vector<int> keys;
+  for (int i = 0; i < size; ++i) {
+    keys.push_back(i);
+  }
+  std::shuffle(keys.begin(), keys.end(), std::mt19937{});
+  return keys;
+}
+
+/** Creates a set of `size` keys, spaced `step` apart. */
+IntSet MakeSet(int64_t size, int step) {
+  std::vector<int> keys;
+  for (int i = 0; i < size; ++i) {
+    keys.push_back(i * step);
+  }
+  return IntSet::FromSortedRange(keys.begin(), keys.end());
+}
+
+}  // namespace
+
+static void BM_BuildByInsert(benchmark::State& state) {
+  std::vector<std::pair<int, int>> pairs = SortedPairs(state.range(0));
+
+  for (auto _ : state) {
+    IntMap map;
+    for (const auto& pair : pairs) {
+      map = map.insert(pair.first, pair.second);
+    }
+    benchmark::DoNotOptimize(map);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_BuildByInsert)->Range(16, 1 << 16);
+
+static void BM_BuildFromSortedRange(benchmark::State& state) {
+  std::vector<std::pair<int, int>> pairs = SortedPairs(state.range(0));
+
+  for (auto _ : state) {
+    IntMap map = IntMap::FromSortedRange(pairs.begin(), pairs.end());
+    benchmark::DoNotOptimize(map);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_BuildFromSortedRange)->Range(16, 1 << 16);
+
+static void BM_SelectByIteration(benchmark::State& state) {
+  std::vector<std::pair<int, int>> pairs = SortedPairs(state.range(0));
+  IntMap map = IntMap::FromSortedRange(pairs.begin(), pairs.end());
+  auto index = static_cast<std::ptrdiff_t>(map.size() / 2);
+
+  for (auto _ : state) {
+    auto it = map.begin();
+    std::advance(it, index);
+    benchmark::DoNotOptimize(*it);
+  }
+}
+BENCHMARK(BM_SelectByIteration)->Range(16, 1 << 16);
+
+static void BM_SelectByRank(benchmark::State& state) {
+  std::vector<std::pair<int, int>> pairs = SortedPairs(state.range(0));
+  IntMap map = IntMap::FromSortedRange(pairs.begin(), pairs.end());
+  IntMap::size_type index = map.size() / 2;
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(map.at(index));
+  }
+}
+BENCHMARK(BM_SelectByRank)->Range(16, 1 << 16);
+
+/**
+ * Unions a set of `range(0)` keys with one of `range(1)` keys, half of which
+ * are also in the first set.
+ */
+static void BM_UnionWith(benchmark::State& state) {
+  IntSet lhs = MakeSet(state.range(0), 2);
+  IntSet rhs = MakeSet(state.range(1), 1);
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(lhs.union_with(rhs));
+  }
+}
+BENCHMARK(BM_UnionWith)
+    ->Args({10000, 10})
+    ->Args({10000, 1000})
+    ->Args({10000, 10000})
+    ->Args({100000, 100000});
+
+/** Removes a set of `range(1)` keys from one of `range(0)` keys. */
+static void BM_Difference(benchmark::State& state) {
+  IntSet lhs = MakeSet(state.range(0), 1);
+  IntSet rhs = MakeSet(state.range(1), 2);
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(lhs.difference(rhs));
+  }
+}
+BENCHMARK(BM_Difference)
+    ->Args({10000, 10})
+    ->Args({10000, 1000})
+    ->Args({10000, 5000})
+    ->Args({100000, 50000});
+
+/**
+ * Inserts and then erases random keys into a map that holds `range(0)` keys
+ * in between.
+ */
+template <typename R>
+void BM_InsertErase(benchmark::State& state) {
+  using Map = SortedMap<int, int, Comparator<int>, R>;
+
+  std::vector<std::pair<int, int>> pairs;
+  for (int i = 0; i < state.range(0); ++i) {
+    pairs.emplace_back(i * 2, i);
+  }
+  Map map = Map::FromSortedRange(pairs.begin(), pairs.end());
+  std::vector<int> keys = ShuffledKeys(state.range(0));
+
+  size_t next = 0;
+  for (auto _ : state) {
+    int key = keys[next] * 2 + 1;
+    next = (next + 1) % keys.size();
+    map = map.insert(key, key);
+    map = map.erase(key);
+  }
+  state.SetItemsProcessed(state.iterations() * 2);
+}
+BENCHMARK_TEMPLATE(BM_InsertErase, AtomicRefCount)->Range(64, 1 << 16);
+BENCHMARK_TEMPLATE(BM_InsertErase, ThreadConfinedRefCount)
+    ->Range(64, 1 << 16);
+
+/**
+ * Inserts random keys into a map while keeping the last few versions of the
+ * map alive, like views that hold on to snapshots of their documents.
+ */
+template <typename R>
+void BM_InsertWithSnapshots(benchmark::State& state) {
+  using Map = SortedMap<int, int, Comparator<int>, R>;
+
+  std::vector<int> keys = ShuffledKeys(state.range(0));
+  for (auto _ : state) {
+    std::array<Map, 8> snapshots;
+    Map map;
+    for (size_t i = 0; i < keys.size(); ++i) {
+      map = map.insert(keys[i], keys[i]);
+      snapshots[i % snapshots.size()] = map;
+    }
+    benchmark::DoNotOptimize(map);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK_TEMPLATE(BM_InsertWithSnapshots, AtomicRefCount)
+    ->Range(64, 1 << 16);
+BENCHMARK_TEMPLATE(BM_InsertWithSnapshots, ThreadConfinedRefCount)
+    ->Range(64, 1 << 16);
@@ -30,6 +30,7 @@
 #include <utility>
 
 #include "Firestore/core/src/immutable/array_sorted_map.h"
+#include "Firestore/core/src/immutable/ref_count.h"
 #include "Firestore/core/src/immutable/tree_sorted_map.h"
 #include "Firestore/core/src/util/secure_random.h"
 #include "Firestore/core/test/unit/immutable/testing.h"
@@ -65,9 +66,11 @@ class SortedMapTest : public ::testing::Test {
 };
 
 // NOLINTNEXTLINE: must be a typedef for the gtest macros
-typedef ::testing::Types<SortedMap<int, int>,
-                         impl::ArraySortedMap<int, int>,
-                         impl::TreeSortedMap<int, int>>
+typedef ::testing::Types<
+    SortedMap<int, int>,
+    SortedMap<int, int, util::Comparator<int>, ThreadConfinedRefCount>,
+    impl::ArraySortedMap<int, int>,
+    impl::TreeSortedMap<int, int>>
     TestedTypes;
 TYPED_TEST_SUITE(SortedMapTest, TestedTypes);
 
@@ -267,6 +270,26 @@ TYPED_TEST(SortedMapTest, FindIndex) {
   ASSERT_EQ(5u, map.find_index(50));
 }
 
+TYPED_TEST(SortedMapTest, At) {
+  std::vector<int> to_insert = Sequence(0, this->large_number() * 2, 2);
+  TypeParam map = ToMap<TypeParam>(Shuffled(to_insert));
+
+  for (SizeType i = 0; i < map.size(); ++i) {
+    ASSERT_EQ(to_insert[i], map.at(i).first);
+    ASSERT_EQ(i, map.find_index(map.at(i).first));
+  }
+}
+
+TYPED_TEST(SortedMapTest, FromSortedRange) {
+  for (int size = 0; size <= this->large_number(); ++size) {
+    std::vector<std::pair<int, int>> pairs = Pairs(Sequence(size));
+    TypeParam map = TypeParam::FromSortedRange(pairs.begin(), pairs.end(), {});
+
+    ASSERT_EQ(static_cast<SizeType>(size), map.size());
+    ASSERT_SEQ_EQ(pairs, map);
+  }
+}
+
 TYPED_TEST(SortedMapTest, MinMax) {
   TypeParam empty;
   auto min = empty.min();
@@ -16,8 +16,12 @@
 
 #include "Firestore/core/src/immutable/sorted_set.h"
 
+#include <algorithm>
+#include <iterator>
 #include <random>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include "Firestore/core/test/unit/immutable/testing.h"
 
@@ -154,6 +158,70 @@ TEST(SortedSetTest, ValuesIn) {
   ASSERT_SEQ_EQ(Seq(8, 14), set.values_in(7, 13));   // in between to in between
 }
 
+TEST(SortedSetTest, At) {
+  std::vector<int> all = Sequence(0, 200, 2);
+  SortedSet<int> set = ToSet(Shuffled(all));
+
+  for (SizeType i = 0; i < set.size(); ++i) {
+    ASSERT_EQ(all[i], set.at(i));
+    ASSERT_EQ(i, set.find_index(set.at(i)));
+  }
+}
+
+TEST(SortedSetTest, FromSortedRange) {
+  std::vector<int> all = Sequence(kLargeNumber);
+  SortedSet<int> set = SortedSet<int>::FromSortedRange(all.begin(), all.end());
+
+  ASSERT_SEQ_EQ(all, set);
+  ASSERT_EQ(ToSet(all), set);
+}
+
+TEST(SortedSetTest, FromKeysOf) {
+  std::vector<int> all = Sequence(kLargeNumber);
+  SortedMap<int, int> map;
+  for (int value : Shuffled(all)) {
+    map = map.insert(value, value);
+  }
+
+  ASSERT_SEQ_EQ(all, SortedSet<int>::FromKeysOf(map));
+}
+
+TEST(SortedSetTest, UnionWith) {
+  // Covers both merging similarly sized sets and inserting a few keys into a
+  // large one.
+  std::vector<std::pair<int, int>> sizes{{0, 0},   {0, 5},    {5, 5},
+                                         {3, 100}, {100, 50}, {1, 1000}};
+  for (const auto& size : sizes) {
+    std::vector<int> evens = Sequence(0, size.first * 2, 2);
+    std::vector<int> threes = Sequence(0, size.second * 3, 3);
+    SortedSet<int> lhs = ToSet(evens);
+    SortedSet<int> rhs = ToSet(threes);
+
+    std::vector<int> expected;
+    std::set_union(evens.begin(), evens.end(), threes.begin(), threes.end(),
+                   std::back_inserter(expected));
+    ASSERT_SEQ_EQ(expected, lhs.union_with(rhs));
+    ASSERT_SEQ_EQ(expected, rhs.union_with(lhs));
+  }
+}
+
+TEST(SortedSetTest, Difference) {
+  std::vector<std::pair<int, int>> sizes{{0, 0},    {0, 5},   {5, 0},
+                                         {100, 3},  {3, 100}, {100, 50},
+                                         {1000, 1}, {50, 1000}};
+  for (const auto& size : sizes) {
+    std::vector<int> evens = Sequence(0, size.first * 2, 2);
+    std::vector<int> threes = Sequence(0, size.second * 3, 3);
+    SortedSet<int> lhs = ToSet(evens);
+    SortedSet<int> rhs = ToSet(threes);
+
+    std::vector<int> expected;
+    std::set_difference(evens.begin(), evens.end(), threes.begin(),
+                        threes.end(), std::back_inserter(expected));
+    ASSERT_SEQ_EQ(expected, lhs.difference(rhs));
+  }
+}
+
 TEST(SortedSetTest, HashesStdHashable) {
   SortedSet<int> set;
 
@@ -29,6 +29,32 @@ namespace impl {
 
 using IntMap = TreeSortedMap<int, int>;
 
+/**
+ * Returns the black height of the given tree, or -1 if the tree violates the
+ * invariants of a left-leaning red-black tree or has inconsistent sizes.
+ */
+int BlackHeight(const IntMap::node_type& node) {
+  if (node.empty()) {
+    return 0;
+  }
+  if (node.right().red()) {
+    return -1;
+  }
+  if (node.red() && node.left().red()) {
+    return -1;
+  }
+  if (node.size() != node.left().size() + node.right().size() + 1) {
+    return -1;
+  }
+
+  int left = BlackHeight(node.left());
+  int right = BlackHeight(node.right());
+  if (left < 0 || left != right) {
+    return -1;
+  }
+  return left + (node.red() ? 0 : 1);
+}
+
 TEST(TreeSortedMap, EmptySize) {
   IntMap map;
   EXPECT_TRUE(map.empty());
@@ -230,6 +256,33 @@ TEST(TreeSortedMap, InitializerIsSorted) {
   EXPECT_TRUE(std::is_sorted(map.begin(), map.end()));
 }
 
+TEST(TreeSortedMap, FromSortedRangeIsBalanced) {
+  for (int size = 0; size < 300; ++size) {
+    std::vector<IntMap::value_type> pairs = Pairs(Sequence(size));
+    IntMap map = IntMap::FromSortedRange(pairs.begin(), pairs.end(), {});
+
+    ASSERT_FALSE(map.root().red());
+    ASSERT_LE(0, BlackHeight(map.root())) << "size " << size;
+    ASSERT_EQ(static_cast<size_t>(size), map.size());
+    ASSERT_TRUE(std::equal(pairs.begin(), pairs.end(), map.begin()));
+  }
+}
+
+TEST(TreeSortedMap, FromSortedRangeSupportsInsertAndErase) {
+  std::vector<IntMap::value_type> pairs = Pairs(Sequence(0, 200, 2));
+  IntMap map = IntMap::FromSortedRange(pairs.begin(), pairs.end(), {});
+
+  for (int i = 1; i < 200; i += 2) {
+    map = map.insert(i, i);
+    ASSERT_LE(0, BlackHeight(map.root()));
+  }
+  for (int i = 0; i < 200; i += 3) {
+    map = map.erase(i);
+    ASSERT_LE(0, BlackHeight(map.root()));
+  }
+  EXPECT_EQ(133u, map.size());
+}
+
 }  // namespace impl
 }  // namespace immutable
 }  // namespace firestore
@@ -206,6 +206,19 @@ model::MutableDocumentMap WrappedRemoteDocumentCache::GetDocumentsMatchingQuery(
   return result;
 }
 
+model::MutableDocumentMap
+WrappedRemoteDocumentCache::GetDocumentsMatchingCollectionGroupQuery(
+    const core::Query& query,
+    const std::vector<model::ResourcePath>& collections,
+    const model::IndexOffset& offset,
+    absl::optional<QueryContext>& context,
+    const model::OverlayByDocumentKeyMap& mutated_docs) const {
+  auto result = subject_->GetDocumentsMatchingCollectionGroupQuery(
+      query, collections, offset, context, mutated_docs);
+  query_engine_->documents_read_by_query_ += result.size();
+  return result;
+}
+
 // MARK: - WrappedDocumentOverlayCache
 
 absl::optional<model::Overlay> WrappedDocumentOverlayCache::GetOverlay(
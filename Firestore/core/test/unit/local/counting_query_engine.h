@@ -209,6 +209,13 @@ class WrappedRemoteDocumentCache : public RemoteDocumentCache {
       absl::optional<size_t> limit,
       const model::OverlayByDocumentKeyMap& mutated_docs) const override;
 
+  model::MutableDocumentMap GetDocumentsMatchingCollectionGroupQuery(
+      const core::Query& query,
+      const std::vector<model::ResourcePath>& collections,
+      const model::IndexOffset& offset,
+      absl::optional<QueryContext>& context,
+      const model::OverlayByDocumentKeyMap& mutated_docs) const override;
+
   void SetIndexManager(IndexManager* manager) override {
     index_manager_ = NOT_NULL(manager);
   }
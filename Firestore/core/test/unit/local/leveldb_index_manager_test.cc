@@ -42,6 +42,7 @@ using testutil::Array;
 using testutil::CollectionGroupQuery;
 using testutil::DeletedDoc;
 using testutil::Doc;
+using testutil::Field;
 using testutil::Filter;
 using testutil::Key;
 using testutil::MakeFieldIndex;
@@ -887,6 +888,58 @@ TEST_F(LevelDbIndexManagerTest, LimitAppliesOrdering) {
   });
 }
 
+TEST_F(LevelDbIndexManagerTest, LimitMergesInFilterRangesInQueryOrder) {
+  persistence_->Run("TestLimitMergesInFilterRangesInQueryOrder", [&]() {
+    index_manager_->Start();
+    index_manager_->AddFieldIndex(
+        MakeFieldIndex("coll", "count", model::Segment::kAscending));
+    AddDoc("coll/a", Map("count", 3));
+    AddDoc("coll/b", Map("count", 1));
+    AddDoc("coll/c", Map("count", 2));
+    AddDoc("coll/d", Map("count", 3));
+    AddDoc("coll/e", Map("count", 4));
+
+    // Without a limit, each range is read in key order.
+    auto query =
+        Query("coll").AddingFilter(Filter("count", "in", Array(3, 1, 2, 1)));
+    VerifyResults(query, {"coll/b", "coll/c", "coll/a", "coll/d"});
+
+    // With a limit, the ranges are merged by document key and the scan stops
+    // at the limit.
+    VerifyResults(query.WithLimitToFirst(2), {"coll/a", "coll/b"});
+    VerifyResults(query.WithLimitToFirst(3), {"coll/a", "coll/b", "coll/c"});
+  });
+}
+
+TEST_F(LevelDbIndexManagerTest, LimitMergesArrayContainsAnyRanges) {
+  persistence_->Run("TestLimitMergesArrayContainsAnyRanges", [&]() {
+    index_manager_->Start();
+    SetUpArrayValueFilter();
+    AddDoc("coll/arr0", Map("values", Array(1, 4)));
+    auto query = Query("coll")
+                     .AddingFilter(Filter("values", "array-contains-any",
+                                          Array(1, 2, 4)))
+                     .WithLimitToFirst(2);
+    VerifyResults(query, {"coll/arr0", "coll/arr1"});
+  });
+}
+
+TEST_F(LevelDbIndexManagerTest, LimitDoesNotMergeRangesOrderedByInField) {
+  persistence_->Run("TestLimitDoesNotMergeRangesOrderedByInField", [&]() {
+    index_manager_->Start();
+    index_manager_->AddFieldIndex(
+        MakeFieldIndex("coll", "count", model::Segment::kAscending));
+    AddDoc("coll/a", Map("count", 3));
+    AddDoc("coll/b", Map("count", 1));
+    AddDoc("coll/c", Map("count", 2));
+    auto query = Query("coll")
+                     .AddingFilter(Filter("count", "in", Array(3, 1, 2)))
+                     .AddingOrderBy(OrderBy("count"))
+                     .WithLimitToFirst(2);
+    VerifyResults(query, {"coll/b", "coll/c", "coll/a"});
+  });
+}
+
 TEST_F(LevelDbIndexManagerTest, IndexEntriesAreUpdated) {
   persistence_->Run("TestIndexEntriesAreUpdated", [&]() {
     index_manager_->Start();
@@ -1653,6 +1706,46 @@ TEST_F(LevelDbIndexManagerTest,
       });
 }
 
+TEST_F(LevelDbIndexManagerTest, CoveringIndexStoresCoveredValues) {
+  persistence_->Run("TestCoveringIndexStoresCoveredValues", [&]() {
+    index_manager_->Start();
+    index_manager_->AddFieldIndex(FieldIndex(
+        FieldIndex::UnknownId(), "coll",
+        {Segment(Field("count"), Segment::kAscending)},
+        FieldIndex::InitialState(), {Field("title")}));
+    AddDoc("coll/a", Map("count", 1, "title", "a", "body", "long"));
+    AddDoc("coll/b", Map("count", 2, "title", "b", "body", "long"));
+
+    // Changing only a covered field rewrites the stored values.
+    AddDoc("coll/b", Map("count", 2, "title", "b2", "body", "long"));
+
+    auto query = Query("coll").AddingFilter(Filter("count", ">=", 1));
+    auto documents = index_manager_->GetCoveredDocumentsMatchingTarget(
+        query.ToTarget(), {Field("title")});
+    ASSERT_TRUE(documents.has_value());
+    ASSERT_EQ(documents->size(), 2u);
+    EXPECT_EQ((*documents)[0].key(), Key("coll/a"));
+    EXPECT_EQ((*documents)[1].key(), Key("coll/b"));
+    EXPECT_EQ(*(*documents)[1].field(Field("title")), *testutil::Value("b2"));
+    EXPECT_FALSE((*documents)[1].field(Field("body")).has_value());
+
+    // Fields that are not covered require the documents.
+    EXPECT_FALSE(index_manager_
+                     ->GetCoveredDocumentsMatchingTarget(query.ToTarget(),
+                                                         {Field("body")})
+                     .has_value());
+
+    // Covered fields survive a restart.
+    IndexManager* index_manager =
+        persistence_->GetIndexManager(User::Unauthenticated());
+    index_manager->Start();
+    std::vector<FieldIndex> indexes = index_manager->GetFieldIndexes("coll");
+    ASSERT_EQ(indexes.size(), 1u);
+    EXPECT_EQ(indexes[0].covered_fields(),
+              std::vector<model::FieldPath>{Field("title")});
+  });
+}
+
 }  // namespace local
 }  // namespace firestore
 }  // namespace firebase
@@ -1196,6 +1196,39 @@ TEST(LevelDbDataMigrationKeyTest, Encode) {
   EXPECT_EQ(decoded_key.migration_name(), "animal_migration");
 }
 
+TEST(LevelDbFieldNameKeyTest, Prefixing) {
+  const std::string table_key = LevelDbFieldNameKey::KeyPrefix();
+  const std::string group_key = LevelDbFieldNameKey::KeyPrefix("coll");
+
+  ASSERT_TRUE(absl::StartsWith(group_key, table_key));
+  ASSERT_TRUE(absl::StartsWith(LevelDbFieldNameKey::Key("coll", 1), group_key));
+  ASSERT_FALSE(
+      absl::StartsWith(LevelDbFieldNameKey::Key("coll2", 1), group_key));
+}
+
+TEST(LevelDbFieldNameKeyTest, Ordering) {
+  ASSERT_LT(LevelDbFieldNameKey::Key("coll", 1),
+            LevelDbFieldNameKey::Key("coll", 2));
+  ASSERT_LT(LevelDbFieldNameKey::Key("coll", 2),
+            LevelDbFieldNameKey::Key("coll", 10));
+  ASSERT_LT(LevelDbFieldNameKey::Key("coll", 10),
+            LevelDbFieldNameKey::Key("coll2", 0));
+}
+
+TEST(LevelDbFieldNameKeyTest, EncodeDecodeCycle) {
+  const std::string encoded_key = LevelDbFieldNameKey::Key("coll", 42);
+  LevelDbFieldNameKey decoded_key;
+  ASSERT_TRUE(decoded_key.Decode(encoded_key));
+  EXPECT_EQ(decoded_key.collection_group(), "coll");
+  EXPECT_EQ(decoded_key.field_name_id(), 42);
+}
+
+TEST(LevelDbFieldNameKeyTest, Description) {
+  AssertExpectedKeyDescription(
+      "[field_names: collection_group=coll field_name_id=42]",
+      LevelDbFieldNameKey::Key("coll", 42));
+}
+
 #undef AssertExpectedKeyDescription
 
 }  // namespace local
@@ -14,9 +14,21 @@
  * limitations under the License.
  */
 
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <utility>
+#include <vector>
+
 #include "Firestore/core/src/core/filter.h"
 #include "Firestore/core/src/core/query.h"
+#include "Firestore/core/src/credentials/user.h"
 #include "Firestore/core/src/local/leveldb_persistence.h"
+#include "Firestore/core/src/local/local_store.h"
+#include "Firestore/core/src/local/local_write_result.h"
+#include "Firestore/core/src/local/query_engine.h"
+#include "Firestore/core/src/local/query_result.h"
 #include "Firestore/core/src/model/delete_mutation.h"
 #include "Firestore/core/src/model/field_index.h"
 #include "Firestore/core/src/model/set_mutation.h"
@@ -69,6 +81,19 @@ std::unique_ptr<LocalStoreTestHelper> Factory() {
   return absl::make_unique<TestHelper>();
 }
 
+class GroupCommitTestHelper : public TestHelper {
+ public:
+  std::unique_ptr<Persistence> MakePersistence() override {
+    auto persistence = LevelDbPersistenceForTesting();
+    persistence->EnableGroupCommit(WriteDurability::kAsync);
+    return std::move(persistence);
+  }
+};
+
+std::unique_ptr<LocalStoreTestHelper> GroupCommitFactory() {
+  return absl::make_unique<GroupCommitTestHelper>();
+}
+
 // This lambda function takes a rvalue vector as parameter,
 // then coverts it to a sorted set based on the compare function.
 auto convertToSet = [](std::vector<FieldIndex>&& vec) {
@@ -85,6 +110,10 @@ INSTANTIATE_TEST_SUITE_P(LevelDbLocalStoreTest,
                          LocalStoreTest,
                          ::testing::Values(Factory));
 
+INSTANTIATE_TEST_SUITE_P(LevelDbGroupCommitLocalStoreTest,
+                         LocalStoreTest,
+                         ::testing::Values(GroupCommitFactory));
+
 class LevelDbLocalStoreTest : public LocalStoreTestBase {
  public:
   LevelDbLocalStoreTest()
@@ -801,6 +830,119 @@ TEST_F(LevelDbLocalStoreTest,
   FSTAssertQueryReturned("coll/a", "coll/e");
 }
 
+TEST_F(LevelDbLocalStoreTest, SnapshotQueriesMatchQueries) {
+  core::Query query = testutil::Query("foo");
+  AllocateQuery(query);
+  FSTAssertTargetID(2);
+
+  ApplyRemoteEvent(
+      UpdateRemoteEvent(Doc("foo/baz", 10, Map("a", "b")), {2}, {}));
+  local_store_.WriteLocally({SetMutation("foo/bonk", Map("a", "b"))});
+
+  QueryResult expected = ExecuteQuery(query);
+  QueryResult actual = local_store_.ExecuteQueryFromSnapshot(query);
+  using Entries = std::vector<std::pair<DocumentKey, model::Document>>;
+  ASSERT_EQ(Entries(expected.documents().begin(), expected.documents().end()),
+            Entries(actual.documents().begin(), actual.documents().end()));
+  ASSERT_EQ(expected.remote_keys(), actual.remote_keys());
+
+  ASSERT_EQ(local_store_.ReadDocument(Key("foo/bonk")),
+            local_store_.ReadDocumentFromSnapshot(Key("foo/bonk")));
+}
+
+TEST(LevelDbLocalStoreConcurrencyTest, SnapshotReadsSeeWholeBatches) {
+  // Uses a plain QueryEngine: the counting one used by the fixtures above is
+  // not thread-safe.
+  std::unique_ptr<Persistence> persistence = LevelDbPersistenceForTesting();
+  ASSERT_TRUE(persistence->SupportsConcurrentReads());
+  QueryEngine query_engine;
+  LocalStore local_store(persistence.get(), &query_engine,
+                         credentials::User::Unauthenticated());
+  local_store.Start();
+
+  constexpr int kBatches = 50;
+  core::Query query = testutil::Query("foo");
+  std::atomic<bool> done{false};
+
+  // Every batch writes two documents, so a consistent read never observes an
+  // odd number of them, and never fewer than a previous read did.
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 2; ++i) {
+    readers.emplace_back([&] {
+      size_t last_size = 0;
+      while (!done) {
+        size_t size =
+            local_store.ExecuteQueryFromSnapshot(query).documents().size();
+        EXPECT_EQ(0u, size % 2);
+        EXPECT_LE(last_size, size);
+        last_size = size;
+      }
+    });
+  }
+
+  for (int i = 0; i < kBatches; ++i) {
+    std::string suffix = std::to_string(i);
+    local_store.WriteLocally({SetMutation("foo/a" + suffix, Map("i", i)),
+                              SetMutation("foo/b" + suffix, Map("i", i))});
+  }
+  done = true;
+  for (std::thread& reader : readers) {
+    reader.join();
+  }
+
+  ASSERT_EQ(2u * kBatches,
+            local_store.ExecuteQueryFromSnapshot(query).documents().size());
+  ASSERT_TRUE(
+      local_store.ReadDocumentFromSnapshot(Key("foo/a0"))->is_found_document());
+}
+
+TEST(LevelDbLocalStoreConcurrencyTest, SnapshotQueriesDecodeRemoteDocuments) {
+  std::unique_ptr<LevelDbPersistence> persistence =
+      LevelDbPersistenceForTesting();
+  persistence->SetFieldNameDictionaryEnabled(true);
+  QueryEngine query_engine;
+  LocalStore local_store(persistence.get(), &query_engine,
+                         credentials::User::Unauthenticated());
+  local_store.Start();
+
+  constexpr int kDocuments = 50;
+  core::Query query = testutil::Query("foo");
+  model::TargetId target_id =
+      local_store.AllocateTarget(query.ToTarget()).target_id();
+  std::atomic<bool> done{false};
+
+  // The remote documents are decoded by background tasks while remote events
+  // are written, which must not touch the writer's transaction.
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 2; ++i) {
+    readers.emplace_back([&] {
+      size_t last_size = 0;
+      while (!done) {
+        model::DocumentMap documents =
+            local_store.ExecuteQueryFromSnapshot(query).documents();
+        for (const auto& entry : documents) {
+          EXPECT_TRUE(entry.second->field(Field("i")).has_value());
+        }
+        EXPECT_LE(last_size, documents.size());
+        last_size = documents.size();
+      }
+    });
+  }
+
+  for (int i = 0; i < kDocuments; ++i) {
+    local_store.ApplyRemoteEvent(UpdateRemoteEvent(
+        Doc("foo/a" + std::to_string(i), 10 + i, Map("i", i)), {target_id},
+        {}));
+  }
+  done = true;
+  for (std::thread& reader : readers) {
+    reader.join();
+  }
+
+  ASSERT_EQ(static_cast<size_t>(kDocuments),
+            local_store.ExecuteQueryFromSnapshot(query).documents().size());
+}
+
 }  // namespace local
 }  // namespace firestore
 }  // namespace firebase
@@ -40,6 +40,7 @@ using testutil::AndFilters;
 using testutil::Array;
 using testutil::Doc;
 using testutil::DocSet;
+using testutil::Field;
 using testutil::Filter;
 using testutil::MakeFieldIndex;
 using testutil::Map;
@@ -638,6 +639,61 @@ TEST_F(LevelDbQueryEngineTest, OrderByEquality) {
   });
 }
 
+TEST_F(LevelDbQueryEngineTest, ProjectsQueriesFromCoveringIndexes) {
+  persistence_->Run("ProjectsQueriesFromCoveringIndexes", [&] {
+    mutation_queue_->Start();
+    index_manager_->Start();
+
+    auto doc1 = Doc("coll/1", 1, Map("a", 1, "title", "one", "body", "..."));
+    auto doc2 = Doc("coll/2", 1, Map("a", 1, "title", "two", "body", "..."));
+    auto doc3 = Doc("coll/3", 1, Map("a", 1, "title", "three", "body", "..."));
+    auto doc4 = Doc("coll/4", 1, Map("a", 2, "title", "four", "body", "..."));
+    auto other = Doc("other/x/coll/6", 1, Map("a", 1, "title", "six"));
+    AddDocuments({doc1, doc2, doc3, doc4, other});
+
+    index_manager_->AddFieldIndex(model::FieldIndex(
+        model::FieldIndex::UnknownId(), "coll",
+        {model::Segment(Field("a"), model::Segment::kAscending)},
+        model::FieldIndex::InitialState(), {Field("title")}));
+    index_manager_->UpdateIndexEntries(
+        DocumentMap({doc1, doc2, doc3, doc4, other}));
+    index_manager_->UpdateCollectionGroup(
+        "coll", model::IndexOffset::FromDocument(other));
+
+    // Changes after the index offset are read from the documents.
+    auto doc2_changed =
+        Doc("coll/2", 2, Map("a", 1, "title", "two!", "body", "..."));
+    auto doc5 = Doc("coll/5", 3, Map("a", 1, "title", "five", "body", "..."));
+    auto doc3_deleted = testutil::DeletedDoc("coll/3", 4);
+    AddDocuments({doc2_changed, doc5, doc3_deleted});
+    AddMutation(PatchMutation("coll/1", Map("title", "one!")));
+
+    core::Query query = Query("coll").AddingFilter(Filter("a", "==", 1));
+    absl::optional<model::DocumentMap> results =
+        query_engine_.GetProjectedDocumentsMatchingQuery(query,
+                                                         {Field("title")});
+    ASSERT_TRUE(results.has_value());
+    ASSERT_EQ(results->size(), 3u);
+    EXPECT_TRUE(results->find(testutil::Key("coll/3")) == results->end());
+
+    auto get = [&](const std::string& path) {
+      auto it = results->find(testutil::Key(path));
+      EXPECT_TRUE(it != results->end());
+      EXPECT_FALSE(it->second->field(Field("body")).has_value());
+      return it->second;
+    };
+    EXPECT_EQ(*get("coll/1")->field(Field("title")), *testutil::Value("one!"));
+    EXPECT_EQ(*get("coll/2")->field(Field("title")), *testutil::Value("two!"));
+    EXPECT_EQ(*get("coll/5")->field(Field("title")), *testutil::Value("five"));
+    EXPECT_TRUE(get("coll/1")->has_local_mutations());
+
+    // Queries that need fields the index does not cover are not projected.
+    EXPECT_FALSE(
+        query_engine_.GetProjectedDocumentsMatchingQuery(query, {Field("body")})
+            .has_value());
+  });
+}
+
 }  // namespace local
 }  // namespace firestore
 }  // namespace firebase
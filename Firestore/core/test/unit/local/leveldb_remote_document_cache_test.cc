@@ -18,12 +18,17 @@
 #include <memory>
 #include <string>
 
+#include "Firestore/core/src/local/leveldb_key.h"
 #include "Firestore/core/src/local/leveldb_persistence.h"
+#include "Firestore/core/src/local/leveldb_remote_document_cache.h"
 #include "Firestore/core/src/local/remote_document_cache.h"
+#include "Firestore/core/src/model/mutable_document.h"
 #include "Firestore/core/src/util/ordered_code.h"
 #include "Firestore/core/test/unit/local/persistence_testing.h"
 #include "Firestore/core/test/unit/local/remote_document_cache_test.h"
+#include "Firestore/core/test/unit/testutil/testutil.h"
 #include "absl/memory/memory.h"
+#include "gtest/gtest.h"
 #include "leveldb/db.h"
 
 namespace firebase {
@@ -31,7 +36,12 @@ namespace firestore {
 namespace local {
 namespace {
 
+using leveldb::ReadOptions;
 using leveldb::WriteOptions;
+using model::MutableDocument;
+using testutil::Doc;
+using testutil::Key;
+using testutil::Map;
 using util::OrderedCode;
 
 // A dummy document value, useful for testing code that's known to examine only
@@ -78,12 +88,83 @@ std::unique_ptr<Persistence> PersistenceFactory() {
   return persistence;
 }
 
+/** Returns the number of rows in the field name dictionary. */
+size_t CountFieldNameRows(LevelDbPersistence* db) {
+  std::string prefix = LevelDbFieldNameKey::KeyPrefix();
+  std::unique_ptr<leveldb::Iterator> it(db->ptr()->NewIterator(ReadOptions()));
+  size_t count = 0;
+  for (it->Seek(prefix); it->Valid() && it->key().starts_with(prefix);
+       it->Next()) {
+    ++count;
+  }
+  return count;
+}
+
+MutableDocument ReadDocument(LevelDbPersistence* db, absl::string_view path) {
+  return db->Run("ReadDocument", [&] {
+    return db->remote_document_cache()->Get(Key(path));
+  });
+}
+
+void WriteDocument(LevelDbPersistence* db, const MutableDocument& document) {
+  db->Run("WriteDocument", [&] {
+    db->remote_document_cache()->Add(document, document.version());
+  });
+}
+
 }  // namespace
 
 INSTANTIATE_TEST_SUITE_P(LevelDbRemoteDocumentCacheTest,
                          RemoteDocumentCacheTest,
                          testing::Values(PersistenceFactory));
 
+TEST(LevelDbRemoteDocumentCacheTest, EncodesFieldNamesOnlyWhenEnabled) {
+  auto db = LevelDbPersistenceForTesting();
+  MutableDocument doc = Doc("coll/a", 1, Map("field", "value"));
+
+  WriteDocument(db.get(), doc);
+  EXPECT_EQ(CountFieldNameRows(db.get()), 0);
+  EXPECT_NE(ReadDocument(db.get(), "coll/a").data().encoded_document(),
+            nullptr);
+
+  // Enabling the dictionary does not touch documents that are already stored.
+  db->SetFieldNameDictionaryEnabled(true);
+  MutableDocument stored = ReadDocument(db.get(), "coll/a");
+  EXPECT_EQ(stored, doc);
+  EXPECT_NE(stored.data().encoded_document(), nullptr);
+
+  // Documents are encoded once they are written again.
+  WriteDocument(db.get(), stored);
+  EXPECT_EQ(CountFieldNameRows(db.get()), 1);
+  stored = ReadDocument(db.get(), "coll/a");
+  EXPECT_EQ(stored, doc);
+  EXPECT_EQ(stored.data().encoded_document(), nullptr);
+}
+
+TEST(LevelDbRemoteDocumentCacheTest, DisablingRewritesEncodedDocuments) {
+  auto db = LevelDbPersistenceForTesting();
+  db->SetFieldNameDictionaryEnabled(true);
+
+  MutableDocument doc1 = Doc("coll/a", 1, Map("field", Map("nested", 1)));
+  MutableDocument doc2 = Doc("other/b", 2, Map("field", "value"));
+  MutableDocument missing = testutil::DeletedDoc("coll/c", 3);
+  WriteDocument(db.get(), doc1);
+  WriteDocument(db.get(), doc2);
+  WriteDocument(db.get(), missing);
+  EXPECT_EQ(CountFieldNameRows(db.get()), 3);
+
+  db->SetFieldNameDictionaryEnabled(false);
+  EXPECT_EQ(CountFieldNameRows(db.get()), 0);
+
+  MutableDocument stored1 = ReadDocument(db.get(), "coll/a");
+  MutableDocument stored2 = ReadDocument(db.get(), "other/b");
+  EXPECT_EQ(stored1, doc1);
+  EXPECT_EQ(stored2, doc2);
+  EXPECT_EQ(ReadDocument(db.get(), "coll/c"), missing);
+  EXPECT_NE(stored1.data().encoded_document(), nullptr);
+  EXPECT_NE(stored2.data().encoded_document(), nullptr);
+}
+
 }  // namespace local
 }  // namespace firestore
 }  // namespace firebase
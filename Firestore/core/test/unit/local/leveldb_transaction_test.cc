@@ -290,6 +290,81 @@ TEST_F(LevelDbTransactionTest, DeletingAheadOfAnIterator) {
   ASSERT_FALSE(it->Valid());
 }
 
+TEST_F(LevelDbTransactionTest, ReadOnlyTransactionReadsSnapshot) {
+  const WriteOptions& write_options = LevelDbTransaction::DefaultWriteOptions();
+  ASSERT_TRUE(db_->Put(write_options, "key_0", "value_0").ok());
+  ASSERT_TRUE(db_->Put(write_options, "key_1", "value_1").ok());
+
+  std::unique_ptr<LevelDbTransaction> transaction =
+      LevelDbTransaction::CreateReadOnly(db_.get(), "ReadOnly");
+  ASSERT_TRUE(transaction->read_only());
+
+  // Writes committed after the transaction started are not visible to it.
+  ASSERT_TRUE(db_->Put(write_options, "key_0", "new_value").ok());
+  ASSERT_TRUE(db_->Delete(write_options, "key_1").ok());
+  ASSERT_TRUE(db_->Put(write_options, "key_2", "value_2").ok());
+
+  std::string value;
+  ASSERT_TRUE(transaction->Get("key_0", &value).ok());
+  ASSERT_EQ("value_0", value);
+  ASSERT_TRUE(transaction->Get("key_1", &value).ok());
+  ASSERT_EQ("value_1", value);
+  ASSERT_TRUE(transaction->Get("key_2", &value).IsNotFound());
+
+  auto iter = transaction->NewIterator();
+  iter->Seek("");
+  ASSERT_EQ("key_0", iter->key());
+  iter->Next();
+  ASSERT_EQ("key_1", iter->key());
+  iter->Next();
+  ASSERT_FALSE(iter->Valid());
+
+  // A new transaction observes the writes.
+  LevelDbTransaction latest(db_.get(), "Latest");
+  ASSERT_TRUE(latest.Get("key_0", &value).ok());
+  ASSERT_EQ("new_value", value);
+  ASSERT_TRUE(latest.Get("key_1", &value).IsNotFound());
+}
+
+TEST_F(LevelDbTransactionTest, CountsRowsReadAndWritten) {
+  const WriteOptions& write_options = LevelDbTransaction::DefaultWriteOptions();
+  ASSERT_TRUE(db_->Put(write_options, "key_0", "value_0").ok());
+  ASSERT_TRUE(db_->Put(write_options, "key_1", "value_1").ok());
+
+  LevelDbTransaction transaction(db_.get(), "Counters");
+  transaction.EnableReadCounting();
+  std::string value;
+  ASSERT_TRUE(transaction.Get("key_0", &value).ok());
+  ASSERT_TRUE(transaction.Get("missing", &value).IsNotFound());
+
+  // Rows changed in the transaction are not read from leveldb.
+  transaction.Put("key_1", "new");
+  transaction.Put("key_2", "value_2");
+  transaction.Delete("key_0");
+  auto iter = transaction.NewIterator();
+  for (iter->Seek(""); iter->Valid(); iter->Next()) {
+  }
+
+  OperationCounters counters = transaction.counters();
+  ASSERT_EQ(1, counters.rows_read);
+  ASSERT_EQ(7, counters.bytes_read);
+  ASSERT_EQ(3, counters.rows_written);
+  ASSERT_EQ(10, counters.bytes_written);
+}
+
+TEST_F(LevelDbTransactionTest, DoesNotCountReadsUnlessEnabled) {
+  const WriteOptions& write_options = LevelDbTransaction::DefaultWriteOptions();
+  ASSERT_TRUE(db_->Put(write_options, "key_0", "value_0").ok());
+
+  LevelDbTransaction transaction(db_.get(), "Counters");
+  std::string value;
+  ASSERT_TRUE(transaction.Get("key_0", &value).ok());
+
+  OperationCounters counters = transaction.counters();
+  ASSERT_EQ(0, counters.rows_read);
+  ASSERT_EQ(0, counters.bytes_read);
+}
+
 TEST_F(LevelDbTransactionTest, ToString) {
   std::string key = LevelDbMutationKey::Key("user1", 42);
   Message<firestore_client_WriteBatch> message;
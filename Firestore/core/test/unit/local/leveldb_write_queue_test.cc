@@ -0,0 +1,224 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/local/leveldb_write_queue.h"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Firestore/core/src/local/leveldb_transaction.h"
+#include "Firestore/core/src/util/path.h"
+#include "Firestore/core/test/unit/local/persistence_testing.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/str_format.h"
+#include "gtest/gtest.h"
+#include "leveldb/db.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+using leveldb::DB;
+using leveldb::Options;
+using leveldb::Status;
+using util::Path;
+
+class LevelDbWriteQueueTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    Options options;
+    options.error_if_exists = true;
+    options.create_if_missing = true;
+
+    Path dir = LevelDbDir();
+    DB* db = nullptr;
+    Status status = DB::Open(options, dir.ToUtf8String(), &db);
+    ASSERT_TRUE(status.ok()) << "Failed to create db: "
+                             << status.ToString().c_str();
+    db_.reset(db);
+    queue_ = absl::make_unique<LevelDbWriteQueue>(db_.get(),
+                                                  WriteDurability::kAsync);
+  }
+
+  void TearDown() override {
+    queue_.reset();
+  }
+
+  void Commit(const std::vector<std::string>& puts,
+              const std::vector<std::string>& deletes) {
+    LevelDbTransaction transaction(db_.get(), "Commit");
+    transaction.ReadThrough(queue_->pending_writes());
+    for (const std::string& key : puts) {
+      transaction.Put(key, "value_" + key);
+    }
+    for (const std::string& key : deletes) {
+      transaction.Delete(key);
+    }
+    transaction.CommitTo(queue_.get());
+  }
+
+  std::vector<std::string> Keys(LevelDbTransaction* transaction) {
+    std::vector<std::string> result;
+    auto it = transaction->NewIterator();
+    for (it->Seek(""); it->Valid(); it->Next()) {
+      result.push_back(it->key());
+    }
+    return result;
+  }
+
+  std::unique_ptr<DB> db_;
+  std::unique_ptr<LevelDbWriteQueue> queue_;
+};
+
+TEST_F(LevelDbWriteQueueTest, CommittedChangesAreVisibleBeforeTheyAreWritten) {
+  ASSERT_TRUE(db_->Put(LevelDbTransaction::DefaultWriteOptions(), "b", "old")
+                  .ok());
+
+  // The commit may or may not have been written yet; readers observe it
+  // either way.
+  Commit({"a", "b"}, {});
+
+  LevelDbTransaction transaction(db_.get(), "Read");
+  transaction.ReadThrough(queue_->pending_writes());
+  std::string value;
+  ASSERT_TRUE(transaction.Get("b", &value).ok());
+  ASSERT_EQ("value_b", value);
+  ASSERT_EQ((std::vector<std::string>{"a", "b"}), Keys(&transaction));
+
+  queue_->Flush();
+  ASSERT_TRUE(queue_->pending_writes()->empty());
+  ASSERT_TRUE(
+      db_->Get(LevelDbTransaction::DefaultReadOptions(), "b", &value).ok());
+  ASSERT_EQ("value_b", value);
+}
+
+TEST_F(LevelDbWriteQueueTest, PendingDeletionsShadowRows) {
+  for (const char* key : {"a", "b", "c"}) {
+    ASSERT_TRUE(
+        db_->Put(LevelDbTransaction::DefaultWriteOptions(), key, key).ok());
+  }
+
+  auto pending = std::make_shared<const PendingWrites>(
+      PendingWrites{}
+          .insert("b", PendingWrite{1, absl::nullopt})
+          .insert("d", PendingWrite{1, std::string("d")}));
+  auto it = NewPendingWritesIterator(
+      pending, std::unique_ptr<leveldb::Iterator>(db_->NewIterator(
+                   LevelDbTransaction::DefaultReadOptions())));
+
+  std::vector<std::string> forward;
+  for (it->SeekToFirst(); it->Valid(); it->Next()) {
+    forward.push_back(it->key().ToString());
+  }
+  ASSERT_EQ((std::vector<std::string>{"a", "c", "d"}), forward);
+
+  std::vector<std::string> backward;
+  for (it->SeekToLast(); it->Valid(); it->Prev()) {
+    backward.push_back(it->key().ToString());
+  }
+  ASSERT_EQ((std::vector<std::string>{"d", "c", "a"}), backward);
+
+  // Moving forward again after Prev() resumes after the current entry.
+  it->Seek("c");
+  it->Prev();
+  ASSERT_EQ("a", it->key().ToString());
+  it->Next();
+  ASSERT_EQ("c", it->key().ToString());
+}
+
+TEST_F(LevelDbWriteQueueTest, IteratesManyPendingWrites) {
+  // Enough pending writes that the map switches to its tree representation.
+  constexpr int kKeys = 100;
+  PendingWrites pending;
+  std::vector<std::string> expected;
+  for (int i = 0; i < kKeys; ++i) {
+    std::string key = absl::StrFormat("key_%03d", i);
+    if (i % 2 == 0) {
+      pending = pending.insert(key, PendingWrite{1, key});
+      expected.push_back(key);
+    } else {
+      ASSERT_TRUE(
+          db_->Put(LevelDbTransaction::DefaultWriteOptions(), key, key).ok());
+      if (i % 3 == 0) {
+        pending = pending.insert(key, PendingWrite{1, absl::nullopt});
+      } else {
+        expected.push_back(key);
+      }
+    }
+  }
+  auto it = NewPendingWritesIterator(
+      std::make_shared<const PendingWrites>(std::move(pending)),
+      std::unique_ptr<leveldb::Iterator>(
+          db_->NewIterator(LevelDbTransaction::DefaultReadOptions())));
+
+  std::vector<std::string> forward;
+  for (it->SeekToFirst(); it->Valid(); it->Next()) {
+    forward.push_back(it->key().ToString());
+  }
+  ASSERT_EQ(expected, forward);
+
+  std::vector<std::string> backward;
+  for (it->SeekToLast(); it->Valid(); it->Prev()) {
+    backward.push_back(it->key().ToString());
+  }
+  std::reverse(expected.begin(), expected.end());
+  ASSERT_EQ(expected, backward);
+}
+
+TEST_F(LevelDbWriteQueueTest, LaterCommitsWin) {
+  Commit({"a", "b"}, {});
+  Commit({}, {"a"});
+  Commit({"c"}, {});
+
+  LevelDbTransaction transaction(db_.get(), "Read");
+  transaction.ReadThrough(queue_->pending_writes());
+  ASSERT_EQ((std::vector<std::string>{"b", "c"}), Keys(&transaction));
+
+  queue_->Flush();
+  LevelDbTransaction written(db_.get(), "Written");
+  ASSERT_EQ((std::vector<std::string>{"b", "c"}), Keys(&written));
+}
+
+TEST_F(LevelDbWriteQueueTest, ReadOnlyTransactionsSeePendingWrites) {
+  Commit({"a"}, {});
+  std::unique_ptr<LevelDbTransaction> snapshot =
+      queue_->CreateReadOnlyTransaction("Snapshot");
+  Commit({"b"}, {});
+  queue_->Flush();
+
+  ASSERT_EQ((std::vector<std::string>{"a"}), Keys(snapshot.get()));
+}
+
+TEST_F(LevelDbWriteQueueTest, GroupsCommits) {
+  constexpr int kCommits = 200;
+  for (int i = 0; i < kCommits; ++i) {
+    Commit({"key_" + std::to_string(i)}, {});
+  }
+  queue_->Flush();
+
+  LevelDbWriteQueue::Metrics metrics = queue_->metrics();
+  ASSERT_EQ(static_cast<uint64_t>(kCommits), metrics.commits);
+  ASSERT_GE(metrics.writes, 1u);
+  ASSERT_LE(metrics.writes, metrics.commits);
+  ASSERT_GE(metrics.max_commits_per_write * metrics.writes, metrics.commits);
+  ASSERT_LE(metrics.max_commit_latency, metrics.total_commit_latency);
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,119 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <memory>
+#include <string>
+
+#include "Firestore/core/src/core/query.h"
+#include "Firestore/core/src/credentials/user.h"
+#include "Firestore/core/src/local/leveldb_persistence.h"
+#include "Firestore/core/src/local/local_documents_view.h"
+#include "Firestore/core/src/local/memory_persistence.h"
+#include "Firestore/core/src/local/persistence.h"
+#include "Firestore/core/src/local/query_context.h"
+#include "Firestore/core/src/local/remote_document_cache.h"
+#include "Firestore/core/src/model/model_fwd.h"
+#include "Firestore/core/src/util/hard_assert.h"
+#include "Firestore/core/test/unit/local/persistence_testing.h"
+#include "Firestore/core/test/unit/testutil/testutil.h"
+#include "absl/types/optional.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+namespace {
+
+using credentials::User;
+using model::DocumentMap;
+using model::IndexOffset;
+using testutil::CollectionGroupQuery;
+using testutil::Doc;
+using testutil::Map;
+
+/** The number of documents stored in every `users/{uid}/events` collection. */
+constexpr int kEventsPerUser = 2;
+
+/**
+ * Stores `user_count` collections `users/{uid}/events` and runs a collection
+ * group query for `events` against them.
+ */
+void RunCollectionGroupQuery(benchmark::State& state,
+                             Persistence* persistence) {
+  User user = User::Unauthenticated();
+  RemoteDocumentCache* remote_documents =
+      persistence->remote_document_cache();
+  IndexManager* index_manager = persistence->GetIndexManager(user);
+  remote_documents->SetIndexManager(index_manager);
+  LocalDocumentsView view(remote_documents,
+                          persistence->GetMutationQueue(user, index_manager),
+                          persistence->GetDocumentOverlayCache(user),
+                          index_manager);
+
+  auto user_count = static_cast<int>(state.range(0));
+  persistence->Run("Populate", [&] {
+    for (int user_id = 0; user_id < user_count; ++user_id) {
+      for (int event = 0; event < kEventsPerUser; ++event) {
+        std::string path = "users/" + std::to_string(user_id) + "/events/" +
+                           std::to_string(event);
+        remote_documents->Add(
+            Doc(path, 1, Map("type", "click", "sequence", event)),
+            testutil::Version(1));
+      }
+    }
+  });
+
+  core::Query query = CollectionGroupQuery("events");
+  for (auto _ : state) {
+    DocumentMap results = persistence->Run("Query", [&] {
+      absl::optional<QueryContext> context;
+      return view.GetDocumentsMatchingQuery(query, IndexOffset::None(),
+                                            context);
+    });
+    HARD_ASSERT(results.size() ==
+                static_cast<size_t>(user_count * kEventsPerUser));
+    benchmark::DoNotOptimize(results);
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *
+                          user_count * kEventsPerUser);
+}
+
+void BM_CollectionGroupQueryLevelDb(benchmark::State& state) {
+  std::unique_ptr<LevelDbPersistence> persistence =
+      LevelDbPersistenceForTesting();
+  RunCollectionGroupQuery(state, persistence.get());
+}
+BENCHMARK(BM_CollectionGroupQueryLevelDb)
+    ->Arg(100)
+    ->Arg(1000)
+    ->Arg(10000)
+    ->Unit(benchmark::kMillisecond);
+
+void BM_CollectionGroupQueryMemory(benchmark::State& state) {
+  std::unique_ptr<MemoryPersistence> persistence =
+      MemoryPersistenceWithEagerGcForTesting();
+  RunCollectionGroupQuery(state, persistence.get());
+}
+BENCHMARK(BM_CollectionGroupQueryMemory)
+    ->Arg(100)
+    ->Arg(1000)
+    ->Arg(10000)
+    ->Unit(benchmark::kMillisecond);
+
+}  // namespace
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
@@ -16,6 +16,12 @@
 
 #include "Firestore/core/src/local/local_serializer.h"
 
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+
 #include "Firestore/Protos/cpp/firestore/bundle.pb.h"
 #include "Firestore/Protos/cpp/firestore/local/maybe_document.pb.h"
 #include "Firestore/Protos/cpp/firestore/local/mutation.pb.h"
@@ -25,6 +31,7 @@
 #include "Firestore/core/src/core/field_filter.h"
 #include "Firestore/core/src/core/query.h"
 #include "Firestore/core/src/core/target.h"
+#include "Firestore/core/src/local/field_name_dictionary.h"
 #include "Firestore/core/src/local/target_data.h"
 #include "Firestore/core/src/model/delete_mutation.h"
 #include "Firestore/core/src/model/field_mask.h"
@@ -87,6 +94,7 @@ using nanopb::ProtobufSerialize;
 using nanopb::SetRepeatedField;
 using nanopb::StringReader;
 using nanopb::Writer;
+using testutil::Array;
 using testutil::DeletedDoc;
 using testutil::Doc;
 using testutil::Field;
@@ -100,6 +108,45 @@ using testutil::Value;
 using testutil::WrapObject;
 using util::Status;
 
+/** A FieldNameDictionary that assigns ids in memory. */
+class TestFieldNameDictionary : public FieldNameDictionary {
+ public:
+  absl::optional<int32_t> GetOrAssignId(const std::string& collection_group,
+                                        absl::string_view field_name) override {
+    std::deque<std::string>& names = Table(collection_group)->names;
+    auto found = std::find(names.begin(), names.end(), field_name);
+    if (found != names.end()) {
+      return static_cast<int32_t>(found - names.begin());
+    }
+    names.emplace_back(field_name);
+    return static_cast<int32_t>(names.size() - 1);
+  }
+
+  std::shared_ptr<const model::FieldNameTable> GetFieldNames(
+      const std::string& collection_group) const override {
+    return Table(collection_group);
+  }
+
+ private:
+  struct TestFieldNameTable : public model::FieldNameTable {
+    const std::string* GetFieldName(int32_t field_name_id) const override {
+      if (field_name_id >= static_cast<int32_t>(names.size())) return nullptr;
+      return &names[field_name_id];
+    }
+
+    std::deque<std::string> names;
+  };
+
+  std::shared_ptr<TestFieldNameTable> Table(
+      const std::string& collection_group) const {
+    std::shared_ptr<TestFieldNameTable>& table = tables_[collection_group];
+    if (!table) table = std::make_shared<TestFieldNameTable>();
+    return table;
+  }
+
+  mutable std::map<std::string, std::shared_ptr<TestFieldNameTable>> tables_;
+};
+
 class LocalSerializerTest : public ::testing::Test {
  public:
   LocalSerializerTest()
@@ -461,6 +508,92 @@ TEST_F(LocalSerializerTest, EncodesUnknownDocumentAsMaybeDocument) {
   ExpectRoundTrip(unknown_doc, maybe_doc_proto);
 }
 
+TEST_F(LocalSerializerTest, DecodesMaybeDocumentLazily) {
+  MutableDocument doc =
+      Doc("some/path", /*version=*/42, Map("foo", "bar", "nested", Map("a", 1)))
+          .SetHasCommittedMutations();
+  std::string bytes = MakeStdString(serializer.EncodeMaybeDocument(doc));
+
+  util::ReadContext context;
+  MutableDocument decoded = serializer.DecodeMaybeDocument(&context, bytes);
+  EXPECT_OK(context.status());
+  ASSERT_NE(nullptr, decoded.data().encoded_document());
+  EXPECT_EQ(doc, decoded);
+
+  // Documents that retain their serialized form are written back as-is.
+  EXPECT_EQ(bytes, serializer.EncodeMaybeDocumentToString(decoded));
+
+  // Once modified, documents are encoded from their fields again.
+  decoded.data().Set(Field("foo"), Value("baz"));
+  EXPECT_EQ(nullptr, decoded.data().encoded_document());
+  EXPECT_EQ(MakeStdString(serializer.EncodeMaybeDocument(decoded)),
+            serializer.EncodeMaybeDocumentToString(decoded));
+}
+
+TEST_F(LocalSerializerTest, DecodesNoDocumentFromString) {
+  MutableDocument no_doc =
+      DeletedDoc("some/path", /*version=*/42).SetHasCommittedMutations();
+  std::string bytes = serializer.EncodeMaybeDocumentToString(no_doc);
+  EXPECT_EQ(MakeStdString(serializer.EncodeMaybeDocument(no_doc)), bytes);
+
+  util::ReadContext context;
+  MutableDocument decoded = serializer.DecodeMaybeDocument(&context, bytes);
+  EXPECT_OK(context.status());
+  EXPECT_EQ(no_doc, decoded);
+}
+
+TEST_F(LocalSerializerTest, FailsToDecodeMalformedMaybeDocument) {
+  util::ReadContext context;
+  serializer.DecodeMaybeDocument(&context, std::string("\x12\x05ab", 4));
+  EXPECT_FALSE(context.ok());
+}
+
+TEST_F(LocalSerializerTest, EncodesFieldNamesWithDictionary) {
+  MutableDocument doc =
+      Doc("coll/doc", /*version=*/42,
+          Map("repeated_field_name", Map("repeated_field_name", "foo"), "array",
+              Array(Map("repeated_field_name", 1), "bar"), "empty", Map()));
+  std::string plain = serializer.EncodeMaybeDocumentToString(doc);
+
+  TestFieldNameDictionary dictionary;
+  std::string encoded =
+      serializer.EncodeMaybeDocumentToString(doc, &dictionary);
+  EXPECT_LT(encoded.size(), plain.size());
+
+  util::ReadContext context;
+  MutableDocument decoded =
+      serializer.DecodeMaybeDocument(&context, encoded, &dictionary);
+  EXPECT_OK(context.status());
+  EXPECT_EQ(doc, decoded);
+
+  // Field name ids are resolved as fields are accessed, and decoded
+  // documents are written back with the same ids.
+  decoded = serializer.DecodeMaybeDocument(&context, encoded, &dictionary);
+  EXPECT_EQ(decoded.field(Field("repeated_field_name.repeated_field_name")),
+            *Value("foo"));
+  EXPECT_EQ(encoded,
+            serializer.EncodeMaybeDocumentToString(decoded, &dictionary));
+
+  // Without the dictionary, the fields are written in the regular format.
+  EXPECT_EQ(plain, serializer.EncodeMaybeDocumentToString(decoded));
+
+  // Documents written without a dictionary can be read with one.
+  decoded = serializer.DecodeMaybeDocument(&context, plain, &dictionary);
+  EXPECT_OK(context.status());
+  EXPECT_EQ(doc, decoded);
+}
+
+TEST_F(LocalSerializerTest, FailsToDecodeFieldNamesWithoutDictionary) {
+  MutableDocument doc = Doc("coll/doc", /*version=*/42, Map("foo", "bar"));
+  TestFieldNameDictionary dictionary;
+  std::string encoded =
+      serializer.EncodeMaybeDocumentToString(doc, &dictionary);
+
+  util::ReadContext context;
+  serializer.DecodeMaybeDocument(&context, encoded);
+  EXPECT_FALSE(context.ok());
+}
+
 TEST_F(LocalSerializerTest, EncodesTargetData) {
   core::Query query = Query("room");
   TargetId target_id = 42;
@@ -497,6 +630,29 @@ TEST_F(LocalSerializerTest, EncodesTargetData) {
   ExpectRoundTrip(target_data, expected);
 }
 
+TEST_F(LocalSerializerTest, EncodesTargetDefinitionAndCheckpointSeparately) {
+  TargetData target_data(
+      Query("room").AddingFilter(Filter("n", ">", 1)).ToTarget(),
+      /*target_id=*/42, /*sequence_number=*/10, QueryPurpose::Listen,
+      testutil::Version(1039), testutil::Version(1000),
+      testutil::ResumeToken(1039), /*expected_count=*/absl::nullopt);
+
+  std::string bytes =
+      MakeStdString(serializer.EncodeTargetDefinition(target_data)) +
+      MakeStdString(serializer.EncodeTargetCheckpoint(target_data));
+
+  auto actual = ProtobufParse<::firestore::client::Target>(ByteString(bytes));
+  auto expected = ProtobufParse<::firestore::client::Target>(
+      EncodeTargetData(&serializer, target_data));
+  EXPECT_TRUE(msg_diff.Compare(expected, actual)) << message_differences;
+
+  StringReader reader(bytes);
+  auto message = Message<firestore_client_Target>::TryParse(&reader);
+  TargetData decoded = serializer.DecodeTargetData(&reader, *message);
+  EXPECT_OK(reader.status());
+  EXPECT_EQ(target_data, decoded);
+}
+
 TEST_F(LocalSerializerTest, EncodesTargetDataWillDropExpectedCount) {
   core::Query query = Query("room");
   TargetId target_id = 42;
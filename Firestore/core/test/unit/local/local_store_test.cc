@@ -31,6 +31,7 @@
 #include "Firestore/core/src/local/local_write_result.h"
 #include "Firestore/core/src/local/persistence.h"
 #include "Firestore/core/src/local/query_result.h"
+#include "Firestore/core/src/local/target_cache.h"
 #include "Firestore/core/src/local/target_data.h"
 #include "Firestore/core/src/model/delete_mutation.h"
 #include "Firestore/core/src/model/document.h"
@@ -143,6 +144,28 @@ RemoteEvent NoChangeEvent(int target_id, int version) {
   return NoChangeEvent(target_id, version, testutil::ResumeToken(version));
 }
 
+/**
+ * Creates a remote event that adds a document at `path` to `target_id` and
+ * advances the target's resume token, both at `version`.
+ */
+RemoteEvent AddedRemoteEventWithResumeToken(const std::string& path,
+                                            int version,
+                                            TargetId target_id) {
+  MutableDocument doc = Doc(path, version, Map("a", "b"));
+  auto metadata_provider =
+      FakeTargetMetadataProvider::CreateEmptyResultProvider(
+          doc.key().path().PopLast(), {target_id});
+
+  WatchChangeAggregator aggregator{&metadata_provider};
+  aggregator.HandleDocumentChange(
+      DocumentWatchChange{{target_id}, {}, doc.key(), doc});
+  aggregator.HandleTargetChange(
+      WatchTargetChange{WatchTargetChangeState::NoChange,
+                        {target_id},
+                        testutil::ResumeToken(version)});
+  return aggregator.CreateRemoteEvent(testutil::Version(version));
+}
+
 /** Creates a remote event that inserts a list of documents. */
 RemoteEvent ExistenceFilterEvent(TargetId target_id,
                                  const DocumentKeySet& synced_keys,
@@ -976,6 +999,37 @@ TEST_P(LocalStoreTest, PersistsResumeTokens) {
   ASSERT_GT(new_sequence_number, initial_sequence_number);
 }
 
+TEST_P(LocalStoreTest, CheckpointsResumeTokensAfterEnoughDocuments) {
+  ResumeTokenCheckpointPolicy policy;
+  policy.documents = 2;
+  local_store_.SetResumeTokenCheckpointPolicy(policy);
+
+  core::Query query = Query("foo");
+  TargetId target_id = AllocateQuery(query);
+  auto persisted_resume_token = [&] {
+    return persistence_->Run("PersistedResumeToken", [&] {
+      return persistence_->target_cache()
+          ->GetTarget(query.ToTarget())
+          ->resume_token();
+    });
+  };
+
+  // The first resume token of a target is always persisted.
+  ApplyRemoteEvent(AddedRemoteEventWithResumeToken("foo/a", 1000, target_id));
+  EXPECT_EQ(testutil::ResumeToken(1000), persisted_resume_token());
+
+  ApplyRemoteEvent(AddedRemoteEventWithResumeToken("foo/b", 2000, target_id));
+  EXPECT_EQ(testutil::ResumeToken(1000), persisted_resume_token());
+
+  ApplyRemoteEvent(AddedRemoteEventWithResumeToken("foo/c", 3000, target_id));
+  EXPECT_EQ(testutil::ResumeToken(3000), persisted_resume_token());
+
+  // Resume tokens without document changes are never checkpointed.
+  ApplyRemoteEvent(NoChangeEvent(target_id, 4000));
+  ApplyRemoteEvent(NoChangeEvent(target_id, 5000));
+  EXPECT_EQ(testutil::ResumeToken(3000), persisted_resume_token());
+}
+
 TEST_P(LocalStoreTest, RemoteDocumentKeysForTarget) {
   core::Query query = Query("foo");
   AllocateQuery(query);
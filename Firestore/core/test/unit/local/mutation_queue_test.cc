@@ -346,6 +346,56 @@ TEST_P(MutationQueueTest, AllMutationBatchesAffectingQuery) {
   });
 }
 
+TEST_P(MutationQueueTest, AllMutationBatchesAffectingQueryInDeepHierarchy) {
+  persistence_->Run("AllMutationBatchesAffectingQueryInDeepHierarchy", [&] {
+    std::vector<Mutation> mutations = {
+        testutil::SetMutation("a/1", Map("a", 1)),
+        testutil::SetMutation("a/1/b/1", Map("a", 1)),
+        testutil::SetMutation("a/1/b/1/c/1", Map("a", 1)),
+        testutil::SetMutation("a/1/b/2", Map("a", 1)),
+        testutil::SetMutation("a/1/b/2/c/1", Map("a", 1)),
+        testutil::SetMutation("a/1/b/2/c/1/d/1", Map("a", 1)),
+        testutil::SetMutation("a/1/bb/1", Map("a", 1)),
+        testutil::SetMutation("a/2/b/1", Map("a", 1)),
+        testutil::SetMutation("a/1/b/3", Map("a", 1)),
+    };
+
+    std::vector<MutationBatch> batches;
+    for (const Mutation& mutation : mutations) {
+      MutationBatch batch =
+          mutation_queue_->AddMutationBatch(Timestamp::Now(), {}, {mutation});
+      batches.push_back(batch);
+    }
+
+    std::vector<MutationBatch> expected = {batches[1], batches[3], batches[8]};
+    EXPECT_EQ(mutation_queue_->AllMutationBatchesAffectingQuery(
+                  Query("a/1/b")),
+              expected);
+
+    expected = {batches[2]};
+    EXPECT_EQ(mutation_queue_->AllMutationBatchesAffectingQuery(
+                  Query("a/1/b/1/c")),
+              expected);
+
+    expected = {batches[0]};
+    EXPECT_EQ(mutation_queue_->AllMutationBatchesAffectingQuery(Query("a")),
+              expected);
+
+    EXPECT_TRUE(
+        mutation_queue_->AllMutationBatchesAffectingQuery(Query("a/2/c"))
+            .empty());
+
+    // Removed batches are no longer returned.
+    for (size_t i = 0; i < 4; ++i) {
+      mutation_queue_->RemoveMutationBatch(batches[i]);
+    }
+    expected = {batches[8]};
+    EXPECT_EQ(mutation_queue_->AllMutationBatchesAffectingQuery(
+                  Query("a/1/b")),
+              expected);
+  });
+}
+
 TEST_P(MutationQueueTest, RemoveMutationBatches) {
   persistence_->Run("RemoveMutationBatches", [&] {
     std::vector<MutationBatch> batches = CreateBatches(10);
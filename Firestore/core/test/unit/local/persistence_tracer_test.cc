@@ -0,0 +1,181 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/local/persistence_tracer.h"
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <map>
+#include <memory>
+#include <string>
+
+#include "Firestore/core/src/local/memory_persistence.h"
+#include "Firestore/core/src/local/persistence.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+using std::chrono::microseconds;
+using Clock = PersistenceTracer::Clock;
+
+namespace {
+
+OperationCounters Counters(int64_t rows_read, int64_t rows_written) {
+  OperationCounters result;
+  result.rows_read = rows_read;
+  result.bytes_read = rows_read * 10;
+  result.rows_written = rows_written;
+  result.bytes_written = rows_written * 10;
+  return result;
+}
+
+}  // namespace
+
+TEST(LatencyHistogramTest, BucketsByPowersOfTwo) {
+  LatencyHistogram histogram;
+  histogram.Record(microseconds(0));
+  histogram.Record(microseconds(1));
+  histogram.Record(microseconds(3));
+  histogram.Record(microseconds(4));
+  histogram.Record(microseconds(1000));
+
+  const LatencyHistogram::Buckets& buckets = histogram.buckets();
+  ASSERT_EQ(1, buckets[0]);
+  ASSERT_EQ(1, buckets[1]);
+  ASSERT_EQ(1, buckets[2]);
+  ASSERT_EQ(1, buckets[3]);
+  ASSERT_EQ(1, buckets[10]);
+
+  ASSERT_EQ(5, histogram.count());
+  ASSERT_EQ(microseconds(1008), histogram.total());
+  ASSERT_EQ(microseconds(1000), histogram.max());
+}
+
+TEST(LatencyHistogramTest, Percentiles) {
+  LatencyHistogram histogram;
+  ASSERT_EQ(microseconds(0), histogram.Percentile(50));
+
+  for (int i = 0; i < 99; ++i) {
+    histogram.Record(microseconds(10));
+  }
+  histogram.Record(microseconds(5000));
+
+  // 10us falls into [8, 16), and the percentile reports its upper end.
+  ASSERT_EQ(microseconds(15), histogram.Percentile(50));
+  ASSERT_EQ(microseconds(15), histogram.Percentile(99));
+  ASSERT_EQ(microseconds(5000), histogram.Percentile(100));
+}
+
+TEST(PersistenceTracerTest, RecordsNothingUntilEnabled) {
+  PersistenceTracer tracer;
+  {
+    OperationTrace trace(&tracer, "Disabled");
+    ASSERT_FALSE(trace.active());
+  }
+  ASSERT_TRUE(tracer.GetStats().empty());
+
+  tracer.Enable(/*record_trace_events=*/false);
+  {
+    OperationTrace trace(&tracer, "Enabled");
+    ASSERT_TRUE(trace.active());
+    trace.set_counters(Counters(2, 1));
+  }
+  tracer.Disable();
+  {
+    OperationTrace trace(&tracer, "Enabled");
+  }
+
+  std::map<std::string, OperationStats> stats = tracer.GetStats();
+  ASSERT_EQ(1u, stats.size());
+  ASSERT_EQ(1, stats["Enabled"].latency.count());
+  ASSERT_EQ(2, stats["Enabled"].totals.rows_read);
+
+  OperationTrace null_trace(nullptr, "Null");
+  ASSERT_FALSE(null_trace.active());
+}
+
+TEST(PersistenceTracerTest, AggregatesStatsByLabel) {
+  PersistenceTracer tracer;
+  tracer.Enable(/*record_trace_events=*/false);
+
+  Clock::time_point start = Clock::now();
+  tracer.Record("Write", start, start + microseconds(100), Counters(0, 3));
+  tracer.Record("Write", start, start + microseconds(300), Counters(1, 5));
+  tracer.Record("Read", start, start + microseconds(50), Counters(7, 0));
+
+  std::map<std::string, OperationStats> stats = tracer.GetStats();
+  ASSERT_EQ(2u, stats.size());
+
+  const OperationStats& write = stats["Write"];
+  ASSERT_EQ(2, write.latency.count());
+  ASSERT_EQ(microseconds(400), write.latency.total());
+  ASSERT_EQ(microseconds(300), write.latency.max());
+  ASSERT_EQ(1, write.totals.rows_read);
+  ASSERT_EQ(8, write.totals.rows_written);
+  ASSERT_EQ(80, write.totals.bytes_written);
+  ASSERT_EQ(5, write.max_rows_written);
+
+  ASSERT_EQ(7, stats["Read"].totals.rows_read);
+
+  tracer.Reset();
+  ASSERT_TRUE(tracer.GetStats().empty());
+}
+
+TEST(PersistenceTracerTest, WritesChromeTraceEvents) {
+  PersistenceTracer tracer;
+  Clock::time_point start = Clock::now();
+
+  tracer.Enable(/*record_trace_events=*/false);
+  tracer.Record("Untraced", start, start, Counters(0, 0));
+  ASSERT_EQ(std::string::npos, tracer.ToChromeTraceJson().find("Untraced"));
+
+  tracer.Enable(/*record_trace_events=*/true);
+  tracer.Record("Write \"batch\"", start + microseconds(10),
+                start + microseconds(35), Counters(2, 1));
+
+  std::string json = tracer.ToChromeTraceJson();
+  EXPECT_NE(std::string::npos, json.find("\"traceEvents\":["));
+  EXPECT_NE(std::string::npos, json.find("\"name\":\"Write \\\"batch\\\"\""));
+  EXPECT_NE(std::string::npos, json.find("\"ph\":\"X\""));
+  EXPECT_NE(std::string::npos, json.find("\"tid\":1"));
+  EXPECT_NE(std::string::npos, json.find("\"dur\":25"));
+  EXPECT_NE(std::string::npos, json.find("\"rows_read\":2"));
+  EXPECT_NE(std::string::npos, json.find("\"bytes_written\":10"));
+  EXPECT_NE(std::string::npos, json.find("\"dropped_events\":0"));
+}
+
+TEST(PersistenceTracerTest, TracesPersistenceTransactions) {
+  PersistenceTracer tracer;
+  tracer.Enable(/*record_trace_events=*/true);
+
+  std::unique_ptr<MemoryPersistence> persistence =
+      MemoryPersistence::WithEagerGarbageCollector();
+  persistence->set_tracer(&tracer);
+  persistence->Run("First", [] {});
+  persistence->Run("Second", [] {});
+  persistence->Run("Second", [] {});
+
+  std::map<std::string, OperationStats> stats = tracer.GetStats();
+  ASSERT_EQ(1, stats["First"].latency.count());
+  ASSERT_EQ(2, stats["Second"].latency.count());
+
+  persistence->Shutdown();
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
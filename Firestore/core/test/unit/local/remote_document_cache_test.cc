@@ -23,6 +23,7 @@
 #include "Firestore/core/src/credentials/user.h"
 #include "Firestore/core/src/local/memory_remote_document_cache.h"
 #include "Firestore/core/src/local/persistence.h"
+#include "Firestore/core/src/local/query_context.h"
 #include "Firestore/core/src/local/remote_document_cache.h"
 #include "Firestore/core/src/model/document_key.h"
 #include "Firestore/core/src/model/document_key_set.h"
@@ -232,6 +233,48 @@ TEST_P(RemoteDocumentCacheTest, DocumentsMatchingQuerySinceReadTime) {
   });
 }
 
+TEST_P(RemoteDocumentCacheTest, DocumentsMatchingQuerySinceReadTimeAndKey) {
+  persistence_->Run(
+      "test_documents_matching_query_since_read_time_and_key", [&] {
+        SetTestDocument("b/a", /* updateTime= */ 1, /* readTime= */ 11);
+        SetTestDocument("b/b", /* updateTime= */ 2, /* readTime= */ 11);
+        SetTestDocument("b/c", /* updateTime= */ 3, /* readTime= */ 11);
+        SetTestDocument("b/d", /* updateTime= */ 4, /* readTime= */ 12);
+
+        core::Query query = Query("b");
+        model::IndexOffset offset(Version(11), Key("b/b"),
+                                  model::IndexOffset::InitialLargestBatchId());
+        MutableDocumentMap results =
+            cache_->GetDocumentsMatchingQuery(query, offset);
+        std::vector<MutableDocument> docs = {
+            Doc("b/c", 3, Map("a", 1, "b", 2)),
+            Doc("b/d", 4, Map("a", 1, "b", 2)),
+        };
+        EXPECT_THAT(results, HasExactlyDocs(docs));
+      });
+}
+
+TEST_P(RemoteDocumentCacheTest, DocumentsMatchingQueryUsesLatestReadTime) {
+  persistence_->Run("test_documents_matching_query_uses_latest_read_time", [&] {
+    SetTestDocument("b/moved", /* updateTime= */ 1, /* readTime= */ 11);
+    SetTestDocument("b/removed", /* updateTime= */ 1, /* readTime= */ 13);
+    SetTestDocument("b/moved", /* updateTime= */ 2, /* readTime= */ 14);
+    cache_->Remove(Key("b/removed"));
+
+    core::Query query = Query("b");
+    MutableDocumentMap results = cache_->GetDocumentsMatchingQuery(
+        query, model::IndexOffset::CreateSuccessor(Version(12)));
+    std::vector<MutableDocument> docs = {
+        Doc("b/moved", 2, Map("a", 1, "b", 2)),
+    };
+    EXPECT_THAT(results, HasExactlyDocs(docs));
+
+    results = cache_->GetDocumentsMatchingQuery(
+        query, model::IndexOffset::CreateSuccessor(Version(14)));
+    EXPECT_THAT(results, HasExactlyDocs(std::vector<MutableDocument>{}));
+  });
+}
+
 TEST_P(RemoteDocumentCacheTest, DocumentsMatchingUsesReadTimeNotUpdateTime) {
   persistence_->Run(
       "test_documents_matching_query_uses_read_time_not_update_time", [&] {
@@ -287,6 +330,34 @@ TEST_P(RemoteDocumentCacheTest, DocumentsMatchingRespectsMutatedDocs) {
   });
 }
 
+TEST_P(RemoteDocumentCacheTest, DocumentsMatchingCollectionGroupQuery) {
+  persistence_->Run("test_documents_matching_collection_group_query", [&] {
+    SetTestDocument("a/1/c/1", Map("matches", true), /* update_time= */ 1,
+                    /* read_time= */ 1);
+    SetTestDocument("a/2/c/1", Map("matches", true), /* update_time= */ 1,
+                    /* read_time= */ 2);
+    SetTestDocument("a/2/c/2", Map("matches", false), /* update_time= */ 1,
+                    /* read_time= */ 3);
+    SetTestDocument("a/3/c/1", Map("matches", true), /* update_time= */ 1,
+                    /* read_time= */ 4);
+    SetTestDocument("a/2/d/1", Map("matches", true), /* update_time= */ 1,
+                    /* read_time= */ 5);
+
+    core::Query query = testutil::CollectionGroupQuery("c").AddingFilter(
+        testutil::Filter("matches", "==", true));
+    absl::optional<QueryContext> context = QueryContext();
+    MutableDocumentMap results =
+        cache_->GetDocumentsMatchingCollectionGroupQuery(
+            query, {model::ResourcePath{"a", "2", "c"},
+                    model::ResourcePath{"a", "1", "c"}},
+            model::IndexOffset::CreateSuccessor(Version(1)), context, {});
+    std::vector<MutableDocument> docs = {
+        Doc("a/2/c/1", 1, Map("matches", true)),
+    };
+    EXPECT_THAT(results, HasExactlyDocs(docs));
+  });
+}
+
 TEST_P(RemoteDocumentCacheTest, DoesNotApplyDocumentModificationsToCache) {
   // This test verifies that the MemoryMutationCache returns copies of all
   // data to ensure that the documents in the cache cannot be modified.
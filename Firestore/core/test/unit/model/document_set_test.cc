@@ -75,6 +75,17 @@ TEST_F(DocumentSetTest, FirstAndLastDocument) {
   EXPECT_EQ(set.GetLastDocument(), doc2_);
 }
 
+TEST_F(DocumentSetTest, IndexOfAndAt) {
+  DocumentSet set = DocSet(comp_, {doc1_, doc2_, doc3_});
+
+  EXPECT_EQ(set.IndexOf(doc3_->key()), 0u);
+  EXPECT_EQ(set.IndexOf(doc1_->key()), 1u);
+  EXPECT_EQ(set.IndexOf(doc2_->key()), 2u);
+  EXPECT_EQ(set.at(0), doc3_);
+  EXPECT_EQ(set.at(1), doc1_);
+  EXPECT_EQ(set.at(2), doc2_);
+}
+
 TEST_F(DocumentSetTest, KeepsDocumentsInTheRightOrder) {
   DocumentSet set = DocSet(comp_, {doc1_, doc2_, doc3_});
   ASSERT_THAT(set, ElementsAre(doc3_, doc1_, doc2_));
@@ -16,6 +16,10 @@
 
 #include "Firestore/core/src/model/mutable_document.h"
 
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/immutable/sorted_map.h"
 #include "Firestore/core/src/model/field_path.h"
 #include "Firestore/core/test/unit/testutil/testutil.h"
 #include "absl/strings/string_view.h"
@@ -84,6 +88,23 @@ TEST(DocumentTest, Equality) {
   EXPECT_NE(DeletedDoc("same/path", 1), UnknownDoc("same/path", 1));
 }
 
+TEST(DocumentTest, ToSortedMapSortsEntries) {
+  std::vector<std::pair<DocumentKey, MutableDocument>> entries;
+  for (const char* path : {"coll/c", "coll/a", "coll/b"}) {
+    entries.emplace_back(Key(path), Doc(path, 1, Map()));
+  }
+
+  MutableDocumentMap map = ToSortedMap(std::move(entries));
+
+  std::vector<DocumentKey> keys;
+  for (const auto& entry : map) {
+    EXPECT_EQ(entry.first, entry.second.key());
+    keys.push_back(entry.first);
+  }
+  EXPECT_EQ(keys, (std::vector<DocumentKey>{Key("coll/a"), Key("coll/b"),
+                                            Key("coll/c")}));
+}
+
 }  // namespace model
 }  // namespace firestore
 }  // namespace firebase
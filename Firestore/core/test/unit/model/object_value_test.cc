@@ -17,6 +17,8 @@
 #include "Firestore/core/src/model/object_value.h"
 
 #include "Firestore/core/src/model/value_util.h"
+#include "Firestore/core/src/nanopb/byte_string.h"
+#include "Firestore/core/src/nanopb/message.h"
 #include "Firestore/core/src/remote/serializer.h"
 #include "Firestore/core/test/unit/testutil/testutil.h"
 #include "gtest/gtest.h"
@@ -31,13 +33,25 @@ const char kBarString[] = "bar";
 namespace {
 
 using absl::nullopt;
+using nanopb::ByteString;
+using nanopb::Message;
+using testutil::Array;
 using testutil::DbId;
 using testutil::Field;
+using testutil::Key;
 using testutil::Map;
 using testutil::Value;
 using testutil::WrapObject;
 
 class ObjectValueTest : public ::testing::Test {
+ protected:
+  /** Returns `value` serialized as the fields of a Document. */
+  ByteString EncodeAsDocument(const ObjectValue& value) {
+    Message<google_firestore_v1_Document> document{
+        serializer.EncodeDocument(Key("coll/doc"), value)};
+    return nanopb::MakeByteString(document);
+  }
+
  private:
   remote::Serializer serializer{DbId()};
 };
@@ -335,6 +349,97 @@ TEST_F(ObjectValueTest, DoesNotRequireSortedInserts) {
   EXPECT_EQ(*Value(2), *object_value.Get(Field("nested.nested.c")));
 }
 
+TEST_F(ObjectValueTest, DecodesEncodedDocumentOnAccess) {
+  ObjectValue expected =
+      WrapObject("foo", Map("a", 1, "b", true), "bar", "string");
+  ObjectValue object_value =
+      ObjectValue::FromEncodedDocument(EncodeAsDocument(expected));
+
+  ASSERT_NE(nullptr, object_value.encoded_document());
+  EXPECT_EQ(*Value(1), *object_value.Get(Field("foo.a")));
+  EXPECT_EQ(*Value("string"), *object_value.Get(Field("bar")));
+  EXPECT_EQ(nullopt, object_value.Get(Field("baz")));
+  EXPECT_EQ(expected, object_value);
+  EXPECT_EQ(expected.ToFieldMask(), object_value.ToFieldMask());
+}
+
+TEST_F(ObjectValueTest, ExtractsFieldsFromEncodedDocument) {
+  ObjectValue expected =
+      WrapObject("foo", Map("a", 1, "b", Map("c", "string", "d", Array(1, 2))),
+                 "bar", Map(), "baz", true);
+  ObjectValue object_value =
+      ObjectValue::FromEncodedDocument(EncodeAsDocument(expected));
+
+  // Values are decoded individually before the document is decoded.
+  EXPECT_EQ(*Value(1), *object_value.Get(Field("foo.a")));
+  EXPECT_EQ(*Value("string"), *object_value.Get(Field("foo.b.c")));
+  EXPECT_EQ(*Value(Array(1, 2)), *object_value.Get(Field("foo.b.d")));
+  EXPECT_EQ(*Value(Map("c", "string", "d", Array(1, 2))),
+            *object_value.Get(Field("foo.b")));
+  EXPECT_EQ(*Value(Map()), *object_value.Get(Field("bar")));
+  EXPECT_EQ(*Value(true), *object_value.Get("baz"));
+
+  EXPECT_EQ(nullopt, object_value.Get(Field("foo.a.b")));
+  EXPECT_EQ(nullopt, object_value.Get(Field("foo.e")));
+  EXPECT_EQ(nullopt, object_value.Get(Field("bar.a")));
+  EXPECT_EQ(nullopt, object_value.Get("qux"));
+
+  // Previously extracted values remain valid after the full decode.
+  absl::optional<google_firestore_v1_Value> field =
+      object_value.Get(Field("foo.b.c"));
+  EXPECT_EQ(expected, object_value);
+  EXPECT_EQ(*Value("string"), *field);
+  EXPECT_EQ(*Value(1), *object_value.Get(Field("foo.a")));
+}
+
+TEST_F(ObjectValueTest, CopiesShareEncodedDocument) {
+  ObjectValue expected = WrapObject("foo", Map("a", 1));
+  ObjectValue object_value =
+      ObjectValue::FromEncodedDocument(EncodeAsDocument(expected));
+
+  ObjectValue copy_before_decoding = object_value;
+  EXPECT_EQ(object_value.encoded_document(),
+            copy_before_decoding.encoded_document());
+
+  EXPECT_EQ(*Value(1), *object_value.Get(Field("foo.a")));
+  ObjectValue copy_after_decoding = object_value;
+  EXPECT_EQ(object_value.encoded_document(),
+            copy_after_decoding.encoded_document());
+
+  EXPECT_EQ(expected, copy_before_decoding);
+  EXPECT_EQ(expected, copy_after_decoding);
+}
+
+TEST_F(ObjectValueTest, ModificationsDiscardEncodedDocument) {
+  ObjectValue object_value = ObjectValue::FromEncodedDocument(
+      EncodeAsDocument(WrapObject("foo", Map("a", 1))));
+
+  object_value.Set(Field("foo.b"), Value(2));
+
+  EXPECT_EQ(nullptr, object_value.encoded_document());
+  EXPECT_EQ(WrapObject("foo", Map("a", 1, "b", 2)), object_value);
+
+  ObjectValue deleted = ObjectValue::FromEncodedDocument(
+      EncodeAsDocument(WrapObject("foo", Map("a", 1))));
+  deleted.Delete(Field("foo.a"));
+
+  EXPECT_EQ(nullptr, deleted.encoded_document());
+  EXPECT_EQ(WrapObject("foo", Map()), deleted);
+}
+
+TEST_F(ObjectValueTest, DeletingMissingFieldsKeepsEncodedDocument) {
+  ObjectValue expected = WrapObject("foo", Map("a", 1));
+  ObjectValue object_value =
+      ObjectValue::FromEncodedDocument(EncodeAsDocument(expected));
+
+  object_value.Delete(Field("bar"));
+  object_value.Delete(Field("foo.b"));
+  object_value.Delete(Field("foo.a.c"));
+
+  EXPECT_NE(nullptr, object_value.encoded_document());
+  EXPECT_EQ(expected, object_value);
+}
+
 }  // namespace
 
 }  // namespace model
@@ -0,0 +1,115 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/nanopb/field_scanner.h"
+
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace nanopb {
+namespace {
+
+TEST(FieldScannerTest, ScansEmptyMessage) {
+  FieldScanner scanner{""};
+  EXPECT_FALSE(scanner.Next());
+  EXPECT_TRUE(scanner.ok());
+}
+
+TEST(FieldScannerTest, ScansFields) {
+  std::string message;
+  AppendVarintField(&message, 1, 300);
+  AppendBytesField(&message, 2, "foo");
+  AppendVarintField(&message, 17, 1);
+
+  FieldScanner scanner{message};
+
+  ASSERT_TRUE(scanner.Next());
+  EXPECT_EQ(1u, scanner.field_number());
+  EXPECT_EQ(PB_WT_VARINT, scanner.wire_type());
+  EXPECT_EQ(300u, scanner.varint_value());
+
+  ASSERT_TRUE(scanner.Next());
+  EXPECT_EQ(2u, scanner.field_number());
+  EXPECT_EQ(PB_WT_STRING, scanner.wire_type());
+  EXPECT_EQ("foo", scanner.bytes_value());
+  EXPECT_EQ(std::string("\x12\x03"
+                        "foo"),
+            scanner.encoded_field());
+
+  ASSERT_TRUE(scanner.Next());
+  EXPECT_EQ(17u, scanner.field_number());
+  EXPECT_EQ(1u, scanner.varint_value());
+
+  EXPECT_FALSE(scanner.Next());
+  EXPECT_TRUE(scanner.ok());
+}
+
+TEST(FieldScannerTest, SkipsFixedWidthFields) {
+  // Field 1 as fixed64, field 2 as fixed32, followed by field 3 as a varint.
+  std::string message("\x09"
+                      "12345678"
+                      "\x15"
+                      "1234",
+                      14);
+  AppendVarintField(&message, 3, 7);
+
+  FieldScanner scanner{message};
+  ASSERT_TRUE(scanner.NextField(3));
+  EXPECT_EQ(7u, scanner.varint_value());
+  EXPECT_TRUE(scanner.ok());
+}
+
+TEST(FieldScannerTest, FindsFieldByNumber) {
+  std::string message;
+  AppendBytesField(&message, 1, "a");
+  AppendBytesField(&message, 2, "b");
+  AppendBytesField(&message, 1, "c");
+
+  FieldScanner scanner{message};
+  ASSERT_TRUE(scanner.NextField(1));
+  EXPECT_EQ("a", scanner.bytes_value());
+  ASSERT_TRUE(scanner.NextField(1));
+  EXPECT_EQ("c", scanner.bytes_value());
+  EXPECT_FALSE(scanner.NextField(1));
+  EXPECT_TRUE(scanner.ok());
+}
+
+TEST(FieldScannerTest, FailsOnTruncatedMessage) {
+  std::string message;
+  AppendBytesField(&message, 1, "foobar");
+  message.resize(message.size() - 1);
+
+  FieldScanner scanner{message};
+  EXPECT_FALSE(scanner.Next());
+  EXPECT_FALSE(scanner.ok());
+}
+
+TEST(FieldScannerTest, FailsOnInvalidFieldNumber) {
+  std::string message;
+  AppendVarintField(&message, 0, 1);
+
+  FieldScanner scanner{message};
+  EXPECT_FALSE(scanner.Next());
+  EXPECT_FALSE(scanner.ok());
+}
+
+}  // namespace
+}  // namespace nanopb
+}  // namespace firestore
+}  // namespace firebase
@@ -67,6 +67,7 @@ using util::AsyncQueue;
 using util::Executor;
 using util::Status;
 using util::StatusOr;
+using util::TimerId;
 
 using Type = GrpcCompletion::Type;
 
@@ -308,6 +309,124 @@ TEST_F(DatastoreTest, LookupDocumentsTwoSuccessfulReads) {
   EXPECT_TRUE(resulting_status.ok());
 }
 
+TEST_F(DatastoreTest, LookupDocumentsCoalescesConcurrentLookups) {
+  datastore->EnableLookupBatching(10, std::chrono::seconds(10));
+
+  std::vector<Document> first_docs;
+  std::vector<Document> second_docs;
+  datastore->LookupDocuments(
+      {model::DocumentKey::FromPathString("foo/2"),
+       model::DocumentKey::FromPathString("foo/1")},
+      [&](const StatusOr<std::vector<Document>>& documents) {
+        first_docs = documents.ValueOrDie();
+      });
+  datastore->LookupDocuments(
+      {model::DocumentKey::FromPathString("foo/3"),
+       model::DocumentKey::FromPathString("foo/2")},
+      [&](const StatusOr<std::vector<Document>>& documents) {
+        second_docs = documents.ValueOrDie();
+      });
+
+  // Send the batch without waiting for its delay to pass.
+  worker_queue->EnqueueBlocking([] {});
+  ASSERT_TRUE(worker_queue->IsScheduled(TimerId::LookupBatchDelay));
+  worker_queue->RunScheduledOperationsUntil(TimerId::LookupBatchDelay);
+  // Make sure Auth has a chance to run.
+  worker_queue->EnqueueBlocking([] {});
+
+  // A single call reads the three distinct documents.
+  ForceFinishAnyTypeOrder(
+      {{Type::Write, CompletionResult::Ok},
+       {Type::Read, MakeFakeDocument("foo/1")},
+       {Type::Read, MakeFakeDocument("foo/2")},
+       {Type::Read, MakeFakeDocument("foo/3")},
+       /*Read after last*/ {Type::Read, CompletionResult::Error}});
+  ForceFinish({{Type::Finish, grpc::Status::OK}});
+
+  ASSERT_EQ(first_docs.size(), 2);
+  EXPECT_EQ(first_docs[0]->key().ToString(), "foo/1");
+  EXPECT_EQ(first_docs[1]->key().ToString(), "foo/2");
+  ASSERT_EQ(second_docs.size(), 2);
+  EXPECT_EQ(second_docs[0]->key().ToString(), "foo/2");
+  EXPECT_EQ(second_docs[1]->key().ToString(), "foo/3");
+}
+
+TEST_F(DatastoreTest, LookupDocumentsSendsFullBatchesRightAway) {
+  datastore->EnableLookupBatching(2, std::chrono::seconds(10));
+
+  bool done = false;
+  datastore->LookupDocuments(
+      {model::DocumentKey::FromPathString("foo/1"),
+       model::DocumentKey::FromPathString("foo/2")},
+      [&](const StatusOr<std::vector<Document>>& documents) {
+        done = documents.ok();
+      });
+  worker_queue->EnqueueBlocking([] {});
+  EXPECT_FALSE(worker_queue->IsScheduled(TimerId::LookupBatchDelay));
+  // Make sure Auth has a chance to run.
+  worker_queue->EnqueueBlocking([] {});
+
+  ForceFinishAnyTypeOrder(
+      {{Type::Write, CompletionResult::Ok},
+       {Type::Read, MakeFakeDocument("foo/1")},
+       {Type::Read, MakeFakeDocument("foo/2")},
+       /*Read after last*/ {Type::Read, CompletionResult::Error}});
+  ForceFinish({{Type::Finish, grpc::Status::OK}});
+
+  EXPECT_TRUE(done);
+}
+
+TEST_F(DatastoreTest, LookupDocumentsResendsLookupsAfterPermanentError) {
+  datastore->EnableLookupBatching(10, std::chrono::seconds(10));
+
+  Status first_status;
+  std::vector<Document> second_docs;
+  int callbacks = 0;
+  datastore->LookupDocuments(
+      {model::DocumentKey::FromPathString("foo/1")},
+      [&](const StatusOr<std::vector<Document>>& documents) {
+        ++callbacks;
+        first_status = documents.status();
+      });
+  datastore->LookupDocuments(
+      {model::DocumentKey::FromPathString("foo/2")},
+      [&](const StatusOr<std::vector<Document>>& documents) {
+        ++callbacks;
+        if (documents.ok()) {
+          second_docs = documents.ValueOrDie();
+        }
+      });
+
+  worker_queue->EnqueueBlocking([] {});
+  worker_queue->RunScheduledOperationsUntil(TimerId::LookupBatchDelay);
+  // Make sure Auth has a chance to run.
+  worker_queue->EnqueueBlocking([] {});
+
+  // The batch fails as a whole, so each lookup is sent again by itself.
+  ForceFinishAnyTypeOrder({{Type::Write, CompletionResult::Ok},
+                           {Type::Read, CompletionResult::Error}});
+  ForceFinish({{Type::Finish, grpc::Status{grpc::PERMISSION_DENIED, ""}}});
+  EXPECT_EQ(callbacks, 0);
+  // Make sure Auth has a chance to run.
+  worker_queue->EnqueueBlocking([] {});
+
+  // The lookup of "foo/2" was sent last.
+  ForceFinishAnyTypeOrder(
+      {{Type::Write, CompletionResult::Ok},
+       {Type::Read, MakeFakeDocument("foo/2")},
+       /*Read after last*/ {Type::Read, CompletionResult::Error}});
+  ForceFinish({{Type::Finish, grpc::Status::OK}});
+
+  ForceFinishAnyTypeOrder({{Type::Write, CompletionResult::Ok},
+                           {Type::Read, CompletionResult::Error}});
+  ForceFinish({{Type::Finish, grpc::Status{grpc::PERMISSION_DENIED, ""}}});
+
+  EXPECT_EQ(callbacks, 2);
+  EXPECT_EQ(first_status.code(), Error::kErrorPermissionDenied);
+  ASSERT_EQ(second_docs.size(), 1);
+  EXPECT_EQ(second_docs[0]->key().ToString(), "foo/2");
+}
+
 // gRPC errors
 
 TEST_F(DatastoreTest, CommitMutationsError) {
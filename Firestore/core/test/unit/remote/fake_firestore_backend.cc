@@ -0,0 +1,930 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/test/unit/remote/fake_firestore_backend.h"
+
+#include <algorithm>
+#include <deque>
+#include <utility>
+
+#include "Firestore/Protos/nanopb/google/firestore/v1/firestore.nanopb.h"
+#include "Firestore/core/include/firebase/firestore/timestamp.h"
+#include "Firestore/core/src/core/target.h"
+#include "Firestore/core/src/model/document.h"
+#include "Firestore/core/src/model/field_mask.h"
+#include "Firestore/core/src/model/field_path.h"
+#include "Firestore/core/src/model/mutation.h"
+#include "Firestore/core/src/model/value_util.h"
+#include "Firestore/core/src/nanopb/message.h"
+#include "Firestore/core/src/nanopb/nanopb_util.h"
+#include "Firestore/core/src/remote/grpc_nanopb.h"
+#include "Firestore/core/src/util/hard_assert.h"
+#include "Firestore/core/src/util/read_context.h"
+#include "absl/strings/numbers.h"
+#include "grpcpp/security/server_credentials.h"
+#include "grpcpp/server_builder.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+namespace {
+
+using core::LimitType;
+using core::Query;
+using core::Target;
+using model::DocumentKey;
+using model::FieldPath;
+using model::MutableDocument;
+using model::Mutation;
+using model::ObjectValue;
+using model::SnapshotVersion;
+using nanopb::MakeArray;
+using nanopb::MakeBytesArray;
+using nanopb::Message;
+using std::chrono::duration_cast;
+using std::chrono::microseconds;
+
+const char* const kListen = "/google.firestore.v1.Firestore/Listen";
+const char* const kWrite = "/google.firestore.v1.Firestore/Write";
+const char* const kCommit = "/google.firestore.v1.Firestore/Commit";
+const char* const kBatchGetDocuments =
+    "/google.firestore.v1.Firestore/BatchGetDocuments";
+const char* const kRunAggregationQuery =
+    "/google.firestore.v1.Firestore/RunAggregationQuery";
+
+/** The stream token handed out on every `Write` response. */
+const char* const kStreamToken = "fake-stream-token";
+
+grpc::Status InvalidArgument(const util::ReadContext& context) {
+  return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
+                      context.status().error_message());
+}
+
+/** The query whose results a target describes, without any limit. */
+Query QueryForTarget(const Target& target) {
+  return Query(target.path(), target.collection_group(), target.filters(),
+               target.order_bys(), Target::kNoLimit, LimitType::None,
+               target.start_at(), target.end_at());
+}
+
+bool Matches(const Query& query, const MutableDocument& document) {
+  return document.is_found_document() &&
+         query.Matches(model::Document(document));
+}
+
+/** Returns the fields of `value` that are in `mask`. */
+ObjectValue ApplyMask(const ObjectValue& value, const model::FieldMask& mask) {
+  ObjectValue result;
+  for (const FieldPath& path : mask) {
+    absl::optional<google_firestore_v1_Value> field = value.Get(path);
+    if (field) {
+      result.Set(path, model::DeepClone(*field));
+    }
+  }
+  return result;
+}
+
+int64_t ToMicroseconds(const SnapshotVersion& version) {
+  const Timestamp& timestamp = version.timestamp();
+  return timestamp.seconds() * 1000000 + timestamp.nanoseconds() / 1000;
+}
+
+/**
+ * Returns the version encoded in the resume token of `target`, or nullopt if
+ * the target is not resumed from a token of this backend.
+ */
+absl::optional<int64_t> ResumeMicroseconds(
+    const google_firestore_v1_Target& target) {
+  if (target.which_resume_type !=
+      google_firestore_v1_Target_resume_token_tag) {
+    return absl::nullopt;
+  }
+  int64_t micros = 0;
+  if (!absl::SimpleAtoi(
+          nanopb::MakeStringView(target.resume_type.resume_token), &micros)) {
+    return absl::nullopt;
+  }
+  return micros;
+}
+
+int32_t* CopyTargetIds(const std::vector<int32_t>& target_ids) {
+  auto* result = MakeArray<int32_t>(nanopb::CheckedSize(target_ids.size()));
+  std::copy(target_ids.begin(), target_ids.end(), result);
+  return result;
+}
+
+google_firestore_v1_Value IntegerValue(int64_t value) {
+  google_firestore_v1_Value result{};
+  result.which_value_type = google_firestore_v1_Value_integer_value_tag;
+  result.integer_value = value;
+  return result;
+}
+
+google_firestore_v1_Value DoubleValue(double value) {
+  google_firestore_v1_Value result{};
+  result.which_value_type = google_firestore_v1_Value_double_value_tag;
+  result.double_value = value;
+  return result;
+}
+
+/**
+ * Computes a `sum` or `avg` aggregation over the numeric values of `field`,
+ * skipping documents where it is missing or not a number.
+ */
+google_firestore_v1_Value Aggregate(
+    const std::vector<const MutableDocument*>& documents,
+    const FieldPath& field,
+    bool average) {
+  int64_t integer_sum = 0;
+  double double_sum = 0;
+  bool all_integers = true;
+  size_t count = 0;
+  for (const MutableDocument* document : documents) {
+    absl::optional<google_firestore_v1_Value> value =
+        document->data().Get(field);
+    if (model::IsInteger(value)) {
+      integer_sum += value->integer_value;
+      double_sum += static_cast<double>(value->integer_value);
+    } else if (model::IsDouble(value)) {
+      double_sum += value->double_value;
+      all_integers = false;
+    } else {
+      continue;
+    }
+    ++count;
+  }
+
+  if (average) {
+    return count == 0 ? model::NullValue() : DoubleValue(double_sum / count);
+  }
+  return all_integers ? IntegerValue(integer_sum) : DoubleValue(double_sum);
+}
+
+}  // namespace
+
+// MARK: - Call
+
+/**
+ * A single call, unary or streaming. Responses are written one at a time in
+ * the order they are sent; the call deletes itself once it is done.
+ */
+class FakeFirestoreBackend::Call : public grpc::ServerGenericBidiReactor {
+ public:
+  Call(FakeFirestoreBackend* backend, std::string method)
+      : backend_(backend), method_(std::move(method)) {
+    backend_->RegisterCall(this);
+    StartRead(&request_);
+  }
+
+  /** Queues `message` to be written after all previous ones. */
+  void Send(grpc::ByteBuffer message) {
+    const grpc::ByteBuffer* next = nullptr;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (finishing_) return;
+
+      outgoing_.push_back(std::move(message));
+      if (writing_) return;
+
+      writing_ = true;
+      next = &outgoing_.front();
+    }
+    StartWrite(next);
+  }
+
+  /** Finishes the call with `status` once all queued messages are written. */
+  void FinishAfterWrites(grpc::Status status) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (finishing_) return;
+
+      finishing_ = true;
+      finish_status_ = std::move(status);
+      if (writing_) return;
+    }
+    Finish(finish_status_);
+  }
+
+  void OnReadDone(bool ok) override {
+    if (!ok) {
+      // The client has closed its side, or the call is broken.
+      FinishAfterWrites(grpc::Status::OK);
+      return;
+    }
+
+    if (method_ == kListen || method_ == kWrite) {
+      grpc::Status status = method_ == kListen
+                                ? backend_->HandleListen(this, request_)
+                                : backend_->HandleWrite(this, request_);
+      if (status.ok()) {
+        StartRead(&request_);
+      } else {
+        FinishAfterWrites(std::move(status));
+      }
+      return;
+    }
+
+    std::vector<grpc::ByteBuffer> responses;
+    grpc::Status status = backend_->HandleUnary(method_, request_, &responses);
+    for (grpc::ByteBuffer& response : responses) {
+      Send(std::move(response));
+    }
+    FinishAfterWrites(std::move(status));
+  }
+
+  void OnWriteDone(bool ok) override {
+    const grpc::ByteBuffer* next = nullptr;
+    bool finish = false;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      outgoing_.pop_front();
+      if (!ok) {
+        // The call is broken; nothing else will get through.
+        outgoing_.clear();
+        if (!finishing_) {
+          finishing_ = true;
+          finish_status_ = grpc::Status::CANCELLED;
+        }
+      }
+
+      if (!outgoing_.empty()) {
+        next = &outgoing_.front();
+      } else {
+        writing_ = false;
+        finish = finishing_;
+      }
+    }
+
+    if (next) {
+      StartWrite(next);
+    } else if (finish) {
+      Finish(finish_status_);
+    }
+  }
+
+  void OnCancel() override {
+    FinishAfterWrites(grpc::Status::CANCELLED);
+  }
+
+  void OnDone() override {
+    backend_->UnregisterCall(this);
+    delete this;
+  }
+
+ private:
+  FakeFirestoreBackend* backend_ = nullptr;
+  std::string method_;
+  grpc::ByteBuffer request_;
+
+  std::mutex mutex_;
+  std::deque<grpc::ByteBuffer> outgoing_;
+  bool writing_ = false;
+  bool finishing_ = false;
+  grpc::Status finish_status_;
+};
+
+// MARK: - Service
+
+class FakeFirestoreBackend::Service : public grpc::CallbackGenericService {
+ public:
+  explicit Service(FakeFirestoreBackend* backend) : backend_(backend) {
+  }
+
+  grpc::ServerGenericBidiReactor* CreateReactor(
+      grpc::GenericCallbackServerContext* context) override {
+    return new Call(backend_, context->method());
+  }
+
+ private:
+  FakeFirestoreBackend* backend_ = nullptr;
+};
+
+// MARK: - FakeFirestoreBackend
+
+FakeFirestoreBackend::FakeFirestoreBackend(model::DatabaseId database_id)
+    : serializer_(std::move(database_id)),
+      service_(new Service(this)),
+      last_change_time_(Clock::now()) {
+  version_ = NextVersion();
+
+  int port = 0;
+  grpc::ServerBuilder builder;
+  builder.AddListeningPort("localhost:0", grpc::InsecureServerCredentials(),
+                           &port);
+  builder.RegisterCallbackGenericService(service_.get());
+  server_ = builder.BuildAndStart();
+  HARD_ASSERT(server_ && port != 0, "Failed to start the fake backend");
+
+  host_ = "localhost:" + std::to_string(port);
+}
+
+FakeFirestoreBackend::~FakeFirestoreBackend() {
+  {
+    std::lock_guard<std::mutex> lock(replay_mutex_);
+    stop_replay_ = true;
+  }
+  replay_changed_.notify_all();
+  WaitForReplay();
+
+  server_->Shutdown(std::chrono::system_clock::now());
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  calls_done_.wait(lock, [this] { return open_calls_ == 0; });
+}
+
+void FakeFirestoreBackend::Replay(std::vector<DocumentChange> changes,
+                                  double speed) {
+  HARD_ASSERT(speed > 0, "Replay speed must be positive");
+
+  {
+    std::lock_guard<std::mutex> lock(replay_mutex_);
+    stop_replay_ = true;
+  }
+  replay_changed_.notify_all();
+  WaitForReplay();
+  stop_replay_ = false;
+
+  replay_thread_ = std::thread([this, changes = std::move(changes), speed] {
+    Clock::time_point next = Clock::now();
+    for (const DocumentChange& change : changes) {
+      next += duration_cast<Clock::duration>(change.delay / speed);
+      {
+        std::unique_lock<std::mutex> lock(replay_mutex_);
+        if (replay_changed_.wait_until(lock, next,
+                                       [this] { return stop_replay_; })) {
+          return;
+        }
+      }
+
+      std::lock_guard<std::mutex> lock(mutex_);
+      ApplyChange(change.key, change.value, NextVersion());
+      SendGlobalSnapshot();
+    }
+  });
+}
+
+void FakeFirestoreBackend::WaitForReplay() {
+  if (replay_thread_.joinable()) {
+    replay_thread_.join();
+  }
+}
+
+std::vector<FakeFirestoreBackend::DocumentChange>
+FakeFirestoreBackend::recorded_changes() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return recorded_changes_;
+}
+
+void FakeFirestoreBackend::set_change_observer(
+    std::function<void(const DocumentChange&, Clock::time_point)> observer) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  change_observer_ = std::move(observer);
+}
+
+std::vector<FakeFirestoreBackend::DocumentChange>
+FakeFirestoreBackend::SyntheticWorkload(const model::ResourcePath& collection,
+                                        int documents,
+                                        int count,
+                                        double changes_per_second) {
+  HARD_ASSERT(documents > 0 && changes_per_second > 0,
+              "Invalid synthetic workload");
+
+  auto delay = duration_cast<microseconds>(
+      std::chrono::duration<double>(1.0 / changes_per_second));
+
+  std::vector<DocumentChange> result;
+  result.reserve(count);
+  for (int i = 0; i < count; ++i) {
+    ObjectValue value;
+    Message<google_firestore_v1_Value> sequence{IntegerValue(i)};
+    value.Set(FieldPath::FromDotSeparatedString("sequence"),
+              std::move(sequence));
+
+    DocumentKey key{
+        collection.Append("doc" + std::to_string(i % documents))};
+    result.push_back(DocumentChange{delay, std::move(key), std::move(value)});
+  }
+  return result;
+}
+
+void FakeFirestoreBackend::DeleteBehindExistenceFilter(const DocumentKey& key) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  StoreChange(key, absl::nullopt, NextVersion());
+
+  for (auto& listen : listens_) {
+    for (auto& kv : listen.second) {
+      ListenTarget& target = kv.second;
+      if (target.matching.erase(key) == 0) continue;
+      listen.first->Send(
+          EncodeExistenceFilter(kv.first, target.matching.size()));
+    }
+  }
+  SendGlobalSnapshot();
+}
+
+void FakeFirestoreBackend::set_lookup_status(grpc::Status status) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  lookup_status_ = std::move(status);
+}
+
+size_t FakeFirestoreBackend::document_count() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return static_cast<size_t>(
+      std::count_if(documents_.begin(), documents_.end(), [](const auto& kv) {
+        return kv.second.is_found_document();
+      }));
+}
+
+int64_t FakeFirestoreBackend::call_count() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return call_count_;
+}
+
+int64_t FakeFirestoreBackend::resumed_documents_sent() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return resumed_documents_sent_;
+}
+
+void FakeFirestoreBackend::RegisterCall(Call*) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ++call_count_;
+  ++open_calls_;
+}
+
+void FakeFirestoreBackend::UnregisterCall(Call* call) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  listens_.erase(call);
+  --open_calls_;
+  calls_done_.notify_all();
+}
+
+grpc::Status FakeFirestoreBackend::HandleListen(
+    Call* call, const grpc::ByteBuffer& request) {
+  ByteBufferReader reader{request};
+  auto message = Message<google_firestore_v1_ListenRequest>::TryParse(&reader);
+  if (!reader.ok()) return InvalidArgument(*reader.context());
+
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  if (message->which_target_change ==
+      google_firestore_v1_ListenRequest_remove_target_tag) {
+    int32_t target_id = message->remove_target;
+    listens_[call].erase(target_id);
+    call->Send(EncodeTargetChange(
+        google_firestore_v1_TargetChange_TargetChangeType_REMOVE, {target_id},
+        SnapshotVersion::None()));
+    return grpc::Status::OK;
+  }
+
+  google_firestore_v1_Target& proto = message->add_target;
+  util::ReadContext context;
+  Target target =
+      proto.which_target_type == google_firestore_v1_Target_query_tag
+          ? serializer_.DecodeQueryTarget(&context, proto.target_type.query)
+          : serializer_.DecodeDocumentsTarget(&context,
+                                              proto.target_type.documents);
+  if (!context.ok()) return InvalidArgument(context);
+
+  int32_t target_id = proto.target_id;
+  ListenTarget& listen = listens_[call][target_id];
+  listen.query = QueryForTarget(target);
+  listen.matching.clear();
+
+  call->Send(EncodeTargetChange(
+      google_firestore_v1_TargetChange_TargetChangeType_ADD, {target_id},
+      SnapshotVersion::None()));
+  absl::optional<int64_t> resume_micros = ResumeMicroseconds(proto);
+  for (const auto& kv : documents_) {
+    const MutableDocument& document = kv.second;
+    bool matches = Matches(listen.query, document);
+    if (matches) listen.matching.insert(kv.first);
+
+    if (resume_micros) {
+      // The client is up to date as of the token, so only send what changed
+      // since, including documents that were deleted or stopped matching.
+      if (ToMicroseconds(document.version()) <= *resume_micros) continue;
+      call->Send(matches ? EncodeDocumentChange(document, {target_id}, {})
+                         : EncodeDocumentChange(document, {}, {target_id}));
+      ++resumed_documents_sent_;
+    } else if (matches) {
+      call->Send(EncodeDocumentChange(document, {target_id}, {}));
+    }
+  }
+  call->Send(EncodeTargetChange(
+      google_firestore_v1_TargetChange_TargetChangeType_CURRENT, {target_id},
+      version_));
+  call->Send(EncodeTargetChange(
+      google_firestore_v1_TargetChange_TargetChangeType_NO_CHANGE, {},
+      version_));
+  return grpc::Status::OK;
+}
+
+grpc::Status FakeFirestoreBackend::HandleWrite(
+    Call* call, const grpc::ByteBuffer& request) {
+  ByteBufferReader reader{request};
+  auto message = Message<google_firestore_v1_WriteRequest>::TryParse(&reader);
+  if (!reader.ok()) return InvalidArgument(*reader.context());
+
+  Message<google_firestore_v1_WriteResponse> response;
+  response->stream_token = MakeBytesArray(kStreamToken);
+
+  bool handshake = message->stream_token == nullptr;
+  if (!handshake) {
+    // An empty request after the handshake announces that the client is
+    // closing the stream, and gets no response.
+    if (message->writes_count == 0) return grpc::Status::OK;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    SnapshotVersion commit_version;
+    grpc::Status status =
+        ApplyWrites(message->writes, message->writes_count,
+                    &response->write_results, &commit_version);
+    if (!status.ok()) return status;
+
+    response->write_results_count = message->writes_count;
+    response->commit_time = Serializer::EncodeVersion(commit_version);
+    SendGlobalSnapshot();
+  }
+
+  call->Send(MakeByteBuffer(response));
+  return grpc::Status::OK;
+}
+
+grpc::Status FakeFirestoreBackend::HandleUnary(
+    const std::string& method,
+    const grpc::ByteBuffer& request,
+    std::vector<grpc::ByteBuffer>* responses) {
+  if (method == kCommit) {
+    return Commit(request, responses);
+  } else if (method == kBatchGetDocuments) {
+    return BatchGetDocuments(request, responses);
+  } else if (method == kRunAggregationQuery) {
+    return RunAggregationQuery(request, responses);
+  }
+  return grpc::Status(grpc::StatusCode::UNIMPLEMENTED, method);
+}
+
+grpc::Status FakeFirestoreBackend::Commit(
+    const grpc::ByteBuffer& request, std::vector<grpc::ByteBuffer>* responses) {
+  ByteBufferReader reader{request};
+  auto message = Message<google_firestore_v1_CommitRequest>::TryParse(&reader);
+  if (!reader.ok()) return InvalidArgument(*reader.context());
+
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  Message<google_firestore_v1_CommitResponse> response;
+  SnapshotVersion commit_version;
+  grpc::Status status = ApplyWrites(message->writes, message->writes_count,
+                                    &response->write_results, &commit_version);
+  if (!status.ok()) return status;
+
+  response->write_results_count = message->writes_count;
+  response->commit_time = Serializer::EncodeVersion(commit_version);
+  SendGlobalSnapshot();
+
+  responses->push_back(MakeByteBuffer(response));
+  return grpc::Status::OK;
+}
+
+grpc::Status FakeFirestoreBackend::BatchGetDocuments(
+    const grpc::ByteBuffer& request, std::vector<grpc::ByteBuffer>* responses) {
+  ByteBufferReader reader{request};
+  auto message =
+      Message<google_firestore_v1_BatchGetDocumentsRequest>::TryParse(&reader);
+  if (!reader.ok()) return InvalidArgument(*reader.context());
+
+  absl::optional<model::FieldMask> mask;
+  if (message->mask.field_paths_count > 0) {
+    util::ReadContext context;
+    mask = Serializer::DecodeFieldMask(&context, message->mask);
+    if (!context.ok()) return InvalidArgument(context);
+    for (const FieldPath& path : *mask) {
+      if (path.IsKeyFieldPath()) {
+        return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
+                            "The mask must not contain __name__");
+      }
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!lookup_status_.ok()) return lookup_status_;
+
+  for (pb_size_t i = 0; i < message->documents_count; ++i) {
+    util::ReadContext context;
+    DocumentKey key = serializer_.DecodeKey(&context, message->documents[i]);
+    if (!context.ok()) return InvalidArgument(context);
+
+    Message<google_firestore_v1_BatchGetDocumentsResponse> response;
+    auto found = documents_.find(key);
+    if (found != documents_.end() && found->second.is_found_document()) {
+      const MutableDocument& document = found->second;
+      response->which_result =
+          google_firestore_v1_BatchGetDocumentsResponse_found_tag;
+      google_protobuf_Timestamp version =
+          Serializer::EncodeVersion(document.version());
+      response->found = serializer_.EncodeDocument(
+          key, mask ? ApplyMask(document.data(), *mask) : document.data());
+      response->found.create_time = version;
+      response->found.has_update_time = true;
+      response->found.update_time = version;
+    } else {
+      response->which_result =
+          google_firestore_v1_BatchGetDocumentsResponse_missing_tag;
+      response->missing = nanopb::CopyBytesArray(message->documents[i]);
+    }
+    response->read_time = Serializer::EncodeVersion(version_);
+    responses->push_back(MakeByteBuffer(response));
+  }
+  return grpc::Status::OK;
+}
+
+grpc::Status FakeFirestoreBackend::RunAggregationQuery(
+    const grpc::ByteBuffer& request, std::vector<grpc::ByteBuffer>* responses) {
+  ByteBufferReader reader{request};
+  auto message =
+      Message<google_firestore_v1_RunAggregationQueryRequest>::TryParse(
+          &reader);
+  if (!reader.ok()) return InvalidArgument(*reader.context());
+
+  google_firestore_v1_StructuredAggregationQuery& aggregation_query =
+      message->query_type.structured_aggregation_query;
+  util::ReadContext context;
+  Target target = serializer_.DecodeStructuredQuery(
+      &context, message->parent, aggregation_query.structured_query);
+  if (!context.ok()) return InvalidArgument(context);
+
+  Query query = QueryForTarget(target);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  std::vector<const MutableDocument*> matching;
+  for (const auto& kv : documents_) {
+    if (Matches(query, kv.second)) {
+      matching.push_back(&kv.second);
+    }
+  }
+
+  Message<google_firestore_v1_RunAggregationQueryResponse> response;
+  pb_size_t count = aggregation_query.aggregations_count;
+  response->result.aggregate_fields_count = count;
+  response->result.aggregate_fields =
+      MakeArray<google_firestore_v1_AggregationResult_AggregateFieldsEntry>(
+          count);
+
+  for (pb_size_t i = 0; i < count; ++i) {
+    const auto& aggregation = aggregation_query.aggregations[i];
+    auto& entry = response->result.aggregate_fields[i];
+    entry.key = nanopb::CopyBytesArray(aggregation.alias);
+
+    switch (aggregation.which_operator) {
+      case google_firestore_v1_StructuredAggregationQuery_Aggregation_count_tag:
+        entry.value = IntegerValue(static_cast<int64_t>(matching.size()));
+        break;
+
+      case google_firestore_v1_StructuredAggregationQuery_Aggregation_sum_tag:
+      case google_firestore_v1_StructuredAggregationQuery_Aggregation_avg_tag: {
+        bool average =
+            aggregation.which_operator ==
+            google_firestore_v1_StructuredAggregationQuery_Aggregation_avg_tag;
+        const pb_bytes_array_t* field_path =
+            average ? aggregation.avg.field.field_path
+                    : aggregation.sum.field.field_path;
+        FieldPath field = Serializer::DecodeFieldPath(&context, field_path);
+        if (!context.ok()) return InvalidArgument(context);
+
+        entry.value = Aggregate(matching, field, average);
+        break;
+      }
+
+      default:
+        return grpc::Status(grpc::StatusCode::UNIMPLEMENTED,
+                            "Unsupported aggregation");
+    }
+  }
+  response->read_time = Serializer::EncodeVersion(version_);
+
+  responses->push_back(MakeByteBuffer(response));
+  return grpc::Status::OK;
+}
+
+grpc::Status FakeFirestoreBackend::ApplyWrites(
+    google_firestore_v1_Write* writes,
+    pb_size_t writes_count,
+    google_firestore_v1_WriteResult** results,
+    SnapshotVersion* commit_version) {
+  std::vector<Mutation> mutations;
+  mutations.reserve(writes_count);
+  for (pb_size_t i = 0; i < writes_count; ++i) {
+    util::ReadContext context;
+    mutations.push_back(serializer_.DecodeMutation(&context, writes[i]));
+    if (!context.ok()) return InvalidArgument(context);
+  }
+
+  *commit_version = NextVersion();
+
+  // Apply all mutations to copies first so that a failed precondition leaves
+  // the stored documents untouched.
+  std::map<DocumentKey, MutableDocument> staged;
+  std::vector<const MutableDocument*> written;
+  for (const Mutation& mutation : mutations) {
+    auto it = staged.find(mutation.key());
+    if (it == staged.end()) {
+      auto stored = documents_.find(mutation.key());
+      MutableDocument document =
+          stored != documents_.end()
+              ? stored->second
+              : MutableDocument::NoDocument(mutation.key(),
+                                            SnapshotVersion::None());
+      it = staged.emplace(mutation.key(), std::move(document)).first;
+    }
+
+    if (!mutation.precondition().IsValidFor(it->second)) {
+      return grpc::Status(grpc::StatusCode::FAILED_PRECONDITION,
+                          "Precondition failed for " +
+                              mutation.key().ToString());
+    }
+    if (mutation.type() != Mutation::Type::Verify) {
+      mutation.ApplyToLocalView(it->second, absl::nullopt,
+                                commit_version->timestamp());
+    }
+    written.push_back(&it->second);
+  }
+
+  *results = MakeArray<google_firestore_v1_WriteResult>(writes_count);
+  for (pb_size_t i = 0; i < writes_count; ++i) {
+    google_firestore_v1_WriteResult& result = (*results)[i];
+    result.has_update_time = true;
+    result.update_time = Serializer::EncodeVersion(*commit_version);
+
+    // Report the transformed values as of the end of the commit.
+    const std::vector<model::FieldTransform>& transforms =
+        mutations[i].field_transforms();
+    result.transform_results_count = nanopb::CheckedSize(transforms.size());
+    result.transform_results =
+        MakeArray<google_firestore_v1_Value>(result.transform_results_count);
+    for (size_t j = 0; j < transforms.size(); ++j) {
+      absl::optional<google_firestore_v1_Value> value =
+          written[i]->data().Get(transforms[j].path());
+      result.transform_results[j] =
+          value ? *model::DeepClone(*value).release() : model::NullValue();
+    }
+  }
+
+  for (auto& kv : staged) {
+    const MutableDocument& document = kv.second;
+    absl::optional<ObjectValue> value;
+    if (document.is_found_document()) value = document.data();
+    ApplyChange(kv.first, value, *commit_version);
+  }
+  return grpc::Status::OK;
+}
+
+void FakeFirestoreBackend::ApplyChange(const DocumentKey& key,
+                                       const absl::optional<ObjectValue>& value,
+                                       const SnapshotVersion& version) {
+  MutableDocument document = StoreChange(key, value, version);
+
+  for (auto& listen : listens_) {
+    std::vector<int32_t> target_ids;
+    std::vector<int32_t> removed_target_ids;
+    for (auto& kv : listen.second) {
+      ListenTarget& target = kv.second;
+      if (Matches(target.query, document)) {
+        target.matching.insert(key);
+        target_ids.push_back(kv.first);
+      } else if (target.matching.erase(key) > 0) {
+        removed_target_ids.push_back(kv.first);
+      }
+    }
+
+    if (target_ids.empty() && removed_target_ids.empty()) continue;
+    listen.first->Send(
+        EncodeDocumentChange(document, target_ids, removed_target_ids));
+  }
+}
+
+MutableDocument FakeFirestoreBackend::StoreChange(
+    const DocumentKey& key,
+    const absl::optional<ObjectValue>& value,
+    const SnapshotVersion& version) {
+  MutableDocument document =
+      value ? MutableDocument::FoundDocument(key, version, *value)
+            : MutableDocument::NoDocument(key, version);
+  documents_[key] = document;
+
+  Clock::time_point now = Clock::now();
+  recorded_changes_.push_back(DocumentChange{
+      duration_cast<microseconds>(now - last_change_time_), key, value});
+  last_change_time_ = now;
+  if (change_observer_) {
+    change_observer_(recorded_changes_.back(), now);
+  }
+  return document;
+}
+
+void FakeFirestoreBackend::SendGlobalSnapshot() {
+  for (const auto& listen : listens_) {
+    if (listen.second.empty()) continue;
+    listen.first->Send(EncodeTargetChange(
+        google_firestore_v1_TargetChange_TargetChangeType_NO_CHANGE, {},
+        version_));
+  }
+}
+
+SnapshotVersion FakeFirestoreBackend::NextVersion() {
+  int64_t now = ToMicroseconds(SnapshotVersion(Timestamp::Now()));
+  int64_t micros = std::max(now, ToMicroseconds(version_) + 1);
+  version_ = SnapshotVersion(Timestamp(
+      micros / 1000000, static_cast<int32_t>(micros % 1000000) * 1000));
+  return version_;
+}
+
+grpc::ByteBuffer FakeFirestoreBackend::EncodeTargetChange(
+    google_firestore_v1_TargetChange_TargetChangeType type,
+    const std::vector<int32_t>& target_ids,
+    const SnapshotVersion& version) const {
+  Message<google_firestore_v1_ListenResponse> response;
+  response->which_response_type =
+      google_firestore_v1_ListenResponse_target_change_tag;
+
+  google_firestore_v1_TargetChange& change = response->target_change;
+  change.target_change_type = type;
+  change.target_ids_count = nanopb::CheckedSize(target_ids.size());
+  change.target_ids = CopyTargetIds(target_ids);
+  if (version != SnapshotVersion::None()) {
+    change.resume_token =
+        MakeBytesArray(std::to_string(ToMicroseconds(version)));
+    change.read_time = Serializer::EncodeVersion(version);
+  }
+  return MakeByteBuffer(response);
+}
+
+grpc::ByteBuffer FakeFirestoreBackend::EncodeDocumentChange(
+    const MutableDocument& document,
+    const std::vector<int32_t>& target_ids,
+    const std::vector<int32_t>& removed_target_ids) const {
+  Message<google_firestore_v1_ListenResponse> response;
+
+  if (!document.is_found_document()) {
+    response->which_response_type =
+        google_firestore_v1_ListenResponse_document_delete_tag;
+    google_firestore_v1_DocumentDelete& change = response->document_delete;
+    change.document = serializer_.EncodeKey(document.key());
+    change.has_read_time = true;
+    change.read_time = Serializer::EncodeVersion(document.version());
+    change.removed_target_ids_count =
+        nanopb::CheckedSize(removed_target_ids.size());
+    change.removed_target_ids = CopyTargetIds(removed_target_ids);
+    return MakeByteBuffer(response);
+  }
+
+  response->which_response_type =
+      google_firestore_v1_ListenResponse_document_change_tag;
+  google_firestore_v1_DocumentChange& change = response->document_change;
+  change.document = serializer_.EncodeDocument(document.key(), document.data());
+  change.document.create_time = Serializer::EncodeVersion(document.version());
+  change.document.has_update_time = true;
+  change.document.update_time = Serializer::EncodeVersion(document.version());
+  change.target_ids_count = nanopb::CheckedSize(target_ids.size());
+  change.target_ids = CopyTargetIds(target_ids);
+  change.removed_target_ids_count =
+      nanopb::CheckedSize(removed_target_ids.size());
+  change.removed_target_ids = CopyTargetIds(removed_target_ids);
+  return MakeByteBuffer(response);
+}
+
+grpc::ByteBuffer FakeFirestoreBackend::EncodeExistenceFilter(
+    int32_t target_id, size_t count) const {
+  Message<google_firestore_v1_ListenResponse> response;
+  response->which_response_type =
+      google_firestore_v1_ListenResponse_filter_tag;
+
+  google_firestore_v1_ExistenceFilter& filter = response->filter;
+  filter.target_id = target_id;
+  filter.count = static_cast<int32_t>(count);
+
+  // With all bits set, every document might be in the filter.
+  filter.has_unchanged_names = true;
+  filter.unchanged_names.has_bits = true;
+  filter.unchanged_names.bits.bitmap = MakeBytesArray(std::string(1, '\xFF'));
+  filter.unchanged_names.hash_count = 1;
+  return MakeByteBuffer(response);
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,276 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_TEST_UNIT_REMOTE_FAKE_FIRESTORE_BACKEND_H_
+#define FIRESTORE_CORE_TEST_UNIT_REMOTE_FAKE_FIRESTORE_BACKEND_H_
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <set>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <unordered_map>
+#include <vector>
+
+#include "Firestore/core/src/core/query.h"
+#include "Firestore/core/src/model/database_id.h"
+#include "Firestore/core/src/model/document_key.h"
+#include "Firestore/core/src/model/mutable_document.h"
+#include "Firestore/core/src/model/object_value.h"
+#include "Firestore/core/src/model/snapshot_version.h"
+#include "Firestore/core/src/remote/serializer.h"
+#include "absl/types/optional.h"
+#include "grpcpp/generic/async_generic_service.h"
+#include "grpcpp/server.h"
+#include "grpcpp/support/byte_buffer.h"
+#include "grpcpp/support/status.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+/**
+ * An in-process stand-in for the Firestore backend: a gRPC server on a local
+ * port that implements enough of `google.firestore.v1.Firestore` (`Listen`,
+ * `Write`, `Commit`, `BatchGetDocuments` and `RunAggregationQuery`) to drive
+ * the remote layer end to end.
+ *
+ * Documents are kept in memory. Listen targets are matched with
+ * `core::Query::Matches`, ignoring limits, and every change is followed by a
+ * global snapshot. A target resumed with a resume token only receives the
+ * documents changed since; other resumed targets receive their full result
+ * set. Transforms are applied with the commit time as the local write time,
+ * and lookups return only the fields in their mask, if any, rejecting masks
+ * that contain the document key like the backend does. Existence filters are
+ * only sent for deletions made with `DeleteBehindExistenceFilter`.
+ *
+ * Besides the writes of its clients, the backend can replay changes made by
+ * "other clients", either recorded from a previous run (see
+ * `recorded_changes`) or generated with `SyntheticWorkload`.
+ */
+class FakeFirestoreBackend {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  /** A change made to a single document. */
+  struct DocumentChange {
+    /** The time to wait after the previous change before making this one. */
+    std::chrono::microseconds delay{0};
+
+    model::DocumentKey key;
+
+    /** The new contents of the document, or `nullopt` to delete it. */
+    absl::optional<model::ObjectValue> value;
+  };
+
+  /** Starts serving on an unused port of localhost. */
+  explicit FakeFirestoreBackend(model::DatabaseId database_id);
+
+  /** Stops any replay and shuts the server down, cancelling all calls. */
+  ~FakeFirestoreBackend();
+
+  FakeFirestoreBackend(const FakeFirestoreBackend&) = delete;
+  FakeFirestoreBackend& operator=(const FakeFirestoreBackend&) = delete;
+
+  /** The `host:port` to connect to, without SSL. */
+  const std::string& host() const {
+    return host_;
+  }
+
+  /**
+   * Applies the given changes in order on a background thread, waiting the
+   * delay of each change divided by `speed` before applying it. Returns
+   * immediately; a replay in progress is stopped first.
+   */
+  void Replay(std::vector<DocumentChange> changes, double speed = 1.0);
+
+  /** Blocks until the current replay, if any, has applied all its changes. */
+  void WaitForReplay();
+
+  /**
+   * Returns every change the backend has applied so far, whether written by a
+   * client or replayed, with the delays between them as observed.
+   */
+  std::vector<DocumentChange> recorded_changes() const;
+
+  /**
+   * Sets a function that is called, with the backend locked, right after a
+   * change is applied and before it is sent to listeners.
+   */
+  void set_change_observer(
+      std::function<void(const DocumentChange&, Clock::time_point)> observer);
+
+  /**
+   * Returns `count` changes to `documents` documents in `collection`, one
+   * every `1 / changes_per_second` seconds, cycling through the documents.
+   */
+  static std::vector<DocumentChange> SyntheticWorkload(
+      const model::ResourcePath& collection,
+      int documents,
+      int count,
+      double changes_per_second);
+
+  /**
+   * Deletes the document at `key` without sending the deletion to listeners.
+   * Each target the document matched receives an existence filter instead,
+   * with a bloom filter that might contain any document, so that clients can
+   * only tell which document was removed by looking them up.
+   */
+  void DeleteBehindExistenceFilter(const model::DocumentKey& key);
+
+  /**
+   * Makes all following `BatchGetDocuments` calls fail with `status`, or
+   * succeed again if it is OK.
+   */
+  void set_lookup_status(grpc::Status status);
+
+  /** The number of documents currently stored. */
+  size_t document_count() const;
+
+  /** The number of `Listen`, `Write` and unary calls received so far. */
+  int64_t call_count() const;
+
+  /**
+   * The number of documents sent to targets that were resumed with a resume
+   * token, i.e. the documents clients received again after reconnecting.
+   */
+  int64_t resumed_documents_sent() const;
+
+ private:
+  class Call;
+  class Service;
+
+  /** A listen target of a single `Listen` call. */
+  struct ListenTarget {
+    core::Query query;
+    std::set<model::DocumentKey> matching;
+  };
+
+  void RegisterCall(Call* call);
+  void UnregisterCall(Call* call);
+
+  /** Handles a request of a `Listen` call. */
+  grpc::Status HandleListen(Call* call, const grpc::ByteBuffer& request);
+
+  /** Handles a request of a `Write` call. */
+  grpc::Status HandleWrite(Call* call, const grpc::ByteBuffer& request);
+
+  /**
+   * Handles the only request of a unary or server-streaming call, returning
+   * its responses.
+   */
+  grpc::Status HandleUnary(const std::string& method,
+                           const grpc::ByteBuffer& request,
+                           std::vector<grpc::ByteBuffer>* responses);
+
+  grpc::Status Commit(const grpc::ByteBuffer& request,
+                      std::vector<grpc::ByteBuffer>* responses);
+  grpc::Status BatchGetDocuments(const grpc::ByteBuffer& request,
+                                 std::vector<grpc::ByteBuffer>* responses);
+  grpc::Status RunAggregationQuery(const grpc::ByteBuffer& request,
+                                   std::vector<grpc::ByteBuffer>* responses);
+
+  /**
+   * Applies the encoded writes atomically and fills in their results.
+   * Requires `mutex_`.
+   */
+  grpc::Status ApplyWrites(google_firestore_v1_Write* writes,
+                           pb_size_t writes_count,
+                           google_firestore_v1_WriteResult** results,
+                           model::SnapshotVersion* commit_version);
+
+  /**
+   * Stores a change and sends it to the listen targets it affects. Requires
+   * `mutex_`.
+   */
+  void ApplyChange(const model::DocumentKey& key,
+                   const absl::optional<model::ObjectValue>& value,
+                   const model::SnapshotVersion& version);
+
+  /**
+   * Stores and records a change without sending it, returning the new state
+   * of the document. Requires `mutex_`.
+   */
+  model::MutableDocument StoreChange(
+      const model::DocumentKey& key,
+      const absl::optional<model::ObjectValue>& value,
+      const model::SnapshotVersion& version);
+
+  /**
+   * Tells all listeners that they are consistent at `version_`. Requires
+   * `mutex_`.
+   */
+  void SendGlobalSnapshot();
+
+  /**
+   * Advances `version_` to the current time, or past it if the clock has not
+   * moved. Requires `mutex_`.
+   */
+  model::SnapshotVersion NextVersion();
+
+  grpc::ByteBuffer EncodeTargetChange(
+      google_firestore_v1_TargetChange_TargetChangeType type,
+      const std::vector<int32_t>& target_ids,
+      const model::SnapshotVersion& version) const;
+  grpc::ByteBuffer EncodeDocumentChange(
+      const model::MutableDocument& document,
+      const std::vector<int32_t>& target_ids,
+      const std::vector<int32_t>& removed_target_ids) const;
+
+  /**
+   * Encodes an existence filter whose bloom filter might contain any
+   * document.
+   */
+  grpc::ByteBuffer EncodeExistenceFilter(int32_t target_id,
+                                         size_t count) const;
+
+  Serializer serializer_;
+  std::string host_;
+
+  std::unique_ptr<Service> service_;
+  std::unique_ptr<grpc::Server> server_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable calls_done_;
+  std::map<model::DocumentKey, model::MutableDocument> documents_;
+  std::unordered_map<Call*, std::map<int32_t, ListenTarget>> listens_;
+  int64_t call_count_ = 0;
+  int64_t resumed_documents_sent_ = 0;
+  grpc::Status lookup_status_;
+  size_t open_calls_ = 0;
+  model::SnapshotVersion version_;
+
+  std::vector<DocumentChange> recorded_changes_;
+  Clock::time_point last_change_time_;
+  std::function<void(const DocumentChange&, Clock::time_point)>
+      change_observer_;
+
+  std::mutex replay_mutex_;
+  std::condition_variable replay_changed_;
+  std::thread replay_thread_;
+  bool stop_replay_ = false;
+};
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_TEST_UNIT_REMOTE_FAKE_FIRESTORE_BACKEND_H_
@@ -0,0 +1,395 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/test/unit/remote/fake_firestore_backend.h"
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <future>  // NOLINT(build/c++11)
+#include <memory>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "Firestore/core/src/core/database_info.h"
+#include "Firestore/core/src/credentials/auth_token.h"
+#include "Firestore/core/src/credentials/user.h"
+#include "Firestore/core/src/local/target_data.h"
+#include "Firestore/core/src/model/aggregate_alias.h"
+#include "Firestore/core/src/model/aggregate_field.h"
+#include "Firestore/core/src/model/delete_mutation.h"
+#include "Firestore/core/src/model/document.h"
+#include "Firestore/core/src/model/patch_mutation.h"
+#include "Firestore/core/src/model/set_mutation.h"
+#include "Firestore/core/src/remote/datastore.h"
+#include "Firestore/core/src/remote/firebase_metadata_provider.h"
+#include "Firestore/core/src/remote/firebase_metadata_provider_noop.h"
+#include "Firestore/core/src/remote/watch_change.h"
+#include "Firestore/core/src/remote/watch_stream.h"
+#include "Firestore/core/src/util/async_queue.h"
+#include "Firestore/core/src/util/executor.h"
+#include "Firestore/core/src/util/status.h"
+#include "Firestore/core/src/util/statusor.h"
+#include "Firestore/core/test/unit/remote/create_noop_connectivity_monitor.h"
+#include "Firestore/core/test/unit/remote/fake_credentials_provider.h"
+#include "Firestore/core/test/unit/testutil/async_testing.h"
+#include "Firestore/core/test/unit/testutil/testutil.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+using core::DatabaseInfo;
+using credentials::AuthToken;
+using credentials::User;
+using local::QueryPurpose;
+using local::TargetData;
+using model::AggregateAlias;
+using model::AggregateField;
+using model::DatabaseId;
+using model::Document;
+using model::DocumentKey;
+using model::Mutation;
+using model::ObjectValue;
+using model::SnapshotVersion;
+using nanopb::ByteString;
+using testutil::Key;
+using testutil::Map;
+using testutil::Value;
+using util::AsyncQueue;
+using util::Executor;
+using util::Status;
+using util::StatusOr;
+
+/**
+ * Records the documents a watch stream receives until the first global
+ * snapshot.
+ */
+class WatchRecorder : public WatchStreamCallback {
+ public:
+  explicit WatchRecorder(AsyncQueue* worker_queue)
+      : worker_queue_{worker_queue} {
+  }
+
+  void OnWatchStreamOpen() override {
+    opened.set_value();
+  }
+
+  void OnWatchStreamChange(const WatchChange& change,
+                           const SnapshotVersion& version) override {
+    worker_queue_->VerifyIsCurrentQueue();
+    if (change.type() == WatchChange::Type::Document) {
+      keys.push_back(
+          static_cast<const DocumentWatchChange&>(change).document_key());
+      return;
+    }
+
+    if (change.type() != WatchChange::Type::TargetChange || synced_) return;
+    const auto& target_change = static_cast<const WatchTargetChange&>(change);
+    if (target_change.target_ids().empty() &&
+        version != SnapshotVersion::None()) {
+      resume_token = target_change.resume_token();
+      snapshot_version = version;
+      synced_ = true;
+      synced.set_value();
+    }
+  }
+
+  void OnWatchStreamClose(const Status& status) override {
+    ADD_FAILURE() << "Watch stream closed: " << status.ToString();
+  }
+
+  std::promise<void> opened;
+  std::promise<void> synced;
+  std::vector<DocumentKey> keys;
+  ByteString resume_token;
+  SnapshotVersion snapshot_version;
+
+ private:
+  AsyncQueue* worker_queue_ = nullptr;
+  bool synced_ = false;
+};
+
+class FakeFirestoreBackendTest : public testing::Test {
+ public:
+  FakeFirestoreBackendTest()
+      : backend{DatabaseId{"p", "d"}},
+        worker_queue{testutil::AsyncQueueForTesting()},
+        connectivity_monitor{CreateNoOpConnectivityMonitor()},
+        firebase_metadata_provider{CreateFirebaseMetadataProviderNoOp()},
+        datastore{std::make_shared<Datastore>(
+            DatabaseInfo{DatabaseId{"p", "d"}, "", backend.host(), false},
+            worker_queue,
+            std::make_shared<FakeCredentialsProvider<AuthToken, User>>(),
+            std::make_shared<
+                FakeCredentialsProvider<std::string, std::string>>(),
+            connectivity_monitor.get(),
+            firebase_metadata_provider.get())} {
+    datastore->Start();
+  }
+
+  ~FakeFirestoreBackendTest() {
+    datastore->Shutdown();
+    // Ensure that nothing remains on the AsyncQueue before destroying it.
+    worker_queue->EnqueueBlocking([] {});
+  }
+
+  /**
+   * Listens to `target_data` with a new watch stream until the first global
+   * snapshot.
+   */
+  void Listen(const TargetData& target_data, WatchRecorder* recorder) {
+    std::shared_ptr<WatchStream> stream =
+        datastore->CreateWatchStream(recorder);
+    worker_queue->EnqueueBlocking([&] { stream->Start(); });
+    Wait(recorder->opened);
+
+    worker_queue->EnqueueBlocking([&] { stream->WatchQuery(target_data); });
+    Wait(recorder->synced);
+    worker_queue->EnqueueBlocking([&] { stream->Stop(); });
+  }
+
+  Status Commit(const std::vector<Mutation>& mutations) {
+    std::promise<Status> result;
+    datastore->CommitMutations(
+        mutations, [&](const Status& status) { result.set_value(status); });
+    return Wait(result);
+  }
+
+  std::vector<Document> Lookup(const std::vector<model::DocumentKey>& keys) {
+    std::promise<StatusOr<std::vector<Document>>> result;
+    datastore->LookupDocuments(
+        keys, [&](const StatusOr<std::vector<Document>>& documents) {
+          result.set_value(documents);
+        });
+    StatusOr<std::vector<Document>> documents = Wait(result);
+    EXPECT_TRUE(documents.ok()) << documents.status().ToString();
+    return documents.ok() ? documents.ValueOrDie() : std::vector<Document>{};
+  }
+
+  template <typename T>
+  T Wait(std::promise<T>& promise) {  // NOLINT(runtime/references)
+    std::future<T> future = promise.get_future();
+    EXPECT_EQ(std::future_status::ready, future.wait_for(testutil::kTimeout));
+    return future.get();
+  }
+
+  FakeFirestoreBackend backend;
+  std::shared_ptr<AsyncQueue> worker_queue;
+  std::unique_ptr<ConnectivityMonitor> connectivity_monitor;
+  std::unique_ptr<FirebaseMetadataProvider> firebase_metadata_provider;
+  std::shared_ptr<Datastore> datastore;
+};
+
+TEST_F(FakeFirestoreBackendTest, CommitsAndLooksUpDocuments) {
+  Status status = Commit({testutil::SetMutation("coll/a", Map("n", 1)),
+                          testutil::SetMutation("coll/b", Map("n", 2)),
+                          testutil::DeleteMutation("coll/b")});
+  ASSERT_TRUE(status.ok()) << status.ToString();
+  ASSERT_EQ(1u, backend.document_count());
+
+  std::vector<Document> documents = Lookup({Key("coll/a"), Key("coll/b")});
+  ASSERT_EQ(2u, documents.size());
+  EXPECT_TRUE(documents[0]->is_found_document());
+  EXPECT_EQ(Key("coll/a"), documents[0]->key());
+  EXPECT_EQ(*Value(1), *documents[0]->field(testutil::Field("n")));
+  EXPECT_TRUE(documents[1]->is_no_document());
+}
+
+TEST_F(FakeFirestoreBackendTest, LooksUpDocumentFields) {
+  ASSERT_TRUE(
+      Commit({testutil::SetMutation("coll/a", Map("n", 1, "s", "text"))}).ok());
+
+  std::promise<StatusOr<std::vector<Document>>> result;
+  SnapshotVersion read_time;
+  datastore->LookupDocumentFields(
+      {Key("coll/a"), Key("coll/b")}, model::FieldMask{testutil::Field("n")},
+      [&](const StatusOr<std::vector<Document>>& documents,
+          const SnapshotVersion& version) {
+        read_time = version;
+        result.set_value(documents);
+      });
+  StatusOr<std::vector<Document>> documents = Wait(result);
+  ASSERT_TRUE(documents.ok()) << documents.status().ToString();
+
+  ASSERT_EQ(2u, documents.ValueOrDie().size());
+  const Document& found = documents.ValueOrDie()[0];
+  EXPECT_TRUE(found->is_found_document());
+  EXPECT_EQ(*Value(1), *found->field(testutil::Field("n")));
+  EXPECT_FALSE(found->field(testutil::Field("s")));
+  EXPECT_TRUE(documents.ValueOrDie()[1]->is_no_document());
+  // The lookup read the documents after they were committed.
+  EXPECT_LE(found->version(), read_time);
+}
+
+TEST_F(FakeFirestoreBackendTest, RejectsWritesWithFailedPreconditions) {
+  // The patch requires the document to exist, which fails the whole commit.
+  Status status =
+      Commit({testutil::SetMutation("coll/a", Map("n", 1)),
+              testutil::PatchMutation("coll/missing", Map("n", 2))});
+  EXPECT_EQ(Error::kErrorFailedPrecondition, status.code());
+  EXPECT_EQ(0u, backend.document_count());
+}
+
+TEST_F(FakeFirestoreBackendTest, RunsAggregationQueries) {
+  ASSERT_TRUE(Commit({testutil::SetMutation("coll/a", Map("n", 1)),
+                      testutil::SetMutation("coll/b", Map("n", 2.5)),
+                      testutil::SetMutation("coll/c", Map("s", "x")),
+                      testutil::SetMutation("other/d", Map("n", 10))})
+                  .ok());
+
+  std::vector<AggregateField> aggregates{
+      AggregateField(AggregateField::OpKind::Count, AggregateAlias("count")),
+      AggregateField(AggregateField::OpKind::Sum, AggregateAlias("sum"),
+                     testutil::Field("n")),
+      AggregateField(AggregateField::OpKind::Avg, AggregateAlias("avg"),
+                     testutil::Field("n"))};
+
+  std::promise<StatusOr<ObjectValue>> result;
+  datastore->RunAggregateQuery(
+      testutil::Query("coll"), aggregates,
+      [&](const StatusOr<ObjectValue>& value) { result.set_value(value); });
+  StatusOr<ObjectValue> value = Wait(result);
+  ASSERT_TRUE(value.ok()) << value.status().ToString();
+
+  EXPECT_EQ(*Value(3), *value.ValueOrDie().Get(testutil::Field("count")));
+  EXPECT_EQ(*Value(3.5), *value.ValueOrDie().Get(testutil::Field("sum")));
+  EXPECT_EQ(*Value(1.75), *value.ValueOrDie().Get(testutil::Field("avg")));
+}
+
+TEST_F(FakeFirestoreBackendTest, ReplaysAndRecordsChanges) {
+  std::vector<FakeFirestoreBackend::DocumentChange> workload =
+      FakeFirestoreBackend::SyntheticWorkload(testutil::Resource("coll"),
+                                              /*documents=*/3, /*count=*/7,
+                                              /*changes_per_second=*/1000);
+  ASSERT_EQ(7u, workload.size());
+  EXPECT_EQ(Key("coll/doc1"), workload[4].key);
+
+  size_t observed = 0;
+  backend.set_change_observer(
+      [&](const FakeFirestoreBackend::DocumentChange& change,
+          FakeFirestoreBackend::Clock::time_point) {
+        EXPECT_TRUE(change.value.has_value());
+        ++observed;
+      });
+
+  backend.Replay(workload, /*speed=*/10);
+  backend.WaitForReplay();
+
+  EXPECT_EQ(3u, backend.document_count());
+  EXPECT_EQ(7u, observed);
+  EXPECT_EQ(7u, backend.recorded_changes().size());
+
+  std::vector<Document> documents = Lookup({Key("coll/doc0")});
+  ASSERT_EQ(1u, documents.size());
+  EXPECT_EQ(*Value(6), *documents[0]->field(testutil::Field("sequence")));
+}
+
+TEST_F(FakeFirestoreBackendTest, ListensWithBackgroundDecoding) {
+  ASSERT_TRUE(Commit({testutil::SetMutation("coll/a", Map("n", 1)),
+                      testutil::SetMutation("coll/b", Map("n", 2)),
+                      testutil::SetMutation("other/c", Map("n", 3))})
+                  .ok());
+
+  datastore->EnableBackgroundWatchDecoding();
+  WatchRecorder recorder{worker_queue.get()};
+  Listen(TargetData(testutil::Query("coll").ToTarget(), /*target_id=*/1,
+                    /*sequence_number=*/0, QueryPurpose::Listen),
+         &recorder);
+
+  EXPECT_EQ(recorder.keys,
+            (std::vector<DocumentKey>{Key("coll/a"), Key("coll/b")}));
+}
+
+TEST_F(FakeFirestoreBackendTest, DropsChangesDecodedAfterRestart) {
+  ASSERT_TRUE(Commit({testutil::SetMutation("coll/a", Map("n", 1))}).ok());
+  TargetData target_data(testutil::Query("coll").ToTarget(), /*target_id=*/1,
+                         /*sequence_number=*/0, QueryPurpose::Listen);
+
+  std::shared_ptr<Executor> decode_executor =
+      testutil::ExecutorForTesting("decode");
+  WatchRecorder recorder{worker_queue.get()};
+  std::shared_ptr<WatchStream> stream = datastore->CreateWatchStream(&recorder);
+  stream->DecodeResponsesOn(decode_executor);
+  worker_queue->EnqueueBlocking([&] { stream->Start(); });
+  Wait(recorder.opened);
+
+  // Hold back decoding until the stream has received the whole snapshot.
+  std::promise<void> decoding_blocked;
+  std::shared_future<void> unblock_decoding =
+      decoding_blocked.get_future().share();
+  decode_executor->Execute([unblock_decoding] { unblock_decoding.wait(); });
+  worker_queue->EnqueueBlocking([&] { stream->WatchQuery(target_data); });
+
+  // The target add, the document, the current and the global snapshot.
+  const int64_t snapshot_responses = 4;
+  auto deadline = std::chrono::steady_clock::now() + testutil::kTimeout;
+  int64_t received = 0;
+  while (received < snapshot_responses &&
+         std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    worker_queue->EnqueueBlocking(
+        [&] { received = stream->message_stats().messages_received; });
+  }
+  ASSERT_EQ(snapshot_responses, received);
+
+  recorder.opened = std::promise<void>{};
+  worker_queue->EnqueueBlocking([&] {
+    stream->Stop();
+    stream->Start();
+  });
+  decoding_blocked.set_value();
+  decode_executor->ExecuteBlocking([] {});
+  worker_queue->EnqueueBlocking([] {});
+  EXPECT_TRUE(recorder.keys.empty());
+
+  // The restarted stream still delivers its own changes.
+  Wait(recorder.opened);
+  worker_queue->EnqueueBlocking([&] { stream->WatchQuery(target_data); });
+  Wait(recorder.synced);
+  worker_queue->EnqueueBlocking([&] { stream->Stop(); });
+  EXPECT_EQ(recorder.keys, std::vector<DocumentKey>{Key("coll/a")});
+}
+
+TEST_F(FakeFirestoreBackendTest, ResumesListensFromResumeTokens) {
+  ASSERT_TRUE(Commit({testutil::SetMutation("coll/a", Map("n", 1)),
+                      testutil::SetMutation("coll/b", Map("n", 2))})
+                  .ok());
+
+  TargetData target_data(testutil::Query("coll").ToTarget(), /*target_id=*/1,
+                         /*sequence_number=*/0, QueryPurpose::Listen);
+  WatchRecorder initial{worker_queue.get()};
+  Listen(target_data, &initial);
+  ASSERT_FALSE(initial.resume_token.empty());
+  EXPECT_EQ(2u, initial.keys.size());
+  EXPECT_EQ(0, backend.resumed_documents_sent());
+
+  ASSERT_TRUE(Commit({testutil::SetMutation("coll/b", Map("n", 3)),
+                      testutil::SetMutation("coll/c", Map("n", 4))})
+                  .ok());
+
+  // Only the documents changed since the resume token are sent again.
+  WatchRecorder resumed{worker_queue.get()};
+  Listen(target_data.WithResumeToken(initial.resume_token,
+                                     initial.snapshot_version),
+         &resumed);
+  EXPECT_EQ(resumed.keys,
+            (std::vector<DocumentKey>{Key("coll/b"), Key("coll/c")}));
+  EXPECT_EQ(2, backend.resumed_documents_sent());
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
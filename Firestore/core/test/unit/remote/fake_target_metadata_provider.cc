@@ -32,6 +32,7 @@ namespace remote {
 using local::QueryPurpose;
 using local::TargetData;
 using model::DocumentKey;
+using model::DocumentKeyHashSet;
 using model::DocumentKeySet;
 using model::ResourcePath;
 using model::TargetId;
@@ -82,11 +83,12 @@ FakeTargetMetadataProvider::CreateEmptyResultProvider(
 
 void FakeTargetMetadataProvider::SetSyncedKeys(DocumentKeySet keys,
                                                TargetData target_data) {
-  synced_keys_[target_data.target_id()] = keys;
+  synced_keys_[target_data.target_id()] =
+      DocumentKeyHashSet::FromKeysOf(keys);
   target_data_[target_data.target_id()] = std::move(target_data);
 }
 
-DocumentKeySet FakeTargetMetadataProvider::GetRemoteKeysForTarget(
+DocumentKeyHashSet FakeTargetMetadataProvider::GetRemoteKeysForTarget(
     TargetId target_id) const {
   auto it = synced_keys_.find(target_id);
   HARD_ASSERT(it != synced_keys_.end(), "Cannot process unknown target %s",
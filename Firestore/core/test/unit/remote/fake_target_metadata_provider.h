@@ -70,7 +70,7 @@ class FakeTargetMetadataProvider : public TargetMetadataProvider {
   /** Sets or replaces the local state for the provided target data. */
   void SetSyncedKeys(model::DocumentKeySet keys, local::TargetData target_data);
 
-  model::DocumentKeySet GetRemoteKeysForTarget(
+  model::DocumentKeyHashSet GetRemoteKeysForTarget(
       model::TargetId target_id) const override;
   absl::optional<local::TargetData> GetTargetDataForTarget(
       model::TargetId target_id) const override;
@@ -85,7 +85,7 @@ class FakeTargetMetadataProvider : public TargetMetadataProvider {
   }
 
  private:
-  std::unordered_map<model::TargetId, model::DocumentKeySet> synced_keys_;
+  std::unordered_map<model::TargetId, model::DocumentKeyHashSet> synced_keys_;
   std::unordered_map<model::TargetId, local::TargetData> target_data_;
   model::DatabaseId database_id_ =
       model::DatabaseId("test-project", "(default)");
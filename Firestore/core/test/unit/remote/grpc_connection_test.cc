@@ -231,6 +231,27 @@ TEST_F(GrpcConnectionTest, ShutdownFastFinishesActiveCalls) {
   EXPECT_NO_THROW(baz.reset());
 }
 
+TEST_F(GrpcConnectionTest, CompressesStreamsIfEnabled) {
+  ConnectivityObserver observer;
+  std::unique_ptr<GrpcStream> uncompressed = tester.CreateStream(&observer);
+  EXPECT_EQ(uncompressed->context()->compression_algorithm(),
+            GRPC_COMPRESS_NONE);
+
+  GrpcStreamTester compressed_tester{
+      worker_queue, connectivity_monitor.get(),
+      DatabaseInfo{model::DatabaseId{"foo", "bar"}, "",
+                   "firestore.googleapis.com", false,
+                   /* compression_enabled= */ true}};
+  std::unique_ptr<GrpcStream> compressed =
+      compressed_tester.CreateStream(&observer);
+  EXPECT_EQ(compressed->context()->compression_algorithm(), GRPC_COMPRESS_GZIP);
+
+  // Only streams are compressed.
+  std::unique_ptr<GrpcStreamingReader> reader =
+      compressed_tester.CreateStreamingReader();
+  EXPECT_EQ(reader->context()->compression_algorithm(), GRPC_COMPRESS_NONE);
+}
+
 }  // namespace remote
 }  // namespace firestore
 }  // namespace firebase
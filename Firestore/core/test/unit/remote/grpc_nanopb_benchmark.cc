@@ -0,0 +1,116 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string>
+#include <vector>
+
+#include "Firestore/Protos/nanopb/google/firestore/v1/firestore.nanopb.h"
+#include "Firestore/core/src/model/database_id.h"
+#include "Firestore/core/src/model/mutation.h"
+#include "Firestore/core/src/model/set_mutation.h"
+#include "Firestore/core/src/nanopb/byte_string.h"
+#include "Firestore/core/src/nanopb/message.h"
+#include "Firestore/core/src/remote/grpc_nanopb.h"
+#include "Firestore/core/src/remote/remote_objc_bridge.h"
+#include "Firestore/core/src/remote/serializer.h"
+#include "Firestore/core/src/util/hard_assert.h"
+#include "Firestore/core/test/unit/testutil/testutil.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+namespace {
+
+using model::DatabaseId;
+using model::Mutation;
+using nanopb::ByteString;
+using nanopb::Message;
+using testutil::Map;
+
+Message<google_firestore_v1_WriteRequest> MakeWriteRequest(int mutations) {
+  WriteStreamSerializer serializer{Serializer{DatabaseId{"p", "d"}}};
+  std::vector<Mutation> batch;
+  for (int i = 0; i < mutations; ++i) {
+    batch.push_back(testutil::SetMutation(
+        "coll/doc" + std::to_string(i),
+        Map("title", "some title", "count", i, "score", 1.5, "tags",
+            Map("a", true, "b", false), "owner",
+            "users/" + std::to_string(i))));
+  }
+  return serializer.EncodeWriteMutationsRequest(batch,
+                                                ByteString("stream_token"));
+}
+
+bool AppendSlicePerWrite(pb_ostream_t* stream,
+                         const pb_byte_t* buf,
+                         size_t count) {
+  auto slices = static_cast<std::vector<grpc::Slice>*>(stream->state);
+  slices->emplace_back(buf, count);
+  return true;
+}
+
+/**
+ * Encodes a write request of `state.range(0)` mutations with
+ * `ByteBufferWriter`.
+ */
+void BM_EncodeWriteRequest(benchmark::State& state) {
+  Message<google_firestore_v1_WriteRequest> request =
+      MakeWriteRequest(static_cast<int>(state.range(0)));
+
+  size_t bytes = 0;
+  for (auto _ : state) {
+    grpc::ByteBuffer buffer = MakeByteBuffer(request);
+    bytes = buffer.Length();
+    benchmark::DoNotOptimize(buffer);
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * bytes));
+}
+BENCHMARK(BM_EncodeWriteRequest)->Arg(1)->Arg(10)->Arg(100)->Arg(500);
+
+/**
+ * Encodes the same request into one slice per nanopb write, for comparison.
+ */
+void BM_EncodeWriteRequestSlicePerWrite(benchmark::State& state) {
+  Message<google_firestore_v1_WriteRequest> request =
+      MakeWriteRequest(static_cast<int>(state.range(0)));
+
+  size_t bytes = 0;
+  for (auto _ : state) {
+    std::vector<grpc::Slice> slices;
+    pb_ostream_t stream{};
+    stream.callback = AppendSlicePerWrite;
+    stream.state = &slices;
+    stream.max_size = SIZE_MAX;
+    bool encoded = pb_encode(&stream, request.fields(), request.get());
+    HARD_ASSERT(encoded);
+
+    grpc::ByteBuffer buffer{slices.data(), slices.size()};
+    bytes = buffer.Length();
+    benchmark::DoNotOptimize(buffer);
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * bytes));
+}
+BENCHMARK(BM_EncodeWriteRequestSlicePerWrite)
+    ->Arg(1)
+    ->Arg(10)
+    ->Arg(100)
+    ->Arg(500);
+
+}  // namespace
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
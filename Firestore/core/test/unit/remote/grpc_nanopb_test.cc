@@ -0,0 +1,173 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/remote/grpc_nanopb.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Firestore/Protos/nanopb/google/firestore/v1/firestore.nanopb.h"
+#include "Firestore/core/src/model/database_id.h"
+#include "Firestore/core/src/model/mutation.h"
+#include "Firestore/core/src/model/set_mutation.h"
+#include "Firestore/core/src/nanopb/byte_string.h"
+#include "Firestore/core/src/nanopb/message.h"
+#include "Firestore/core/src/nanopb/writer.h"
+#include "Firestore/core/src/remote/remote_objc_bridge.h"
+#include "Firestore/core/src/remote/serializer.h"
+#include "Firestore/core/test/unit/testutil/status_testing.h"
+#include "Firestore/core/test/unit/testutil/testutil.h"
+#include "absl/memory/memory.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+namespace {
+
+using model::DatabaseId;
+using model::Mutation;
+using nanopb::ByteString;
+using nanopb::Message;
+using nanopb::StringWriter;
+using testutil::Map;
+
+Message<google_firestore_v1_WriteRequest> MakeWriteRequest(int mutations) {
+  WriteStreamSerializer serializer{Serializer{DatabaseId{"p", "d"}}};
+  std::vector<Mutation> batch;
+  for (int i = 0; i < mutations; ++i) {
+    batch.push_back(testutil::SetMutation(
+        "coll/doc" + std::to_string(i),
+        Map("title", "some title", "count", i, "tags", Map("a", true))));
+  }
+  return serializer.EncodeWriteMutationsRequest(batch,
+                                                ByteString("stream_token"));
+}
+
+/** Splits `bytes` into a buffer of slices of at most `slice_size` bytes. */
+grpc::ByteBuffer SplitIntoSlices(const std::string& bytes, size_t slice_size) {
+  std::vector<grpc::Slice> slices;
+  for (size_t pos = 0; pos < bytes.size(); pos += slice_size) {
+    std::string chunk = bytes.substr(pos, slice_size);
+    slices.emplace_back(chunk.data(), chunk.size());
+  }
+  return grpc::ByteBuffer{slices.data(), slices.size()};
+}
+
+std::string Encode(const Message<google_firestore_v1_WriteRequest>& request) {
+  StringWriter writer;
+  writer.Write(request.fields(), request.get());
+  return writer.Release();
+}
+
+std::vector<grpc::Slice> Slices(const grpc::ByteBuffer& buffer) {
+  std::vector<grpc::Slice> slices;
+  EXPECT_TRUE(buffer.Dump(&slices).ok());
+  return slices;
+}
+
+}  // namespace
+
+TEST(ByteBufferWriterTest, EncodesEachMessageIntoOneSlice) {
+  Message<google_firestore_v1_WriteRequest> request = MakeWriteRequest(100);
+  grpc::ByteBuffer buffer = MakeByteBuffer(request);
+
+  std::string expected_bytes = Encode(request);
+
+  std::vector<grpc::Slice> slices = Slices(buffer);
+  ASSERT_EQ(1u, slices.size());
+  ASSERT_EQ(expected_bytes.size(), buffer.Length());
+  ASSERT_EQ(expected_bytes,
+            std::string(reinterpret_cast<const char*>(slices[0].begin()),
+                        slices[0].size()));
+
+  ByteBufferReader reader{buffer};
+  auto parsed =
+      Message<google_firestore_v1_WriteRequest>::TryParse(&reader);
+  ASSERT_OK(reader.status());
+  ASSERT_EQ(100u, parsed->writes_count);
+}
+
+TEST(ByteBufferWriterTest, AppendsConsecutiveMessages) {
+  Message<google_firestore_v1_WriteRequest> first = MakeWriteRequest(1);
+  Message<google_firestore_v1_WriteRequest> second = MakeWriteRequest(2);
+
+  ByteBufferWriter writer;
+  writer.Write(first.fields(), first.get());
+  writer.Write(second.fields(), second.get());
+  grpc::ByteBuffer buffer = writer.Release();
+
+  ASSERT_EQ(2u, Slices(buffer).size());
+  ASSERT_EQ(MakeByteBuffer(first).Length() + MakeByteBuffer(second).Length(),
+            buffer.Length());
+
+  // Releasing leaves the writer empty.
+  ASSERT_EQ(0u, writer.Release().Length());
+}
+
+TEST(ByteBufferWriterTest, EncodesEmptyMessages) {
+  Message<google_firestore_v1_WriteRequest> request;
+  ASSERT_EQ(0u, MakeByteBuffer(request).Length());
+}
+
+TEST(ByteBufferReaderTest, ReadsAcrossSlices) {
+  Message<google_firestore_v1_WriteRequest> request = MakeWriteRequest(20);
+  std::string bytes = Encode(request);
+
+  for (size_t slice_size : {size_t{1}, size_t{7}, size_t{1000}, bytes.size()}) {
+    SCOPED_TRACE(slice_size);
+    grpc::ByteBuffer buffer = SplitIntoSlices(bytes, slice_size);
+    ByteBufferReader reader{buffer};
+
+    auto parsed =
+        Message<google_firestore_v1_WriteRequest>::TryParse(&reader);
+    ASSERT_OK(reader.status());
+    ASSERT_EQ(20u, parsed->writes_count);
+    ASSERT_EQ(bytes, Encode(parsed));
+    ASSERT_EQ(bytes, std::string(reader.bytes()));
+  }
+}
+
+TEST(ByteBufferReaderTest, OutlivesTheBuffer) {
+  Message<google_firestore_v1_WriteRequest> request = MakeWriteRequest(3);
+  std::string bytes = Encode(request);
+
+  std::unique_ptr<ByteBufferReader> reader;
+  {
+    grpc::ByteBuffer buffer = SplitIntoSlices(bytes, 16);
+    reader = absl::make_unique<ByteBufferReader>(buffer);
+  }
+
+  auto parsed =
+      Message<google_firestore_v1_WriteRequest>::TryParse(reader.get());
+  ASSERT_OK(reader->status());
+  ASSERT_EQ(3u, parsed->writes_count);
+}
+
+TEST(ByteBufferReaderTest, FailsOnTruncatedMessages) {
+  std::string bytes = Encode(MakeWriteRequest(3));
+  grpc::ByteBuffer buffer =
+      SplitIntoSlices(bytes.substr(0, bytes.size() - 5), 16);
+
+  ByteBufferReader reader{buffer};
+  Message<google_firestore_v1_WriteRequest>::TryParse(&reader);
+  EXPECT_NOT_OK(reader.status());
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
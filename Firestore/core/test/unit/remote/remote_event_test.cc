@@ -676,6 +676,111 @@ TEST_F(RemoteEventTest,
   ASSERT_EQ(event.document_updates().size(), 0);
 }
 
+TEST_F(RemoteEventTest,
+       ExistenceFilterMismatchWithBloomFilterFalsePositiveIsReconciled) {
+  std::unordered_map<TargetId, TargetData> target_map = ActiveQueries({1});
+
+  MutableDocument doc1 = Doc("docs/1", 1, Map("value", 1));
+  MutableDocument doc2 = Doc("docs/2", 2, Map("value", 2));
+  WatchChangeAggregator aggregator =
+      CreateAggregator(target_map, no_outstanding_responses_,
+                       DocumentKeySet{doc1.key(), doc2.key()}, Changes());
+  aggregator.EnableMismatchReconciliation();
+
+  // The given BloomFilter will return true on both MightContain(doc1) and
+  // MightContain(doc2), so either of them may have been removed.
+  ExistenceFilterWatchChange existence_filter{
+      ExistenceFilter{1, BloomFilterParameters{{0x42, 0xFE}, 2, 7}}, 1};
+  aggregator.HandleExistenceFilter(existence_filter);
+
+  RemoteEvent event = aggregator.CreateRemoteEvent(testutil::Version(3));
+  ASSERT_EQ(event.target_mismatches().size(), 0);
+  ASSERT_EQ(event.target_reconciliations().size(), 1);
+  ASSERT_EQ(event.target_reconciliations().at(1),
+            (DocumentKeySet{doc1.key(), doc2.key()}));
+  ASSERT_EQ(event.target_changes().at(1).resume_token(), resume_token1_);
+  ASSERT_EQ(event.document_updates().size(), 0);
+
+  // The lookup found that only doc2 was removed.
+  aggregator.HandleReconciledDocuments(1, DocumentKeySet{doc2.key()},
+                                       testutil::Version(4));
+  event = aggregator.CreateRemoteEvent(testutil::Version(4));
+
+  // The target keeps its resume token.
+  TargetChange target_change{resume_token1_, false, DocumentKeySet{},
+                             DocumentKeySet{}, DocumentKeySet{doc2.key()}};
+  ASSERT_TRUE(event.target_changes().at(1) == target_change);
+  ASSERT_EQ(event.target_mismatches().size(), 0);
+  ASSERT_EQ(event.target_reconciliations().size(), 0);
+  ASSERT_EQ(event.document_updates().size(), 0);
+}
+
+TEST_F(RemoteEventTest, ReconciledTargetIsNotCurrentUntilReadTime) {
+  std::unordered_map<TargetId, TargetData> target_map = ActiveQueries({1});
+
+  MutableDocument doc1 = Doc("docs/1", 1, Map("value", 1));
+  MutableDocument doc2 = Doc("docs/2", 2, Map("value", 2));
+  WatchChangeAggregator aggregator =
+      CreateAggregator(target_map, no_outstanding_responses_,
+                       DocumentKeySet{doc1.key(), doc2.key()}, Changes());
+  aggregator.EnableMismatchReconciliation();
+  aggregator.HandleTargetChange(
+      WatchTargetChange{WatchTargetChangeState::Current, {1}, resume_token1_});
+  aggregator.CreateRemoteEvent(testutil::Version(2));
+
+  aggregator.HandleExistenceFilter(ExistenceFilterWatchChange{
+      ExistenceFilter{1, BloomFilterParameters{{0x42, 0xFE}, 2, 7}}, 1});
+  RemoteEvent event = aggregator.CreateRemoteEvent(testutil::Version(3));
+  ASSERT_EQ(event.target_reconciliations().size(), 1);
+  ASSERT_FALSE(event.target_changes().at(1).current());
+
+  // Watch updated doc1 while the lookups were in flight, which found both
+  // documents removed as of version 5.
+  MutableDocument updated_doc1 = Doc("docs/1", 4, Map("value", 3));
+  aggregator.HandleDocumentChange(
+      DocumentWatchChange{{1}, {}, updated_doc1.key(), updated_doc1});
+  aggregator.HandleReconciledDocuments(
+      1, DocumentKeySet{doc1.key(), doc2.key()}, testutil::Version(5));
+
+  // The removals are not consistent with an earlier snapshot.
+  event = aggregator.CreateRemoteEvent(testutil::Version(4));
+  TargetChange target_change1{resume_token1_, false, DocumentKeySet{},
+                              DocumentKeySet{updated_doc1.key()},
+                              DocumentKeySet{}};
+  ASSERT_TRUE(event.target_changes().at(1) == target_change1);
+
+  // Only doc2 is removed, and the target is current again.
+  event = aggregator.CreateRemoteEvent(testutil::Version(5));
+  TargetChange target_change2{resume_token1_, true, DocumentKeySet{},
+                              DocumentKeySet{}, DocumentKeySet{doc2.key()}};
+  ASSERT_TRUE(event.target_changes().at(1) == target_change2);
+}
+
+TEST_F(RemoteEventTest, FailedReconciliationResetsTarget) {
+  std::unordered_map<TargetId, TargetData> target_map = ActiveQueries({1});
+
+  MutableDocument doc1 = Doc("docs/1", 1, Map("value", 1));
+  MutableDocument doc2 = Doc("docs/2", 2, Map("value", 2));
+  WatchChangeAggregator aggregator =
+      CreateAggregator(target_map, no_outstanding_responses_,
+                       DocumentKeySet{doc1.key(), doc2.key()}, Changes());
+  aggregator.EnableMismatchReconciliation();
+  aggregator.HandleExistenceFilter(ExistenceFilterWatchChange{
+      ExistenceFilter{1, BloomFilterParameters{{0x42, 0xFE}, 2, 7}}, 1});
+  aggregator.CreateRemoteEvent(testutil::Version(3));
+
+  aggregator.HandleFailedReconciliation(1);
+  RemoteEvent event = aggregator.CreateRemoteEvent(testutil::Version(4));
+
+  TargetChange target_change{ByteString(), false, DocumentKeySet{},
+                             DocumentKeySet{},
+                             DocumentKeySet{doc1.key(), doc2.key()}};
+  ASSERT_TRUE(event.target_changes().at(1) == target_change);
+  ASSERT_EQ(event.target_mismatches().size(), 1);
+  ASSERT_EQ(event.target_mismatches().at(1),
+            QueryPurpose::ExistenceFilterMismatchBloom);
+}
+
 TEST_F(RemoteEventTest, ExistenceFilterMismatchRemovesCurrentChanges) {
   std::unordered_map<TargetId, TargetData> target_map = ActiveQueries({1});
 
@@ -0,0 +1,269 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/api/settings.h"
+#include "Firestore/core/src/core/database_info.h"
+#include "Firestore/core/src/core/event_listener.h"
+#include "Firestore/core/src/core/firestore_client.h"
+#include "Firestore/core/src/core/listen_options.h"
+#include "Firestore/core/src/core/query_listener.h"
+#include "Firestore/core/src/core/view_snapshot.h"
+#include "Firestore/core/src/credentials/empty_credentials_provider.h"
+#include "Firestore/core/src/local/persistence_tracer.h"
+#include "Firestore/core/src/model/set_mutation.h"
+#include "Firestore/core/src/remote/firebase_metadata_provider_noop.h"
+#include "Firestore/core/src/util/async_queue.h"
+#include "Firestore/core/src/util/executor.h"
+#include "Firestore/core/src/util/hard_assert.h"
+#include "Firestore/core/src/util/status.h"
+#include "Firestore/core/src/util/statusor.h"
+#include "Firestore/core/test/unit/remote/fake_firestore_backend.h"
+#include "Firestore/core/test/unit/testutil/testutil.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+namespace {
+
+using core::FirestoreClient;
+using core::ViewSnapshot;
+using local::LatencyHistogram;
+using model::DatabaseId;
+using util::AsyncQueue;
+using util::Executor;
+using util::Status;
+using util::StatusOr;
+using Clock = FakeFirestoreBackend::Clock;
+
+/** The number of documents changed in every iteration of the listen test. */
+constexpr int kListenChanges = 100;
+
+/** A `FirestoreClient` without persistence, connected to a fake backend. */
+class LoadTest {
+ public:
+  LoadTest() : backend_(DatabaseId{"p", "d"}) {
+    api::Settings settings;
+    settings.set_host(backend_.host());
+    settings.set_ssl_enabled(false);
+    settings.set_persistence_enabled(false);
+
+    client_ = FirestoreClient::Create(
+        core::DatabaseInfo{DatabaseId{"p", "d"}, "load", backend_.host(),
+                           false},
+        settings, std::make_shared<credentials::EmptyAuthCredentialsProvider>(),
+        std::make_shared<credentials::EmptyAppCheckCredentialsProvider>(),
+        Executor::CreateSerial("com.google.firebase.firestore.load.user"),
+        AsyncQueue::Create(
+            Executor::CreateSerial("com.google.firebase.firestore.load")),
+        CreateFirebaseMetadataProviderNoOp());
+  }
+
+  ~LoadTest() {
+    client_->Dispose();
+  }
+
+  FakeFirestoreBackend& backend() {
+    return backend_;
+  }
+
+  FirestoreClient& client() {
+    return *client_;
+  }
+
+ private:
+  FakeFirestoreBackend backend_;
+  std::shared_ptr<FirestoreClient> client_;
+};
+
+/** Counts down completions from other threads. */
+class Latch {
+ public:
+  void Add(int count) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_ += count;
+  }
+
+  void CountDown() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    --pending_;
+    done_.notify_all();
+  }
+
+  void Wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this] { return pending_ <= 0; });
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable done_;
+  int pending_ = 0;
+};
+
+void ReportLatency(benchmark::State& state, const LatencyHistogram& latency) {
+  state.counters["p50_us"] =
+      static_cast<double>(latency.Percentile(50).count());
+  state.counters["p99_us"] =
+      static_cast<double>(latency.Percentile(99).count());
+  state.counters["max_us"] = static_cast<double>(latency.max().count());
+}
+
+/**
+ * Writes batches of `state.range(0)` concurrent single-document sets and
+ * waits for the backend to acknowledge all of them.
+ */
+void BM_WriteThroughput(benchmark::State& state) {
+  LoadTest test;
+  auto batch_size = static_cast<int>(state.range(0));
+
+  LatencyHistogram latency;
+  std::mutex latency_mutex;
+  int64_t sequence = 0;
+  for (auto _ : state) {
+    Latch acknowledged;
+    acknowledged.Add(batch_size);
+    for (int i = 0; i < batch_size; ++i, ++sequence) {
+      std::string path = "writes/doc" + std::to_string(i);
+      Clock::time_point start = Clock::now();
+      test.client().WriteMutations(
+          {testutil::SetMutation(path, testutil::Map("sequence", sequence))},
+          [&, start](const Status& status) {
+            HARD_ASSERT(status.ok(), "Write failed: %s", status.ToString());
+            auto elapsed = Clock::now() - start;
+            {
+              std::lock_guard<std::mutex> lock(latency_mutex);
+              latency.Record(
+                  std::chrono::duration_cast<std::chrono::microseconds>(
+                      elapsed));
+            }
+            acknowledged.CountDown();
+          });
+    }
+    acknowledged.Wait();
+  }
+
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *
+                          batch_size);
+  ReportLatency(state, latency);
+}
+BENCHMARK(BM_WriteThroughput)
+    ->Arg(1)
+    ->Arg(10)
+    ->Arg(100)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+/**
+ * Listens to a collection while the backend changes `kListenChanges` of its
+ * documents at `state.range(0)` changes per second, measuring the time from
+ * each change being applied on the backend to it reaching the listener.
+ */
+void BM_ListenLatency(benchmark::State& state) {
+  LoadTest test;
+  auto changes_per_second = static_cast<double>(state.range(0));
+  model::FieldPath sequence_field = testutil::Field("sequence");
+
+  std::mutex mutex;
+  std::unordered_map<int64_t, Clock::time_point> applied;
+  LatencyHistogram latency;
+  Latch received;
+
+  test.backend().set_change_observer(
+      [&](const FakeFirestoreBackend::DocumentChange& change,
+          Clock::time_point time) {
+        std::lock_guard<std::mutex> lock(mutex);
+        applied[change.value->Get(sequence_field)->integer_value] = time;
+      });
+
+  Latch listening;
+  listening.Add(1);
+  bool first_snapshot = true;
+  auto listener = test.client().ListenToQuery(
+      testutil::Query("listen"), core::ListenOptions::DefaultOptions(),
+      core::EventListener<ViewSnapshot>::Create(
+          [&](const StatusOr<ViewSnapshot>& snapshot) {
+            HARD_ASSERT(snapshot.ok(), "Listen failed: %s",
+                        snapshot.status().ToString());
+            Clock::time_point now = Clock::now();
+            if (first_snapshot) {
+              first_snapshot = false;
+              listening.CountDown();
+              return;
+            }
+
+            const ViewSnapshot& view = snapshot.ValueOrDie();
+            for (const auto& change : view.document_changes()) {
+              int64_t sequence =
+                  change.document()->field(sequence_field)->integer_value;
+              {
+                std::lock_guard<std::mutex> lock(mutex);
+                auto found = applied.find(sequence);
+                HARD_ASSERT(found != applied.end());
+                latency.Record(
+                    std::chrono::duration_cast<std::chrono::microseconds>(
+                        now - found->second));
+                applied.erase(found);
+              }
+              received.CountDown();
+            }
+          }));
+  listening.Wait();
+
+  int64_t sequence = 0;
+  for (auto _ : state) {
+    std::vector<FakeFirestoreBackend::DocumentChange> changes =
+        FakeFirestoreBackend::SyntheticWorkload(
+            testutil::Resource("listen"), kListenChanges, kListenChanges,
+            changes_per_second);
+    // Every iteration must change the documents' contents for the changes to
+    // reach the listener.
+    for (FakeFirestoreBackend::DocumentChange& change : changes) {
+      change.value->Set(sequence_field, testutil::Value(sequence++));
+    }
+
+    received.Add(kListenChanges);
+    test.backend().Replay(std::move(changes));
+    received.Wait();
+  }
+
+  test.client().RemoveListener(listener);
+  test.backend().set_change_observer(nullptr);
+
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *
+                          kListenChanges);
+  ReportLatency(state, latency);
+}
+BENCHMARK(BM_ListenLatency)
+    ->Arg(100)
+    ->Arg(1000)
+    ->Arg(10000)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
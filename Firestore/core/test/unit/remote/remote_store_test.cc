@@ -0,0 +1,280 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/remote/remote_store.h"
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <functional>
+#include <future>  // NOLINT(build/c++11)
+#include <memory>
+#include <thread>  // NOLINT(build/c++11)
+#include <unordered_map>
+#include <vector>
+
+#include "Firestore/core/src/core/database_info.h"
+#include "Firestore/core/src/credentials/auth_token.h"
+#include "Firestore/core/src/credentials/user.h"
+#include "Firestore/core/src/local/local_store.h"
+#include "Firestore/core/src/local/memory_persistence.h"
+#include "Firestore/core/src/local/query_engine.h"
+#include "Firestore/core/src/local/target_data.h"
+#include "Firestore/core/src/model/document_key_set.h"
+#include "Firestore/core/src/model/mutation.h"
+#include "Firestore/core/src/model/mutation_batch_result.h"
+#include "Firestore/core/src/model/set_mutation.h"
+#include "Firestore/core/src/remote/datastore.h"
+#include "Firestore/core/src/remote/firebase_metadata_provider.h"
+#include "Firestore/core/src/remote/firebase_metadata_provider_noop.h"
+#include "Firestore/core/src/remote/remote_event.h"
+#include "Firestore/core/src/util/async_queue.h"
+#include "Firestore/core/src/util/status.h"
+#include "Firestore/core/test/unit/remote/create_noop_connectivity_monitor.h"
+#include "Firestore/core/test/unit/remote/fake_credentials_provider.h"
+#include "Firestore/core/test/unit/remote/fake_firestore_backend.h"
+#include "Firestore/core/test/unit/testutil/async_testing.h"
+#include "Firestore/core/test/unit/testutil/testutil.h"
+#include "absl/memory/memory.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+namespace {
+
+using core::DatabaseInfo;
+using credentials::AuthToken;
+using credentials::User;
+using local::LocalStore;
+using local::MemoryPersistence;
+using local::QueryEngine;
+using local::TargetData;
+using model::BatchId;
+using model::DatabaseId;
+using model::DocumentKeyHashSet;
+using model::DocumentKeySet;
+using model::MutationBatchResult;
+using model::OnlineState;
+using model::TargetId;
+using testutil::Key;
+using testutil::Map;
+using util::AsyncQueue;
+using util::Status;
+
+/**
+ * Stands in for the sync engine: applies remote events to the local store and
+ * keeps track of whether watch considers each target current.
+ */
+class FakeSyncEngine : public RemoteStoreCallback {
+ public:
+  explicit FakeSyncEngine(LocalStore* local_store) : local_store_{local_store} {
+  }
+
+  void ApplyRemoteEvent(const RemoteEvent& remote_event) override {
+    local_store_->ApplyRemoteEvent(remote_event);
+    for (const auto& entry : remote_event.target_changes()) {
+      current[entry.first] = entry.second.current();
+    }
+  }
+
+  void HandleRejectedListen(TargetId target_id, Status error) override {
+    ADD_FAILURE() << "Target " << target_id
+                  << " rejected: " << error.ToString();
+  }
+
+  void HandleSuccessfulWrite(MutationBatchResult) override {
+  }
+
+  void HandleRejectedWrite(BatchId, Status) override {
+  }
+
+  void HandleOnlineStateChange(OnlineState) override {
+  }
+
+  DocumentKeyHashSet GetRemoteKeys(TargetId target_id) const override {
+    DocumentKeyHashSet result;
+    for (const auto& key : local_store_->GetRemoteDocumentKeys(target_id)) {
+      result = result.insert(key);
+    }
+    return result;
+  }
+
+  std::unordered_map<TargetId, bool> current;
+
+ private:
+  LocalStore* local_store_ = nullptr;
+};
+
+class RemoteStoreTest : public testing::Test {
+ public:
+  RemoteStoreTest()
+      : backend{DatabaseId{"p", "d"}},
+        worker_queue{testutil::AsyncQueueForTesting()},
+        persistence{MemoryPersistence::WithEagerGarbageCollector()},
+        local_store{persistence.get(), &query_engine, User::Unauthenticated()},
+        connectivity_monitor{CreateNoOpConnectivityMonitor()},
+        firebase_metadata_provider{CreateFirebaseMetadataProviderNoOp()},
+        datastore{std::make_shared<Datastore>(
+            DatabaseInfo{DatabaseId{"p", "d"}, "", backend.host(), false},
+            worker_queue,
+            std::make_shared<FakeCredentialsProvider<AuthToken, User>>(),
+            std::make_shared<
+                FakeCredentialsProvider<std::string, std::string>>(),
+            connectivity_monitor.get(),
+            firebase_metadata_provider.get())},
+        sync_engine{&local_store} {
+    worker_queue->EnqueueBlocking([&] {
+      remote_store = absl::make_unique<RemoteStore>(
+          &local_store, datastore, worker_queue, connectivity_monitor.get(),
+          [](OnlineState) {});
+      remote_store->set_sync_engine(&sync_engine);
+      remote_store->EnableExistenceFilterReconciliation(/*max_batch_size=*/2);
+      local_store.Start();
+      remote_store->Start();
+    });
+  }
+
+  ~RemoteStoreTest() {
+    worker_queue->EnqueueBlocking([&] { remote_store->Shutdown(); });
+    // Ensure that nothing remains on the AsyncQueue before destroying it.
+    worker_queue->EnqueueBlocking([] {});
+  }
+
+  void Commit(const std::vector<model::Mutation>& mutations) {
+    std::promise<Status> result;
+    worker_queue->Enqueue([&] {
+      datastore->CommitMutations(
+          mutations, [&](const Status& status) { result.set_value(status); });
+    });
+    std::future<Status> status = result.get_future();
+    ASSERT_EQ(std::future_status::ready, status.wait_for(testutil::kTimeout));
+    Status committed = status.get();
+    ASSERT_TRUE(committed.ok()) << committed.ToString();
+  }
+
+  /** Listens to the "coll" collection and returns its target id. */
+  TargetId Listen() {
+    TargetId target_id = 0;
+    worker_queue->EnqueueBlocking([&] {
+      TargetData target_data =
+          local_store.AllocateTarget(testutil::Query("coll").ToTarget());
+      target_id = target_data.target_id();
+      remote_store->Listen(std::move(target_data));
+    });
+    return target_id;
+  }
+
+  /**
+   * Waits until `condition`, which is checked on the worker queue, holds.
+   * Returns whether it did before the timeout.
+   */
+  bool WaitUntil(const std::function<bool()>& condition) {
+    auto deadline = std::chrono::steady_clock::now() + testutil::kTimeout;
+    bool done = false;
+    while (std::chrono::steady_clock::now() < deadline) {
+      worker_queue->EnqueueBlocking([&] { done = condition(); });
+      if (done) return true;
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return false;
+  }
+
+  /** Waits until `target_id` is current with exactly the `expected` keys. */
+  bool WaitUntilSynced(TargetId target_id, const DocumentKeySet& expected) {
+    return WaitUntil([&] {
+      return sync_engine.current[target_id] &&
+             local_store.GetRemoteDocumentKeys(target_id) == expected;
+    });
+  }
+
+  RemoteStore::ReconciliationStats reconciliation_stats() {
+    RemoteStore::ReconciliationStats stats;
+    worker_queue->EnqueueBlocking(
+        [&] { stats = remote_store->reconciliation_stats(); });
+    return stats;
+  }
+
+  FakeFirestoreBackend backend;
+  std::shared_ptr<AsyncQueue> worker_queue;
+  std::unique_ptr<MemoryPersistence> persistence;
+  QueryEngine query_engine;
+  LocalStore local_store;
+  std::unique_ptr<ConnectivityMonitor> connectivity_monitor;
+  std::unique_ptr<FirebaseMetadataProvider> firebase_metadata_provider;
+  std::shared_ptr<Datastore> datastore;
+  FakeSyncEngine sync_engine;
+  std::unique_ptr<RemoteStore> remote_store;
+};
+
+TEST_F(RemoteStoreTest, ReconcilesExistenceFilterMismatchesWithLookups) {
+  Commit({testutil::SetMutation("coll/a", Map("n", 1)),
+          testutil::SetMutation("coll/b", Map("n", 2)),
+          testutil::SetMutation("coll/c", Map("n", 3))});
+  TargetId target_id = Listen();
+  ASSERT_TRUE(WaitUntilSynced(
+      target_id, DocumentKeySet{Key("coll/a"), Key("coll/b"), Key("coll/c")}));
+
+  int64_t calls = backend.call_count();
+  backend.DeleteBehindExistenceFilter(Key("coll/b"));
+  ASSERT_TRUE(WaitUntil(
+      [&] { return remote_store->reconciliation_stats().resets_avoided > 0; }));
+  // The three documents were looked up two at a time.
+  EXPECT_EQ(calls + 2, backend.call_count());
+
+  // The target is not current until the removal is raised, with the next
+  // global snapshot.
+  worker_queue->EnqueueBlocking(
+      [&] { EXPECT_FALSE(sync_engine.current[target_id]); });
+  Commit({testutil::SetMutation("other/d", Map("n", 4))});
+  EXPECT_TRUE(
+      WaitUntilSynced(target_id, DocumentKeySet{Key("coll/a"), Key("coll/c")}));
+
+  RemoteStore::ReconciliationStats stats = reconciliation_stats();
+  EXPECT_EQ(1, stats.resets_avoided);
+  EXPECT_EQ(0, stats.lookups_failed);
+  EXPECT_EQ(3, stats.documents_looked_up);
+  EXPECT_EQ(1, stats.documents_removed);
+  // The lookups only fetched the document names.
+  EXPECT_GT(stats.bytes_saved, 0);
+}
+
+TEST_F(RemoteStoreTest, ResetsTargetWhenReconciliationLookupFails) {
+  Commit({testutil::SetMutation("coll/a", Map("n", 1)),
+          testutil::SetMutation("coll/b", Map("n", 2))});
+  TargetId target_id = Listen();
+  ASSERT_TRUE(
+      WaitUntilSynced(target_id, DocumentKeySet{Key("coll/a"), Key("coll/b")}));
+
+  backend.set_lookup_status(
+      grpc::Status(grpc::StatusCode::PERMISSION_DENIED, "lookups disabled"));
+  backend.DeleteBehindExistenceFilter(Key("coll/b"));
+  ASSERT_TRUE(WaitUntil(
+      [&] { return remote_store->reconciliation_stats().lookups_failed > 0; }));
+
+  // The next global snapshot resets the target, which is listened to again
+  // from scratch.
+  Commit({testutil::SetMutation("other/c", Map("n", 3))});
+  EXPECT_TRUE(WaitUntilSynced(target_id, DocumentKeySet{Key("coll/a")}));
+
+  RemoteStore::ReconciliationStats stats = reconciliation_stats();
+  EXPECT_EQ(0, stats.resets_avoided);
+  EXPECT_EQ(1, stats.lookups_failed);
+  EXPECT_EQ(0, stats.documents_removed);
+}
+
+}  // namespace
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,219 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <functional>
+#include <future>  // NOLINT(build/c++11)
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
+
+#include "Firestore/core/src/api/settings.h"
+#include "Firestore/core/src/core/database_info.h"
+#include "Firestore/core/src/core/event_listener.h"
+#include "Firestore/core/src/core/firestore_client.h"
+#include "Firestore/core/src/core/listen_options.h"
+#include "Firestore/core/src/core/query_listener.h"
+#include "Firestore/core/src/core/view_snapshot.h"
+#include "Firestore/core/src/credentials/empty_credentials_provider.h"
+#include "Firestore/core/src/local/leveldb_persistence.h"
+#include "Firestore/core/src/local/resume_token_checkpoint_policy.h"
+#include "Firestore/core/src/model/set_mutation.h"
+#include "Firestore/core/src/remote/firebase_metadata_provider_noop.h"
+#include "Firestore/core/src/util/status.h"
+#include "Firestore/core/src/util/statusor.h"
+#include "Firestore/core/test/unit/remote/fake_firestore_backend.h"
+#include "Firestore/core/test/unit/testutil/async_testing.h"
+#include "Firestore/core/test/unit/testutil/testutil.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+namespace {
+
+using core::DatabaseInfo;
+using core::FirestoreClient;
+using core::ViewSnapshot;
+using local::LevelDbPersistence;
+using local::ResumeTokenCheckpointPolicy;
+using model::DatabaseId;
+using util::Status;
+using util::StatusOr;
+
+/** The number of documents changed while the first client listens. */
+constexpr int kChangedDocuments = 10;
+
+/**
+ * A `FirestoreClient` with persistence and the given checkpoint policy,
+ * connected to a fake backend. Restarts reuse the same local cache.
+ */
+class RestartingClient {
+ public:
+  explicit RestartingClient(const ResumeTokenCheckpointPolicy& policy)
+      : backend_{DatabaseId{"p", "d"}},
+        database_info_{DatabaseId{"p", "d"}, "resume_token_checkpoint",
+                       backend_.host(), false} {
+    settings_.set_host(backend_.host());
+    settings_.set_ssl_enabled(false);
+    settings_.set_resume_token_checkpoint_policy(policy);
+
+    Status cleared = LevelDbPersistence::ClearPersistence(database_info_);
+    EXPECT_TRUE(cleared.ok()) << cleared.ToString();
+  }
+
+  ~RestartingClient() {
+    if (client_) client_->Dispose();
+    LevelDbPersistence::ClearPersistence(database_info_);
+  }
+
+  FakeFirestoreBackend& backend() {
+    return backend_;
+  }
+
+  FirestoreClient& client() {
+    return *client_;
+  }
+
+  /** Disposes the current client, if any, and starts a new one. */
+  void Restart() {
+    if (client_) client_->Dispose();
+    client_ = FirestoreClient::Create(
+        database_info_, settings_,
+        std::make_shared<credentials::EmptyAuthCredentialsProvider>(),
+        std::make_shared<credentials::EmptyAppCheckCredentialsProvider>(),
+        testutil::ExecutorForTesting("user"),
+        testutil::AsyncQueueForTesting(), CreateFirebaseMetadataProviderNoOp());
+  }
+
+  /**
+   * Listens to the "coll" collection until the listener receives a snapshot
+   * for which `done` returns true.
+   */
+  void ListenUntil(const std::function<bool(const ViewSnapshot&)>& done) {
+    std::mutex mutex;
+    bool received = false;
+    std::promise<void> snapshot_received;
+    auto listener = client_->ListenToQuery(
+        testutil::Query("coll"),
+        core::ListenOptions::FromIncludeMetadataChanges(true),
+        core::EventListener<ViewSnapshot>::Create(
+            [&](const StatusOr<ViewSnapshot>& snapshot) {
+              EXPECT_TRUE(snapshot.ok()) << snapshot.status().ToString();
+              std::lock_guard<std::mutex> lock(mutex);
+              if (received || !snapshot.ok() || !done(snapshot.ValueOrDie())) {
+                return;
+              }
+              received = true;
+              snapshot_received.set_value();
+            }));
+    EXPECT_EQ(std::future_status::ready,
+              snapshot_received.get_future().wait_for(testutil::kTimeout));
+    client_->RemoveListener(listener);
+  }
+
+ private:
+  FakeFirestoreBackend backend_;
+  DatabaseInfo database_info_;
+  api::Settings settings_;
+  std::shared_ptr<FirestoreClient> client_;
+};
+
+/**
+ * Returns whether `snapshot` holds `documents` documents that are all
+ * acknowledged and up to date with the backend.
+ */
+bool IsSynced(const ViewSnapshot& snapshot, size_t documents) {
+  return !snapshot.from_cache() && !snapshot.has_pending_writes() &&
+         snapshot.documents().size() == documents;
+}
+
+/**
+ * Listens with the given policy while documents change, restarts the client
+ * and listens again. Returns the number of documents the backend sent again
+ * when the listen was resumed.
+ */
+int64_t ResumedDocumentsAfterRestart(
+    const ResumeTokenCheckpointPolicy& policy) {
+  RestartingClient test{policy};
+  test.Restart();
+
+  // Keep the target active while the documents change, so that only the
+  // checkpoint policy decides which resume token is persisted.
+  std::mutex mutex;
+  bool initial = true;
+  bool changed = false;
+  std::promise<void> initial_snapshot;
+  std::promise<void> changes_received;
+  auto listener = test.client().ListenToQuery(
+      testutil::Query("coll"),
+      core::ListenOptions::FromIncludeMetadataChanges(true),
+      core::EventListener<ViewSnapshot>::Create(
+          [&](const StatusOr<ViewSnapshot>& snapshot) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!snapshot.ok()) return;
+            if (initial && IsSynced(snapshot.ValueOrDie(), 0)) {
+              initial = false;
+              initial_snapshot.set_value();
+            } else if (!changed &&
+                       IsSynced(snapshot.ValueOrDie(), kChangedDocuments)) {
+              changed = true;
+              changes_received.set_value();
+            }
+          }));
+  EXPECT_EQ(std::future_status::ready,
+            initial_snapshot.get_future().wait_for(testutil::kTimeout));
+
+  for (int i = 0; i < kChangedDocuments; ++i) {
+    test.client().WriteMutations(
+        {testutil::SetMutation("coll/doc" + std::to_string(i),
+                               testutil::Map("n", i))},
+        [](const Status& status) { EXPECT_TRUE(status.ok()); });
+  }
+  EXPECT_EQ(std::future_status::ready,
+            changes_received.get_future().wait_for(testutil::kTimeout));
+
+  // Restart without removing the listener, as if the app was killed, so that
+  // the target is not released.
+  test.Restart();
+  EXPECT_EQ(0, test.backend().resumed_documents_sent());
+  test.ListenUntil([](const ViewSnapshot& snapshot) {
+    return IsSynced(snapshot, kChangedDocuments);
+  });
+
+  return test.backend().resumed_documents_sent();
+}
+
+TEST(ResumeTokenCheckpointTest, CheckpointingLessOftenResendsMoreDocuments) {
+  ResumeTokenCheckpointPolicy frequent;
+  frequent.documents = 1;
+
+  // Only the first resume token of the target is persisted.
+  ResumeTokenCheckpointPolicy never;
+  never.max_age_seconds = 0;
+  never.documents = 0;
+  never.bytes = 0;
+
+  int64_t resumed_frequent = ResumedDocumentsAfterRestart(frequent);
+  int64_t resumed_never = ResumedDocumentsAfterRestart(never);
+
+  EXPECT_EQ(kChangedDocuments, resumed_never);
+  EXPECT_LT(resumed_frequent, resumed_never);
+}
+
+}  // namespace
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
@@ -80,6 +80,10 @@ class TestStream : public Stream {
     Write({});
   }
 
+  void WriteString(const std::string& contents) {
+    Write(MakeByteBuffer(contents));
+  }
+
   void FailNextStreamRead() {
     fail_next_stream_read_ = true;
   }
@@ -360,6 +364,26 @@ TEST_F(StreamTest, SeveralWrites) {
   // hang or crash indicates success.
 }
 
+TEST_F(StreamTest, CountsMessagesSentAndReceived) {
+  StartStream();
+
+  ForceFinish({
+      {Type::Read, MakeByteBuffer("foo")},
+      {Type::Read, MakeByteBuffer("barbaz")},
+  });
+
+  worker_queue->EnqueueBlocking([&] {
+    firestore_stream->WriteString("hello");
+    firestore_stream->WriteEmptyBuffer();
+
+    const Stream::MessageStats& stats = firestore_stream->message_stats();
+    EXPECT_EQ(stats.messages_sent, 2);
+    EXPECT_EQ(stats.bytes_sent, 5);
+    EXPECT_EQ(stats.messages_received, 2);
+    EXPECT_EQ(stats.bytes_received, 9);
+  });
+}
+
 // Auth edge cases
 
 TEST_F(StreamTest, AuthFailureOnStart) {
@@ -283,6 +283,24 @@ TEST_F(FilesystemTest, ReadFile) {
   ASSERT_EQ(result.ValueOrDie(), "foobar");
 }
 
+TEST_F(FilesystemTest, WriteFile) {
+  TestTempDir root_dir;
+  Path file = root_dir.RandomChild();
+
+  ASSERT_OK(fs_->WriteFile(file, "foobar"));
+  StatusOr<std::string> result = fs_->ReadFile(file);
+  ASSERT_OK(result.status());
+  ASSERT_EQ(result.ValueOrDie(), "foobar");
+
+  // Overwrites existing contents.
+  ASSERT_OK(fs_->WriteFile(file, "baz"));
+  result = fs_->ReadFile(file);
+  ASSERT_OK(result.status());
+  ASSERT_EQ(result.ValueOrDie(), "baz");
+
+  ASSERT_FALSE(fs_->WriteFile(root_dir.Child("missing/file"), "").ok());
+}
+
 TEST_F(FilesystemTest, IsEmptyDir) {
   TestTempDir root_dir;
 